@@ -10,11 +10,13 @@
 #ifndef KLEE_EITHER_H
 #define KLEE_EITHER_H
 
+#include "klee/ADT/Hashing.h"
 #include "klee/ADT/Ref.h"
 
 #include "klee/Support/Casting.h"
 
 #include <cassert>
+#include <cstdint>
 
 namespace llvm {
 class raw_ostream;
@@ -32,9 +34,7 @@ protected:
 
   /// @brief Required by klee::ref-managed objects
   class ReferenceCounter _refCount;
-  unsigned hashValue;
-
-  static const unsigned MAGIC_HASH_CONSTANT = 39;
+  uint64_t hashValue;
 
 public:
   using left = either_left<T1, T2>;
@@ -49,7 +49,7 @@ public:
   virtual int compare(const either<T1, T2> &b) = 0;
   virtual bool equals(const either<T1, T2> &b) = 0;
 
-  unsigned hash() const { return hashValue; }
+  uint64_t hash() const { return hashValue; }
 };
 
 template <class T1, class T2> class either_left : public either<T1, T2> {
@@ -60,10 +60,9 @@ protected:
 private:
   ref<T1> value_;
 
-  unsigned computeHash() {
-    unsigned res = (unsigned)getKind();
-    res = (res * either<T1, T2>::MAGIC_HASH_CONSTANT) + value_->hash();
-    either<T1, T2>::hashValue = res;
+  uint64_t computeHash() {
+    either<T1, T2>::hashValue =
+        hashing::combine((uint64_t)getKind(), value_->hash());
     return either<T1, T2>::hashValue;
   }
 
@@ -110,10 +109,9 @@ protected:
 private:
   ref<T2> value_;
 
-  unsigned computeHash() {
-    unsigned res = (unsigned)getKind();
-    res = (res * either<T1, T2>::MAGIC_HASH_CONSTANT) + value_->hash();
-    either<T1, T2>::hashValue = res;
+  uint64_t computeHash() {
+    either<T1, T2>::hashValue =
+        hashing::combine((uint64_t)getKind(), value_->hash());
     return either<T1, T2>::hashValue;
   }
 
@@ -0,0 +1,37 @@
+//===-- Hashing.h -----------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_HASHING_H
+#define KLEE_HASHING_H
+
+#include <cstdint>
+
+namespace klee {
+namespace hashing {
+/// Mix all bits of x into all bits of the result (the finalizer of
+/// splitmix64). Unlike llvm::hash_combine, the result does not depend on a
+/// per-process seed, so hashes and the orders derived from them are stable
+/// between runs.
+inline uint64_t mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= UINT64_C(0xbf58476d1ce4e5b9);
+  x ^= x >> 27;
+  x *= UINT64_C(0x94d049bb133111eb);
+  x ^= x >> 31;
+  return x;
+}
+
+/// Extend the hash seed with value, depending on the order of combination.
+inline uint64_t combine(uint64_t seed, uint64_t value) {
+  return mix(seed + UINT64_C(0x9e3779b97f4a7c15) + mix(value));
+}
+} // namespace hashing
+} // namespace klee
+
+#endif /* KLEE_HASHING_H */
@@ -66,6 +66,50 @@ unsigned kTest_numBytes(KTest *);
 
 void kTest_free(KTest *);
 
+/* A test case archive packs many tests into one append-only data file
+   plus an index file (path + ".idx"). Readers memory-map both files. */
+typedef struct KTestArchive KTestArchive;
+typedef struct KTestArchiveWriter KTestArchiveWriter;
+
+/* return true iff file at path matches KTest archive header */
+int kTestArchive_isArchiveFile(const char *path);
+
+/* returns NULL on (unspecified) error */
+KTestArchive *kTestArchive_open(const char *path);
+
+unsigned kTestArchive_numTests(const KTestArchive *);
+
+/* returns a copy of the test at index, to be released with kTest_free,
+   or NULL on (unspecified) error */
+KTest *kTestArchive_getTest(const KTestArchive *, unsigned index);
+
+/* returns the bytes of an object without copying them out of the mapping,
+   or NULL on (unspecified) error */
+const unsigned char *kTestArchive_getObjectBytes(const KTestArchive *,
+                                                 unsigned index,
+                                                 unsigned object,
+                                                 unsigned *numBytes);
+
+void kTestArchive_close(KTestArchive *);
+
+/* opens (or creates) an archive for appending; if deduplicate is set,
+   object contents equal to ones already in the archive are shared.
+   returns NULL on (unspecified) error */
+KTestArchiveWriter *kTestArchiveWriter_open(const char *path,
+                                            int deduplicate);
+
+/* returns 1 on success, 0 on (unspecified) error */
+int kTestArchiveWriter_append(KTestArchiveWriter *, const KTest *);
+
+/* appends a named file, such as the .kquery of a test case, which readers
+   skip when iterating over tests.
+   returns 1 on success, 0 on (unspecified) error */
+int kTestArchiveWriter_appendFile(KTestArchiveWriter *, const char *name,
+                                  const unsigned char *bytes,
+                                  unsigned numBytes);
+
+void kTestArchiveWriter_close(KTestArchiveWriter *);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,325 @@
+//===-- SetIndex.h ----------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SETINDEX_H
+#define KLEE_SETINDEX_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace klee {
+
+/// SetIndex - Maps sets to values, like MapOfSets, but finds the subsets and
+/// supersets of a set through inverted indices instead of a trie walk.
+///
+/// Every entry is listed under all of its elements (for superset searches)
+/// and under a single representative element, the one shared with the
+/// fewest other entries at insertion time (for subset searches). A subset
+/// of a set S has its representative in S, so a subset search only looks at
+/// the entries represented by elements of S. Candidates are filtered by a
+/// 64 bit signature of their elements before their elements are compared.
+///
+/// Matches are tried in the order in which their sets were inserted, oldest
+/// first.
+///
+/// The index has a memory budget. Once it is exceeded the least frequently
+/// hit quarter of the entries, the oldest among equally hit ones, is evicted
+/// and all hit counts are halved.
+/// Pointers to values are invalidated by insert() and clear().
+template <class K, class V, class Hash = std::hash<K>> class SetIndex {
+  typedef std::uint32_t id_ty;
+
+  struct Entry {
+    std::vector<K> key;
+    V value;
+    std::size_t hash = 0;
+    std::uint64_t signature = 0;
+    std::uint64_t hits = 0;
+    /// insertion order of the set
+    std::uint64_t serial = 0;
+    std::size_t size = 0;
+    bool live = false;
+  };
+
+  std::vector<Entry> entries;
+  std::vector<id_ty> freeIds;
+  std::unordered_multimap<std::size_t, id_ty> exact;
+  std::unordered_map<K, std::unordered_set<id_ty>, Hash> occurrences;
+  std::unordered_map<K, std::unordered_set<id_ty>, Hash> represented;
+  /// entries for the empty set have no representative
+  std::unordered_set<id_ty> emptySets;
+
+  std::size_t size = 0;
+  std::size_t capacity;
+  std::uint64_t evictions = 0;
+  std::uint64_t nextSerial = 0;
+
+  static std::size_t hashKey(const std::set<K> &set) {
+    std::size_t res = set.size();
+    for (const K &k : set)
+      res = res * 31 + Hash()(k);
+    return res;
+  }
+
+  static std::uint64_t signature(const std::set<K> &set) {
+    std::uint64_t res = 0;
+    for (const K &k : set)
+      res |= std::uint64_t(1) << (Hash()(k) % 64);
+    return res;
+  }
+
+  Entry *find(const std::set<K> &set, std::size_t hash) {
+    auto range = exact.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      Entry &e = entries[it->second];
+      if (e.key.size() == set.size() &&
+          std::equal(e.key.begin(), e.key.end(), set.begin()))
+        return &e;
+    }
+    return nullptr;
+  }
+
+  template <class Predicate>
+  V *findFirst(std::vector<id_ty> &matches, const Predicate &p) {
+    std::sort(matches.begin(), matches.end(), [this](id_ty a, id_ty b) {
+      return entries[a].serial < entries[b].serial;
+    });
+    for (id_ty id : matches) {
+      if (p(entries[id].value)) {
+        ++entries[id].hits;
+        return &entries[id].value;
+      }
+    }
+    return nullptr;
+  }
+
+  void erase(id_ty id, std::vector<V> *removed);
+  void evict(std::vector<V> *removed);
+
+public:
+  /// capacity - memory budget in bytes, 0 for no budget
+  explicit SetIndex(std::size_t capacity = 0) : capacity(capacity) {}
+
+  /// Associate value with set, replacing any previous value. valueSize is
+  /// the memory held by the value beyond sizeof(V). The replaced and the
+  /// evicted values are added to removed, if given.
+  void insert(const std::set<K> &set, const V &value,
+              std::size_t valueSize = 0, std::vector<V> *removed = nullptr);
+
+  V *lookup(const std::set<K> &set) {
+    Entry *e = find(set, hashKey(set));
+    if (!e)
+      return nullptr;
+    ++e->hits;
+    return &e->value;
+  }
+
+  /// Return the value of the first inserted subset of set whose value
+  /// satisfies p.
+  template <class Predicate>
+  V *findSubset(const std::set<K> &set, const Predicate &p);
+  /// Return the value of the first inserted superset of set whose value
+  /// satisfies p.
+  template <class Predicate>
+  V *findSuperset(const std::set<K> &set, const Predicate &p);
+
+  void clear();
+
+  std::size_t getSize() const { return exact.size(); }
+  std::size_t getMemoryUsage() const { return size; }
+  std::uint64_t getEvictions() const { return evictions; }
+};
+
+/***/
+
+template <class K, class V, class Hash>
+void SetIndex<K, V, Hash>::insert(const std::set<K> &set, const V &value,
+                                  std::size_t valueSize,
+                                  std::vector<V> *removed) {
+  std::size_t hash = hashKey(set);
+  // every element is stored in the key and in a node of an occurrence set
+  std::size_t entrySize = sizeof(Entry) + valueSize +
+                          set.size() * (sizeof(K) + 3 * sizeof(void *));
+
+  if (Entry *existing = find(set, hash)) {
+    size = size - existing->size + entrySize;
+    if (removed)
+      removed->push_back(existing->value);
+    existing->value = value;
+    existing->size = entrySize;
+  } else {
+    id_ty id;
+    if (freeIds.empty()) {
+      id = entries.size();
+      entries.emplace_back();
+    } else {
+      id = freeIds.back();
+      freeIds.pop_back();
+    }
+
+    Entry &e = entries[id];
+    e.key.assign(set.begin(), set.end());
+    e.value = value;
+    e.hash = hash;
+    e.signature = signature(set);
+    e.hits = 0;
+    e.serial = nextSerial++;
+    e.size = entrySize;
+    e.live = true;
+    size += entrySize;
+
+    exact.emplace(hash, id);
+    if (set.empty()) {
+      emptySets.insert(id);
+    } else {
+      const K *representative = nullptr;
+      std::size_t shared = 0;
+      for (const K &k : set) {
+        auto &entriesWithK = occurrences[k];
+        if (!representative || entriesWithK.size() < shared) {
+          representative = &k;
+          shared = entriesWithK.size();
+        }
+        entriesWithK.insert(id);
+      }
+      represented[*representative].insert(id);
+    }
+  }
+
+  if (capacity && size > capacity)
+    evict(removed);
+}
+
+template <class K, class V, class Hash>
+void SetIndex<K, V, Hash>::erase(id_ty id, std::vector<V> *removed) {
+  Entry &e = entries[id];
+  assert(e.live && "erasing a dead entry");
+  if (removed)
+    removed->push_back(e.value);
+
+  auto range = exact.equal_range(e.hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == id) {
+      exact.erase(it);
+      break;
+    }
+  }
+  emptySets.erase(id);
+  for (const K &k : e.key) {
+    auto occ = occurrences.find(k);
+    occ->second.erase(id);
+    if (occ->second.empty())
+      occurrences.erase(occ);
+    auto rep = represented.find(k);
+    if (rep != represented.end() && rep->second.erase(id) &&
+        rep->second.empty())
+      represented.erase(rep);
+  }
+
+  size -= e.size;
+  e = Entry();
+  freeIds.push_back(id);
+}
+
+template <class K, class V, class Hash>
+void SetIndex<K, V, Hash>::evict(std::vector<V> *removed) {
+  std::vector<id_ty> ids;
+  ids.reserve(exact.size());
+  for (id_ty id = 0; id != entries.size(); ++id)
+    if (entries[id].live)
+      ids.push_back(id);
+
+  std::size_t victims = std::max<std::size_t>(1, ids.size() / 4);
+  auto byHits = [this](id_ty a, id_ty b) {
+    return entries[a].hits < entries[b].hits ||
+           (entries[a].hits == entries[b].hits &&
+            entries[a].serial < entries[b].serial);
+  };
+  std::nth_element(ids.begin(), ids.begin() + (victims - 1), ids.end(),
+                   byHits);
+  for (std::size_t i = 0; i != victims; ++i)
+    erase(ids[i], removed);
+  evictions += victims;
+
+  for (Entry &e : entries)
+    e.hits /= 2;
+}
+
+template <class K, class V, class Hash>
+template <class Predicate>
+V *SetIndex<K, V, Hash>::findSubset(const std::set<K> &set,
+                                    const Predicate &p) {
+  std::uint64_t sig = signature(set);
+  std::vector<id_ty> matches(emptySets.begin(), emptySets.end());
+  for (const K &k : set) {
+    auto rep = represented.find(k);
+    if (rep == represented.end())
+      continue;
+    for (id_ty id : rep->second) {
+      const Entry &e = entries[id];
+      if ((e.signature & ~sig) == 0 && e.key.size() <= set.size() &&
+          std::includes(set.begin(), set.end(), e.key.begin(), e.key.end()))
+        matches.push_back(id);
+    }
+  }
+  return findFirst(matches, p);
+}
+
+template <class K, class V, class Hash>
+template <class Predicate>
+V *SetIndex<K, V, Hash>::findSuperset(const std::set<K> &set,
+                                      const Predicate &p) {
+  std::vector<id_ty> matches;
+  if (set.empty()) {
+    for (id_ty id = 0; id != entries.size(); ++id)
+      if (entries[id].live)
+        matches.push_back(id);
+    return findFirst(matches, p);
+  }
+
+  // the rarest element has the fewest candidates
+  const std::unordered_set<id_ty> *candidates = nullptr;
+  for (const K &k : set) {
+    auto occ = occurrences.find(k);
+    if (occ == occurrences.end())
+      return nullptr;
+    if (!candidates || occ->second.size() < candidates->size())
+      candidates = &occ->second;
+  }
+
+  std::uint64_t sig = signature(set);
+  for (id_ty id : *candidates) {
+    const Entry &e = entries[id];
+    if ((sig & ~e.signature) == 0 && e.key.size() >= set.size() &&
+        std::includes(e.key.begin(), e.key.end(), set.begin(), set.end()))
+      matches.push_back(id);
+  }
+  return findFirst(matches, p);
+}
+
+template <class K, class V, class Hash> void SetIndex<K, V, Hash>::clear() {
+  entries.clear();
+  freeIds.clear();
+  exact.clear();
+  occurrences.clear();
+  represented.clear();
+  emptySets.clear();
+  size = 0;
+}
+
+} // namespace klee
+
+#endif /* KLEE_SETINDEX_H */
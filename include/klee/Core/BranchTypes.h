@@ -25,7 +25,8 @@
   BTYPE(Realloc, 8U)                                                           \
   BTYPE(Free, 9U)                                                              \
   BTYPE(GetVal, 10U)                                                           \
-  BMARK(END, 10U)
+  BTYPE(LoopSummary, 11U)                                                      \
+  BMARK(END, 11U)
 /// \endcond
 
 /** @enum BranchType
@@ -50,7 +51,9 @@
  * `realloc`ation size                                                      | |
  * `BranchType::Free`              | branch caused by `free`ing symbolic pointer
  * | | `BranchType::GetVal`            | branch caused by user-invoked
- * concretization while seeding                                         |
+ * concretization while seeding                                         | |
+ * `BranchType::LoopSummary`       | branch caused by leaving a summarized
+ * loop through one of its exits                                      |
  */
 enum class BranchType : std::uint8_t {
 /// \cond DO_NOT_DOCUMENT
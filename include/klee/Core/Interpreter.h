@@ -244,7 +244,7 @@ public:
   virtual SarifReportJson getSARIFReport() const = 0;
 
   virtual void logState(const ExecutionState &state, int id,
-                        std::unique_ptr<llvm::raw_fd_ostream> &f) = 0;
+                        std::unique_ptr<llvm::raw_ostream> &f) = 0;
 
   virtual void
   getCoveredLines(const ExecutionState &state,
@@ -14,15 +14,19 @@
 #include "klee/Expr/ExprHashMap.h"
 #include "klee/Expr/ExprVisitor.h"
 
+#include <memory>
+
 namespace klee {
 
 class AlphaBuilder final : public ExprVisitor {
 public:
-  ExprHashMap<ref<Expr>> reverseExprMap;
-  ArrayCache::ArrayHashMap<const Array *> reverseAlphaArrayMap;
-  ArrayCache::ArrayHashMap<const Array *> alphaArrayMap;
+  typedef ArrayCache::ArrayHashMap<const Array *> ArrayMap;
 
 private:
+  /// Renamed arrays and their originals. Copies of a builder share the maps
+  /// until one of them renames a new array.
+  std::shared_ptr<ArrayMap> alphaArrayMap;
+  std::shared_ptr<ArrayMap> reverseAlphaArrayMap;
   unsigned index = 0;
   bool reverse = false;
 
@@ -33,10 +37,17 @@ private:
 
 public:
   AlphaBuilder();
+  /// Continue the renaming of b. The cache of visited expressions is not
+  /// copied.
+  AlphaBuilder(const AlphaBuilder &b);
+  AlphaBuilder(AlphaBuilder &&) = default;
   constraints_ty visitConstraints(const constraints_ty &cs);
   ref<Expr> build(ref<Expr> v);
   const Array *buildArray(const Array *arr) { return visitArray(arr); }
   ref<Expr> reverseBuild(ref<Expr> v);
+  const ArrayMap &getReverseAlphaArrayMap() const {
+    return *reverseAlphaArrayMap;
+  }
 };
 
 } // namespace klee
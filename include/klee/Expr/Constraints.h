@@ -110,6 +110,9 @@ public:
   void getAllDependentConstraintsSets(
       ref<Expr> queryExpr,
       std::vector<ref<const IndependentConstraintSet>> &result) const;
+  void getAllDependentConstraintsSets(
+      const std::vector<const Array *> &arrays,
+      std::vector<ref<const IndependentConstraintSet>> &result) const;
 };
 
 class PathConstraints {
@@ -131,6 +134,12 @@ public:
   static PathConstraints concat(const PathConstraints &l,
                                 const PathConstraints &r);
 
+  /// Keep the constraints shared with b and add the disjunction of the
+  /// remaining constraints of either side. Returns the conditions under which
+  /// a path is one of this or of b, or null expressions (and leaves this
+  /// unchanged) if the constraints of one side are implied by the other's.
+  std::pair<ref<Expr>, ref<Expr>> merge(const PathConstraints &b);
+
 private:
   Path _path;
   ConstraintSet constraints;
@@ -10,6 +10,7 @@
 #ifndef KLEE_EXPR_H
 #define KLEE_EXPR_H
 
+#include "klee/ADT/Hashing.h"
 #include "klee/ADT/Ref.h"
 #include "klee/Expr/SymbolicSource.h"
 
@@ -112,12 +113,17 @@ public:
 
 protected:
   struct ExprHash {
-    unsigned operator()(Expr *const e) const { return e->hash(); }
+    std::size_t operator()(Expr *const e) const { return e->hash(); }
   };
 
   struct ExprCmp {
     bool operator()(Expr *const a, Expr *const b) const {
-      return a->equals(*b);
+      if (a->hash() != b->hash())
+        return false;
+      if (a->equals(*b))
+        return true;
+      ++cacheCollisions;
+      return false;
     }
   };
 
@@ -156,6 +162,10 @@ protected:
   bool toBeCleared = false;
 
 public:
+  /// Number of lookups in the expression cache that met a different
+  /// expression with the same hash.
+  static uint64_t cacheCollisions;
+
   // NOTE: The prefix "Int" in no way implies the integer type of expression.
   // For example, Int64 can indicate i64, double or <2 * i32> in different
   // cases.
@@ -279,7 +289,7 @@ public:
   class ReferenceCounter _refCount;
 
 protected:
-  unsigned hashValue;
+  uint64_t hashValue;
   unsigned heightValue;
 
   /// Compares `b` to `this` Expr and determines how they are ordered
@@ -325,12 +335,12 @@ public:
   std::string toString() const;
 
   /// Returns the pre-computed hash of the current expression
-  unsigned hash() const { return hashValue; }
+  uint64_t hash() const { return hashValue; }
   unsigned height() const { return heightValue; }
 
   /// (Re)computes the hash of the current expression.
   /// Returns the hash value.
-  virtual unsigned computeHash();
+  virtual uint64_t computeHash();
   virtual unsigned computeHeight();
 
   /// Compares `b` to `this` Expr for structural equivalence.
@@ -589,40 +599,81 @@ public:
   static bool classof(const NotOptimizedExpr *) { return true; }
 };
 
-/// Class representing a byte update of an array.
+/// Class representing a byte update of an array. Update nodes are
+/// hash-consed: equal updates of equal sequences are the same node, so
+/// update sequences can be compared by their heads.
 class UpdateNode {
   friend class UpdateList;
 
   // cache instead of recalc
-  unsigned hashValue;
+  uint64_t hashValue;
   unsigned heightValue;
 
+  struct UpdateNodeHash {
+    std::size_t operator()(UpdateNode *const un) const {
+      return un->hash();
+    }
+  };
+
+  struct UpdateNodeCmp {
+    bool operator()(UpdateNode *const a, UpdateNode *const b) const {
+      return a->next.get() == b->next.get() && a->index == b->index &&
+             a->value == b->value;
+    }
+  };
+
+  typedef std::unordered_set<UpdateNode *, UpdateNodeHash, UpdateNodeCmp>
+      CacheType;
+
+  struct UpdateNodeCacheSet {
+    CacheType cache;
+    ~UpdateNodeCacheSet() {
+      while (cache.size() != 0) {
+        ref<UpdateNode> tmp = *cache.begin();
+        tmp->isCached = false;
+        cache.erase(cache.begin());
+      }
+    }
+  };
+
+  static UpdateNodeCacheSet cachedNodes;
+  bool isCached = false;
+
 public:
   const ref<UpdateNode> next;
-  ref<Expr> index, value;
+  const ref<Expr> index, value;
 
   /// @brief Required by klee::ref-managed objects
   mutable class ReferenceCounter _refCount;
 
+  /// Number of nodes created that were already cached, and that were not.
+  static uint64_t cacheHits, cacheMisses;
+
 private:
   /// size of this update sequence, including this update
   unsigned size;
 
-public:
   UpdateNode(const ref<UpdateNode> &_next, const ref<Expr> &_index,
              const ref<Expr> &_value);
 
+public:
+  static ref<UpdateNode> create(const ref<UpdateNode> &next,
+                                const ref<Expr> &index, const ref<Expr> &value);
+
+  /// Number of update nodes currently in the cache.
+  static size_t getCacheSize() { return cachedNodes.cache.size(); }
+
   unsigned getSize() const { return size; }
 
   int compare(const UpdateNode &b) const;
   bool equals(const UpdateNode &b) const;
-  unsigned hash() const { return hashValue; }
+  uint64_t hash() const { return hashValue; }
   unsigned height() const { return heightValue; }
 
   UpdateNode() = delete;
-  ~UpdateNode() = default;
+  ~UpdateNode();
 
-  unsigned computeHash();
+  uint64_t computeHash();
   unsigned computeHeight();
 };
 
@@ -648,7 +699,7 @@ public:
 private:
   static ArrayCache cachedArrays;
 
-  unsigned hashValue;
+  uint64_t hashValue;
 
   // FIXME: Make =delete when we switch to C++11
   Array(const Array &array);
@@ -688,8 +739,8 @@ public:
 
   /// ComputeHash must take into account the name, the size, the domain, and the
   /// range
-  unsigned computeHash();
-  unsigned hash() const { return hashValue; }
+  uint64_t computeHash();
+  uint64_t hash() const { return hashValue; }
   friend class ArrayCache;
 };
 
@@ -722,7 +773,7 @@ public:
   bool operator==(const UpdateList &rhs) const { return compare(rhs) == 0; }
   bool operator!=(const UpdateList &rhs) const { return compare(rhs) != 0; }
 
-  unsigned hash() const;
+  uint64_t hash() const;
   unsigned height() const;
 };
 
@@ -762,7 +813,7 @@ public:
     return create(updates, kids[0]);
   }
 
-  virtual unsigned computeHash();
+  virtual uint64_t computeHash();
   virtual unsigned computeHeight();
 
 private:
@@ -959,7 +1010,7 @@ public:
     return create(kids[0], offset, width);
   }
 
-  virtual unsigned computeHash();
+  virtual uint64_t computeHash();
 
 private:
   ExtractExpr(const ref<Expr> &e, unsigned b, Width w)
@@ -998,7 +1049,7 @@ public:
 
   virtual ref<Expr> rebuild(ref<Expr> kids[]) const { return create(kids[0]); }
 
-  virtual unsigned computeHash();
+  virtual uint64_t computeHash();
 
 public:
   static bool classof(const Expr *E) { return E->getKind() == Expr::Not; }
@@ -1038,7 +1089,7 @@ public:
     return 0;
   }
 
-  virtual unsigned computeHash();
+  virtual uint64_t computeHash();
 
   static bool classof(const Expr *E) {
     Expr::Kind k = E->getKind();
@@ -1315,7 +1366,7 @@ COMPARISON_EXPR_CLASS(FOGe)
     virtual ref<Expr> rebuild(ref<Expr> kids[]) const {                        \
       return create(kids[0]);                                                  \
     }                                                                          \
-    virtual unsigned computeHash();                                            \
+    virtual uint64_t computeHash();                                            \
     static ref<Expr> either(const ref<Expr> &e0, const ref<Expr> &e1);         \
     static bool classof(const Expr *E) {                                       \
       return E->getKind() == Expr::_class_kind;                                \
@@ -1364,7 +1415,7 @@ FP_PRED_EXPR_CLASS(IsSubnormal)
     virtual ref<Expr> rebuild(ref<Expr> kids[]) const {                        \
       return create(kids[0], roundingMode);                                    \
     }                                                                          \
-    virtual unsigned computeHash();                                            \
+    virtual uint64_t computeHash();                                            \
     static ref<Expr> either(const ref<Expr> &e0, const ref<Expr> &e1);         \
     static bool classof(const Expr *E) {                                       \
       return E->getKind() == Expr::_class_kind;                                \
@@ -1406,7 +1457,7 @@ public:
     return 0;
   }
   virtual ref<Expr> rebuild(ref<Expr> kids[]) const { return create(kids[0]); }
-  virtual unsigned computeHash();
+  virtual uint64_t computeHash();
   static ref<Expr> either(const ref<Expr> &e0, const ref<Expr> &e1);
   static bool classof(const Expr *E) { return E->getKind() == Expr::FAbs; }
   static bool classof(const FAbsExpr *) { return true; }
@@ -1439,7 +1490,7 @@ public:
     return 0;
   }
   virtual ref<Expr> rebuild(ref<Expr> kids[]) const { return create(kids[0]); }
-  virtual unsigned computeHash();
+  virtual uint64_t computeHash();
   static ref<Expr> either(const ref<Expr> &e0, const ref<Expr> &e1);
   static bool classof(const Expr *E) { return E->getKind() == Expr::FNeg; }
   static bool classof(const FAbsExpr *) { return true; }
@@ -1526,7 +1577,7 @@ public:
     return const_cast<ConstantExpr *>(this);
   }
 
-  virtual unsigned computeHash();
+  virtual uint64_t computeHash();
 
   static ref<Expr> fromMemory(void *address, Width w);
   void toMemory(void *address);
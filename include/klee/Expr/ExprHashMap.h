@@ -20,7 +20,7 @@ namespace klee {
 
 namespace util {
 struct ExprHash {
-  unsigned operator()(const ref<Expr> &e) const { return e->hash(); }
+  std::size_t operator()(const ref<Expr> &e) const { return e->hash(); }
 };
 
 struct ExprCmp {
@@ -37,12 +37,21 @@ public:
 
   void getAllDependentConstraintSets(
       ref<Expr> e, std::vector<ref<const IndependentConstraintSet>> &result);
+  /// The sets that read any of arrays.
+  void getAllDependentConstraintSets(
+      const std::vector<const Array *> &arrays,
+      std::vector<ref<const IndependentConstraintSet>> &result);
   void getAllIndependentConstraintSets(
       ref<Expr> e, std::vector<ref<const IndependentConstraintSet>> &result);
 
   void addExpr(ref<Expr> e);
   void addSymcrete(ref<Symcrete> s);
   void flushConstraints();
+
+private:
+  void getAllDependentConstraintSets(
+      ref<const IndependentConstraintSet> compare,
+      std::vector<ref<const IndependentConstraintSet>> &result);
 };
 } // namespace klee
 
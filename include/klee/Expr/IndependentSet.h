@@ -21,7 +21,9 @@ using ExprOrSymcrete = either<Expr, Symcrete>;
 class IndependentConstraintSetUnion;
 
 struct ExprOrSymcreteHash {
-  unsigned operator()(const ref<ExprOrSymcrete> &e) const { return e->hash(); }
+  std::size_t operator()(const ref<ExprOrSymcrete> &e) const {
+    return e->hash();
+  }
 };
 
 struct ExprOrSymcreteCmp {
@@ -1,8 +1,11 @@
 #ifndef KLEE_PATH_H
 #define KLEE_PATH_H
 
-#include "klee/ADT/ImmutableList.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -15,9 +18,15 @@ class KModule;
 // Callsite, called function
 using stackframe_ty = std::pair<KInstruction *, KFunction *>;
 
+/// The sequence of basic blocks a state went through.
+///
+/// Blocks are stored run-length encoded: a sequence of blocks that repeats
+/// right after itself, like the iterations of a loop, is stored once with a
+/// repetition count. Runs are frozen into immutable checkpoints shared by all
+/// copies of a path, so that copying a path on a fork copies only the runs
+/// since the last checkpoint.
 class Path {
 public:
-  using path_ty = ImmutableList<KBlock *>;
   enum class TransitionKind { StepInto, StepOut, None };
 
   struct PathIndex {
@@ -43,14 +52,28 @@ public:
   void advance(KInstruction *ki);
 
   unsigned KBlockSize() const;
-  const path_ty &getBlocks() const;
+  /// The block at the given index of the path.
+  KBlock *getBlock(unsigned long index) const;
+  KBlock *getBlock(const PathIndex &index) const {
+    return getBlock(index.block);
+  }
   unsigned getFirstIndex() const;
   unsigned getLastIndex() const;
 
   PathIndex getCurrentIndex() const;
 
+  /// The call stack at the end of the path, outermost frame first or, if
+  /// reversed, innermost frame first. A path that starts inside a function
+  /// has no callsite for its outermost frame.
   std::vector<stackframe_ty> getStack(bool reversed) const;
 
+  /// Call f on every block of the path, in order.
+  void forEachBlock(llvm::function_ref<void(KBlock *)> f) const;
+
+  /// Bytes used to store the path, including checkpoints it shares with other
+  /// paths.
+  std::size_t getMemoryUsage() const;
+
   std::string toString() const;
 
   static Path concat(const Path &l, const Path &r);
@@ -59,18 +82,51 @@ public:
 
   Path() = default;
 
-  Path(unsigned firstInstruction, const path_ty &kblocks,
-       unsigned lastInstruction)
-      : KBlocks(kblocks), firstInstruction(firstInstruction),
-        lastInstruction(lastInstruction) {}
+  Path(unsigned firstInstruction, const std::vector<KBlock *> &kblocks,
+       unsigned lastInstruction);
 
 private:
-  path_ty KBlocks;
+  /// The blocks [start, start + length) of the literal blocks the run is
+  /// stored with, repeated a number of times.
+  struct Run {
+    std::uint32_t start;
+    std::uint32_t length;
+    std::uint64_t repeat;
+  };
+
+  struct Checkpoint {
+    std::shared_ptr<const Checkpoint> prev;
+    std::vector<KBlock *> literal;
+    std::vector<Run> runs;
+    /// Number of blocks on the path up to the end of this checkpoint.
+    unsigned long size;
+  };
+
+  std::shared_ptr<const Checkpoint> checkpoint;
+  /// Runs since the last checkpoint. The last run ends at the end of the
+  /// literal blocks.
+  std::vector<KBlock *> literal;
+  std::vector<Run> runs;
+  /// Number of blocks of the next repetition of the last run seen so far.
+  std::uint32_t matched = 0;
+  unsigned long size = 0;
+
   // Index of the first instruction in the first basic block
   unsigned firstInstruction = 0;
   // Index of the last (current) instruction in the current basic block
   unsigned lastInstruction = 0;
 
+  KBlock *back() const;
+  void push(KBlock *kblock);
+  /// Append body repeated the given number of times.
+  void append(llvm::ArrayRef<KBlock *> body, std::uint64_t repeat);
+  /// Fold a repetition at the end of the last run into a run of its own.
+  void fold();
+  void makeCheckpoint();
+  void forEachRun(
+      llvm::function_ref<void(llvm::ArrayRef<KBlock *>, std::uint64_t)> f)
+      const;
+
   static TransitionKind getTransitionKind(KBlock *a, KBlock *b);
 };
 
@@ -1,6 +1,7 @@
 #ifndef KLEE_SYMBOLICSOURCE_H
 #define KLEE_SYMBOLICSOURCE_H
 
+#include "klee/ADT/Hashing.h"
 #include "klee/ADT/Ref.h"
 
 #include "klee/ADT/SparseStorage.h"
@@ -9,6 +10,7 @@
 #include "llvm/IR/Argument.h"
 #include "llvm/IR/Instruction.h"
 
+#include <cstdint>
 #include <memory>
 #include <set>
 #include <string>
@@ -28,7 +30,7 @@ struct KInstruction;
 
 class SymbolicSource {
 protected:
-  unsigned hashValue;
+  uint64_t hashValue;
 
 public:
   /// @brief Required by klee::ref-managed objects
@@ -58,8 +60,8 @@ public:
   virtual std::set<const Array *> getRelatedArrays() const { return {}; }
 
   static bool classof(const SymbolicSource *) { return true; }
-  unsigned hash() const { return hashValue; }
-  virtual unsigned computeHash() = 0;
+  uint64_t hash() const { return hashValue; }
+  virtual uint64_t computeHash() = 0;
   virtual void print(llvm::raw_ostream &os) const;
   void dump() const;
   std::string toString() const;
@@ -87,7 +89,7 @@ public:
 
   static bool classof(const ConstantSource *) { return true; }
 
-  unsigned computeHash() override;
+  uint64_t computeHash() override;
 
   int internalCompare(const SymbolicSource &b) const override {
     if (getKind() != b.getKind()) {
@@ -119,7 +121,7 @@ public:
 
   static bool classof(const UninitializedSource *) { return true; }
 
-  unsigned computeHash() override;
+  uint64_t computeHash() override;
 
   int internalCompare(const SymbolicSource &b) const override;
 };
@@ -146,7 +148,7 @@ public:
     return true;
   }
 
-  virtual unsigned computeHash() override;
+  virtual uint64_t computeHash() override;
 
   virtual int internalCompare(const SymbolicSource &b) const override;
 };
@@ -166,7 +168,7 @@ public:
   }
   static bool classof(const MakeSymbolicSource *) { return true; }
 
-  virtual unsigned computeHash() override;
+  virtual uint64_t computeHash() override;
 
   virtual int internalCompare(const SymbolicSource &b) const override {
     if (getKind() != b.getKind()) {
@@ -194,7 +196,7 @@ public:
            S->getKind() == Kind::LazyInitializationContent;
   }
 
-  virtual unsigned computeHash() override;
+  virtual uint64_t computeHash() override;
 
   virtual int internalCompare(const SymbolicSource &b) const override {
     if (getKind() != b.getKind()) {
@@ -268,7 +270,7 @@ public:
 
   virtual const llvm::Value &value() const = 0;
 
-  virtual unsigned computeHash() = 0;
+  virtual uint64_t computeHash() = 0;
 };
 
 class ArgumentSource : public ValueSource {
@@ -289,7 +291,7 @@ public:
 
   const llvm::Value &value() const override { return allocSite; }
 
-  virtual unsigned computeHash() override;
+  virtual uint64_t computeHash() override;
 
   virtual int internalCompare(const SymbolicSource &b) const override;
 };
@@ -312,7 +314,7 @@ public:
 
   const llvm::Value &value() const override { return allocSite; }
 
-  virtual unsigned computeHash() override;
+  virtual uint64_t computeHash() override;
 
   virtual int internalCompare(const SymbolicSource &b) const override;
 };
@@ -330,10 +332,10 @@ public:
   }
   static bool classof(const IrreproducibleSource *) { return true; }
 
-  virtual unsigned computeHash() override {
-    unsigned res = getKind();
+  virtual uint64_t computeHash() override {
+    uint64_t res = hashing::mix(getKind());
     for (unsigned i = 0, e = name.size(); i != e; ++i) {
-      res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) + name[i];
+      res = hashing::combine(res, name[i]);
     }
     hashValue = res;
     return hashValue;
@@ -365,9 +367,8 @@ public:
   }
   static bool classof(const AlphaSource *) { return true; }
 
-  virtual unsigned computeHash() override {
-    unsigned res = getKind();
-    hashValue = res ^ (index * SymbolicSource::MAGIC_HASH_CONSTANT);
+  virtual uint64_t computeHash() override {
+    hashValue = hashing::combine(getKind(), index);
     return hashValue;
   }
 
@@ -411,7 +412,7 @@ public:
     return S->getKind() == Kind::MockNaive;
   }
 
-  unsigned computeHash() override;
+  uint64_t computeHash() override;
 
   [[nodiscard]] int internalCompare(const SymbolicSource &b) const override;
 };
@@ -434,7 +435,7 @@ public:
     return S->getKind() == Kind::MockDeterministic;
   }
 
-  unsigned computeHash() override;
+  uint64_t computeHash() override;
 
   [[nodiscard]] int internalCompare(const SymbolicSource &b) const override;
 };
@@ -50,6 +50,11 @@ private:
   functionBranchesSet functionConditionalBranches;
   functionBranchesSet functionBlocks;
 
+  std::unordered_map<KFunction *, std::unordered_map<KBlock *, KBlock *>>
+      functionPostDominators;
+  std::unordered_map<KFunction *, std::unordered_map<KBlock *, unsigned>>
+      functionLoopDepths;
+
 private:
   void calculateDistance(KBlock *bb);
   void calculateBackwardDistance(KBlock *bb);
@@ -60,6 +65,8 @@ private:
   void calculateFunctionBranches(KFunction *kf);
   void calculateFunctionConditionalBranches(KFunction *kf);
   void calculateFunctionBlocks(KFunction *kf);
+  void calculatePostDominators(KFunction *kf);
+  void calculateLoopDepths(KFunction *kf);
 
 public:
   const BlockDistanceMap &getDistance(KBlock *b);
@@ -77,6 +84,12 @@ public:
   const KBlockMap<std::set<unsigned>> &
   getFunctionConditionalBranches(KFunction *kf);
   const KBlockMap<std::set<unsigned>> &getFunctionBlocks(KFunction *kf);
+
+  /// The block every path from kb to a return of its function passes
+  /// through first, or null if there is none (e.g. several exits).
+  KBlock *getImmediatePostDominator(KBlock *kb);
+  /// The number of natural loops kb is nested in.
+  unsigned getLoopDepth(KBlock *kb);
 };
 
 } // namespace klee
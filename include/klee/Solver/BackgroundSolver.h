@@ -0,0 +1,91 @@
+//===-- BackgroundSolver.h --------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_BACKGROUNDSOLVER_H
+#define KLEE_BACKGROUNDSOLVER_H
+
+#include "klee/ADT/Ref.h"
+#include "klee/Solver/SolverUtil.h"
+#include "klee/System/Time.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace klee {
+class ExpressionLock;
+class Solver;
+
+/// BackgroundSolver - Checks queries on a thread of its own while the
+/// thread that submits them goes on with its work.
+///
+/// Expressions are not thread-safe, so the submitting thread holds the
+/// expression lock for the lifetime of the background solver and has to
+/// call yield() regularly. The background thread only works without the
+/// lock while it is inside the native solver library.
+class BackgroundSolver {
+public:
+  struct Result {
+    std::uint64_t id;
+    /// False if the solver failed, e.g. because it timed out.
+    bool success;
+    ref<SolverResponse> response;
+    /// Time the background thread spent on the query.
+    time::Span solveTime;
+  };
+
+private:
+  struct Task {
+    std::uint64_t id;
+    Query query;
+  };
+
+  std::unique_ptr<Solver> solver;
+  std::unique_ptr<ExpressionLock> expressionLock;
+  std::thread thread;
+
+  std::mutex mutex;
+  std::condition_variable wakeup, answered;
+  std::deque<std::unique_ptr<Task>> tasks;
+  std::vector<std::unique_ptr<Result>> results;
+  std::size_t running = 0;
+  std::uint64_t nextId = 0;
+  bool stopping = false;
+
+  void work();
+
+public:
+  /// Takes the expression lock for the calling thread.
+  explicit BackgroundSolver(std::unique_ptr<Solver> solver);
+  ~BackgroundSolver();
+
+  BackgroundSolver(const BackgroundSolver &) = delete;
+  BackgroundSolver &operator=(const BackgroundSolver &) = delete;
+
+  /// Queue a check of the query. Returns the id its result will carry.
+  std::uint64_t submit(const Query &query);
+
+  /// The number of submitted queries whose results were not collected yet.
+  std::size_t pending();
+
+  /// Append the results of answered queries to out. If wait is set, block
+  /// until there is at least one, unless nothing is pending.
+  void collect(std::vector<Result> &out, bool wait);
+
+  /// Let the background thread take the expression lock if it waits for it.
+  void yield();
+};
+} // namespace klee
+
+#endif /* KLEE_BACKGROUNDSOLVER_H */
@@ -28,6 +28,11 @@ std::unique_ptr<Solver> constructSolverChain(
     std::unique_ptr<Solver> coreSolver, std::string querySMT2LogPath,
     std::string baseSolverQuerySMT2LogPath, std::string queryKQueryLogPath,
     std::string baseSolverQueryKQueryLogPath);
+
+/// constructBackgroundSolverChain - Like constructSolverChain, but without
+/// logging and debugging solvers, for queries checked off the main thread.
+std::unique_ptr<Solver>
+constructBackgroundSolverChain(std::unique_ptr<Solver> coreSolver);
 } // namespace klee
 
 #endif /* KLEE_COMMON_H */
@@ -243,7 +243,11 @@ std::unique_ptr<Solver> createFastCexSolver(std::unique_ptr<Solver> s);
 /// solver.
 ///
 /// \param s - The underlying solver to use.
-std::unique_ptr<Solver> createIndependentSolver(std::unique_ptr<Solver> s);
+/// \param workers - If not empty, independent factors are solved
+/// concurrently, one thread per worker solver.
+std::unique_ptr<Solver> createIndependentSolver(
+    std::unique_ptr<Solver> s,
+    std::vector<std::unique_ptr<Solver>> workers = {});
 
 /// createAlphaEquivalenceSolver - Create a solver which will change
 /// independent queries to their alpha-equvalent version
@@ -33,6 +33,8 @@ extern llvm::cl::opt<bool> UseConcretizingSolver;
 
 extern llvm::cl::opt<bool> UseIndependentSolver;
 
+extern llvm::cl::opt<unsigned> IndependentSolverThreads;
+
 extern llvm::cl::opt<bool> DebugValidateSolver;
 
 extern llvm::cl::opt<std::string> MinQueryTimeToLog;
@@ -47,6 +49,8 @@ extern llvm::cl::opt<bool> UseForkedCoreSolver;
 
 extern llvm::cl::opt<bool> CoreSolverOptimizeDivides;
 
+extern llvm::cl::opt<unsigned> SolverTranslationCacheSize;
+
 extern llvm::cl::opt<bool> UseAssignmentValidatingSolver;
 
 extern llvm::cl::opt<unsigned> MaxSolversApproxTreeInc;
@@ -22,14 +22,28 @@ extern Statistic queriesInvalid;
 extern Statistic queriesValid;
 extern Statistic queryCacheHits;
 extern Statistic queryCacheMisses;
+extern Statistic solverCacheCollisions;
 extern Statistic queryCexCacheHits;
 extern Statistic queryCexCacheMisses;
+extern Statistic cexCacheEvictions;
 extern Statistic queryConstructs;
 extern Statistic queryCounterexamples;
 extern Statistic validQueriesSize;
 extern Statistic validityCoresSize;
 extern Statistic queryValidityCores;
 extern Statistic queryTime;
+extern Statistic queryTranslationTime;
+extern Statistic queryCheckTime;
+extern Statistic translationCacheHits;
+extern Statistic translationCacheEvictions;
+extern Statistic independentFactors;
+extern Statistic independentFactorTime;
+extern Statistic independentParallelTime;
+extern Statistic independentCriticalPathTime;
+extern Statistic factorCacheHits;
+extern Statistic factorCacheMisses;
+extern Statistic alphaCacheHits;
+extern Statistic alphaCacheTimeSaved;
 
 #ifdef KLEE_ARRAY_DEBUG
 extern Statistic arrayHashTime;
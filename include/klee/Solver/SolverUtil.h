@@ -39,10 +39,30 @@ using PValidity = PartialValidity;
 // Backward compatiblilty
 enum class Validity { True = 1, False = -1, Unknown = 0 };
 
+/// Cheap features of a query from which its solve time is predicted.
+struct QueryFeatures {
+  enum Kind : std::uint8_t { Validity, Value, InitialValues, Check };
+
+  Kind kind = Validity;
+  /// Constraints on the path.
+  std::uint32_t constraints = 0;
+  /// Constraints in the independent factors the query depends on.
+  std::uint32_t factorConstraints = 0;
+  /// Arrays read by the query and its factors.
+  std::uint32_t arrays = 0;
+  /// Multiplications, divisions and remainders of two symbolic operands.
+  std::uint32_t nonlinear = 0;
+};
+
 struct SolverQueryMetaData {
   /// @brief Costs for all queries issued for this state
   time::Span queryCost;
 
+  /// @brief Features and predicted cost of the last query issued for this
+  /// state, only set while query costs are predicted
+  QueryFeatures lastQuery;
+  time::Span predictedCost;
+
   /// @brief Caller state id
   std::uint32_t id = 0;
 };
@@ -265,6 +285,15 @@ public:
     return true;
   }
 
+  /// Whether all objects are bound, rather than defaulted to zeros by
+  /// tryGetInitialValuesFor.
+  bool bindsAll(const std::vector<const Array *> &objects) const {
+    for (auto object : objects)
+      if (!result.bindings.count(object))
+        return false;
+    return true;
+  }
+
   Assignment initialValuesFor(const std::vector<const Array *> objects) const {
     std::vector<SparseStorageImpl<unsigned char>> values;
     std::ignore = tryGetInitialValuesFor(objects, values);
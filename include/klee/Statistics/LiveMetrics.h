@@ -0,0 +1,95 @@
+//===-- LiveMetrics.h -------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_LIVEMETRICS_H
+#define KLEE_LIVEMETRICS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace klee {
+
+/// Histograms exported next to the statistics.
+enum class LiveHistogram : unsigned {
+  QueryTime,        ///< microseconds per constraint solver query
+  ForkRate,         ///< forks per second, sampled at each update
+  States,           ///< number of states, sampled at each update
+  Memory,           ///< memory usage in MiB, sampled at each update
+  CexCacheLookup,   ///< nanoseconds per counterexample cache lookup
+  SpeculativeQueue, ///< background solver queue depth, sampled at each fork
+};
+
+/// LiveMetrics - Mirrors the StatisticManager into a shared memory page
+/// (/dev/shm/klee-live-<pid>) that other processes, e.g. `klee-stats --live`,
+/// can map and poll without any disk I/O.
+///
+/// Statistics are copied into the page by update() under a sequence lock.
+/// Histograms use power-of-two buckets and are recorded directly into the
+/// page with relaxed atomic increments.
+class LiveMetrics {
+public:
+  static constexpr unsigned NumHistograms = 6;
+  static constexpr unsigned NumBuckets = 64;
+
+private:
+  static LiveMetrics *instance;
+
+  struct Page;
+  Page *page;
+  std::size_t size;
+  std::string name;
+
+  LiveMetrics(Page *page, std::size_t size, std::string name);
+
+public:
+  ~LiveMetrics();
+
+  LiveMetrics(const LiveMetrics &) = delete;
+  LiveMetrics &operator=(const LiveMetrics &) = delete;
+
+  /// Create the shared page for a run writing to outputDirectory. Returns
+  /// null on failure.
+  static LiveMetrics *open(const std::string &outputDirectory);
+
+  /// Return the open page, or null if live metrics are disabled.
+  static LiveMetrics *get() { return instance; }
+
+  /// Remove the shared page.
+  static void close();
+
+  /// Name of the shared memory object, as passed to shm_open.
+  const std::string &getName() const { return name; }
+
+  void record(LiveHistogram histogram, std::uint64_t value);
+
+  /// Copy the current value of all statistics into the page.
+  void update();
+};
+
+/// LiveHistogramTimer - Records its lifetime in microseconds into a
+/// histogram, if live metrics are enabled.
+class LiveHistogramTimer {
+  const std::chrono::steady_clock::time_point start;
+  const LiveHistogram histogram;
+
+public:
+  explicit LiveHistogramTimer(LiveHistogram histogram)
+      : start(std::chrono::steady_clock::now()), histogram(histogram) {}
+  ~LiveHistogramTimer() {
+    if (LiveMetrics *metrics = LiveMetrics::get())
+      metrics->record(histogram,
+                      std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count());
+  }
+};
+} // namespace klee
+
+#endif /* KLEE_LIVEMETRICS_H */
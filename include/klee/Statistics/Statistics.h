@@ -43,20 +43,32 @@ private:
   std::vector<Statistic *> stats;
   uint64_t *globalStats;
   uint64_t *indexedStats;
-  StatisticRecord *contextStats;
+  /// The statistics of each context (e.g. call path), one row per context.
+  std::vector<uint64_t> contextStats;
+  unsigned context;
   unsigned index;
+  /// Whether increments of the current thread are counted by index and
+  /// context. The index belongs to the interpreter, so threads running
+  /// alongside it only count globally.
+  static inline thread_local bool threadIndexed = true;
 
 public:
+  /// The context of increments that are only counted globally and by index.
+  static constexpr unsigned NoContext = ~0u;
+
   StatisticManager();
   ~StatisticManager();
 
   void useIndexedStats(unsigned totalIndices);
 
-  StatisticRecord *getContext();
-  void setContext(StatisticRecord *sr); /* null to reset */
+  /// Add a context with all statistics zero and return it.
+  unsigned addContext();
+  unsigned getContext() { return context; }
+  void setContext(unsigned c) { context = c; }
 
   void setIndex(unsigned i) { index = i; }
   unsigned getIndex() { return index; }
+  static void setThreadIndexed(bool indexed) { threadIndexed = indexed; }
   unsigned getNumStatistics() { return stats.size(); }
   Statistic &getStatistic(unsigned i) { return *stats[i]; }
 
@@ -67,6 +79,9 @@ public:
                              uint64_t addend) const;
   uint64_t getIndexedValue(const Statistic &s, unsigned index) const;
   void setIndexedValue(const Statistic &s, unsigned index, uint64_t value);
+  void incrementContextValue(const Statistic &s, unsigned context,
+                             uint64_t addend);
+  uint64_t getContextValue(const Statistic &s, unsigned context) const;
   int getStatisticID(const std::string &name) const;
   Statistic *getStatisticByName(const std::string &name) const;
 };
@@ -77,19 +92,14 @@ inline void StatisticManager::incrementStatistic(Statistic &s,
                                                  uint64_t addend) {
   if (enabled) {
     globalStats[s.id] += addend;
-    if (indexedStats) {
+    if (indexedStats && threadIndexed) {
       indexedStats[index * stats.size() + s.id] += addend;
-      if (contextStats)
-        contextStats->data[s.id] += addend;
+      if (context != NoContext)
+        contextStats[context * stats.size() + s.id] += addend;
     }
   }
 }
 
-inline StatisticRecord *StatisticManager::getContext() { return contextStats; }
-inline void StatisticManager::setContext(StatisticRecord *sr) {
-  contextStats = sr;
-}
-
 inline void StatisticRecord::zero() {
   ::memset(data, 0, sizeof(*data) * theStatisticManager->getNumStatistics());
 }
@@ -145,6 +155,17 @@ inline void StatisticManager::setIndexedValue(const Statistic &s,
                                               unsigned index, uint64_t value) {
   indexedStats[index * stats.size() + s.id] = value;
 }
+
+inline void StatisticManager::incrementContextValue(const Statistic &s,
+                                                    unsigned context,
+                                                    uint64_t addend) {
+  contextStats[context * stats.size() + s.id] += addend;
+}
+
+inline uint64_t StatisticManager::getContextValue(const Statistic &s,
+                                                  unsigned context) const {
+  return contextStats[context * stats.size() + s.id];
+}
 } // namespace klee
 
 #endif /* KLEE_STATISTICS_H */
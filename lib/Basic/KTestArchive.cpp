@@ -0,0 +1,668 @@
+//===-- KTestArchive.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/ADT/KTest.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// An archive is a pair of files: the data file holds a header followed by
+// appended records, the index file (data path + ".idx") holds the data file
+// offsets of all test records in the order they were appended.
+//
+// data file:  "KTESTARC" version:u32 record*
+// record:     kind:u8 length:u32 payload[length]
+// test:       numArgs:u32 string* symArgvs:u32 symArgvLen:u32 numObjects:u32
+//             object*
+// object:     name:string address:u64 numBytes:u32 storage:u8
+//             (bytes[numBytes] | blobOffset:u64) numPointers:u32
+//             (offset:u64 index:u64 indexOffset:u64)*
+// blob:       bytes[length]
+// file:       name:string bytes[]
+// index file: "KTESTIDX" version:u32 reserved:u32 testOffset:u64*
+//
+// All integers are big-endian, as in .ktest files.
+
+#define KTEST_ARCHIVE_VERSION 1
+#define KTEST_ARCHIVE_MAGIC "KTESTARC"
+#define KTEST_ARCHIVE_INDEX_MAGIC "KTESTIDX"
+#define KTEST_ARCHIVE_MAGIC_SIZE 8
+#define KTEST_ARCHIVE_HEADER_SIZE (KTEST_ARCHIVE_MAGIC_SIZE + 4)
+#define KTEST_ARCHIVE_INDEX_HEADER_SIZE (KTEST_ARCHIVE_MAGIC_SIZE + 8)
+#define KTEST_ARCHIVE_RECORD_HEADER_SIZE 5
+#define KTEST_ARCHIVE_INDEX_SUFFIX ".idx"
+
+#define RECORD_TEST 'T'
+#define RECORD_BLOB 'B'
+#define RECORD_FILE 'F'
+
+#define OBJECT_INLINE 0
+#define OBJECT_BLOB 1
+
+// Objects smaller than this are always stored inline, as a blob reference
+// plus the blob record header would not be any smaller.
+#define MIN_DEDUPLICATED_SIZE 32
+
+struct KTestArchive {
+  const unsigned char *data;
+  size_t size;
+
+  /* mapped index file, may be NULL */
+  const unsigned char *index;
+  size_t indexSize;
+  unsigned numIndexed;
+
+  /* test records appended after the last indexed one */
+  std::vector<uint64_t> unindexed;
+};
+
+struct KTestArchiveWriter {
+  FILE *data;
+  FILE *index;
+  uint64_t end;
+  int deduplicate;
+
+  /* content hash -> offsets of blob records */
+  std::unordered_multimap<uint64_t, uint64_t> blobs;
+};
+
+/***/
+
+static uint32_t decode_uint32(const unsigned char *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint64_t decode_uint64(const unsigned char *p) {
+  return ((uint64_t)decode_uint32(p) << 32) | decode_uint32(p + 4);
+}
+
+static void put_uint8(std::vector<unsigned char> &buf, unsigned char value) {
+  buf.push_back(value);
+}
+
+static void put_uint32(std::vector<unsigned char> &buf, uint32_t value) {
+  buf.push_back(value >> 24);
+  buf.push_back(value >> 16);
+  buf.push_back(value >> 8);
+  buf.push_back(value >> 0);
+}
+
+static void put_uint64(std::vector<unsigned char> &buf, uint64_t value) {
+  put_uint32(buf, value >> 32);
+  put_uint32(buf, value);
+}
+
+static void put_bytes(std::vector<unsigned char> &buf,
+                      const unsigned char *bytes, size_t n) {
+  buf.insert(buf.end(), bytes, bytes + n);
+}
+
+static void put_string(std::vector<unsigned char> &buf, const char *value) {
+  unsigned len = strlen(value);
+  put_uint32(buf, len);
+  put_bytes(buf, (const unsigned char *)value, len);
+}
+
+static uint64_t hash_bytes(const unsigned char *bytes, size_t n) {
+  // FNV-1a
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < n; ++i) {
+    h ^= bytes[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+/* Bounds-checked reader over a mapped memory range */
+namespace {
+struct Cursor {
+  const unsigned char *pos;
+  const unsigned char *end;
+
+  const unsigned char *take(size_t n) {
+    if ((size_t)(end - pos) < n)
+      return 0;
+    const unsigned char *res = pos;
+    pos += n;
+    return res;
+  }
+};
+} // namespace
+
+static int get_uint8(Cursor *c, unsigned char *value_out) {
+  const unsigned char *p = c->take(1);
+  if (!p)
+    return 0;
+  *value_out = *p;
+  return 1;
+}
+
+static int get_uint32(Cursor *c, unsigned *value_out) {
+  const unsigned char *p = c->take(4);
+  if (!p)
+    return 0;
+  *value_out = decode_uint32(p);
+  return 1;
+}
+
+static int get_uint64(Cursor *c, uint64_t *value_out) {
+  const unsigned char *p = c->take(8);
+  if (!p)
+    return 0;
+  *value_out = decode_uint64(p);
+  return 1;
+}
+
+static int get_string(Cursor *c, char **value_out) {
+  unsigned len;
+  const unsigned char *p;
+  if (!get_uint32(c, &len) || !(p = c->take(len)))
+    return 0;
+  *value_out = (char *)malloc(len + 1);
+  if (!*value_out)
+    return 0;
+  memcpy(*value_out, p, len);
+  (*value_out)[len] = 0;
+  return 1;
+}
+
+static int skip_string(Cursor *c) {
+  unsigned len;
+  return get_uint32(c, &len) && c->take(len);
+}
+
+/***/
+
+/* Locate the payload of the record at `offset`, checking its kind */
+static int kTestArchive_getRecord(const KTestArchive *a, uint64_t offset,
+                                  unsigned char kind, Cursor *payload) {
+  if (offset < KTEST_ARCHIVE_HEADER_SIZE || offset > a->size)
+    return 0;
+  Cursor c = {a->data + offset, a->data + a->size};
+  unsigned char k;
+  unsigned len;
+  const unsigned char *p;
+  if (!get_uint8(&c, &k) || k != kind || !get_uint32(&c, &len) ||
+      !(p = c.take(len)))
+    return 0;
+  payload->pos = p;
+  payload->end = p + len;
+  return 1;
+}
+
+/* Decode the storage of an object, returning a pointer into the mapping */
+static const unsigned char *kTestArchive_getBytes(const KTestArchive *a,
+                                                  Cursor *c,
+                                                  unsigned numBytes) {
+  unsigned char storage;
+  if (!get_uint8(c, &storage))
+    return 0;
+  if (storage == OBJECT_INLINE)
+    return c->take(numBytes);
+  if (storage != OBJECT_BLOB)
+    return 0;
+  uint64_t blobOffset;
+  Cursor blob;
+  if (!get_uint64(c, &blobOffset) ||
+      !kTestArchive_getRecord(a, blobOffset, RECORD_BLOB, &blob) ||
+      (size_t)(blob.end - blob.pos) != numBytes)
+    return 0;
+  return blob.pos;
+}
+
+static int kTestArchive_getTestRecord(const KTestArchive *a, unsigned index,
+                                      Cursor *payload) {
+  uint64_t offset;
+  if (index < a->numIndexed) {
+    offset = decode_uint64(a->index + KTEST_ARCHIVE_INDEX_HEADER_SIZE +
+                           (size_t)index * 8);
+  } else if (index - a->numIndexed < a->unindexed.size()) {
+    offset = a->unindexed[index - a->numIndexed];
+  } else {
+    return 0;
+  }
+  return kTestArchive_getRecord(a, offset, RECORD_TEST, payload);
+}
+
+static int kTestArchive_checkHeader(const unsigned char *header) {
+  return memcmp(header, KTEST_ARCHIVE_MAGIC, KTEST_ARCHIVE_MAGIC_SIZE) == 0 &&
+         decode_uint32(header + KTEST_ARCHIVE_MAGIC_SIZE) <=
+             KTEST_ARCHIVE_VERSION;
+}
+
+static const unsigned char *map_file(const char *path, size_t *size_out) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+  struct stat st;
+  void *res = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    res = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    *size_out = st.st_size;
+  }
+  close(fd);
+  return res == MAP_FAILED ? 0 : (const unsigned char *)res;
+}
+
+int kTestArchive_isArchiveFile(const char *path) {
+  FILE *f = fopen(path, "rb");
+  unsigned char header[KTEST_ARCHIVE_HEADER_SIZE];
+  int res;
+
+  if (!f)
+    return 0;
+  res = fread(header, KTEST_ARCHIVE_HEADER_SIZE, 1, f) == 1 &&
+        kTestArchive_checkHeader(header);
+  fclose(f);
+
+  return res;
+}
+
+KTestArchive *kTestArchive_open(const char *path) {
+  size_t size = 0;
+  const unsigned char *data = map_file(path, &size);
+  if (!data)
+    return 0;
+  if (size < KTEST_ARCHIVE_HEADER_SIZE || !kTestArchive_checkHeader(data)) {
+    munmap((void *)data, size);
+    return 0;
+  }
+
+  KTestArchive *a = new KTestArchive();
+  a->data = data;
+  a->size = size;
+
+  std::string indexPath = std::string(path) + KTEST_ARCHIVE_INDEX_SUFFIX;
+  a->index = map_file(indexPath.c_str(), &a->indexSize);
+  if (a->index && (a->indexSize < KTEST_ARCHIVE_INDEX_HEADER_SIZE ||
+                   memcmp(a->index, KTEST_ARCHIVE_INDEX_MAGIC,
+                          KTEST_ARCHIVE_MAGIC_SIZE) != 0)) {
+    munmap((void *)a->index, a->indexSize);
+    a->index = 0;
+  }
+
+  // Trust the index up to the last entry that still points into the data
+  // file; a crash between appending a record and its index entry leaves
+  // records behind the last indexed one, which are found by scanning.
+  uint64_t scanFrom = KTEST_ARCHIVE_HEADER_SIZE;
+  if (a->index) {
+    a->numIndexed = (a->indexSize - KTEST_ARCHIVE_INDEX_HEADER_SIZE) / 8;
+    for (; a->numIndexed; --a->numIndexed) {
+      Cursor last;
+      if (kTestArchive_getTestRecord(a, a->numIndexed - 1, &last)) {
+        scanFrom = last.end - a->data;
+        break;
+      }
+    }
+  }
+
+  Cursor c = {a->data + scanFrom, a->data + a->size};
+  while (c.pos != c.end) {
+    uint64_t offset = c.pos - a->data;
+    unsigned char kind;
+    unsigned len;
+    if (!get_uint8(&c, &kind) || !get_uint32(&c, &len) || !c.take(len))
+      break; // truncated record
+    if (kind == RECORD_TEST)
+      a->unindexed.push_back(offset);
+  }
+
+  return a;
+}
+
+unsigned kTestArchive_numTests(const KTestArchive *a) {
+  return a->numIndexed + a->unindexed.size();
+}
+
+KTest *kTestArchive_getTest(const KTestArchive *a, unsigned index) {
+  Cursor c;
+  KTest *res = 0;
+  unsigned i, j;
+
+  if (!kTestArchive_getTestRecord(a, index, &c))
+    goto error;
+
+  res = (KTest *)calloc(1, sizeof(*res));
+  if (!res)
+    goto error;
+  res->version = kTest_getCurrentVersion();
+
+  if (!get_uint32(&c, &res->numArgs))
+    goto error;
+  res->args = (char **)calloc(res->numArgs, sizeof(*res->args));
+  if (!res->args)
+    goto error;
+  for (i = 0; i < res->numArgs; i++)
+    if (!get_string(&c, &res->args[i]))
+      goto error;
+
+  if (!get_uint32(&c, &res->symArgvs))
+    goto error;
+  if (!get_uint32(&c, &res->symArgvLen))
+    goto error;
+
+  if (!get_uint32(&c, &res->numObjects))
+    goto error;
+  res->objects = (KTestObject *)calloc(res->numObjects, sizeof(*res->objects));
+  if (!res->objects)
+    goto error;
+  for (i = 0; i < res->numObjects; i++) {
+    KTestObject *o = &res->objects[i];
+    const unsigned char *bytes;
+    if (!get_string(&c, &o->name))
+      goto error;
+    if (!get_uint64(&c, &o->address))
+      goto error;
+    if (!get_uint32(&c, &o->numBytes))
+      goto error;
+    if (!(bytes = kTestArchive_getBytes(a, &c, o->numBytes)))
+      goto error;
+    o->bytes = (unsigned char *)malloc(o->numBytes);
+    if (o->numBytes && !o->bytes)
+      goto error;
+    memcpy(o->bytes, bytes, o->numBytes);
+    if (!get_uint32(&c, &o->numPointers))
+      goto error;
+    o->pointers = (Pointer *)calloc(o->numPointers, sizeof(*o->pointers));
+    if (o->numPointers && !o->pointers)
+      goto error;
+    for (j = 0; j < o->numPointers; j++) {
+      Pointer *p = &o->pointers[j];
+      if (!get_uint64(&c, &p->offset))
+        goto error;
+      if (!get_uint64(&c, &p->index))
+        goto error;
+      if (!get_uint64(&c, &p->indexOffset))
+        goto error;
+    }
+  }
+
+  return res;
+error:
+  if (res) {
+    if (res->args) {
+      for (i = 0; i < res->numArgs; i++)
+        free(res->args[i]);
+      free(res->args);
+    }
+    if (res->objects) {
+      for (i = 0; i < res->numObjects; i++) {
+        free(res->objects[i].name);
+        free(res->objects[i].bytes);
+        free(res->objects[i].pointers);
+      }
+      free(res->objects);
+    }
+    free(res);
+  }
+
+  return 0;
+}
+
+const unsigned char *kTestArchive_getObjectBytes(const KTestArchive *a,
+                                                 unsigned index,
+                                                 unsigned object,
+                                                 unsigned *numBytes) {
+  Cursor c;
+  unsigned i, numArgs, numObjects, numPointers, dummy;
+  uint64_t address;
+
+  if (!kTestArchive_getTestRecord(a, index, &c) || !get_uint32(&c, &numArgs))
+    return 0;
+  for (i = 0; i < numArgs; i++)
+    if (!skip_string(&c))
+      return 0;
+  if (!get_uint32(&c, &dummy) || !get_uint32(&c, &dummy) ||
+      !get_uint32(&c, &numObjects) || object >= numObjects)
+    return 0;
+
+  for (i = 0;; i++) {
+    const unsigned char *bytes;
+    if (!skip_string(&c) || !get_uint64(&c, &address) ||
+        !get_uint32(&c, numBytes) ||
+        !(bytes = kTestArchive_getBytes(a, &c, *numBytes)))
+      return 0;
+    if (i == object)
+      return bytes;
+    if (!get_uint32(&c, &numPointers) || !c.take((size_t)numPointers * 24))
+      return 0;
+  }
+}
+
+void kTestArchive_close(KTestArchive *a) {
+  munmap((void *)a->data, a->size);
+  if (a->index)
+    munmap((void *)a->index, a->indexSize);
+  delete a;
+}
+
+/***/
+
+static int write_record(KTestArchiveWriter *w, unsigned char kind,
+                        const std::vector<unsigned char> &payload) {
+  std::vector<unsigned char> header;
+  put_uint8(header, kind);
+  put_uint32(header, payload.size());
+  if (fwrite(header.data(), header.size(), 1, w->data) != 1 ||
+      (!payload.empty() &&
+       fwrite(payload.data(), payload.size(), 1, w->data) != 1))
+    return 0;
+  w->end += header.size() + payload.size();
+  return 1;
+}
+
+static int write_index_entry(KTestArchiveWriter *w, uint64_t offset) {
+  std::vector<unsigned char> entry;
+  put_uint64(entry, offset);
+  return fwrite(entry.data(), entry.size(), 1, w->index) == 1;
+}
+
+/* Return the offset of a blob record holding `bytes`, appending one if the
+   archive does not contain such a blob yet. Returns 0 on error. */
+static uint64_t get_or_write_blob(KTestArchiveWriter *w,
+                                  const unsigned char *bytes, unsigned n) {
+  uint64_t hash = hash_bytes(bytes, n);
+  auto range = w->blobs.equal_range(hash);
+  if (range.first != range.second) {
+    std::vector<unsigned char> existing(KTEST_ARCHIVE_RECORD_HEADER_SIZE + n);
+    fflush(w->data);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (pread(fileno(w->data), existing.data(), existing.size(),
+                it->second) == (ssize_t)existing.size() &&
+          decode_uint32(existing.data() + 1) == n &&
+          memcmp(existing.data() + KTEST_ARCHIVE_RECORD_HEADER_SIZE, bytes,
+                 n) == 0)
+        return it->second;
+    }
+  }
+
+  uint64_t offset = w->end;
+  std::vector<unsigned char> payload(bytes, bytes + n);
+  if (!write_record(w, RECORD_BLOB, payload))
+    return 0;
+  w->blobs.emplace(hash, offset);
+  return offset;
+}
+
+/* Rebuild the writer state (end offset, blob table, index) of an existing
+   archive. */
+static int kTestArchiveWriter_load(KTestArchiveWriter *w, const char *path,
+                                   const char *indexPath) {
+  KTestArchive *a = kTestArchive_open(path);
+  if (!a)
+    return 0;
+  // Drop a record that was only partially written, so that new records
+  // are not appended behind it.
+  Cursor c = {a->data + KTEST_ARCHIVE_HEADER_SIZE, a->data + a->size};
+  while (c.pos != c.end) {
+    uint64_t offset = c.pos - a->data;
+    unsigned char kind;
+    unsigned len;
+    const unsigned char *p;
+    if (!get_uint8(&c, &kind) || !get_uint32(&c, &len) ||
+        !(p = c.take(len)))
+      break;
+    if (w->deduplicate && kind == RECORD_BLOB)
+      w->blobs.emplace(hash_bytes(p, len), offset);
+    w->end = c.pos - a->data;
+  }
+  if (w->end < KTEST_ARCHIVE_HEADER_SIZE)
+    w->end = KTEST_ARCHIVE_HEADER_SIZE;
+  if (w->end != a->size &&
+      (ftruncate(fileno(w->data), w->end) != 0 ||
+       fseek(w->data, 0, SEEK_END) != 0)) {
+    kTestArchive_close(a);
+    return 0;
+  }
+
+  // Append the entries of records that were never indexed, rewriting the
+  // index from scratch if it is missing or damaged.
+  unsigned numTests = kTestArchive_numTests(a);
+  unsigned from = a->numIndexed;
+  int ok = 1;
+  if (!a->index) {
+    from = 0;
+    fclose(w->index);
+    std::vector<unsigned char> header(KTEST_ARCHIVE_INDEX_MAGIC,
+                                      KTEST_ARCHIVE_INDEX_MAGIC +
+                                          KTEST_ARCHIVE_MAGIC_SIZE);
+    put_uint32(header, KTEST_ARCHIVE_VERSION);
+    put_uint32(header, 0);
+    w->index = fopen(indexPath, "wb");
+    ok = w->index && fwrite(header.data(), header.size(), 1, w->index) == 1;
+  } else if ((a->indexSize - KTEST_ARCHIVE_INDEX_HEADER_SIZE) / 8 !=
+             a->numIndexed) {
+    fclose(w->index);
+    ok = truncate(indexPath, KTEST_ARCHIVE_INDEX_HEADER_SIZE +
+                                 (off_t)a->numIndexed * 8) == 0;
+    w->index = fopen(indexPath, "ab");
+    ok = ok && w->index && fseek(w->index, 0, SEEK_END) == 0;
+  }
+  for (unsigned i = from; ok && i < numTests; ++i) {
+    Cursor c;
+    ok = kTestArchive_getTestRecord(a, i, &c) &&
+         write_index_entry(w, c.pos - KTEST_ARCHIVE_RECORD_HEADER_SIZE -
+                                  a->data);
+  }
+
+  kTestArchive_close(a);
+  return ok && fflush(w->index) == 0;
+}
+
+KTestArchiveWriter *kTestArchiveWriter_open(const char *path,
+                                            int deduplicate) {
+  std::string indexPath = std::string(path) + KTEST_ARCHIVE_INDEX_SUFFIX;
+  KTestArchiveWriter *w = new KTestArchiveWriter();
+  w->deduplicate = deduplicate;
+  // The data file is also read back to compare deduplication candidates.
+  w->data = fopen(path, "a+b");
+  w->index = fopen(indexPath.c_str(), "ab");
+  if (!w->data || !w->index || fseek(w->data, 0, SEEK_END) != 0 ||
+      fseek(w->index, 0, SEEK_END) != 0)
+    goto error;
+
+  if (ftell(w->data) == 0) {
+    std::vector<unsigned char> header(KTEST_ARCHIVE_MAGIC,
+                                      KTEST_ARCHIVE_MAGIC +
+                                          KTEST_ARCHIVE_MAGIC_SIZE);
+    put_uint32(header, KTEST_ARCHIVE_VERSION);
+    if (fwrite(header.data(), header.size(), 1, w->data) != 1 ||
+        fflush(w->data) != 0)
+      goto error;
+    w->end = header.size();
+  } else if (!kTestArchiveWriter_load(w, path, indexPath.c_str())) {
+    goto error;
+  }
+
+  if (ftell(w->index) == 0) {
+    std::vector<unsigned char> header(KTEST_ARCHIVE_INDEX_MAGIC,
+                                      KTEST_ARCHIVE_INDEX_MAGIC +
+                                          KTEST_ARCHIVE_MAGIC_SIZE);
+    put_uint32(header, KTEST_ARCHIVE_VERSION);
+    put_uint32(header, 0);
+    if (fwrite(header.data(), header.size(), 1, w->index) != 1 ||
+        fflush(w->index) != 0)
+      goto error;
+  }
+
+  return w;
+error:
+  if (w->data)
+    fclose(w->data);
+  if (w->index)
+    fclose(w->index);
+  delete w;
+  return 0;
+}
+
+int kTestArchiveWriter_append(KTestArchiveWriter *w, const KTest *bo) {
+  std::vector<unsigned char> payload;
+  unsigned i, j;
+
+  put_uint32(payload, bo->numArgs);
+  for (i = 0; i < bo->numArgs; i++)
+    put_string(payload, bo->args[i]);
+  put_uint32(payload, bo->symArgvs);
+  put_uint32(payload, bo->symArgvLen);
+
+  put_uint32(payload, bo->numObjects);
+  for (i = 0; i < bo->numObjects; i++) {
+    KTestObject *o = &bo->objects[i];
+    put_string(payload, o->name);
+    put_uint64(payload, o->address);
+    put_uint32(payload, o->numBytes);
+    if (w->deduplicate && o->numBytes >= MIN_DEDUPLICATED_SIZE) {
+      uint64_t blobOffset = get_or_write_blob(w, o->bytes, o->numBytes);
+      if (!blobOffset)
+        return 0;
+      put_uint8(payload, OBJECT_BLOB);
+      put_uint64(payload, blobOffset);
+    } else {
+      put_uint8(payload, OBJECT_INLINE);
+      put_bytes(payload, o->bytes, o->numBytes);
+    }
+    put_uint32(payload, o->numPointers);
+    for (j = 0; j < o->numPointers; j++) {
+      put_uint64(payload, o->pointers[j].offset);
+      put_uint64(payload, o->pointers[j].index);
+      put_uint64(payload, o->pointers[j].indexOffset);
+    }
+  }
+
+  uint64_t offset = w->end;
+  return write_record(w, RECORD_TEST, payload) && fflush(w->data) == 0 &&
+         write_index_entry(w, offset) && fflush(w->index) == 0;
+}
+
+int kTestArchiveWriter_appendFile(KTestArchiveWriter *w, const char *name,
+                                  const unsigned char *bytes,
+                                  unsigned numBytes) {
+  std::vector<unsigned char> payload;
+  put_string(payload, name);
+  put_bytes(payload, bytes, numBytes);
+  return write_record(w, RECORD_FILE, payload) && fflush(w->data) == 0;
+}
+
+void kTestArchiveWriter_close(KTestArchiveWriter *w) {
+  fclose(w->data);
+  fclose(w->index);
+  delete w;
+}
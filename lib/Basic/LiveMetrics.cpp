@@ -0,0 +1,166 @@
+//===-- LiveMetrics.cpp ---------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Statistics/LiveMetrics.h"
+
+#include "klee/Statistics/Statistics.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace klee;
+
+// Layout of the shared page; readers (tools/klee-stats) decode it with the
+// same field order. All fields are native-endian.
+namespace {
+constexpr char Magic[8] = {'K', 'L', 'E', 'E', 'L', 'I', 'V', 'E'};
+constexpr std::uint32_t Version = 1;
+constexpr unsigned NameSize = 48;
+constexpr unsigned PathSize = 4096;
+
+const char *histogramNames[LiveMetrics::NumHistograms] = {
+    "QueryTime", "ForkRate", "States", "Memory", "CexCacheLookup",
+    "SpeculativeQueue"};
+
+struct StatisticSlot {
+  char name[NameSize];
+  std::atomic<std::uint64_t> value;
+};
+
+struct HistogramSlot {
+  char name[NameSize];
+  std::atomic<std::uint64_t> count;
+  std::atomic<std::uint64_t> sum;
+  std::atomic<std::uint64_t> last;
+  std::atomic<std::uint64_t> max;
+  /// bucket i counts values in [2^(i-1), 2^i), bucket 0 counts zeros
+  std::atomic<std::uint64_t> buckets[LiveMetrics::NumBuckets];
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "shared memory counters must be lock-free");
+} // namespace
+
+struct LiveMetrics::Page {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t pid;
+  std::uint32_t numStatistics;
+  std::uint32_t numHistograms;
+  std::uint32_t numBuckets;
+  std::uint32_t nameSize;
+  /// odd while update() is copying statistics
+  std::atomic<std::uint64_t> sequence;
+  /// microseconds since the epoch of the last update()
+  std::atomic<std::uint64_t> updateTime;
+  char outputDirectory[PathSize];
+  HistogramSlot histograms[NumHistograms];
+
+  /// followed by numStatistics slots
+  StatisticSlot *statistics() {
+    return reinterpret_cast<StatisticSlot *>(this + 1);
+  }
+};
+
+LiveMetrics *LiveMetrics::instance = nullptr;
+
+LiveMetrics::LiveMetrics(Page *page, std::size_t size, std::string name)
+    : page(page), size(size), name(std::move(name)) {}
+
+LiveMetrics::~LiveMetrics() {
+  munmap(page, size);
+  shm_unlink(name.c_str());
+}
+
+LiveMetrics *LiveMetrics::open(const std::string &outputDirectory) {
+  if (instance)
+    return instance;
+
+  unsigned numStatistics = theStatisticManager->getNumStatistics();
+  std::size_t size = sizeof(Page) + numStatistics * sizeof(StatisticSlot);
+  std::string name = "/klee-live-" + std::to_string(getpid());
+
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return nullptr;
+  void *mem = MAP_FAILED;
+  if (ftruncate(fd, size) == 0)
+    mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mem == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  // the page is zero-filled, which is a valid initial state for all fields
+  Page *page = static_cast<Page *>(mem);
+  memcpy(page->magic, Magic, sizeof(Magic));
+  page->version = Version;
+  page->pid = getpid();
+  page->numStatistics = numStatistics;
+  page->numHistograms = NumHistograms;
+  page->numBuckets = NumBuckets;
+  page->nameSize = NameSize;
+  strncpy(page->outputDirectory, outputDirectory.c_str(), PathSize - 1);
+  for (unsigned i = 0; i != NumHistograms; ++i)
+    strncpy(page->histograms[i].name, histogramNames[i], NameSize - 1);
+  for (unsigned i = 0; i != numStatistics; ++i)
+    strncpy(page->statistics()[i].name,
+            theStatisticManager->getStatistic(i).getName().c_str(),
+            NameSize - 1);
+
+  instance = new LiveMetrics(page, size, name);
+  instance->update();
+  return instance;
+}
+
+void LiveMetrics::close() {
+  delete instance;
+  instance = nullptr;
+}
+
+void LiveMetrics::record(LiveHistogram histogram, std::uint64_t value) {
+  HistogramSlot &h = page->histograms[static_cast<unsigned>(histogram)];
+  unsigned bucket = value ? 64 - __builtin_clzll(value) : 0;
+  if (bucket >= NumBuckets)
+    bucket = NumBuckets - 1;
+
+  h.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  h.sum.fetch_add(value, std::memory_order_relaxed);
+  h.last.store(value, std::memory_order_relaxed);
+  std::uint64_t max = h.max.load(std::memory_order_relaxed);
+  while (value > max &&
+         !h.max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+    ;
+  h.count.fetch_add(1, std::memory_order_release);
+}
+
+void LiveMetrics::update() {
+  std::uint64_t seq = page->sequence.load(std::memory_order_relaxed);
+  page->sequence.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  for (unsigned i = 0; i != page->numStatistics; ++i)
+    page->statistics()[i].value.store(
+        theStatisticManager->getStatistic(i).getValue(),
+        std::memory_order_relaxed);
+  page->updateTime.store(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count(),
+      std::memory_order_relaxed);
+
+  page->sequence.store(seq + 2, std::memory_order_release);
+}
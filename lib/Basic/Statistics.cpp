@@ -14,7 +14,7 @@
 using namespace klee;
 
 StatisticManager::StatisticManager()
-    : enabled(true), globalStats(0), indexedStats(0), contextStats(0),
+    : enabled(true), globalStats(0), indexedStats(0), context(NoContext),
       index(0) {}
 
 StatisticManager::~StatisticManager() {
@@ -28,6 +28,12 @@ void StatisticManager::useIndexedStats(unsigned totalIndices) {
   memset(indexedStats, 0, sizeof(*indexedStats) * totalIndices * stats.size());
 }
 
+unsigned StatisticManager::addContext() {
+  unsigned c = contextStats.size() / stats.size();
+  contextStats.resize(contextStats.size() + stats.size(), 0);
+  return c;
+}
+
 void StatisticManager::registerStatistic(Statistic &s) {
   delete[] globalStats;
   s.id = stats.size();
@@ -11,6 +11,8 @@
 
 #include "ExecutionState.h"
 #include "Memory.h"
+#include "MemoryManager.h"
+#include "Profiler.h"
 #include "TimingSolver.h"
 
 #include "klee/Expr/ArrayExprVisitor.h"
@@ -75,6 +77,20 @@ void AddressSpace::unbindObject(const MemoryObject *mo) {
   objects = objects.remove(mo);
 }
 
+MemoryFootprint AddressSpace::getMemoryFootprint() const {
+  MemoryFootprint footprint;
+  for (const auto &object : objects) {
+    const ObjectState *os = object.second.get();
+    MemoryFootprint osFootprint = os->getMemoryFootprint();
+    if (cowKey == os->copyOnWriteOwner) {
+      footprint += osFootprint;
+    } else {
+      footprint.shared += osFootprint.total();
+    }
+  }
+  return footprint;
+}
+
 ObjectPair AddressSpace::findObject(const MemoryObject *mo) const {
   const auto res = objects.lookup(mo);
   return res ? ObjectPair(res->first, res->second.get())
@@ -243,6 +259,7 @@ bool AddressSpace::resolveOne(ExecutionState &state, TimingSolver *solver,
   }
 
   TimerStatIncrementer timer(stats::resolveTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Resolve);
 
   // try cheap search, will succeed for any inbounds pointer
 
@@ -332,6 +349,7 @@ bool AddressSpace::resolve(ExecutionState &state, TimingSolver *solver,
     }
   }
   TimerStatIncrementer timer(stats::resolveTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Resolve);
 
   ObjectPair fastPathObjectID;
   bool fastPathSuccess;
@@ -415,6 +433,8 @@ void AddressSpace::copyOutConcrete(const MemoryObject *mo,
       auto address =
           reinterpret_cast<std::uint8_t *>(addressExpr->getZExtValue());
       auto size = sizeExpr->getZExtValue();
+      if (mo->parent)
+        mo->parent->commit(addressExpr->getZExtValue(), size);
       std::memcpy(address, os->valueOS.concreteStore->data(), size);
     }
   }
@@ -443,6 +463,10 @@ bool AddressSpace::copyInConcrete(const MemoryObject *mo, const ObjectState *os,
   auto address = reinterpret_cast<std::uint8_t *>(src_address);
   size_t moSize = cast<ConstantExpr>(mo->getSizeExpr())->getZExtValue();
 
+  // Memory without host pages cannot have been touched by an external call
+  if (mo->parent && !mo->parent->isCommitted(src_address, moSize))
+    return true;
+
   if (memcmp(address, os->valueOS.concreteStore->data(), moSize) != 0) {
     if (os->readOnly) {
       return false;
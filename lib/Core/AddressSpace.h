@@ -129,6 +129,11 @@ public:
   /// Remove a binding from the address space.
   void unbindObject(const MemoryObject *mo);
 
+  /// Estimate host memory held by the bound object states. Objects owned by
+  /// this address space are exclusive; everything else is shared with the
+  /// address spaces it was copied from or to.
+  MemoryFootprint getMemoryFootprint() const;
+
   /// Lookup a binding from a MemoryObject.
   ObjectPair findObject(const MemoryObject *mo) const;
   RefObjectPair lazyInitializeObject(const MemoryObject *mo) const;
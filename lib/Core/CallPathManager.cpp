@@ -11,10 +11,10 @@
 
 #include "klee/Statistics/Statistics.h"
 
+#include "llvm/ADT/Hashing.h"
 #include "llvm/IR/Function.h"
 #include "llvm/Support/raw_ostream.h"
 
-#include <map>
 #include <vector>
 
 using namespace klee;
@@ -23,8 +23,9 @@ using namespace klee;
 
 CallPathNode::CallPathNode(CallPathNode *_parent,
                            const llvm::Instruction *_callSite,
-                           const llvm::Function *_function)
-    : parent(_parent), callSite(_callSite), function(_function), count(0) {}
+                           const llvm::Function *_function, unsigned _id)
+    : parent(_parent), callSite(_callSite), function(_function), id(_id),
+      context(theStatisticManager->addContext()), count(0) {}
 
 void CallPathNode::print() {
   llvm::errs() << "  (Function: " << this->function->getName() << ", "
@@ -39,22 +40,33 @@ void CallPathNode::print() {
 
 ///
 
-CallPathManager::CallPathManager() : root(nullptr, nullptr, nullptr) {}
+CallPathManager::CallPathManager() : slots(1024, Slot{0, nullptr, nullptr, 0}) {
+  paths.emplace_back(nullptr, nullptr, nullptr, 0);
+}
 
 void CallPathManager::getSummaryStatistics(CallSiteSummaryTable &results) {
   results.clear();
 
-  for (auto &path : paths)
-    path->summaryStatistics = path->statistics;
+  StatisticManager &sm = *theStatisticManager;
+  unsigned nStats = sm.getNumStatistics();
+  std::vector<uint64_t> summaries(paths.size() * nStats);
+  for (const auto &path : paths)
+    for (unsigned i = 0; i < nStats; i++)
+      summaries[path.id * nStats + i] =
+          sm.getContextValue(sm.getStatistic(i), path.context);
 
   // compute summary bottom up, while building result table
-  for (auto it = paths.rbegin(), ie = paths.rend(); it != ie; ++it) {
-    const auto &cp = (*it);
-    cp->parent->summaryStatistics += cp->summaryStatistics;
-
-    CallSiteInfo &csi = results[cp->callSite][cp->function];
-    csi.count += cp->count;
-    csi.statistics += cp->summaryStatistics;
+  for (unsigned id = paths.size() - 1; id > 0; --id) {
+    const CallPathNode &cp = paths[id];
+    const uint64_t *summary = &summaries[id * nStats];
+    uint64_t *parentSummary = &summaries[cp.parent->id * nStats];
+
+    CallSiteInfo &csi = results[cp.callSite][cp.function];
+    csi.count += cp.count;
+    for (unsigned i = 0; i < nStats; i++) {
+      parentSummary[i] += summary[i];
+      csi.statistics.incrementValue(sm.getStatistic(i), summary[i]);
+    }
   }
 }
 
@@ -65,25 +77,43 @@ CallPathNode *CallPathManager::computeCallPath(CallPathNode *parent,
     if (cs == p->callSite && f == p->function)
       return p;
 
-  auto cp = std::unique_ptr<CallPathNode>(new CallPathNode(parent, cs, f));
-  auto newCP = cp.get();
-  paths.emplace_back(std::move(cp));
-  return newCP;
+  paths.emplace_back(parent, cs, f, paths.size());
+  return &paths.back();
+}
+
+CallPathManager::Slot &
+CallPathManager::findSlot(unsigned parent, const llvm::Instruction *cs,
+                          const llvm::Function *f) {
+  std::size_t mask = slots.size() - 1;
+  for (std::size_t i = llvm::hash_combine(parent, cs, f) & mask;;
+       i = (i + 1) & mask) {
+    Slot &slot = slots[i];
+    if (!slot.path ||
+        (slot.parent == parent && slot.callSite == cs && slot.function == f))
+      return slot;
+  }
 }
 
 CallPathNode *CallPathManager::getCallPath(CallPathNode *parent,
                                            const llvm::Instruction *cs,
                                            const llvm::Function *f) {
-  std::pair<const llvm::Instruction *, const llvm::Function *> key(cs, f);
   if (!parent)
-    parent = &root;
-
-  auto it = parent->children.find(key);
-  if (it == parent->children.end()) {
-    auto cp = computeCallPath(parent, cs, f);
-    parent->children.insert(std::make_pair(key, cp));
-    return cp;
-  } else {
-    return it->second;
+    parent = &paths.front();
+
+  Slot *slot = &findSlot(parent->id, cs, f);
+  if (slot->path)
+    return &paths[slot->path];
+
+  CallPathNode *cp = computeCallPath(parent, cs, f);
+  if (2 * (usedSlots + 1) > slots.size()) {
+    std::vector<Slot> old(2 * slots.size(), Slot{0, nullptr, nullptr, 0});
+    old.swap(slots);
+    for (const Slot &s : old)
+      if (s.path)
+        findSlot(s.parent, s.callSite, s.function) = s;
+    slot = &findSlot(parent->id, cs, f);
   }
+  *slot = Slot{parent->id, cs, f, cp->id};
+  ++usedSlots;
+  return cp;
 }
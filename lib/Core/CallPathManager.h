@@ -12,8 +12,8 @@
 
 #include "klee/Statistics/Statistics.h"
 
+#include <deque>
 #include <map>
-#include <memory>
 #include <vector>
 
 namespace llvm {
@@ -40,35 +40,54 @@ class CallPathNode {
   friend class CallPathManager;
 
 public:
-  typedef std::map<std::pair<const llvm::Instruction *, const llvm::Function *>,
-                   CallPathNode *>
-      children_ty;
-
   // form list of (callSite,function) path
   CallPathNode *parent;
   const llvm::Instruction *callSite;
   const llvm::Function *function;
-  children_ty children;
 
-  StatisticRecord statistics;
-  StatisticRecord summaryStatistics;
+  /// The index of the path in its CallPathManager, greater than that of its
+  /// parent.
+  unsigned id;
+  /// The context of the statistics of the path in theStatisticManager.
+  unsigned context;
   unsigned count;
 
 public:
   CallPathNode(CallPathNode *parent, const llvm::Instruction *callSite,
-               const llvm::Function *function);
+               const llvm::Function *function, unsigned id);
+
+  uint64_t getValue(const Statistic &s) const {
+    return theStatisticManager->getContextValue(s, context);
+  }
+  void incrementValue(const Statistic &s, uint64_t addend) const {
+    theStatisticManager->incrementContextValue(s, context, addend);
+  }
 
   void print();
 };
 
 class CallPathManager {
-  CallPathNode root;
-  std::vector<std::unique_ptr<CallPathNode>> paths;
+  /// The paths by id, starting with the root. A deque keeps them in place.
+  std::deque<CallPathNode> paths;
+
+  /// The path that a call from a parent path leads to.
+  struct Slot {
+    unsigned parent;
+    const llvm::Instruction *callSite;
+    const llvm::Function *function;
+    /// The id of the path, 0 (the root) for an empty slot.
+    unsigned path;
+  };
+  /// Open addressing table of slots with linear probing, at most half full.
+  std::vector<Slot> slots;
+  unsigned usedSlots = 0;
 
 private:
   CallPathNode *computeCallPath(CallPathNode *parent,
                                 const llvm::Instruction *callSite,
                                 const llvm::Function *f);
+  Slot &findSlot(unsigned parent, const llvm::Instruction *callSite,
+                 const llvm::Function *f);
 
 public:
   CallPathManager();
@@ -12,7 +12,9 @@
 
 using namespace klee;
 
+Statistic stats::adaptiveTimeouts("AdaptiveTimeouts", "AdaptTO");
 Statistic stats::allocations("Allocations", "Alloc");
+Statistic stats::arenaCommittedPages("ArenaCommittedPages", "ArenaPages");
 Statistic stats::coveredInstructions("CoveredInstructions", "Icov");
 Statistic stats::externalCalls("ExternalCalls", "ExtC");
 Statistic stats::falseBranches("FalseBranches", "Bf");
@@ -22,11 +24,24 @@ Statistic stats::inhibitedForks("InhibitedForks", "InhibForks");
 Statistic stats::instructionRealTime("InstructionRealTimes", "Ireal");
 Statistic stats::instructionTime("InstructionTimes", "Itime");
 Statistic stats::instructions("Instructions", "I");
+Statistic stats::mergesRejected("MergesRejected", "MergeRej");
 Statistic stats::minDistToReturn("MinDistToReturn", "Rdist");
 Statistic stats::minDistToUncovered("MinDistToUncovered", "UCdist");
+Statistic stats::modelQueries("ModelQueries", "ModelQ");
 Statistic stats::resolveTime("ResolveTime", "Rtime");
 Statistic stats::solverTime("SolverTime", "Stime");
+Statistic stats::speculativeDiscards("SpeculativeDiscards", "SpecDiscards");
+Statistic stats::speculativeForks("SpeculativeForks", "SpecForks");
+Statistic stats::speculativeHiddenTime("SpeculativeHiddenTime", "SpecHidden");
+Statistic stats::speculativeWaitTime("SpeculativeWaitTime", "SpecWait");
+Statistic stats::speculativeWastedTime("SpeculativeWastedTime", "SpecWasted");
 Statistic stats::states("States", "States");
+Statistic stats::statesMerged("StatesMerged", "Merged");
+Statistic stats::statesMemory("StatesMemory", "Smem");
+Statistic stats::statesSharedMemory("StatesSharedMemory", "SmemShared");
+Statistic stats::statesUnmerged("StatesUnmerged", "Unmerged");
+Statistic stats::summarizedIterations("SummarizedIterations", "SumIters");
+Statistic stats::summarizedLoops("SummarizedLoops", "SumLoops");
 Statistic stats::trueBranches("TrueBranches", "Bt");
 Statistic stats::uncoveredInstructions("UncoveredInstructions", "Iuncov");
 
@@ -18,6 +18,11 @@ namespace klee {
 namespace stats {
 
 extern Statistic allocations;
+
+/// Pages of the reserve-only arena committed so that the host can access
+/// them (see --allocate-reserve-only).
+extern Statistic arenaCommittedPages;
+
 extern Statistic resolveTime;
 extern Statistic instructions;
 extern Statistic instructionTime;
@@ -38,10 +43,49 @@ extern Statistic forks;
 /// Number of inhibited forks.
 extern Statistic inhibitedForks;
 
+/// Branch and value queries that the model of a state answered in place of
+/// the solver (see --state-models).
+extern Statistic modelQueries;
+
+/// Forks that followed the direction taken by a model of the path
+/// constraints and left the other direction to the background solver.
+extern Statistic speculativeForks;
+
+/// Branched states that the background solver found infeasible, and the
+/// time (us) spent branching them.
+extern Statistic speculativeDiscards;
+extern Statistic speculativeWastedTime;
+
+/// Time (us) the background solver worked while the interpreter went on,
+/// and time (us) the interpreter waited for it.
+extern Statistic speculativeHiddenTime;
+extern Statistic speculativeWaitTime;
+
+/// Queries that failed under a timeout shortened by
+/// --adaptive-solver-timeout.
+extern Statistic adaptiveTimeouts;
+
+/// States merged into another state at a merge point (see --merge-states),
+/// states that left a merge point without being merged, and merges of
+/// compatible states rejected as unprofitable.
+extern Statistic statesMerged;
+extern Statistic statesUnmerged;
+extern Statistic mergesRejected;
+
+/// Loops whose iterations were evaluated into a summary instead of being
+/// executed (see --summarize-loops), and the iterations evaluated.
+extern Statistic summarizedLoops;
+extern Statistic summarizedIterations;
+
 /// Number of states, this is a "fake" statistic used by istats, it
 /// isn't normally up-to-date.
 extern Statistic states;
 
+/// Bytes held exclusively resp. shared by the states at an instruction,
+/// "fake" statistics like `states` that are only set while writing istats.
+extern Statistic statesMemory;
+extern Statistic statesSharedMemory;
+
 /// Instruction level statistic tracking the minimum intraprocedural
 /// distance to an uncovered instruction; this is only periodically
 /// updated.
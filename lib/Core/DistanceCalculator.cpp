@@ -15,6 +15,12 @@
 using namespace llvm;
 using namespace klee;
 
+namespace {
+/// Bound on the memoized distances of states, which are dropped at once
+/// when it is reached.
+constexpr std::size_t MaxStateDistances = 1 << 20;
+} // namespace
+
 bool DistanceResult::operator<(const DistanceResult &b) const {
   if (isInsideFunction != b.isInsideFunction)
     return isInsideFunction;
@@ -40,7 +46,18 @@ unsigned DistanceCalculator::SpeculativeState::computeHash() {
 
 DistanceResult DistanceCalculator::getDistance(const ExecutionState &state,
                                                KBlock *target) {
-  return getDistance(state.pc, state.stack.callStack(), target);
+  StackedBlock key = {state.pc->parent, state.stack.size(),
+                      state.stack.callStackHash(), target};
+  auto it = stateDistances.find(key);
+  if (it != stateDistances.end()) {
+    return it->second;
+  }
+  auto result = getDistance(state.pc, state.stack.callStack(), target);
+  if (stateDistances.size() >= MaxStateDistances) {
+    stateDistances.clear();
+  }
+  stateDistances.emplace(key, result);
+  return result;
 }
 
 DistanceResult DistanceCalculator::getDistance(KBlock *kb, TargetKind kind,
@@ -13,6 +13,10 @@
 #include "ExecutionState.h"
 #include "klee/Module/CodeGraphInfo.h"
 
+#include "llvm/ADT/Hashing.h"
+
+#include <unordered_map>
+
 namespace llvm {
 class BasicBlock;
 } // namespace llvm
@@ -96,10 +100,32 @@ private:
   using TargetToSpeculativeStateToDistanceResultMap =
       std::unordered_map<KBlock *, SpeculativeStateToDistanceResultMap>;
 
+  /// A block on a call stack, identified by its depth and hash.
+  struct StackedBlock {
+    KBlock *kb;
+    unsigned depth;
+    std::size_t callStackHash;
+    KBlock *target;
+
+    bool operator==(const StackedBlock &b) const {
+      return kb == b.kb && depth == b.depth &&
+             callStackHash == b.callStackHash && target == b.target;
+    }
+  };
+
+  struct StackedBlockHash {
+    std::size_t operator()(const StackedBlock &a) const {
+      return llvm::hash_combine(a.kb, a.depth, a.callStackHash, a.target);
+    }
+  };
+
   using StatesSet = states_ty;
 
   CodeGraphInfo &codeGraphInfo;
   TargetToSpeculativeStateToDistanceResultMap distanceResultCache;
+  /// Distances of states, which only depend on their block and call stack.
+  std::unordered_map<StackedBlock, DistanceResult, StackedBlockHash>
+      stateDistances;
   StatesSet localStates;
 
   DistanceResult getDistance(KBlock *kb, TargetKind kind, KBlock *target);
@@ -9,12 +9,12 @@
 #ifndef KLEE_EVENT_RECORDER_H
 #define KLEE_EVENT_RECORDER_H
 
+#include "klee/ADT/ImmutableList.h"
 #include "klee/Expr/Path.h"
 
 namespace klee {
 
 template <typename T> class ref;
-template <typename T> class ImmutableList;
 struct CodeFlowJson;
 class CodeEvent;
 
@@ -20,15 +20,18 @@
 #include "klee/Support/OptionCategories.h"
 
 #include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/IR/Function.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iomanip>
 #include <set>
 #include <sstream>
 #include <string>
+#include <tuple>
 
 using namespace llvm;
 using namespace klee;
@@ -63,6 +66,8 @@ void ExecutionStack::pushFrame(KInstIterator caller, KFunction *kf) {
     uniqueFrames_.emplace_back(CallStackFrame(caller, kf));
   }
   callStack_.emplace_back(CallStackFrame(caller, kf));
+  callStackHashes_.push_back(llvm::hash_combine(
+      callStackHash(), static_cast<KInstruction *>(caller), kf));
   infoStack_.emplace_back(InfoStackFrame(kf));
   auto kfLevel = multilevel[kf].second;
   multilevel.replace({kf, kfLevel + 1});
@@ -78,6 +83,7 @@ void ExecutionStack::popFrame() {
   KFunction *kf = callStack_.back().kf;
   valueStack_.pop_back();
   callStack_.pop_back();
+  callStackHashes_.pop_back();
   infoStack_.pop_back();
   auto it = std::find(callStack_.begin(), callStack_.end(),
                       CallStackFrame(caller, kf));
@@ -155,7 +161,8 @@ ExecutionState::ExecutionState(const ExecutionState &state)
       stack(state.stack), stackBalance(state.stackBalance),
       incomingBBIndex(state.incomingBBIndex), depth(state.depth),
       level(state.level), addressSpace(state.addressSpace),
-      constraints(state.constraints), eventsRecorder(state.eventsRecorder),
+      constraints(state.constraints), model(state.model),
+      eventsRecorder(state.eventsRecorder),
       targetForest(state.targetForest), pathOS(state.pathOS),
       symPathOS(state.symPathOS), coveredLines(state.coveredLines),
       symbolics(state.symbolics), resolvedPointers(state.resolvedPointers),
@@ -170,7 +177,8 @@ ExecutionState::ExecutionState(const ExecutionState &state)
       coveredNew(state.coveredNew), coveredNewError(state.coveredNewError),
       forkDisabled(state.forkDisabled), returnValue(state.returnValue),
       gepExprBases(state.gepExprBases), multiplexKF(state.multiplexKF),
-      prevTargets_(state.prevTargets_), targets_(state.targets_),
+      mergePoints(state.mergePoints), prevTargets_(state.prevTargets_),
+      targets_(state.targets_),
       prevHistory_(state.prevHistory_), history_(state.history_),
       isTargeted_(state.isTargeted_) {
   queryMetaData.id = state.id;
@@ -181,6 +189,9 @@ ExecutionState *ExecutionState::branch() {
 
   auto *falseState = new ExecutionState(*this);
   falseState->setID();
+  // constraints added so far are shared by both states from now on
+  unsharedConstraintBytes = 0;
+  falseState->unsharedConstraintBytes = 0;
   falseState->coveredLines.clear();
   falseState->prevTargets_ = falseState->targets_;
   falseState->prevHistory_ = falseState->history_;
@@ -281,34 +292,52 @@ bool ExecutionState::getBase(
   return true;
 }
 
-void ExecutionState::removePointerResolutions(const MemoryObject *mo) {
-  for (auto resolution = begin(resolvedPointers);
-       resolution != end(resolvedPointers);) {
-    resolution->second.erase(mo);
-    if (resolution->second.size() == 0) {
-      resolution = resolvedPointers.erase(resolution);
-    } else {
-      ++resolution;
-    }
+template <typename Resolutions>
+static void removeResolutionsTo(Resolutions &resolutions,
+                                const MemoryObject *mo) {
+  // the map cannot change while it is iterated
+  std::vector<typename Resolutions::value_type> changed;
+  for (const auto &resolution : resolutions) {
+    if (resolution.second.count(mo))
+      changed.push_back(resolution);
   }
 
-  for (auto resolution = begin(resolvedSubobjects);
-       resolution != end(resolvedSubobjects);) {
-    resolution->second.erase(mo);
-    if (resolution->second.size() == 0) {
-      resolution = resolvedSubobjects.erase(resolution);
+  for (auto &resolution : changed) {
+    resolution.second.erase(mo);
+    if (resolution.second.empty()) {
+      resolutions.remove(resolution.first);
     } else {
-      ++resolution;
+      resolutions.replace(resolution);
     }
   }
 }
 
+template <typename Resolutions>
+static void addResolution(Resolutions &resolutions,
+                          const typename Resolutions::key_type &key,
+                          const MemoryObject *mo) {
+  ResolutionSet objects;
+  if (const ResolutionSet *old = resolutions.lookup(key)) {
+    if (old->count(mo))
+      return;
+    objects = *old;
+  }
+  objects.insert(mo);
+  resolutions.replace({key, objects});
+}
+
+void ExecutionState::removePointerResolutions(const MemoryObject *mo) {
+  removeResolutionsTo(resolvedPointers, mo);
+  removeResolutionsTo(resolvedSubobjects, mo);
+}
+
 void ExecutionState::removePointerResolutions(ref<PointerExpr> address,
                                               unsigned size) {
   ref<Expr> base = address->getBase();
   if (!isa<ConstantExpr>(base)) {
-    resolvedPointers[base].clear();
-    resolvedSubobjects[MemorySubobject(address, size)].clear();
+    resolvedPointers.replace({base, ResolutionSet()});
+    resolvedSubobjects.replace(
+        {MemorySubobject(address, size), ResolutionSet()});
   }
 }
 
@@ -318,8 +347,8 @@ void ExecutionState::addPointerResolution(ref<PointerExpr> address,
                                           unsigned size) {
   ref<Expr> base = address->getBase();
   if (!isa<ConstantExpr>(base)) {
-    resolvedPointers[base].insert(mo);
-    resolvedSubobjects[MemorySubobject(address, size)].insert(mo);
+    addResolution(resolvedPointers, base, mo);
+    addResolution(resolvedSubobjects, MemorySubobject(address, size), mo);
   }
 }
 
@@ -328,9 +357,10 @@ void ExecutionState::addUniquePointerResolution(ref<PointerExpr> address,
                                                 unsigned size) {
   ref<Expr> base = address->getBase();
   if (!isa<ConstantExpr>(base)) {
-    removePointerResolutions(address, size);
-    resolvedPointers[base].insert(mo);
-    resolvedSubobjects[MemorySubobject(address, size)].insert(mo);
+    ResolutionSet objects;
+    objects.insert(mo);
+    resolvedPointers.replace({base, objects});
+    resolvedSubobjects.replace({MemorySubobject(address, size), objects});
   }
 }
 
@@ -394,14 +424,178 @@ void ExecutionState::dumpStack(llvm::raw_ostream &out) const {
   }
 }
 
+/// Estimate the size of the expression nodes reachable from `e` only
+/// through `e` itself, i.e. nodes that were built for this expression and
+/// are not referenced by any other expression.
+static std::size_t getUnsharedExprSize(const ref<Expr> &e) {
+  std::size_t size = 0;
+  std::vector<ref<Expr>> worklist{e};
+  while (!worklist.empty()) {
+    ref<Expr> current = worklist.back();
+    worklist.pop_back();
+    size += sizeof(BinaryExpr);
+    for (unsigned i = 0; i < current->getNumKids(); ++i) {
+      ref<Expr> kid = current->getKid(i);
+      if (kid->_refCount.getCount() <= 2) {
+        // One reference from the parent, one from the local copy
+        worklist.push_back(kid);
+      }
+    }
+  }
+  return size;
+}
+
 void ExecutionState::addConstraint(ref<Expr> e) {
-  constraints.addConstraint(e);
+  for (const auto &added : constraints.addConstraint(e)) {
+    unsharedConstraintBytes += getUnsharedExprSize(added);
+  }
+  if (model) {
+    ref<Expr> value = model->evaluate(e, false);
+    if (!isa<ConstantExpr>(value) || !value->isTrue())
+      model.reset();
+  }
+}
+
+MemoryFootprint ExecutionState::getMemoryFootprint() const {
+  MemoryFootprint footprint = addressSpace.getMemoryFootprint();
+  footprint.exclusive += sizeof(ExecutionState);
+
+  for (const auto &frame : stack.valueStack()) {
+    footprint.exclusive += sizeof(StackFrame) +
+                           frame.locals->size() * sizeof(Cell) +
+                           frame.allocas.capacity() * sizeof(frame.allocas[0]);
+  }
+  footprint.exclusive += stack.callStack().capacity() * sizeof(CallStackFrame) +
+                         stack.infoStack().capacity() * sizeof(InfoStackFrame);
+
+  // The constraint set itself is copied on branch, the expressions it refers
+  // to are shared with the parent except for the suffix added since then.
+  const std::size_t constraintNodeSize = sizeof(ref<Expr>) + 4 * sizeof(void *);
+  footprint.exclusive += constraints.cs().cs().size() * constraintNodeSize;
+  footprint.exclusive += unsharedConstraintBytes;
+  return footprint;
 }
 
 void ExecutionState::addCexPreference(const ref<Expr> &cond) {
   cexPreferences = cexPreferences.insert(cond);
 }
 
+bool ExecutionState::canMerge(const ExecutionState &b) const {
+  if (pc != b.pc || stack.size() != b.stack.size() ||
+      !(stack.callStack() == b.stack.callStack()) ||
+      roundingMode != b.roundingMode || unwindingInformation ||
+      b.unwindingInformation || !constraints.cs().symcretes().empty() ||
+      !b.constraints.cs().symcretes().empty() ||
+      symbolics.size() != b.symbolics.size())
+    return false;
+
+  for (auto itA = symbolics.begin(), itB = b.symbolics.begin();
+       itA != symbolics.end(); ++itA, ++itB)
+    if (!(*itA == *itB))
+      return false;
+
+  for (unsigned i = 0; i < stack.size(); ++i) {
+    const StackFrame &frameA = stack.valueStack()[i];
+    const StackFrame &frameB = b.stack.valueStack()[i];
+    if (frameA.kf != frameB.kf || frameA.allocas != frameB.allocas ||
+        frameA.varargs != frameB.varargs)
+      return false;
+    for (unsigned reg = 0; reg < frameA.locals->size(); ++reg) {
+      const ref<Expr> &valueA = frameA.locals->at(reg).value;
+      const ref<Expr> &valueB = frameB.locals->at(reg).value;
+      if (valueA && valueB &&
+          isa<PointerExpr>(valueA) != isa<PointerExpr>(valueB))
+        return false;
+    }
+  }
+
+  if (addressSpace.objects.size() != b.addressSpace.objects.size())
+    return false;
+  for (auto itA = addressSpace.objects.begin(),
+            itB = b.addressSpace.objects.begin();
+       itA != addressSpace.objects.end(); ++itA, ++itB) {
+    if (itA->first != itB->first)
+      return false;
+    const ObjectState *osA = itA->second.get();
+    const ObjectState *osB = itB->second.get();
+    if (osA != osB && (osA->readOnly != osB->readOnly ||
+                       itA->first->hasSymbolicSize()))
+      return false;
+  }
+  return true;
+}
+
+bool ExecutionState::merge(const ExecutionState &b) {
+  if (!canMerge(b))
+    return false;
+  ref<Expr> inA, inB;
+  std::tie(inA, inB) = constraints.merge(b.constraints);
+  if (!inA)
+    return false;
+
+  auto select = [&inA](const ref<Expr> &valueA, const ref<Expr> &valueB) {
+    auto pointerA = dyn_cast<PointerExpr>(valueA);
+    auto pointerB = dyn_cast<PointerExpr>(valueB);
+    if (pointerA && pointerB)
+      return PointerExpr::create(
+          SelectExpr::create(inA, pointerA->getBase(), pointerB->getBase()),
+          SelectExpr::create(inA, pointerA->getValue(), pointerB->getValue()));
+    return SelectExpr::create(inA, valueA, valueB);
+  };
+
+  // registers defined on one path only are dead at the merge point
+  for (unsigned i = 0; i < stack.size(); ++i) {
+    StackFrame &frameA = stack.valueStack()[i];
+    const StackFrame &frameB = b.stack.valueStack()[i];
+    for (unsigned reg = 0; reg < frameA.locals->size(); ++reg) {
+      const ref<Expr> valueA = frameA.locals->at(reg).value;
+      const ref<Expr> &valueB = frameB.locals->at(reg).value;
+      if (valueA && valueB && valueA != valueB)
+        frameA.locals->set(reg, Cell(select(valueA, valueB)));
+    }
+  }
+  if (returnValue && b.returnValue && returnValue != b.returnValue)
+    returnValue = select(returnValue, b.returnValue);
+
+  for (auto itA = addressSpace.objects.begin(),
+            itB = b.addressSpace.objects.begin();
+       itA != addressSpace.objects.end(); ++itA, ++itB) {
+    if (itA->second.get() == itB->second.get())
+      continue;
+    ObjectState *os = addressSpace.getWriteable(itA->first, itA->second.get());
+    os->merge(inA, *itB->second);
+  }
+
+  resolved_pointers_ty mergedPointers;
+  for (const auto &resolution : resolvedPointers) {
+    if (const ResolutionSet *other =
+            b.resolvedPointers.lookup(resolution.first)) {
+      ResolutionSet objects = resolution.second;
+      objects.insert(other->begin(), other->end());
+      mergedPointers.replace({resolution.first, objects});
+    }
+  }
+  resolvedPointers = mergedPointers;
+  resolvedSubobjects.clear();
+  for (const auto &base : b.gepExprBases)
+    gepExprBases.insert(base);
+  for (const auto &preference : b.cexPreferences)
+    addCexPreference(preference);
+  for (const auto &name : b.arrayNames)
+    arrayNames[name.first] = std::max(arrayNames[name.first], name.second);
+  for (KBlock *kb : b.level)
+    level.insert(kb);
+  for (const auto &lines : b.coveredLines)
+    coveredLines[lines.first].insert(lines.second.begin(), lines.second.end());
+
+  if (b.isCoveredNew() && !isCoveredNew())
+    coveredNew.push_back(b.coveredNew.back());
+  depth = std::max(depth, b.depth);
+  instsSinceCovNew = std::min(instsSinceCovNew, b.instsSinceCovNew);
+  model.reset();
+  return true;
+}
+
 BasicBlock *ExecutionState::getInitPCBlock() const {
   return initPC->inst()->getParent();
 }
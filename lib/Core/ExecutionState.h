@@ -15,6 +15,7 @@
 #include "klee/ADT/FixedSizeStorageAdapter.h"
 #include "klee/ADT/ImmutableList.h"
 #include "klee/ADT/ImmutableSet.h"
+#include "klee/ADT/PersistentHashMap.h"
 #include "klee/ADT/PersistentMap.h"
 #include "klee/ADT/PersistentSet.h"
 #include "klee/ADT/SparseStorage.h"
@@ -37,8 +38,10 @@
 #include "EventRecorder.h"
 
 #include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/Function.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <deque>
 #include <map>
@@ -130,6 +133,8 @@ private:
   call_stack_ty callStack_;
   info_stack_ty infoStack_;
   call_stack_ty uniqueFrames_;
+  /// Hash of the callers and functions of the frames up to each frame.
+  std::vector<std::size_t> callStackHashes_;
   size_t stackSize = 0;
   unsigned stackBalance = 0;
 
@@ -143,6 +148,10 @@ public:
   inline const info_stack_ty &infoStack() const { return infoStack_; }
   inline info_stack_ty &infoStack() { return infoStack_; }
   inline const call_stack_ty &uniqueFrames() const { return uniqueFrames_; }
+  /// A hash of the callers and functions on the call stack.
+  inline std::size_t callStackHash() const {
+    return callStackHashes_.empty() ? 0 : callStackHashes_.back();
+  }
 
   void forceReturnLocation(const ref<CodeLocation> &location) {
     assert(!callStack_.empty() && "Call stack should contain at least one "
@@ -266,7 +275,7 @@ struct MemorySubobject {
 };
 
 struct MemorySubobjectHash {
-  bool operator()(const MemorySubobject &a) const {
+  std::size_t operator()(const MemorySubobject &a) const {
     return a.size * Expr::MAGIC_HASH_CONSTANT + a.address->hash();
   }
 };
@@ -277,6 +286,48 @@ struct MemorySubobjectCompare {
   }
 };
 
+/// @brief The memory objects that an address may be resolved to. Almost all
+/// addresses resolve to a single object, so the objects are kept inline in a
+/// sorted vector rather than in a std::set.
+class ResolutionSet {
+  using objects_ty = llvm::SmallVector<ref<const MemoryObject>, 1>;
+  objects_ty objects;
+
+public:
+  using iterator = objects_ty::const_iterator;
+
+  iterator begin() const { return objects.begin(); }
+  iterator end() const { return objects.end(); }
+  std::size_t size() const { return objects.size(); }
+  bool empty() const { return objects.empty(); }
+
+  bool count(const ref<const MemoryObject> &mo) const {
+    return std::binary_search(objects.begin(), objects.end(), mo);
+  }
+  void insert(const ref<const MemoryObject> &mo) {
+    auto it = std::lower_bound(objects.begin(), objects.end(), mo);
+    if (it == objects.end() || mo < *it)
+      objects.insert(it, mo);
+  }
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    for (; first != last; ++first)
+      insert(*first);
+  }
+  void erase(const ref<const MemoryObject> &mo) {
+    auto it = std::lower_bound(objects.begin(), objects.end(), mo);
+    if (it != objects.end() && !(mo < *it))
+      objects.erase(it);
+  }
+  void clear() { objects.clear(); }
+};
+
+using resolved_pointers_ty = PersistentHashMap<ref<Expr>, ResolutionSet,
+                                               util::ExprHash, util::ExprCmp>;
+using resolved_subobjects_ty =
+    PersistentHashMap<MemorySubobject, ResolutionSet, MemorySubobjectHash,
+                      MemorySubobjectCompare>;
+
 typedef std::pair<llvm::BasicBlock *, llvm::BasicBlock *> Transition;
 
 /// @brief ExecutionState representing a path under exploration
@@ -328,6 +379,11 @@ public:
   /// @brief Constraints collected so far
   PathConstraints constraints;
 
+  /// @brief An assignment that satisfies the constraints, if one is known.
+  /// Arrays without a binding are zero. Dropped by addConstraint() once it
+  /// violates an added constraint.
+  std::optional<Assignment> model;
+
   /// @brief Storage for the source code events (e.g. changing control flow or
   /// errors)
   EventRecorder eventsRecorder;
@@ -363,10 +419,9 @@ public:
   ImmutableList<Symbolic> symbolics;
 
   /// @brief map from memory accesses to accessed objects and access offsets.
-  ExprHashMap<std::set<ref<const MemoryObject>>> resolvedPointers;
-  std::unordered_map<MemorySubobject, std::set<ref<const MemoryObject>>,
-                     MemorySubobjectHash, MemorySubobjectCompare>
-      resolvedSubobjects;
+  /// Branched states share the maps until one of them changes.
+  resolved_pointers_ty resolvedPointers;
+  resolved_subobjects_ty resolvedSubobjects;
 
   /// @brief A set of boolean expressions
   /// the user has requested be true of a counterexample.
@@ -387,6 +442,10 @@ public:
   /// instruction was covered.
   std::uint32_t instsSinceCovNew = 0;
 
+  /// @brief Estimated bytes of constraint expressions added since the last
+  /// branch; these are not yet referenced by any other state.
+  std::size_t unsharedConstraintBytes = 0;
+
   ///@brief State cfenv rounding mode
   llvm::APFloat::roundingMode roundingMode = llvm::APFloat::rmNearestTiesToEven;
 
@@ -420,6 +479,14 @@ public:
   // Temp: to know which multiplex path this state has taken
   KFunction *multiplexKF = nullptr;
 
+  /// @brief Points at which this state waits for the states it forked with,
+  /// innermost last, with the stack size they are reached at
+  std::vector<std::pair<KInstruction *, std::size_t>> mergePoints;
+
+  /// @brief Header of a loop the state runs as usual, as its summary did not
+  /// cover all iterations
+  KBlock *unsummarizedLoop = nullptr;
+
 private:
   PersistentSet<ref<Target>> prevTargets_;
   PersistentSet<ref<Target>> targets_;
@@ -471,11 +538,24 @@ public:
   void addConstraint(ref<Expr> e);
   void addCexPreference(const ref<Expr> &cond);
 
+  /// @brief Whether b can be merged into this state: both are at the same
+  /// instruction with the same stack frames, symbolics and objects.
+  bool canMerge(const ExecutionState &b) const;
+  /// @brief Absorb b, so that this state covers the paths of both. Values
+  /// that differ become selects on the path condition of either state.
+  /// Returns false, leaving this state unchanged, if it cannot.
+  bool merge(const ExecutionState &b);
+
   Query toQuery(ref<Expr> head) const;
   Query toQuery() const;
 
   void dumpStack(llvm::raw_ostream &out) const;
 
+  /// @brief Estimate host memory held by this state: owned object states,
+  /// sparse storage entries, stack frames and the unshared constraint suffix
+  /// are exclusive, copy-on-write data reachable from other states is shared.
+  MemoryFootprint getMemoryFootprint() const;
+
   bool visited(KBlock *block) const;
 
   std::uint32_t getID() const { return id; };
@@ -21,8 +21,11 @@
 #include "ImpliedValue.h"
 #include "Memory.h"
 #include "MemoryManager.h"
+#include "LoopSummarizer.h"
+#include "MergeHandler.h"
 #include "PForest.h"
 #include "PTree.h"
+#include "Profiler.h"
 #include "Searcher.h"
 #include "SeedInfo.h"
 #include "SpecialFunctionHandler.h"
@@ -59,9 +62,11 @@
 #include "klee/Module/KInstruction.h"
 #include "klee/Module/KModule.h"
 #include "klee/Module/SarifReport.h"
+#include "klee/Solver/BackgroundSolver.h"
 #include "klee/Solver/Common.h"
 #include "klee/Solver/Solver.h"
 #include "klee/Solver/SolverCmdLine.h"
+#include "klee/Statistics/LiveMetrics.h"
 #include "klee/Statistics/TimerStatIncrementer.h"
 #include "klee/Support/Casting.h"
 #include "klee/Support/ErrorHandling.h"
@@ -292,6 +297,45 @@ cl::opt<bool>
                                   "querying the solver (default=true)"),
                          cl::cat(SolvingCat));
 
+cl::opt<bool> SpeculativeFork(
+    "speculative-fork", cl::init(false),
+    cl::desc("At symbolic branches, follow the direction taken by a model of "
+             "the path constraints and check the other direction on a "
+             "background thread (default=false)"),
+    cl::cat(SolvingCat));
+
+cl::opt<unsigned> MaxSpeculativeBranches(
+    "max-speculative-branches", cl::init(64),
+    cl::desc("Maximum number of states waiting for the background solver "
+             "with --speculative-fork. Further symbolic branches fork as "
+             "usual, as do all symbolic branches at the memory cap. Waiting "
+             "states cannot be terminated by --max-memory, so this bounds "
+             "their footprint (default=64)"),
+    cl::cat(SolvingCat));
+
+cl::opt<bool> StateModels(
+    "state-models", cl::init(false),
+    cl::desc("Keep a model of the path constraints of each state and answer "
+             "the branch and value queries it decides without the solver "
+             "(default=false)"),
+    cl::cat(SolvingCat));
+
+cl::opt<bool> MergeStates(
+    "merge-states", cl::init(false),
+    cl::desc("Merge the states forked at a symbolic branch where their paths "
+             "join again, if that is expected to pay off. Disabled when "
+             "seeding or replaying (default=false)"),
+    cl::cat(SearchCat));
+
+cl::opt<bool> SummarizeLoops(
+    "summarize-loops", cl::init(false),
+    cl::desc("Evaluate loops that only read memory, like those of strlen or "
+             "memchr, without forking, and leave them once per exit instead "
+             "of once per iteration. The blocks of a summarized loop are "
+             "covered and recorded on the path of a state only once. "
+             "Disabled when replaying (default=false)"),
+    cl::cat(SearchCat));
+
 cl::opt<bool> OnlyOutputMakeSymbolicArrays(
     "only-output-make-symbolic-arrays", cl::init(false),
     cl::desc(
@@ -391,6 +435,25 @@ cl::opt<std::string>
                       "search (default=0s (off))"),
              cl::cat(SeedingCat));
 
+/*** Memory cap options ***/
+
+enum class MemoryVictimPolicy {
+  Random,
+  Footprint,
+};
+
+cl::opt<MemoryVictimPolicy> MemoryVictimSelection(
+    "memory-victim-selection",
+    cl::desc("How to pick states to terminate when over the memory cap "
+             "(see -max-memory)"),
+    cl::values(clEnumValN(MemoryVictimPolicy::Random, "random",
+                          "Terminate randomly chosen states, preferring "
+                          "states that did not cover new code"),
+               clEnumValN(MemoryVictimPolicy::Footprint, "footprint",
+                          "Terminate states freeing the most exclusive "
+                          "memory per unit of coverage potential (default)")),
+    cl::init(MemoryVictimPolicy::Footprint), cl::cat(TerminationCat));
+
 /*** Debugging options ***/
 
 /// The different query logging solvers that can switched on/off
@@ -564,6 +627,8 @@ Executor::Executor(LLVMContext &ctx, const InterpreterOptions &opts,
   this->solver = std::make_unique<TimingSolver>(std::move(solver), optimizer,
                                                 EqualitySubstitution);
   initializeSearchOptions();
+  if (userSearcherRequiresQueryCostModel() && !this->solver->costModel)
+    this->solver->costModel = std::make_unique<QueryCostModel>();
 
   if (DebugPrintInstructions.isSet(FILE_ALL) ||
       DebugPrintInstructions.isSet(FILE_COMPACT) ||
@@ -690,7 +755,11 @@ llvm::Module *Executor::setModule(
 
   specialFunctionHandler->bind();
 
-  if (StatsTracker::useStatistics() || userSearcherRequiresMD2U()) {
+  if (Profiler::enabled())
+    profiler = std::make_unique<Profiler>();
+
+  if (StatsTracker::useStatistics() || StatsTracker::useLiveMetrics() ||
+      userSearcherRequiresMD2U() || profiler) {
     statsTracker = new StatsTracker(
         *this, interpreterHandler->getOutputFilename("assembly.ll"),
         userSearcherRequiresMD2U());
@@ -808,6 +877,9 @@ ObjectPair Executor::addExternalObjectAsNonStatic(ExecutionState &state,
                                                   bool isReadOnly) {
   auto mo = allocate(state, Expr::createPointer(size), false, true, nullptr, 8);
   mo->isFixed = true;
+  // The host accesses these objects directly, but read-only and
+  // user-specified objects are never copied out before external calls
+  memory->commit(cast<ConstantExpr>(mo->getBaseExpr())->getZExtValue(), size);
 
   auto os = bindObjectInState(state, mo, false);
   os->setReadOnly(isReadOnly);
@@ -903,11 +975,14 @@ decltype(auto) Executor::addCTypeModelledObject(ExecutionState &state,
   ref<ConstantExpr> seg = cast<ConstantExpr>(ctypeObj.first->getBaseExpr());
   auto addr =
       reinterpret_cast<const uint8_t *>(*objectProvider() - kCTypeMemOffset);
+  ObjectState *wos =
+      state.addressSpace.getWriteable(ctypeObj.first, ctypeObj.second);
   for (unsigned i = 0; i < kCTypeMemSize * sizeof(underlying_t); i++) {
     ref<Expr> byte = ConstantExpr::create(addr[i], Expr::Int8);
-    state.addressSpace.getWriteable(ctypeObj.first, ctypeObj.second)
-        ->write(i, PointerExpr::create(seg, byte));
+    wos->write(i, PointerExpr::create(seg, byte));
   }
+  // Read-only objects are not copied out before external calls
+  state.addressSpace.copyOutConcrete(ctypeObj.first, wos);
 
   // Return address to pointer
   return reinterpret_cast<decltype(objectProvider())>(
@@ -1178,6 +1253,7 @@ void Executor::branch(ExecutionState &state,
                       std::vector<ExecutionState *> &result,
                       BranchType reason) {
   TimerStatIncrementer timer(stats::forkTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Fork);
   unsigned N = conditions.size();
   assert(N);
 
@@ -1282,9 +1358,9 @@ ref<Expr> Executor::maxStaticPctChecks(ExecutionState &current,
        (sm.getIndexedValue(stats::forks, sm.getIndex()) >
         stats::forks * MaxStaticForkPct));
 
-  bool reached_max_cp_fork_limit = (MaxStaticCPForkPct < 1. && cpn &&
-                                    (cpn->statistics.getValue(stats::forks) >
-                                     stats::forks * MaxStaticCPForkPct));
+  bool reached_max_cp_fork_limit =
+      (MaxStaticCPForkPct < 1. && cpn &&
+       (cpn->getValue(stats::forks) > stats::forks * MaxStaticCPForkPct));
 
   bool reached_max_solver_limit =
       (MaxStaticSolvePct < 1 &&
@@ -1293,7 +1369,7 @@ ref<Expr> Executor::maxStaticPctChecks(ExecutionState &current,
 
   bool reached_max_cp_solver_limit =
       (MaxStaticCPForkPct < 1. && cpn &&
-       (cpn->statistics.getValue(stats::solverTime) >
+       (cpn->getValue(stats::solverTime) >
         stats::solverTime * MaxStaticCPSolvePct));
 
   if (reached_max_fork_limit || reached_max_cp_fork_limit ||
@@ -1400,8 +1476,21 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
                                  StateTerminationType::MissedAllTargets);
     return StatePair(nullptr, nullptr);
   }
+  if (res == PartialValidity::None && backgroundSolver && !isSeeding &&
+      !isInternal && !replayPath &&
+      !atMemoryLimit && speculativeBranches.size() < MaxSpeculativeBranches &&
+      !(MaxDepth && MaxDepth <= current.depth + 1)) {
+    if (std::optional<bool> taken = speculativeDirection(current, condition)) {
+      solver->setLimits(time::Span(), 0);
+      return forkSpeculatively(current, condition, *taken, reason);
+    }
+  }
+  ref<SolverResponse> trueResponse, falseResponse;
   if (res != PartialValidity::None) {
     success = true;
+  } else if (StateModels && !isSeeding) {
+    success = evaluateWithModel(current, condition, res, trueResponse,
+                                falseResponse);
   } else {
     success = solver->evaluate(current.constraints.cs(), condition, res,
                                current.queryMetaData);
@@ -1438,6 +1527,7 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
 
       if (!branchingPermitted(current, 2)) {
         TimerStatIncrementer timer(stats::forkTime);
+        Profiler::PhaseScope phase(Profiler::Phase::Fork);
         if (theRNG.getBool()) {
           res = PValidity::MayBeTrue;
         } else {
@@ -1497,6 +1587,7 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
     if (res == PValidity::MayBeTrue) {
       addConstraint(current, condition);
     }
+    updateModel(current, trueResponse);
 
     return StatePair(&current, nullptr);
   } else if (res == PValidity::MustBeFalse || res == PValidity::MayBeFalse) {
@@ -1509,12 +1600,14 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
     if (res == PValidity::MayBeFalse) {
       addConstraint(current, Expr::createIsZero(condition));
     }
+    updateModel(current, falseResponse);
 
     return StatePair(nullptr, &current);
   } else {
     // When does PValidity::None happen?
     assert(res == PValidity::TrueOrFalse);
     TimerStatIncrementer timer(stats::forkTime);
+    Profiler::PhaseScope phase(Profiler::Phase::Fork);
     ExecutionState *falseState, *trueState = &current;
 
     ++stats::forks;
@@ -1578,6 +1671,10 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
 
     trueState->afterFork = true;
     falseState->afterFork = true;
+    // both states still have the model of current, which the added
+    // constraints check
+    updateModel(*trueState, trueResponse);
+    updateModel(*falseState, falseResponse);
     addConstraint(*trueState, condition);
     addConstraint(*falseState, Expr::createIsZero(condition));
 
@@ -1594,6 +1691,230 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
   }
 }
 
+bool Executor::ensureModel(ExecutionState &state) {
+  const ConstraintSet &constraints = state.constraints.cs();
+  // symcretes are concretized by the solver chain, which a model ignores
+  if (!constraints.symcretes().empty())
+    return false;
+  if (state.model)
+    return true;
+
+  // one query for a model instead of the up to two of evaluate()
+  std::vector<const Array *> objects = constraints.gatherArrays();
+  std::vector<SparseStorageImpl<unsigned char>> values;
+  if (!solver->getInitialValues(constraints, objects, values,
+                                state.queryMetaData))
+    return false;
+  Assignment model(objects, values);
+  if (!model.satisfies(constraints.cs().begin(), constraints.cs().end(),
+                       false))
+    return false;
+  state.model = model;
+  return true;
+}
+
+void Executor::updateModel(ExecutionState &state,
+                           ref<SolverResponse> response) {
+  // the counterexample may only bind the arrays of the factor it was
+  // computed for, so it extends a model but does not make one
+  Assignment::bindings_ty bindings;
+  if (!state.model || !response || !response->tryGetInitialValues(bindings))
+    return;
+
+  Assignment model = *state.model;
+  std::vector<const Array *> rebound;
+  for (const auto &binding : bindings) {
+    auto it = model.bindings.find(binding.first);
+    if (it != model.bindings.end() && it->second == binding.second)
+      continue;
+    rebound.push_back(binding.first);
+    model.bindings.replace(binding);
+  }
+  if (rebound.empty())
+    return;
+
+  // only the factors that read a rebound array can be violated
+  std::vector<ref<const IndependentConstraintSet>> factors;
+  state.constraints.cs().getAllDependentConstraintsSets(rebound, factors);
+  for (const auto &factor : factors) {
+    if (!model.satisfies(factor->exprs.begin(), factor->exprs.end(), false)) {
+      state.model.reset();
+      return;
+    }
+  }
+  state.model = model;
+}
+
+bool Executor::evaluateWithModel(ExecutionState &current, ref<Expr> condition,
+                                 PartialValidity &result,
+                                 ref<SolverResponse> &trueResponse,
+                                 ref<SolverResponse> &falseResponse) {
+  const ConstraintSet &constraints = current.constraints.cs();
+  if (!isa<ConstantExpr>(condition) && ensureModel(current)) {
+    ref<Expr> value = current.model->evaluate(condition, false);
+    if (isa<ConstantExpr>(value)) {
+      // the model shows its direction feasible, only the other one is open
+      ++stats::modelQueries;
+      bool taken = value->isTrue();
+      ref<SolverResponse> response;
+      if (!solver->getResponse(constraints,
+                               taken ? condition
+                                     : Expr::createIsZero(condition),
+                               response, current.queryMetaData))
+        return false;
+      if (isa<ValidResponse>(response))
+        result = taken ? PValidity::MustBeTrue : PValidity::MustBeFalse;
+      else if (isa<InvalidResponse>(response))
+        result = PValidity::TrueOrFalse;
+      else
+        result = taken ? PValidity::MayBeTrue : PValidity::MayBeFalse;
+      (taken ? falseResponse : trueResponse) = response;
+      return true;
+    }
+  }
+
+  ref<SolverResponse> queryResult, negatedQueryResult;
+  if (!solver->evaluate(constraints, condition, queryResult,
+                        negatedQueryResult, current.queryMetaData))
+    return false;
+  bool mayBeTrue = isa<InvalidResponse>(negatedQueryResult);
+  bool mayBeFalse = isa<InvalidResponse>(queryResult);
+  if (mayBeTrue && mayBeFalse)
+    result = PValidity::TrueOrFalse;
+  else if (mayBeTrue)
+    result = isa<ValidResponse>(queryResult) ? PValidity::MustBeTrue
+                                             : PValidity::MayBeTrue;
+  else if (mayBeFalse)
+    result = isa<ValidResponse>(negatedQueryResult) ? PValidity::MustBeFalse
+                                                    : PValidity::MayBeFalse;
+  else
+    result = PValidity::None;
+  trueResponse = negatedQueryResult;
+  falseResponse = queryResult;
+  return true;
+}
+
+std::optional<bool> Executor::speculativeDirection(ExecutionState &current,
+                                                  ref<Expr> condition) {
+  if (!ensureModel(current))
+    return std::nullopt;
+
+  ref<Expr> value = current.model->evaluate(condition, false);
+  if (!isa<ConstantExpr>(value))
+    return std::nullopt;
+  return value->isTrue();
+}
+
+Executor::StatePair Executor::forkSpeculatively(ExecutionState &current,
+                                                ref<Expr> condition,
+                                                bool taken,
+                                                BranchType reason) {
+  ref<Expr> takenCondition = taken ? condition : Expr::createIsZero(condition);
+  ref<Expr> otherCondition =
+      Simplificator::simplifyExpr(current.constraints.cs(),
+                                  Expr::createIsZero(takenCondition))
+          .simplified;
+  StatePair result =
+      taken ? StatePair(&current, nullptr) : StatePair(nullptr, &current);
+
+  // the model satisfies the taken direction, so the other one can at most
+  // simplify to false
+  bool otherIsFalse = isa<ConstantExpr>(otherCondition);
+  assert((!otherIsFalse || otherCondition->isFalse()) &&
+         "model contradicts the path constraints");
+  if (otherIsFalse) {
+    if (pathWriter)
+      current.pathOS << (taken ? "1" : "0");
+    return result;
+  }
+  if (!branchingPermitted(current, 2)) {
+    ++stats::inhibitedForks;
+    if (pathWriter)
+      current.pathOS << (taken ? "1" : "0");
+    addConstraint(current, takenCondition);
+    return result;
+  }
+
+  TimerStatIncrementer timer(stats::forkTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Fork);
+  WallTimer branchTimer;
+  ExecutionState *other = objectManager->branchPendingState(&current);
+
+  if (pathWriter) {
+    other->pathOS = pathWriter->open(current.pathOS);
+    current.pathOS << (taken ? "1" : "0");
+    other->pathOS << (taken ? "0" : "1");
+  }
+  if (symPathWriter) {
+    other->symPathOS = symPathWriter->open(current.symPathOS);
+    current.symPathOS << (taken ? "1" : "0");
+    other->symPathOS << (taken ? "0" : "1");
+  }
+
+  current.afterFork = true;
+  other->afterFork = true;
+  other->model.reset();
+  if (mergeHandler && reason == BranchType::Conditional)
+    mergeHandler->addMergePoint(current.prevPC->parent, current, *other);
+  addConstraint(current, takenCondition);
+  addConstraint(*other, otherCondition);
+
+  std::uint64_t id = backgroundSolver->submit(other->toQuery());
+  speculativeBranches.emplace(
+      id, SpeculativeBranch{other, !taken, reason, branchTimer.delta()});
+  ++stats::speculativeForks;
+  if (LiveMetrics *metrics = LiveMetrics::get())
+    metrics->record(LiveHistogram::SpeculativeQueue,
+                    speculativeBranches.size());
+
+  return result;
+}
+
+void Executor::collectSpeculativeBranches(bool wait) {
+  std::vector<BackgroundSolver::Result> results;
+  WallTimer waitTimer;
+  backgroundSolver->collect(results, wait);
+  time::Span waited = wait ? waitTimer.delta() : time::Span();
+  stats::speculativeWaitTime += waited.toMicroseconds();
+
+  for (auto &result : results) {
+    auto it = speculativeBranches.find(result.id);
+    assert(it != speculativeBranches.end() && "unknown background query");
+    SpeculativeBranch branch = it->second;
+    speculativeBranches.erase(it);
+    if (result.solveTime > waited)
+      stats::speculativeHiddenTime +=
+          (result.solveTime - waited).toMicroseconds();
+
+    ExecutionState &state = *branch.state;
+    if (!result.success || !isa<InvalidResponse>(result.response)) {
+      if (!result.success)
+        klee_warning_once(
+            0, "Query timed out (speculative fork), dropping the branch.");
+      ++stats::speculativeDiscards;
+      stats::speculativeWastedTime += branch.branchTime.toMicroseconds();
+      if (mergeHandler)
+        mergeHandler->discard(state);
+      objectManager->discardPendingState(&state);
+      continue;
+    }
+
+    updateModel(state, result.response);
+
+    // account the fork to the branch instruction, as fork() does
+    unsigned index = theStatisticManager->getIndex();
+    theStatisticManager->setIndex(state.prevPC->getGlobalIndex());
+    ++stats::forks;
+    if (statsTracker)
+      statsTracker->markBranchVisited(branch.taken ? &state : nullptr,
+                                      branch.taken ? nullptr : &state);
+    theStatisticManager->setIndex(index);
+
+    transferToBranchSuccessor(state, branch.taken);
+    objectManager->resumePendingState(&state, branch.reason);
+  }
+}
+
 Executor::StatePair Executor::forkInternal(ExecutionState &current,
                                            ref<Expr> condition,
                                            BranchType reason) {
@@ -1704,6 +2025,8 @@ ref<klee::ConstantExpr> Executor::toConstant(ExecutionState &state, ref<Expr> e,
     return CE;
 
   ref<ConstantExpr> value = getValueFromSeeds(state, e);
+  if (!value)
+    value = getValueFromModel(state, e);
   if (!value) {
     [[maybe_unused]] bool success =
         solver->getValue(state.constraints.cs(), e, value, state.queryMetaData);
@@ -1739,6 +2062,19 @@ ref<klee::ConstantExpr> Executor::getValueFromSeeds(ExecutionState &state,
   return nullptr;
 }
 
+ref<klee::ConstantExpr> Executor::getValueFromModel(ExecutionState &state,
+                                                    ref<Expr> e) {
+  if (!StateModels || !state.model ||
+      !state.constraints.cs().symcretes().empty())
+    return nullptr;
+
+  if (auto value = dyn_cast<ConstantExpr>(state.model->evaluate(e, false))) {
+    ++stats::modelQueries;
+    return value;
+  }
+  return nullptr;
+}
+
 ref<klee::ConstantPointerExpr>
 Executor::toConstantPointer(ExecutionState &state, ref<PointerExpr> e,
                             const char *reason) {
@@ -1777,10 +2113,14 @@ void Executor::executeGetValue(ExecutionState &state, ref<Expr> e,
       isa<ConstantPointerExpr>(e)) {
     ref<Expr> value;
     e = optimizer.optimizeExpr(e, true);
-    bool success =
-        solver->getValue(state.constraints.cs(), e, value, state.queryMetaData);
-    assert(success && "FIXME: Unhandled solver failure");
-    (void)success;
+    if (!isa<PointerExpr>(e))
+      value = getValueFromModel(state, e);
+    if (!value) {
+      bool success = solver->getValue(state.constraints.cs(), e, value,
+                                      state.queryMetaData);
+      assert(success && "FIXME: Unhandled solver failure");
+      (void)success;
+    }
     bindLocal(target, state, value);
   } else {
     std::set<ref<Expr>> values;
@@ -1871,6 +2211,9 @@ void Executor::stepInstruction(ExecutionState &state) {
   printDebugInstructions(state);
   if (statsTracker)
     statsTracker->stepInstruction(state);
+  if (profiler)
+    profiler->stepInstruction(state.pc,
+                              state.stack.infoStack().back().callPathNode);
 
   ++stats::instructions;
   ++state.steppedInstructions;
@@ -2680,6 +3023,19 @@ void Executor::transferToBasicBlock(BasicBlock *dst, BasicBlock *src,
   transferToBasicBlock(kdst, src, state);
 }
 
+void Executor::transferToBranchSuccessor(ExecutionState &state, bool taken) {
+  Instruction *i = state.prevPC->inst();
+  BranchInst *bi = cast<BranchInst>(i);
+  ref<CodeLocation> brLocation = locationOf(state);
+
+  transferToBasicBlock(bi->getSuccessor(taken ? 0 : 1), bi->getParent(),
+                       state);
+  if (kmodule->inMainModule(*i)) {
+    BrEvent *brEvent = new BrEvent(brLocation);
+    state.eventsRecorder.record(&brEvent->withBranch(taken));
+  }
+}
+
 void Executor::checkNullCheckAfterDeref(ref<Expr> cond, ExecutionState &state) {
   std::vector<ref<Expr>> conditions;
   Expr::splitAnds(cond, conditions);
@@ -2849,8 +3205,6 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     break;
   }
   case Instruction::Br: {
-    ref<CodeLocation> brLocation = locationOf(state);
-
     BranchInst *bi = cast<BranchInst>(i);
     if (bi->isUnconditional()) {
       // `getMetadata` is used instead of `hasMetadata`
@@ -2877,6 +3231,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         maxNewStateStackSize =
             std::max(maxNewStateStackSize,
                      branches.first->stack.stackRegisterSize() * 8);
+        if (mergeHandler)
+          mergeHandler->addMergePoint(ki->parent, *branches.first,
+                                      *branches.second);
       }
 
       // NOTE: There is a hidden dependency here, markBranchVisited
@@ -2886,22 +3243,10 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
       if (statsTracker)
         statsTracker->markBranchVisited(branches.first, branches.second);
 
-      if (branches.first) {
-        transferToBasicBlock(bi->getSuccessor(0), bi->getParent(),
-                             *branches.first);
-        if (kmodule->inMainModule(*i)) {
-          BrEvent *brEvent = new BrEvent(brLocation);
-          branches.first->eventsRecorder.record(&brEvent->withBranch(true));
-        }
-      }
-      if (branches.second) {
-        transferToBasicBlock(bi->getSuccessor(1), bi->getParent(),
-                             *branches.second);
-        if (kmodule->inMainModule(*i)) {
-          BrEvent *brEvent = new BrEvent(brLocation);
-          branches.second->eventsRecorder.record(&brEvent->withBranch(false));
-        }
-      }
+      if (branches.first)
+        transferToBranchSuccessor(*branches.first, true);
+      if (branches.second)
+        transferToBranchSuccessor(*branches.second, false);
       if (guidanceKind == GuidanceKind::ErrorGuidance) {
         checkNullCheckAfterDeref(cond, state);
       }
@@ -4471,7 +4816,7 @@ bool Executor::checkMemoryUsage() {
 
   // check memory limit
   const auto mallocUsage = util::GetTotalMallocUsage() >> 20U;
-  const auto mmapUsage = memory->getUsedDeterministicSize() >> 20U;
+  const auto mmapUsage = memory->getUsedArenaSize() >> 20U;
   const auto totalUsage = mallocUsage + mmapUsage;
 
   if (MemoryTriggerCoverOnTheFly && totalUsage > MaxMemory * 0.75) {
@@ -4493,6 +4838,19 @@ bool Executor::checkMemoryUsage() {
   auto states = objectManager->getStates();
   const auto numStates = states.size();
   auto toKill = std::max(1UL, numStates - numStates * MaxMemory / totalUsage);
+
+  if (MemoryVictimSelection == MemoryVictimPolicy::Footprint) {
+    auto victims =
+        selectMemoryVictims(states, (totalUsage - MaxMemory) << 20U, toKill);
+    klee_warning("killing %lu states (over memory cap: %luMB)", victims.size(),
+                 totalUsage);
+    for (auto state : victims) {
+      terminateStateEarly(*state, "Memory limit exceeded.",
+                          StateTerminationType::OutOfMemory);
+    }
+    return false;
+  }
+
   klee_warning("killing %lu states (over memory cap: %luMB)", toKill,
                totalUsage);
 
@@ -4514,6 +4872,56 @@ bool Executor::checkMemoryUsage() {
   return false;
 }
 
+/// Rough estimate of how likely a state is to cover new code: states that
+/// just covered something or are close to uncovered instructions score high.
+static double getCoveragePotential(const ExecutionState &state) {
+  uint64_t md2u = computeMinDistToUncovered(
+      state.pc, state.stack.infoStack().back().minDistToUncoveredOnReturn);
+  double potential = 1. / (md2u ? md2u : 10000);
+  if (state.isCoveredNew())
+    potential += 1.;
+  return potential;
+}
+
+std::vector<ExecutionState *>
+Executor::selectMemoryVictims(const states_ty &states, uint64_t bytesToFree,
+                              unsigned long fallbackCount) {
+  struct Candidate {
+    double score;
+    std::size_t exclusive;
+    ExecutionState *state;
+  };
+  std::vector<Candidate> candidates;
+  candidates.reserve(states.size());
+  for (auto state : states) {
+    std::size_t exclusive = state->getMemoryFootprint().exclusive;
+    candidates.push_back(
+        {exclusive / getCoveragePotential(*state), exclusive, state});
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate &a, const Candidate &b) {
+              if (a.score != b.score)
+                return a.score > b.score;
+              return a.state->getID() < b.state->getID();
+            });
+
+  std::vector<ExecutionState *> victims;
+  uint64_t freedBytes = 0;
+  for (const auto &candidate : candidates) {
+    if (freedBytes >= bytesToFree)
+      break;
+    victims.push_back(candidate.state);
+    freedBytes += candidate.exclusive;
+  }
+
+  // The accounting does not see allocator overhead or solver caches, so if
+  // it cannot explain the excess, fall back to the proportional guess.
+  if (freedBytes < bytesToFree) {
+    victims.resize(std::min<std::size_t>(fallbackCount, candidates.size()));
+  }
+  return victims;
+}
+
 void Executor::decreaseConfidenceFromStoppedStates(
     const SetOfStates &leftStates, HaltExecution::Reason reason) {
   if (targets.size() == 0) {
@@ -4541,7 +4949,12 @@ void Executor::doDumpStates() {
 
   klee_message("halting execution, dumping remaining states");
   for (const auto &state : objectManager->getStates()) {
-    terminateStateEarly(*state, "Execution halting.",
+    MemoryFootprint footprint = state->getMemoryFootprint();
+    terminateStateEarly(*state,
+                        "Execution halting.\nMemory: " +
+                            llvm::Twine(footprint.exclusive) +
+                            " bytes exclusive, " +
+                            llvm::Twine(footprint.shared) + " bytes shared",
                         StateTerminationType::Interrupted);
   }
   objectManager->updateSubscribers();
@@ -4710,10 +5123,52 @@ void Executor::run(ExecutionState *initialState) {
 
   objectManager->addSubscriber(searcher.get());
 
+  if (MergeStates && !usingSeeds && !replayKTest && !replayPath &&
+      guidanceKind != GuidanceKind::ErrorGuidance) {
+    mergeHandler = std::make_unique<MergeHandler>(*codeGraphInfo);
+    objectManager->addSubscriber(mergeHandler.get());
+  }
+
+  if (SummarizeLoops && !replayKTest && !replayPath)
+    loopSummarizer = std::make_unique<LoopSummarizer>(*this);
+
   objectManager->initialUpdate();
 
+  if (SpeculativeFork) {
+    std::unique_ptr<Solver> coreSolver = createCoreSolver(CoreSolverToUse);
+    if (!coreSolver)
+      klee_error("Failed to create core solver for speculative forks");
+    std::unique_ptr<Solver> background =
+        constructBackgroundSolverChain(std::move(coreSolver));
+    background->setCoreSolverLimits(coreSolverTimeout, coreSolverMemoryLimit);
+    backgroundSolver =
+        std::make_unique<BackgroundSolver>(std::move(background));
+  }
+
+  if (profiler)
+    profiler->start();
+
   // main interpreter loop
-  while (!haltExecution && !searcher->empty()) {
+  while (!haltExecution &&
+         (!searcher->empty() || !speculativeBranches.empty() ||
+          (mergeHandler && mergeHandler->hasHeldStates()))) {
+    if (mergeHandler && mergeHandler->hasHeldStates()) {
+      // with nothing else to run, the held states are not joined any more
+      bool idle = searcher->empty() && speculativeBranches.empty();
+      for (auto state : mergeHandler->release(idle))
+        objectManager->resumeState(state);
+      objectManager->updateSubscribers();
+    }
+    if (backgroundSolver) {
+      backgroundSolver->yield();
+      if (!speculativeBranches.empty()) {
+        collectSpeculativeBranches(searcher->empty());
+        objectManager->updateSubscribers();
+        if (searcher->empty())
+          continue;
+      }
+    }
+
     auto action = searcher->selectAction();
     executeAction(action);
     objectManager->updateSubscribers();
@@ -4723,6 +5178,26 @@ void Executor::run(ExecutionState *initialState) {
     }
   }
 
+  if (backgroundSolver) {
+    // branches that are still unanswered when execution halts are dropped
+    for (auto &branch : speculativeBranches) {
+      ++stats::speculativeDiscards;
+      stats::speculativeWastedTime +=
+          branch.second.branchTime.toMicroseconds();
+      if (mergeHandler)
+        mergeHandler->discard(*branch.second.state);
+      objectManager->discardPendingState(branch.second.state);
+    }
+    speculativeBranches.clear();
+    backgroundSolver = nullptr;
+  }
+
+  if (mergeHandler) {
+    for (auto state : mergeHandler->release(true))
+      objectManager->resumeState(state);
+    objectManager->updateSubscribers();
+  }
+
   if (guidanceKind == GuidanceKind::ErrorGuidance) {
     reportProgressTowardsTargets();
     decreaseConfidenceFromStoppedStates(objectManager->getStates(),
@@ -4737,14 +5212,39 @@ void Executor::run(ExecutionState *initialState) {
       haltExecution = HaltExecution::NoMoreStates;
   }
 
+  if (profiler) {
+    profiler->stop();
+    writeProfile();
+  }
+
   doDumpStates();
 
   searcher = nullptr;
+  mergeHandler = nullptr;
+  loopSummarizer = nullptr;
   targetManager = nullptr;
 
   haltExecution = HaltExecution::NotHalt;
 }
 
+bool Executor::mergeOrHold(ExecutionState &state) {
+  if (!mergeHandler)
+    return false;
+  switch (mergeHandler->arrive(state)) {
+  case MergeHandler::Arrival::Continue:
+    return false;
+  case MergeHandler::Arrival::Held:
+    objectManager->suspendState(&state);
+    return true;
+  case MergeHandler::Arrival::Merged:
+    // the paths of the state go on in the state it was merged into
+    solver->notifyStateTermination(state.id);
+    objectManager->removeState(&state);
+    return true;
+  }
+  return false;
+}
+
 static bool shouldWriteTest(const ExecutionState &state, bool isError = false) {
   state.updateCoveredNew();
   bool coveredNew = isError ? state.isCoveredNewError() : state.isCoveredNew();
@@ -4820,7 +5320,8 @@ void Executor::goForward(ref<ForwardAction> action) {
   } else if (state.isSymbolicCycled(MaxSymbolicCycles)) {
     terminateStateEarly(state, "max-sym-cycles exceeded.",
                         StateTerminationType::MaxCycles);
-  } else {
+  } else if (!mergeOrHold(state) &&
+             !(loopSummarizer && loopSummarizer->summarize(state))) {
     maxNewWriteableOSSize = 0;
     maxNewStateStackSize = 0;
 
@@ -5368,8 +5869,12 @@ void Executor::callExternalFunction(ExecutionState &state, KInstruction *target,
     return;
   }
 
-  bool success = externalDispatcher->executeCall(callable, target->inst(), args,
-                                                 roundingMode);
+  bool success;
+  {
+    Profiler::PhaseScope phase(Profiler::Phase::External);
+    success = externalDispatcher->executeCall(callable, target->inst(), args,
+                                              roundingMode);
+  }
 
   if (!success) {
     if (interpreterOpts.Mock == MockPolicy::Failed) {
@@ -7216,7 +7721,7 @@ void Executor::addSARIFReport(const ExecutionState &state) {
 SarifReportJson Executor::getSARIFReport() const { return sarifReport; }
 
 void Executor::logState(const ExecutionState &state, int id,
-                        std::unique_ptr<llvm::raw_fd_ostream> &f) {
+                        std::unique_ptr<llvm::raw_ostream> &f) {
   *f << "State number " << state.id << ". Test number: " << id << "\n\n";
   for (auto &object : state.addressSpace.objects) {
     *f << "ID memory object: " << object.first->id << "\n";
@@ -7509,20 +8014,36 @@ bool Executor::getSymbolicSolution(const ExecutionState &state, KTest &res) {
   std::vector<const Array *> objects(objectSet.begin(), objectSet.end());
 
   ref<SolverResponse> response;
-  solver->setLimits(coreSolverTimeout, coreSolverMemoryLimit);
-  bool success =
-      solver->getResponse(extendedConstraints.cs(), Expr::createFalse(),
-                          response, state.queryMetaData);
-  solver->setLimits(time::Span(), 0);
-  if (!success || !isa<InvalidResponse>(response)) {
-    klee_warning("unable to compute initial values (invalid constraints?)!");
-    ExprPPrinter::printQuery(llvm::errs(), state.constraints.cs(),
-                             ConstantExpr::alloc(0, Expr::Bool));
-    return false;
+  Assignment model;
+  const constraints_ty &extended = extendedConstraints.cs().cs();
+  if (StateModels && state.model &&
+      extendedConstraints.cs().symcretes().empty() &&
+      Assignment(*state.model)
+          .satisfies(extended.begin(), extended.end(), false)) {
+    // the model of the state also satisfies the preferences
+    ++stats::modelQueries;
+    std::vector<SparseStorageImpl<unsigned char>> values;
+    for (auto object : objects) {
+      auto binding = state.model->bindings.find(object);
+      values.push_back(binding != state.model->bindings.end()
+                           ? binding->second
+                           : SparseStorageImpl<unsigned char>(0));
+    }
+    model = Assignment(objects, values);
+  } else {
+    solver->setLimits(coreSolverTimeout, coreSolverMemoryLimit);
+    bool success =
+        solver->getResponse(extendedConstraints.cs(), Expr::createFalse(),
+                            response, state.queryMetaData);
+    solver->setLimits(time::Span(), 0);
+    if (!success || !isa<InvalidResponse>(response)) {
+      klee_warning("unable to compute initial values (invalid constraints?)!");
+      ExprPPrinter::printQuery(llvm::errs(), state.constraints.cs(),
+                               ConstantExpr::alloc(0, Expr::Bool));
+      return false;
+    }
+    model = cast<InvalidResponse>(response)->initialValuesFor(objects);
   }
-  assert(isa<InvalidResponse>(response));
-
-  Assignment model = cast<InvalidResponse>(response)->initialValuesFor(objects);
   AssignmentEvaluator evaluator(model, false);
 
   Expr::Width pointerWidthInBits = Context::get().getPointerWidth();
@@ -7773,6 +8294,17 @@ void Executor::prepareForEarlyExit() {
     // Make sure stats get flushed out
     statsTracker->done();
   }
+  if (profiler) {
+    profiler->stop();
+    writeProfile();
+  }
+}
+
+void Executor::writeProfile() {
+  if (auto os = interpreterHandler->openOutputFile("profile.folded"))
+    profiler->writeFoldedStacks(*os);
+  if (auto os = interpreterHandler->openOutputFile("profile.lines"))
+    profiler->writeHotSpots(*os);
 }
 
 /// Returns the errno location in memory
@@ -7829,8 +8361,7 @@ void Executor::dumpStates() {
           computeMinDistToUncovered(es->pc, sf.minDistToUncoveredOnReturn);
       uint64_t icnt = theStatisticManager->getIndexedValue(
           stats::instructions, es->pc->getGlobalIndex());
-      uint64_t cpicnt =
-          sf.callPathNode->statistics.getValue(stats::instructions);
+      uint64_t cpicnt = sf.callPathNode->getValue(stats::instructions);
 
       *os << "{";
       *os << "'depth' : " << es->depth << ", ";
@@ -7840,6 +8371,9 @@ void Executor::dumpStates() {
       *os << "'md2u' : " << md2u << ", ";
       *os << "'icnt' : " << icnt << ", ";
       *os << "'CPicnt' : " << cpicnt << ", ";
+      *os << "'pathBlocks' : " << es->constraints.path().KBlockSize() << ", ";
+      *os << "'pathBytes' : " << es->constraints.path().getMemoryUsage()
+          << ", ";
       *os << "}";
       *os << ")\n";
     }
@@ -45,6 +45,7 @@
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -74,6 +75,7 @@ class Value;
 
 namespace klee {
 class Array;
+class BackgroundSolver;
 struct Cell;
 class CodeGraphInfo;
 struct CodeLocation;
@@ -92,6 +94,7 @@ class MemoryManager;
 class MemoryObject;
 class ObjectState;
 class PForest;
+class Profiler;
 class Searcher;
 class SeedInfo;
 class SpecialFunctionHandler;
@@ -102,6 +105,7 @@ class TargetManager;
 class StatsTracker;
 class TimingSolver;
 class TreeStreamWriter;
+class LoopSummarizer;
 class MergeHandler;
 class MergingSearcher;
 template <class T> class ref;
@@ -111,6 +115,7 @@ template <class T> class ref;
 /// removedStates, and haltExecution, among others.
 
 class Executor : public Interpreter {
+  friend class LoopSummarizer;
   friend class OwningSearcher;
   friend class WeightedRandomSearcher;
   friend class SpecialFunctionHandler;
@@ -154,6 +159,7 @@ private:
 
   std::unique_ptr<ObjectManager> objectManager;
   StatsTracker *statsTracker;
+  std::unique_ptr<Profiler> profiler;
   TreeStreamWriter *pathWriter, *symPathWriter;
   SpecialFunctionHandler *specialFunctionHandler;
   TimerGroup timers;
@@ -173,6 +179,32 @@ private:
   /// on as-yet-to-be-determined flags.
   std::unique_ptr<SeedMap> seedMap;
 
+  /// Checks the directions left behind by speculative forks (see
+  /// --speculative-fork). Only exists while run() runs.
+  std::unique_ptr<BackgroundSolver> backgroundSolver;
+
+  /// A state branched by a speculative fork that waits for the background
+  /// solver to decide whether its path is feasible.
+  struct SpeculativeBranch {
+    ExecutionState *state;
+    /// The successor of the branch instruction the state goes to.
+    bool taken;
+    BranchType reason;
+    /// Time spent branching the state.
+    time::Span branchTime;
+  };
+
+  /// Speculative branches by the ids of their background queries.
+  std::unordered_map<std::uint64_t, SpeculativeBranch> speculativeBranches;
+
+  /// Holds and merges states at the post-dominators of symbolic branches
+  /// (see --merge-states). Only exists while run() runs.
+  std::unique_ptr<MergeHandler> mergeHandler;
+
+  /// Summarizes loops that only read memory (see --summarize-loops). Only
+  /// exists while run() runs.
+  std::unique_ptr<LoopSummarizer> loopSummarizer;
+
   /// Map of globals to their representative memory object.
   std::map<const llvm::GlobalValue *, MemoryObject *> globalObjects;
 
@@ -299,6 +331,9 @@ private:
                             ExecutionState &state);
   void transferToBasicBlock(KBlock *dst, llvm::BasicBlock *src,
                             ExecutionState &state);
+  /// Move a state that executed a conditional branch to its true or false
+  /// successor.
+  void transferToBranchSuccessor(ExecutionState &state, bool taken);
 
   void callExternalFunction(ExecutionState &state, KInstruction *target,
                             KCallable *callable,
@@ -453,6 +488,40 @@ private:
   StatePair forkInternal(ExecutionState &current, ref<Expr> condition,
                          BranchType reason);
 
+  /// Make sure that state has a model of its path constraints, with one
+  /// solver query if it has none. Fails if the constraints have symcretes,
+  /// which the solver chain concretizes and a model ignores.
+  bool ensureModel(ExecutionState &state);
+
+  /// Extend the model of state with the counterexample of response, and keep
+  /// the result if it satisfies the path constraints that read the arrays the
+  /// counterexample rebinds. A state without a model keeps none.
+  void updateModel(ExecutionState &state, ref<SolverResponse> response);
+
+  /// Like solver->evaluate, but let the model of current, computed first if
+  /// it has none, decide one direction of the condition so that only the
+  /// other one goes to the solver (see --state-models). The counterexamples
+  /// that show a direction feasible are returned in trueResponse and
+  /// falseResponse.
+  bool evaluateWithModel(ExecutionState &current, ref<Expr> condition,
+                         PartialValidity &result,
+                         ref<SolverResponse> &trueResponse,
+                         ref<SolverResponse> &falseResponse);
+
+  /// Return the direction that a model of the path constraints of current
+  /// takes at the condition, if there is a cheap way to find one.
+  std::optional<bool> speculativeDirection(ExecutionState &current,
+                                           ref<Expr> condition);
+
+  /// Fork current at a conditional branch by following the direction taken
+  /// and leaving the other one to the background solver.
+  StatePair forkSpeculatively(ExecutionState &current, ref<Expr> condition,
+                              bool taken, BranchType reason);
+
+  /// Resume or discard the speculative branches that the background solver
+  /// has answered. If wait is set, block until there is an answer.
+  void collectSpeculativeBranches(bool wait);
+
   // If the MaxStatic*Pct limits have been reached, concretize the condition
   // and return it. Otherwise, return the unmodified condition.
   ref<Expr> maxStaticPctChecks(ExecutionState &current, ref<Expr> condition);
@@ -587,6 +656,10 @@ private:
   /// seeds.
   ref<klee::ConstantExpr> getValueFromSeeds(ExecutionState &state, ref<Expr> e);
 
+  /// Evaluate the given expression under the model of the state, if it has
+  /// one and --state-models is set. Returns null otherwise.
+  ref<klee::ConstantExpr> getValueFromModel(ExecutionState &state, ref<Expr> e);
+
   ref<klee::ConstantPointerExpr> toConstantPointer(ExecutionState &state,
                                                    ref<PointerExpr> e,
                                                    const char *purpose);
@@ -718,6 +791,14 @@ private:
   /// terminated)
   bool checkMemoryUsage();
 
+  /// Pick states to terminate so that roughly \a bytesToFree bytes are
+  /// released, preferring states that hold the most exclusive memory per
+  /// unit of coverage potential. Falls back to the \a fallbackCount
+  /// best-ranked states if the accounting cannot explain the excess.
+  std::vector<ExecutionState *> selectMemoryVictims(const states_ty &states,
+                                                    uint64_t bytesToFree,
+                                                    unsigned long fallbackCount);
+
   /// check if branching/forking into N branches is allowed
   bool branchingPermitted(ExecutionState &state, unsigned N);
 
@@ -730,6 +811,9 @@ private:
 
   void executeAction(ref<SearcherAction> action);
   void goForward(ref<ForwardAction> action);
+  /// Hand a state at a merge point to the merge handler. Returns whether the
+  /// state was suspended or merged into another state.
+  bool mergeOrHold(ExecutionState &state);
 
   const KInstruction *getKInst(const llvm::Instruction *ints) const;
   const KBlock *getKBlock(const llvm::BasicBlock *bb) const;
@@ -823,6 +907,10 @@ public:
 
   void prepareForEarlyExit() override;
 
+  /// Write profile.folded and profile.lines with the samples collected so
+  /// far
+  void writeProfile();
+
   /*** State accessor methods ***/
 
   unsigned getPathStreamID(const ExecutionState &state) override;
@@ -842,7 +930,7 @@ public:
                               const Assignment &model, KTest &tc);
 
   void logState(const ExecutionState &state, int id,
-                std::unique_ptr<llvm::raw_fd_ostream> &f) override;
+                std::unique_ptr<llvm::raw_ostream> &f) override;
 
   bool getSymbolicSolution(const ExecutionState &state, KTest &res) override;
 
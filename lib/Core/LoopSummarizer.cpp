@@ -0,0 +1,461 @@
+//===-- LoopSummarizer.cpp ------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "LoopSummarizer.h"
+
+#include "AddressSpace.h"
+#include "CoreStats.h"
+#include "ExecutionState.h"
+#include "Executor.h"
+#include "Memory.h"
+#include "StatsTracker.h"
+#include "TimingSolver.h"
+
+#include "klee/Core/BranchTypes.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Module/KInstruction.h"
+#include "klee/Module/KModule.h"
+#include "klee/Support/OptionCategories.h"
+
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Support/CommandLine.h"
+
+using namespace llvm;
+using namespace klee;
+
+namespace {
+cl::opt<unsigned> LoopSummaryMaxIterations(
+    "loop-summary-max-iterations", cl::init(1024),
+    cl::desc("Number of iterations of a loop evaluated for its summary, "
+             "beyond which the loop runs as usual (default=1024)"),
+    cl::cat(SearchCat));
+
+bool isSummarizable(const Instruction &inst) {
+  switch (inst.getOpcode()) {
+  case Instruction::PHI:
+  case Instruction::Br:
+  case Instruction::Add:
+  case Instruction::Sub:
+  case Instruction::Mul:
+  case Instruction::And:
+  case Instruction::Or:
+  case Instruction::Xor:
+  case Instruction::ICmp:
+  case Instruction::Select:
+  case Instruction::Trunc:
+  case Instruction::ZExt:
+  case Instruction::SExt:
+  case Instruction::GetElementPtr:
+    return !inst.getType()->isVectorTy();
+  case Instruction::BitCast:
+    return inst.getType()->isPointerTy();
+  case Instruction::Load: {
+    auto &load = cast<LoadInst>(inst);
+    return load.isSimple() && (load.getType()->isIntegerTy() ||
+                               load.getType()->isPointerTy());
+  }
+  case Instruction::Call:
+    return isa<DbgInfoIntrinsic>(inst);
+  default:
+    return false;
+  }
+}
+} // namespace
+
+LoopSummarizer::LoopSummarizer(Executor &executor) : executor(executor) {}
+
+void LoopSummarizer::analyze(KFunction *kf) {
+  if (!analyzed.insert(kf).second)
+    return;
+  DominatorTree dt(*kf->function());
+  LoopInfo li(dt);
+  for (const Loop *loop : li.getLoopsInPreorder()) {
+    if (!loop->isInnermost())
+      continue;
+    Shape shape;
+    if (analyzeLoop(kf, *loop, shape))
+      shapes.emplace(kf->blockMap.at(loop->getHeader()), std::move(shape));
+  }
+}
+
+bool LoopSummarizer::analyzeLoop(KFunction *kf, const Loop &loop,
+                                 Shape &shape) {
+  BasicBlock *header = loop.getHeader();
+  for (BasicBlock *block : loop.blocks())
+    shape.members.insert(block);
+
+  // follow the loop from its header, which has to take every block of it
+  // once before getting back
+  BasicBlock *block = header;
+  do {
+    if (shape.blocks.size() == shape.members.size())
+      return false;
+    shape.blocks.push_back(kf->blockMap.at(block));
+    for (const Instruction &inst : *block) {
+      if (!isSummarizable(inst) || (isa<PHINode>(inst) && block != header))
+        return false;
+    }
+    auto br = dyn_cast<BranchInst>(block->getTerminator());
+    if (!br)
+      return false;
+    BasicBlock *next = nullptr;
+    for (BasicBlock *successor : br->successors()) {
+      if (!shape.members.count(successor))
+        continue;
+      if (next)
+        return false;
+      next = successor;
+    }
+    if (!next)
+      return false;
+    block = next;
+  } while (block != header);
+  if (shape.blocks.size() != shape.members.size())
+    return false;
+
+  for (KBlock *kb : shape.blocks) {
+    for (unsigned i = 0; i < kb->getNumInstructions(); ++i) {
+      KInstruction *ki = kb->instructions[i];
+      for (const User *user : ki->inst()->users()) {
+        auto inst = dyn_cast<Instruction>(user);
+        if (inst && !shape.members.count(inst->getParent())) {
+          shape.liveOuts.push_back(ki);
+          break;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool LoopSummarizer::entersLoop(const ExecutionState &state,
+                                const Shape &shape) const {
+  if (!state.prevPC)
+    return false;
+  auto br = dyn_cast<BranchInst>(state.prevPC->inst());
+  if (!br || shape.members.count(br->getParent()))
+    return false;
+  BasicBlock *header = shape.blocks.front()->basicBlock();
+  return llvm::is_contained(br->successors(), header);
+}
+
+ref<Expr> LoopSummarizer::getOperand(ExecutionState &state,
+                                     const Shape &shape, KInstruction *ki,
+                                     unsigned index, const Values &values) {
+  auto inst = dyn_cast<Instruction>(ki->inst()->getOperand(index));
+  if (inst && shape.members.count(inst->getParent())) {
+    auto it = values.find(inst);
+    return it == values.end() ? nullptr : it->second;
+  }
+  return executor.eval(ki, index, state).value;
+}
+
+ref<Expr> LoopSummarizer::load(ExecutionState &state, KInstruction *ki,
+                               ref<Expr> address) {
+  auto pointer = dyn_cast<ConstantPointerExpr>(executor.makePointer(address));
+  if (!pointer)
+    return nullptr;
+  ObjectPair op;
+  if (!state.addressSpace.resolveOne(pointer, op) || !op.second)
+    return nullptr;
+  const MemoryObject *mo = op.first;
+  auto base = dyn_cast<ConstantExpr>(mo->getBaseExpr());
+  auto size = dyn_cast<ConstantExpr>(mo->getSizeExpr());
+  if (!base || !size)
+    return nullptr;
+
+  Expr::Width width = executor.getWidthForLLVMType(ki->inst()->getType());
+  uint64_t offset = pointer->getConstantValue()->getZExtValue() -
+                    base->getZExtValue();
+  uint64_t bytes = Expr::getMinBytesForWidth(width);
+  if (offset > size->getZExtValue() ||
+      bytes > size->getZExtValue() - offset)
+    return nullptr;
+
+  ref<Expr> result = op.second->read(offset, width);
+  if (ki->inst()->getType()->isPointerTy())
+    result = executor.makePointer(result);
+  return result;
+}
+
+ref<Expr> LoopSummarizer::evaluate(ExecutionState &state, const Shape &shape,
+                                   KInstruction *ki, const Values &values) {
+  Instruction *inst = ki->inst();
+  std::vector<ref<Expr>> operands;
+  for (unsigned i = 0; i < inst->getNumOperands(); ++i) {
+    if (isa<BasicBlock>(inst->getOperand(i)))
+      continue;
+    ref<Expr> operand = getOperand(state, shape, ki, i, values);
+    if (operand.isNull())
+      return nullptr;
+    operands.push_back(operand);
+  }
+
+  switch (inst->getOpcode()) {
+  case Instruction::Add:
+    return AddExpr::create(operands[0], operands[1]);
+  case Instruction::Sub:
+    return SubExpr::create(operands[0], operands[1]);
+  case Instruction::Mul:
+    return MulExpr::create(operands[0], operands[1]);
+  case Instruction::And:
+    return AndExpr::create(operands[0], operands[1]);
+  case Instruction::Or:
+    return OrExpr::create(operands[0], operands[1]);
+  case Instruction::Xor:
+    return XorExpr::create(operands[0], operands[1]);
+  case Instruction::Select:
+    return SelectExpr::create(operands[0], operands[1], operands[2]);
+  case Instruction::Trunc:
+    return ExtractExpr::create(operands[0], 0,
+                               executor.getWidthForLLVMType(inst->getType()));
+  case Instruction::ZExt:
+    return ZExtExpr::create(operands[0],
+                            executor.getWidthForLLVMType(inst->getType()));
+  case Instruction::SExt:
+    return SExtExpr::create(operands[0],
+                            executor.getWidthForLLVMType(inst->getType()));
+  case Instruction::BitCast:
+    return operands[0];
+  case Instruction::Load:
+    return load(state, ki, operands[0]);
+
+  case Instruction::ICmp: {
+    ref<Expr> left = operands[0];
+    ref<Expr> right = operands[1];
+    switch (cast<ICmpInst>(inst)->getPredicate()) {
+    case ICmpInst::ICMP_EQ:
+      return EqExpr::create(left, right);
+    case ICmpInst::ICMP_NE:
+      return NeExpr::create(left, right);
+    case ICmpInst::ICMP_UGT:
+      return UgtExpr::create(left, right);
+    case ICmpInst::ICMP_UGE:
+      return UgeExpr::create(left, right);
+    case ICmpInst::ICMP_ULT:
+      return UltExpr::create(left, right);
+    case ICmpInst::ICMP_ULE:
+      return UleExpr::create(left, right);
+    case ICmpInst::ICMP_SGT:
+      return SgtExpr::create(left, right);
+    case ICmpInst::ICMP_SGE:
+      return SgeExpr::create(left, right);
+    case ICmpInst::ICMP_SLT:
+      return SltExpr::create(left, right);
+    case ICmpInst::ICMP_SLE:
+      return SleExpr::create(left, right);
+    default:
+      return nullptr;
+    }
+  }
+
+  case Instruction::GetElementPtr: {
+    // as in Executor::executeInstruction
+    auto kgepi = static_cast<KGEPInstruction *>(ki);
+    ref<PointerExpr> pointer = executor.makePointer(operands[0]);
+    ref<Expr> base = pointer->getBase();
+    ref<Expr> offset = pointer->getOffset();
+    for (auto &index : kgepi->indices) {
+      ref<Expr> value = getOperand(state, shape, ki, index.first, values);
+      offset = AddExpr::create(
+          offset, MulExpr::create(Expr::createSExtToPointerWidth(value),
+                                  Expr::createPointer(index.second)));
+    }
+    if (kgepi->offset)
+      offset = AddExpr::create(offset, Expr::createPointer(kgepi->offset));
+    if (ref<PointerExpr> pointerOffset = dyn_cast<PointerExpr>(offset)) {
+      return cast<PointerExpr>(PointerExpr::create(base, base))
+          ->Add(pointerOffset);
+    }
+    return PointerExpr::create(base, AddExpr::create(base, offset));
+  }
+
+  default:
+    return nullptr;
+  }
+}
+
+bool LoopSummarizer::evaluateLoop(ExecutionState &state, const Shape &shape,
+                                  std::vector<Exit> &exits) {
+  KBlock *header = shape.blocks.front();
+  BasicBlock *latch = shape.blocks.back()->basicBlock();
+  Values values;
+  for (unsigned iteration = 0; iteration < LoopSummaryMaxIterations;
+       ++iteration) {
+    ++stats::summarizedIterations;
+    // the phis take their values at once
+    Values next;
+    for (unsigned i = 0; i < header->getNumInstructions(); ++i) {
+      KInstruction *ki = header->instructions[i];
+      auto phi = dyn_cast<PHINode>(ki->inst());
+      if (!phi)
+        break;
+      ref<Expr> value =
+          iteration == 0
+              ? executor.eval(ki, state.incomingBBIndex, state).value
+              : getOperand(state, shape, ki,
+                           phi->getBasicBlockIndex(latch), values);
+      if (value.isNull())
+        return false;
+      next[phi] = value;
+    }
+    values = std::move(next);
+
+    for (unsigned b = 0; b < shape.blocks.size(); ++b) {
+      KBlock *kb = shape.blocks[b];
+      for (unsigned i = 0; i < kb->getNumInstructions(); ++i) {
+        KInstruction *ki = kb->instructions[i];
+        Instruction *inst = ki->inst();
+        if (isa<PHINode>(inst) || isa<DbgInfoIntrinsic>(inst))
+          continue;
+        auto br = dyn_cast<BranchInst>(inst);
+        if (!br) {
+          ref<Expr> value = evaluate(state, shape, ki, values);
+          if (value.isNull())
+            return false;
+          values[inst] = value;
+          continue;
+        }
+        if (br->isUnconditional())
+          break;
+
+        ref<Expr> condition = getOperand(state, shape, ki, 0, values);
+        if (condition.isNull())
+          return false;
+        if (shape.members.count(br->getSuccessor(0)))
+          condition = Expr::createIsZero(condition);
+        if (condition->isFalse())
+          break;
+
+        Exit exit{condition, b, {}};
+        for (KInstruction *liveOut : shape.liveOuts) {
+          auto it = values.find(liveOut->inst());
+          exit.values.push_back(it == values.end() ? nullptr : it->second);
+        }
+        exits.push_back(std::move(exit));
+        if (condition->isTrue())
+          return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool LoopSummarizer::summarize(ExecutionState &state) {
+  KBlock *header = state.pc->parent;
+  if (state.pc != header->getFirstInstruction())
+    return false;
+  if (state.unsummarizedLoop == header) {
+    state.unsummarizedLoop = nullptr;
+    return false;
+  }
+  analyze(header->parent);
+  auto it = shapes.find(header);
+  if (it == shapes.end() || !entersLoop(state, it->second))
+    return false;
+  const Shape &shape = it->second;
+
+  std::vector<Exit> exits;
+  bool complete = evaluateLoop(state, shape, exits);
+  bool symbolic = false;
+  for (auto &exit : exits)
+    symbolic |= !isa<ConstantExpr>(exit.condition);
+  if (!symbolic)
+    return false;
+
+  // the loop is left through the first exit whose condition holds
+  std::vector<ref<Expr>> taken(exits.size());
+  ref<Expr> none = Expr::createTrue();
+  for (unsigned i = 0; i < exits.size(); ++i) {
+    taken[i] = AndExpr::create(none, exits[i].condition);
+    none = AndExpr::create(none, Expr::createIsZero(exits[i].condition));
+  }
+
+  std::vector<unsigned> blockOrder;
+  std::unordered_map<unsigned, ref<Expr>> blockConditions;
+  for (unsigned i = 0; i < exits.size(); ++i) {
+    auto res = blockConditions.emplace(exits[i].block, taken[i]);
+    if (res.second)
+      blockOrder.push_back(exits[i].block);
+    else
+      res.first->second = OrExpr::create(res.first->second, taken[i]);
+  }
+
+  // feasible exits, and the loop itself if not all iterations are covered
+  std::vector<int> targets;
+  std::vector<ref<Expr>> conditions;
+  auto addTarget = [&](int target, ref<Expr> condition) {
+    condition = executor.optimizer.optimizeExpr(condition, false);
+    bool result;
+    if (!executor.solver->mayBeTrue(state.constraints.cs(), condition, result,
+                                    state.queryMetaData))
+      return false;
+    if (result) {
+      targets.push_back(target);
+      conditions.push_back(condition);
+    }
+    return true;
+  };
+  // on solver failures the loop runs as usual
+  for (unsigned block : blockOrder) {
+    if (!addTarget(block, blockConditions.at(block)))
+      return false;
+  }
+  if (!complete && !addTarget(-1, none))
+    return false;
+  if (conditions.empty())
+    return false;
+
+  ++stats::summarizedLoops;
+  std::vector<ExecutionState *> branches;
+  executor.branch(state, conditions, branches, BranchType::LoopSummary);
+
+  for (unsigned i = 0; i < branches.size(); ++i) {
+    ExecutionState *es = branches[i];
+    if (!es)
+      continue;
+    if (targets[i] < 0) {
+      es->unsummarizedLoop = header;
+      continue;
+    }
+    unsigned block = targets[i];
+    // The iterations are not executed. The blocks up to the exiting one
+    // ran in the last of them, so they are covered and go on the path once.
+    for (unsigned b = 0; b <= block; ++b) {
+      KBlock *kb = shape.blocks[b];
+      for (unsigned j = 0; j < kb->getNumInstructions(); ++j) {
+        if (executor.statsTracker)
+          executor.statsTracker->markCovered(*es, kb->instructions[j]);
+        es->constraints.advancePath(kb->instructions[j]);
+      }
+    }
+    for (unsigned l = 0; l < shape.liveOuts.size(); ++l) {
+      ref<Expr> value;
+      for (auto exit = exits.rbegin(); exit != exits.rend(); ++exit) {
+        if (exit->block != block || exit->values[l].isNull())
+          continue;
+        value = value.isNull() ? exit->values[l]
+                               : SelectExpr::create(exit->condition,
+                                                    exit->values[l], value);
+      }
+      if (!value.isNull())
+        executor.bindLocal(shape.liveOuts[l], *es, value);
+    }
+    BasicBlock *exiting = shape.blocks[block]->basicBlock();
+    auto br = cast<BranchInst>(exiting->getTerminator());
+    BasicBlock *exitBlock = shape.members.count(br->getSuccessor(0))
+                                ? br->getSuccessor(1)
+                                : br->getSuccessor(0);
+    executor.transferToBasicBlock(exitBlock, exiting, *es);
+  }
+  return true;
+}
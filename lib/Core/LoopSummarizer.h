@@ -0,0 +1,108 @@
+//===-- LoopSummarizer.h ----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Loops that only read memory and leave in the first iteration in which one
+// of their exit conditions holds, like the loops of strlen, memchr or strcmp,
+// fork once per iteration on symbolic data. A state entering such a loop
+// instead evaluates its iterations without forking, for as long as the
+// addresses it reads are concrete and in bounds. It is then branched once per
+// exit of the loop, with each value defined in the loop and used after it
+// turned into a select over the iteration in which the loop is left. If none
+// of the exit conditions of the evaluated iterations may hold, the loop runs
+// as usual.
+//
+// Only loops whose blocks form a single chain from the header to the latch
+// are summarized, with phis only in the header. Loops that keep their
+// variables in memory, as in unoptimized code, store to it and are left
+// alone.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_LOOPSUMMARIZER_H
+#define KLEE_LOOPSUMMARIZER_H
+
+#include "klee/ADT/Ref.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace llvm {
+class BasicBlock;
+class Instruction;
+class Loop;
+} // namespace llvm
+
+namespace klee {
+class ExecutionState;
+class Executor;
+class Expr;
+struct KBlock;
+struct KFunction;
+struct KInstruction;
+
+class LoopSummarizer {
+  /// A loop that can be summarized.
+  struct Shape {
+    /// The blocks of the loop in the order they run in, header first.
+    std::vector<KBlock *> blocks;
+    std::unordered_set<const llvm::BasicBlock *> members;
+    /// Instructions of the loop that are used after it.
+    std::vector<KInstruction *> liveOuts;
+  };
+
+  /// An exit condition evaluated in some iteration, with the values of the
+  /// live-outs when the loop is left through it.
+  struct Exit {
+    ref<Expr> condition;
+    /// Index of the exiting block in Shape::blocks.
+    unsigned block;
+    std::vector<ref<Expr>> values;
+  };
+
+  using Values = std::unordered_map<const llvm::Instruction *, ref<Expr>>;
+
+  Executor &executor;
+
+  std::unordered_set<KFunction *> analyzed;
+  /// Summarizable loops by their header.
+  std::unordered_map<KBlock *, Shape> shapes;
+
+  void analyze(KFunction *kf);
+  bool analyzeLoop(KFunction *kf, const llvm::Loop &loop, Shape &shape);
+
+  /// Whether state enters the loop with the given header from outside.
+  bool entersLoop(const ExecutionState &state, const Shape &shape) const;
+
+  ref<Expr> getOperand(ExecutionState &state, const Shape &shape,
+                       KInstruction *ki, unsigned index,
+                       const Values &values);
+  /// The value of ki in the current iteration, or null if it cannot be
+  /// computed without executing it.
+  ref<Expr> evaluate(ExecutionState &state, const Shape &shape,
+                     KInstruction *ki, const Values &values);
+  ref<Expr> load(ExecutionState &state, KInstruction *ki,
+                 ref<Expr> address);
+
+  /// Evaluate the iterations of the loop, collecting their exit conditions.
+  /// Returns whether the last exit condition collected always holds.
+  bool evaluateLoop(ExecutionState &state, const Shape &shape,
+                    std::vector<Exit> &exits);
+
+public:
+  explicit LoopSummarizer(Executor &executor);
+
+  /// Summarize the loop state is about to enter, if it enters one that can
+  /// be summarized. Returns whether state was branched out of the loop, in
+  /// which case its next instruction must not be executed.
+  bool summarize(ExecutionState &state);
+};
+} // namespace klee
+
+#endif /* KLEE_LOOPSUMMARIZER_H */
@@ -125,6 +125,13 @@ ObjectState::ObjectState(const ObjectState &os)
 
 /***/
 
+MemoryFootprint ObjectState::getMemoryFootprint() const {
+  MemoryFootprint footprint = valueOS.getMemoryFootprint();
+  footprint += baseOS.getMemoryFootprint();
+  footprint.exclusive += sizeof(ObjectState);
+  return footprint;
+}
+
 void ObjectState::initializeToZero() {
   valueOS.initializeToZero();
   baseOS.initializeToZero();
@@ -279,6 +286,23 @@ void ObjectState::write(ref<const ObjectState> os) {
   lastUpdate = os->lastUpdate;
 }
 
+void ObjectState::merge(ref<Expr> condition, const ObjectState &b) {
+  auto size = cast<ConstantExpr>(object->getSizeExpr())->getZExtValue();
+  for (unsigned offset = 0; offset < size; ++offset) {
+    ref<Expr> valueA = valueOS.readWidth(offset);
+    ref<Expr> valueB = b.valueOS.readWidth(offset);
+    if (valueA != valueB)
+      valueOS.writeWidth(offset,
+                         SelectExpr::create(condition, valueA, valueB));
+    ref<Expr> baseA = baseOS.readWidth(offset);
+    ref<Expr> baseB = b.baseOS.readWidth(offset);
+    if (baseA != baseB)
+      baseOS.writeWidth(offset, SelectExpr::create(condition, baseA, baseB));
+  }
+  wasWritten = true;
+  lastUpdate = nullptr;
+}
+
 /***/
 
 ref<Expr> ObjectState::read(ref<Expr> offset, Expr::Width width) const {
@@ -434,7 +458,7 @@ void ObjectState::write(ref<Expr> offset, ref<Expr> value) {
     write8(AddExpr::create(offset, ConstantExpr::create(idx, Expr::Int32)),
            ExtractExpr::create(value, 8 * i, Expr::Int8));
   }
-  lastUpdate = new UpdateNode(nullptr, offset, value);
+  lastUpdate = UpdateNode::create(nullptr, offset, value);
 }
 
 void ObjectState::write(unsigned offset, ref<Expr> value) {
@@ -503,6 +527,36 @@ void ObjectState::write64(unsigned offset, uint64_t value) {
   }
 }
 
+void ObjectState::copy(unsigned offset, const ObjectState &src,
+                       unsigned srcOffset, unsigned count) {
+  wasWritten = true;
+  valueOS.copy(offset, src.valueOS, srcOffset, count);
+  baseOS.copy(offset, src.baseOS, srcOffset, count);
+  lastUpdate = nullptr;
+}
+
+void ObjectState::fill(unsigned offset, ref<Expr> value, unsigned count) {
+  assert(value->getWidth() == Expr::Int8 && "fill expects a byte value");
+  wasWritten = true;
+  valueOS.fill(offset, value, count);
+  baseOS.fill(offset, Expr::createPointer(0), count);
+  lastUpdate = nullptr;
+}
+
+ref<Expr> ObjectState::compare(unsigned offset, const ObjectState &b,
+                               unsigned bOffset, unsigned count) const {
+  // Build the result from the last byte backwards, so that a pair of
+  // distinct constant bytes folds away everything that follows it.
+  ref<Expr> result = ConstantExpr::create(0, Expr::Int32);
+  for (unsigned i = count; i-- > 0;) {
+    ref<Expr> byteA = ZExtExpr::create(readValue8(offset + i), Expr::Int32);
+    ref<Expr> byteB = ZExtExpr::create(b.readValue8(bOffset + i), Expr::Int32);
+    result = SelectExpr::create(EqExpr::create(byteA, byteB), result,
+                                SubExpr::create(byteA, byteB));
+  }
+  return result;
+}
+
 void ObjectState::print() const {
   llvm::errs() << "-- ObjectState --\n";
   llvm::errs() << "\tBase ObjectStage:\n";
@@ -605,6 +659,32 @@ const UpdateList &ObjectStage::getUpdates() const {
   return updates;
 }
 
+MemoryFootprint ObjectStage::getMemoryFootprint() const {
+  // Rough per-entry cost of a hashed sparse storage slot: key, value and
+  // the bucket link.
+  const size_t symbolicEntrySize =
+      sizeof(size_t) + sizeof(ref<Expr>) + 2 * sizeof(void *);
+  const size_t maskEntrySize = sizeof(size_t) + sizeof(bool) + 2 * sizeof(void *);
+
+  MemoryFootprint footprint;
+  if (concreteStore) {
+    footprint.exclusive += concreteStore->getMemoryUsage();
+  }
+  footprint.exclusive += knownSymbolics->storage().size() * symbolicEntrySize;
+  footprint.exclusive += unflushedMask->storage().size() * maskEntrySize;
+
+  // Update nodes referenced only by this list belong to it; the first node
+  // with another owner starts the suffix shared with other object states.
+  const UpdateNode *un = updates.head.get();
+  for (; un && un->_refCount.getCount() == 1; un = un->next.get()) {
+    footprint.exclusive += sizeof(UpdateNode);
+  }
+  if (un) {
+    footprint.shared += un->getSize() * sizeof(UpdateNode);
+  }
+  return footprint;
+}
+
 void ObjectStage::initializeToZero() {
   auto array = Array::create(
       size,
@@ -798,6 +878,33 @@ void ObjectStage::write(const ObjectStage &os) {
   updates = UpdateList(updates.root, os.updates.head);
 }
 
+void ObjectStage::copy(unsigned offset, const ObjectStage &src,
+                       unsigned srcOffset, unsigned count) {
+  assert(width == src.width);
+  bool backwards = &src == this && srcOffset < offset;
+  for (unsigned n = 0; n < count; ++n) {
+    unsigned i = backwards ? count - n - 1 : n;
+    unsigned from = srcOffset + i;
+    if (src.concreteStore && from < src.concreteStore->size() &&
+        src.concreteStore->isConcrete(from)) {
+      writeWidth(offset + i, src.concreteStore->readValue(from));
+    } else {
+      writeWidth(offset + i, src.readWidth(from));
+    }
+  }
+}
+
+void ObjectStage::fill(unsigned offset, ref<Expr> value, unsigned count) {
+  if (ConstantExpr *CE = dyn_cast<ConstantExpr>(value)) {
+    uint64_t v = CE->getZExtValue(width);
+    for (unsigned i = 0; i < count; ++i)
+      writeWidth(offset + i, v);
+  } else {
+    for (unsigned i = 0; i < count; ++i)
+      writeWidth(offset + i, value);
+  }
+}
+
 /***/
 
 void ObjectStage::print() const {
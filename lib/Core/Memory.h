@@ -39,6 +39,23 @@ class Solver;
 
 typedef uint64_t IDType;
 
+/// Approximate number of host bytes kept alive by a piece of execution
+/// state, split into bytes owned exclusively (released once the owner is
+/// terminated) and bytes shared with other states through copy-on-write or
+/// reference counting.
+struct MemoryFootprint {
+  std::size_t exclusive = 0;
+  std::size_t shared = 0;
+
+  std::size_t total() const { return exclusive + shared; }
+
+  MemoryFootprint &operator+=(const MemoryFootprint &other) {
+    exclusive += other.exclusive;
+    shared += other.shared;
+    return *this;
+  }
+};
+
 extern llvm::cl::opt<unsigned long> MaxFixedSizeStructureSize;
 
 class MemoryObject {
@@ -299,6 +316,10 @@ public:
   const uint8_t *data() const { return store.data(); }
   uint8_t *data() { return store.data(); }
 
+  size_t getMemoryUsage() const {
+    return store.capacity() + mask.capacity() / 8;
+  }
+
   size_t size() const { return size_; }
 
   size_t set() const { return set_; }
@@ -346,11 +367,22 @@ public:
   void write(ref<Expr> offset, ref<Expr> value);
 
   void writeWidth(unsigned offset, uint64_t value);
+
+  /// Copy count units from src at srcOffset to offset, in the direction
+  /// that keeps overlapping ranges of the same stage intact.
+  void copy(unsigned offset, const ObjectStage &src, unsigned srcOffset,
+            unsigned count);
+  void fill(unsigned offset, ref<Expr> value, unsigned count);
   void print() const;
 
   size_t getSparseStorageEntries() {
     return knownSymbolics->storage().size() + unflushedMask->storage().size();
   }
+
+  /// Estimate host memory used by this stage. The concrete store and the
+  /// sparse entries are private to the stage, while update nodes are only
+  /// private until another stage references the same suffix.
+  MemoryFootprint getMemoryFootprint() const;
   void initializeToZero();
 
   void flushToConcreteStore(Assignment &assignment);
@@ -405,6 +437,8 @@ public:
     return valueOS.getSparseStorageEntries() + baseOS.getSparseStorageEntries();
   }
 
+  MemoryFootprint getMemoryFootprint() const;
+
   void swapObjectHack(MemoryObject *mo) { object = mo; }
 
   ref<Expr> read(ref<Expr> offset, Expr::Width width) const;
@@ -420,11 +454,25 @@ public:
   void write(unsigned offset, ref<Expr> value);
   void write(ref<Expr> offset, ref<Expr> value);
   void write(ref<const ObjectState> os);
+  /// Make each byte that differs from b a select of the two under condition,
+  /// for objects of the same constant size.
+  void merge(ref<Expr> condition, const ObjectState &b);
 
   void write8(unsigned offset, uint8_t value);
   void write16(unsigned offset, uint16_t value);
   void write32(unsigned offset, uint32_t value);
   void write64(unsigned offset, uint64_t value);
+
+  /// Copy count bytes from src at srcOffset to offset, like memmove.
+  void copy(unsigned offset, const ObjectState &src, unsigned srcOffset,
+            unsigned count);
+  /// Set count bytes starting at offset to the byte value, like memset.
+  void fill(unsigned offset, ref<Expr> value, unsigned count);
+  /// Compare count bytes at offset with those of b at bOffset, like memcmp.
+  /// \return an Int32 expression of the difference of the first bytes that
+  /// differ, or zero
+  ref<Expr> compare(unsigned offset, const ObjectState &b, unsigned bOffset,
+                    unsigned count) const;
   void print() const;
 
   void flushToConcreteStore(Assignment &assignment);
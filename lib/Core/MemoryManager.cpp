@@ -25,6 +25,7 @@
 #include <algorithm>
 #include <cinttypes>
 #include <sys/mman.h>
+#include <unistd.h>
 
 using namespace klee;
 
@@ -62,6 +63,36 @@ llvm::cl::opt<unsigned long long> DeterministicStartAddress(
     llvm::cl::desc("Start address for deterministic allocation. Has to be page "
                    "aligned (default=0x7ff30000000)"),
     llvm::cl::init(0x7ff30000000), llvm::cl::cat(MemoryCat));
+
+llvm::cl::opt<unsigned> QuarantinePercent(
+    "allocate-quarantine-percent",
+    llvm::cl::desc("Percentage of the allocation arena taken by freed objects "
+                   "whose addresses are not handed out again yet. Keeps "
+                   "accesses through dangling pointers from resolving to "
+                   "newer objects (default=10)"),
+    llvm::cl::init(10), llvm::cl::cat(MemoryCat));
+
+llvm::cl::opt<bool> ReserveOnlyAllocation(
+    "allocate-reserve-only",
+    llvm::cl::desc("Take the addresses of non-deterministic allocations from "
+                   "reserved address space and only back them with host "
+                   "memory when an external call needs their contents "
+                   "(default=true)"),
+    llvm::cl::init(true), llvm::cl::cat(MemoryCat));
+
+llvm::cl::opt<unsigned> ReservedSpaceSize(
+    "allocate-reserve-size",
+    llvm::cl::desc("Address space reserved for non-deterministic allocations "
+                   "in GB. Allocations fall back to malloc once it is used "
+                   "up (default=32)"),
+    llvm::cl::init(32), llvm::cl::cat(MemoryCat));
+
+/// Smallest slot of the deterministic allocator
+constexpr uint64_t MinSlotSize = 16;
+/// Size of the slabs from which slots of up to this size are carved
+constexpr uint64_t SlabSize = 64 * 1024;
+/// Slabs are aligned to their slot size, but at most to a page
+constexpr uint64_t MaxSlabAlignment = 4096;
 } // namespace
 
 llvm::cl::opt<unsigned long> MaxConstantAllocationSize(
@@ -83,14 +114,16 @@ llvm::cl::opt<bool> UseSymbolicSizeAllocation(
 
 /***/
 MemoryManager::MemoryManager()
-    : deterministicSpace(0), nextFreeSlot(0),
-      spaceSize(DeterministicAllocationSize.getValue() * 1024 * 1024) {
+    : arena(0), nextFreeSlot(0),
+      arenaSize(DeterministicAllocationSize.getValue() * 1024 * 1024),
+      reserveOnly(false), pageSize(sysconf(_SC_PAGESIZE)), quarantineSize(0),
+      maxQuarantineSize(0) {
   if (DeterministicAllocation) {
     // Page boundary
     void *expectedAddress = (void *)DeterministicStartAddress.getValue();
 
     char *newSpace =
-        (char *)mmap(expectedAddress, spaceSize, PROT_READ | PROT_WRITE,
+        (char *)mmap(expectedAddress, arenaSize, PROT_READ | PROT_WRITE,
                      MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
 
     if (newSpace == MAP_FAILED) {
@@ -101,9 +134,24 @@ MemoryManager::MemoryManager()
     }
 
     klee_message("Deterministic memory allocation starting from %p", newSpace);
-    deterministicSpace = newSpace;
+    arena = newSpace;
     nextFreeSlot = newSpace;
+  } else if (ReserveOnlyAllocation) {
+    arenaSize = (size_t)ReservedSpaceSize.getValue() << 30;
+    char *newSpace = (char *)mmap(nullptr, arenaSize, PROT_NONE,
+                                  MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE,
+                                  -1, 0);
+    if (newSpace == MAP_FAILED) {
+      klee_warning("Couldn't reserve address space for allocations, "
+                   "falling back to malloc");
+    } else {
+      arena = newSpace;
+      nextFreeSlot = newSpace;
+      reserveOnly = true;
+    }
   }
+  maxQuarantineSize =
+      arenaSize / 100 * std::min(QuarantinePercent.getValue(), 100u);
 }
 
 MemoryManager::~MemoryManager() {
@@ -112,15 +160,16 @@ MemoryManager::~MemoryManager() {
     if (!mo->isFixed && !DeterministicAllocation) {
       if (ref<ConstantExpr> arrayConstantAddress =
               dyn_cast<ConstantExpr>(mo->getBaseExpr())) {
-        free((void *)arrayConstantAddress->getZExtValue());
+        if (!inArena(arrayConstantAddress->getZExtValue()))
+          free((void *)arrayConstantAddress->getZExtValue());
       }
     }
     objects.erase(mo);
     delete mo;
   }
 
-  if (DeterministicAllocation)
-    munmap(deterministicSpace, spaceSize);
+  if (arena)
+    munmap(arena, arenaSize);
 }
 
 MemoryObject *MemoryManager::allocate(ref<Expr> size, bool isLocal,
@@ -153,24 +202,15 @@ MemoryObject *MemoryManager::allocate(ref<Expr> size, bool isLocal,
     ref<ConstantExpr> sizeExpr = dyn_cast<ConstantExpr>(size);
     assert(sizeExpr);
     auto moSize = sizeExpr->getZExtValue();
+    if (arena)
+      address = allocateFromArena(moSize, alignment);
     if (DeterministicAllocation) {
-      address =
-          llvm::alignTo((uint64_t)nextFreeSlot + alignment - 1, alignment);
-
-      // Handle the case of 0-sized allocations as 1-byte allocations.
-      // This way, we make sure we have this allocation between its own red
-      // zones
-      size_t alloc_size = std::max(moSize, (uint64_t)1);
-      if ((char *)address + alloc_size < deterministicSpace + spaceSize) {
-        nextFreeSlot = (char *)address + alloc_size + RedzoneSize;
-      } else {
+      if (!address)
         klee_warning_once(0,
                           "Couldn't allocate %" PRIu64
                           " bytes. Not enough deterministic space left.",
                           moSize);
-        address = 0;
-      }
-    } else {
+    } else if (!address) {
       // Use malloc for the standard case
       if (alignment <= 8)
         address = (uint64_t)malloc(moSize);
@@ -229,16 +269,116 @@ MemoryObject *MemoryManager::allocateFixed(uint64_t address, uint64_t size,
 
 void MemoryManager::markFreed(MemoryObject *mo) {
   if (objects.find(mo) != objects.end()) {
-    if (!mo->isFixed && !DeterministicAllocation) {
+    if (!mo->isFixed) {
       if (ref<ConstantExpr> arrayConstantAddress =
               dyn_cast<ConstantExpr>(mo->getBaseExpr())) {
-        free((void *)arrayConstantAddress->getZExtValue());
+        if (inArena(arrayConstantAddress->getZExtValue()))
+          freeToArena(arrayConstantAddress->getZExtValue());
+        else if (!DeterministicAllocation)
+          free((void *)arrayConstantAddress->getZExtValue());
       }
     }
     objects.erase(mo);
   }
 }
 
-size_t MemoryManager::getUsedDeterministicSize() {
-  return nextFreeSlot - deterministicSpace;
+uint64_t MemoryManager::allocateFromArena(uint64_t size, size_t alignment) {
+  // Handle the case of 0-sized allocations as 1-byte allocations.
+  // This way, we make sure we have this allocation between its own red
+  // zones
+  uint64_t slotSize =
+      std::max({llvm::PowerOf2Ceil(std::max(size, (uint64_t)1) + RedzoneSize),
+                (uint64_t)alignment, MinSlotSize});
+  unsigned sizeClass = llvm::Log2_64(slotSize);
+  SizeClass &sc = sizeClasses[sizeClass];
+
+  // Slots are only guaranteed to be aligned to the slab alignment, larger
+  // alignments have to be checked
+  uint64_t address = 0;
+  if (!sc.reusable.empty() && sc.reusable.back() % alignment == 0) {
+    address = sc.reusable.back();
+    sc.reusable.pop_back();
+  } else {
+    if (sc.slabNext == sc.slabEnd || sc.slabNext % alignment != 0) {
+      uint64_t slabSize = std::max(slotSize, SlabSize);
+      uint64_t slab = llvm::alignTo(
+          (uint64_t)nextFreeSlot,
+          std::max(std::min(slotSize, MaxSlabAlignment), (uint64_t)alignment));
+      if (slab + slabSize > (uint64_t)arena + arenaSize)
+        return 0;
+      nextFreeSlot = (char *)(slab + slabSize);
+      sc.slabNext = slab;
+      sc.slabEnd = slab + slabSize;
+    }
+    address = sc.slabNext;
+    sc.slabNext += slotSize;
+  }
+
+  liveSlots.emplace(address, sizeClass);
+  return address;
+}
+
+void MemoryManager::freeToArena(uint64_t address) {
+  auto it = liveSlots.find(address);
+  if (it == liveSlots.end())
+    return;
+  unsigned sizeClass = it->second;
+  quarantine.emplace_back(address, sizeClass);
+  quarantineSize += 1ULL << sizeClass;
+  liveSlots.erase(it);
+
+  if (reserveOnly) {
+    // Give back the pages that belong to this slot alone. They stay
+    // accessible, so that dangling pointers passed to external calls read
+    // zeros rather than crash.
+    uint64_t first = llvm::alignTo(address, pageSize);
+    uint64_t end = llvm::alignDown(address + (1ULL << sizeClass), pageSize);
+    if (first < end) {
+      madvise((void *)first, end - first, MADV_DONTNEED);
+      for (uint64_t page = first; page < end; page += pageSize)
+        committedPages.erase(page);
+    }
+  }
+
+  while (quarantineSize > maxQuarantineSize) {
+    auto [slot, sizeClass] = quarantine.front();
+    sizeClasses[sizeClass].reusable.push_back(slot);
+    quarantineSize -= 1ULL << sizeClass;
+    quarantine.pop_front();
+  }
+}
+
+void MemoryManager::commit(uint64_t address, uint64_t size) {
+  if (!reserveOnly || !inArena(address) || size == 0)
+    return;
+  uint64_t first = llvm::alignDown(address, pageSize);
+  uint64_t end = llvm::alignTo(address + size, pageSize);
+  bool uncommitted = false;
+  for (uint64_t page = first; page < end; page += pageSize) {
+    if (committedPages.insert(page).second) {
+      uncommitted = true;
+      ++stats::arenaCommittedPages;
+    }
+  }
+  if (uncommitted &&
+      mprotect((void *)first, end - first, PROT_READ | PROT_WRITE) != 0)
+    klee_error("Couldn't commit memory for allocation at %p",
+               (void *)address);
+}
+
+bool MemoryManager::isCommitted(uint64_t address, uint64_t size) const {
+  if (!reserveOnly || !inArena(address))
+    return true;
+  uint64_t first = llvm::alignDown(address, pageSize);
+  uint64_t end = llvm::alignTo(address + size, pageSize);
+  for (uint64_t page = first; page < end; page += pageSize)
+    if (!committedPages.count(page))
+      return false;
+  return true;
+}
+
+size_t MemoryManager::getUsedArenaSize() {
+  if (reserveOnly)
+    return committedPages.size() * pageSize;
+  return nextFreeSlot - arena;
 }
@@ -12,9 +12,15 @@
 
 #include "klee/Expr/Expr.h"
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace llvm {
 class Value;
@@ -31,9 +37,41 @@ private:
   typedef std::set<MemoryObject *> objects_ty;
   objects_ty objects;
 
-  char *deterministicSpace;
+  /// Address range that allocations are served from: the deterministic
+  /// space, or address space reserved without any host memory behind it
+  char *arena;
   char *nextFreeSlot;
-  size_t spaceSize;
+  size_t arenaSize;
+  /// Whether pages of the arena have to be committed before use
+  bool reserveOnly;
+  /// Committed pages of a reserve-only arena, by address
+  std::unordered_set<uint64_t> committedPages;
+  uint64_t pageSize;
+
+  /// Arena allocations are served from power-of-two size classes. Each
+  /// class carves its slots from slabs that are bump allocated from the
+  /// arena, and reuses the slots of freed objects once they leave the
+  /// quarantine.
+  struct SizeClass {
+    uint64_t slabNext = 0;
+    uint64_t slabEnd = 0;
+    std::vector<uint64_t> reusable;
+  };
+  std::array<SizeClass, 64> sizeClasses;
+  /// Size class of every live arena allocation, by address
+  std::unordered_map<uint64_t, unsigned> liveSlots;
+  /// Freed slots that may not be reused yet, oldest first
+  std::deque<std::pair<uint64_t, unsigned>> quarantine;
+  /// Bytes of the slots in quarantine, and the share of the arena they may
+  /// take before the oldest ones become reusable
+  uint64_t quarantineSize;
+  uint64_t maxQuarantineSize;
+
+  uint64_t allocateFromArena(uint64_t size, size_t alignment);
+  void freeToArena(uint64_t address);
+  bool inArena(uint64_t address) const {
+    return address >= (uint64_t)arena && address < (uint64_t)arena + arenaSize;
+  }
 
 public:
   MemoryManager();
@@ -53,10 +91,20 @@ public:
   MemoryObject *allocateFixed(uint64_t address, uint64_t size,
                               ref<CodeLocation> allocSite);
   void markFreed(MemoryObject *mo);
+
+  /// Make [address, address+size) usable by the host, e.g. before an
+  /// external call accesses it.
+  void commit(uint64_t address, uint64_t size);
+  /// Whether the host can access [address, address+size) without
+  /// committing it first.
+  bool isCommitted(uint64_t address, uint64_t size) const;
+
   /*
-   * Returns the size used by deterministic allocation in bytes
+   * Returns the host memory used by the arena in bytes: the claimed part
+   * of the deterministic space, or the committed pages of a reserve-only
+   * arena
    */
-  size_t getUsedDeterministicSize();
+  size_t getUsedArenaSize();
 };
 
 } // namespace klee
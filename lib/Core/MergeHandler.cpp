@@ -0,0 +1,415 @@
+//===-- MergeHandler.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MergeHandler.h"
+
+#include "CodeLocation.h"
+#include "CoreStats.h"
+#include "ExecutionState.h"
+#include "Memory.h"
+
+#include "klee/Module/CodeGraphInfo.h"
+#include "klee/Module/KInstruction.h"
+#include "klee/Module/KModule.h"
+#include "klee/Support/OptionCategories.h"
+
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Support/CommandLine.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <deque>
+#include <set>
+
+using namespace llvm;
+using namespace klee;
+
+namespace {
+cl::opt<unsigned> MergeMaxWait(
+    "merge-max-wait", cl::init(100000),
+    cl::desc("Number of instructions a state waits at a merge point for "
+             "other states to arrive (default=100000)"),
+    cl::cat(SearchCat));
+
+cl::opt<double> MergeQueryRatio(
+    "merge-query-ratio", cl::init(0.1),
+    cl::desc("Do not merge states if a value that turns symbolic by the merge "
+             "may affect more than this share of the queries issued after "
+             "the merge point (default=0.1)"),
+    cl::cat(SearchCat));
+
+/// Loop nesting beyond which queries are not weighted any higher.
+constexpr unsigned MaxLoopDepth = 6;
+
+/// Whether pointer may only be resolved by a query.
+bool isAddress(const Value *pointer) {
+  const Value *base = pointer->stripPointerCasts();
+  return !isa<AllocaInst>(base) && !isa<GlobalValue>(base);
+}
+
+/// Whether executing inst may query the solver for a symbolic operand.
+bool isQuerySite(const Instruction &inst) {
+  switch (inst.getOpcode()) {
+  case Instruction::Br:
+    return cast<BranchInst>(inst).isConditional();
+  case Instruction::Switch:
+  case Instruction::IndirectBr:
+    return true;
+  case Instruction::Load:
+    return isAddress(cast<LoadInst>(inst).getPointerOperand());
+  case Instruction::Store:
+    return isAddress(cast<StoreInst>(inst).getPointerOperand());
+  case Instruction::UDiv:
+  case Instruction::SDiv:
+  case Instruction::URem:
+  case Instruction::SRem:
+    return !isa<Constant>(inst.getOperand(1));
+  case Instruction::Call:
+  case Instruction::Invoke:
+    return !isa<DbgInfoIntrinsic>(inst) &&
+           (cast<CallBase>(inst).isIndirectCall() ||
+            cast<CallBase>(inst).arg_size() != 0);
+  default:
+    return false;
+  }
+}
+
+/// Whether the query inst may issue depends on its operand value.
+bool isQueriedBy(const Instruction &inst, const Value *value) {
+  switch (inst.getOpcode()) {
+  case Instruction::Load:
+    return cast<LoadInst>(inst).getPointerOperand() == value;
+  case Instruction::Store:
+    return cast<StoreInst>(inst).getPointerOperand() == value;
+  case Instruction::UDiv:
+  case Instruction::SDiv:
+  case Instruction::URem:
+  case Instruction::SRem:
+    return inst.getOperand(1) == value;
+  default:
+    return true;
+  }
+}
+} // namespace
+
+MergeHandler::MergeHandler(CodeGraphInfo &codeGraphInfo)
+    : codeGraphInfo(codeGraphInfo) {}
+
+void MergeHandler::push(ExecutionState &state, const MergePoint &point) {
+  if (!state.mergePoints.empty() && state.mergePoints.back() == point)
+    return;
+  state.mergePoints.push_back(point);
+  if (states.count(&state))
+    ++expected[point];
+}
+
+void MergeHandler::pop(ExecutionState &state) {
+  MergePoint point = state.mergePoints.back();
+  state.mergePoints.pop_back();
+  if (states.count(&state))
+    unexpect(point);
+}
+
+void MergeHandler::unexpect(const MergePoint &point) {
+  auto it = expected.find(point);
+  assert(it != expected.end() && it->second && "merge point not expected");
+  if (--it->second)
+    return;
+  expected.erase(it);
+  if (held.count(point))
+    ready.push_back(point);
+}
+
+void MergeHandler::count(const ExecutionState &state, bool added) {
+  for (const auto &point : state.mergePoints) {
+    if (added)
+      ++expected[point];
+    else
+      unexpect(point);
+  }
+}
+
+void MergeHandler::addMergePoint(KBlock *branch, ExecutionState &a,
+                                 ExecutionState &b) {
+  KBlock *join = codeGraphInfo.getImmediatePostDominator(branch);
+  if (!join)
+    return;
+  // merge after the phis, which read the block the state came from
+  KInstruction **ki = join->instructions;
+  while (isa<PHINode>((*ki)->inst()))
+    ++ki;
+  MergePoint point(*ki, a.stack.size());
+  // a state branched by this fork may only be added to the object manager
+  // later, but must be expected from now on
+  for (ExecutionState *state : {&a, &b}) {
+    if (states.insert(state).second)
+      count(*state, true);
+    push(*state, point);
+  }
+}
+
+void MergeHandler::discard(ExecutionState &state) {
+  if (states.erase(&state))
+    count(state, false);
+}
+
+MergeHandler::Arrival MergeHandler::arrive(ExecutionState &state) {
+  auto &points = state.mergePoints;
+  // merge points in returned frames are not reached any more
+  while (!points.empty() && points.back().second > state.stack.size())
+    pop(state);
+  if (points.empty() || points.back().first != state.pc ||
+      points.back().second != state.stack.size())
+    return Arrival::Continue;
+
+  MergePoint point = points.back();
+  pop(state);
+
+  auto group = held.find(point);
+  if (group != held.end()) {
+    for (auto &waiting : group->second) {
+      if (!waiting.state->canMerge(state))
+        continue;
+      if (!isProfitable(*waiting.state, state)) {
+        ++stats::mergesRejected;
+        continue;
+      }
+      if (!waiting.state->merge(state))
+        continue;
+      waiting.merged = true;
+      ++stats::statesMerged;
+      return Arrival::Merged;
+    }
+  }
+
+  if (!expected.count(point)) {
+    ++stats::statesUnmerged;
+    return Arrival::Continue;
+  }
+  held[point].push_back({&state, stats::instructions});
+  ++heldCount;
+  if (!nextExpiry)
+    nextExpiry = stats::instructions + MergeMaxWait;
+  return Arrival::Held;
+}
+
+std::vector<ExecutionState *> MergeHandler::release(bool all) {
+  std::vector<ExecutionState *> released;
+  auto take = [&](std::vector<HeldState> &group) {
+    for (auto &waiting : group) {
+      if (!waiting.merged)
+        ++stats::statesUnmerged;
+      released.push_back(waiting.state);
+    }
+    heldCount -= group.size();
+    group.clear();
+  };
+
+  if (all) {
+    for (auto &group : held)
+      take(group.second);
+    held.clear();
+    ready.clear();
+    nextExpiry = 0;
+    return released;
+  }
+
+  for (const auto &point : ready) {
+    auto group = held.find(point);
+    if (group != held.end() && !expected.count(point)) {
+      take(group->second);
+      held.erase(group);
+    }
+  }
+  ready.clear();
+
+  if (nextExpiry && stats::instructions >= nextExpiry) {
+    nextExpiry = 0;
+    for (auto group = held.begin(); group != held.end();) {
+      std::vector<HeldState> expired, waiting;
+      for (const auto &state : group->second) {
+        std::uint64_t expiry = state.since + MergeMaxWait;
+        if (stats::instructions >= expiry) {
+          expired.push_back(state);
+        } else {
+          waiting.push_back(state);
+          if (!nextExpiry || expiry < nextExpiry)
+            nextExpiry = expiry;
+        }
+      }
+      take(expired);
+      group->second = std::move(waiting);
+      group = group->second.empty() ? held.erase(group) : std::next(group);
+    }
+  }
+  return released;
+}
+
+void MergeHandler::update(ref<ObjectManager::Event> e) {
+  if (auto statesEvent = dyn_cast<ObjectManager::States>(e)) {
+    for (auto state : statesEvent->added) {
+      if (states.insert(state).second)
+        count(*state, true);
+    }
+    for (auto state : statesEvent->removed) {
+      if (states.erase(state))
+        count(*state, false);
+    }
+  }
+}
+
+MergeHandler::Region &MergeHandler::getRegion(KBlock *kb) {
+  auto cached = regions.find(kb);
+  if (cached != regions.end())
+    return cached->second;
+
+  Region &region = regions[kb];
+  KFunction *kf = kb->parent;
+  std::deque<const BasicBlock *> blocks{kb->basicBlock()};
+  while (!blocks.empty()) {
+    const BasicBlock *bb = blocks.front();
+    blocks.pop_front();
+    if (region.blocks.count(bb))
+      continue;
+    unsigned depth = codeGraphInfo.getLoopDepth(kf->blockMap.at(bb));
+    double weight = std::pow(10., std::min(depth, MaxLoopDepth));
+    region.blocks.emplace(bb, weight);
+    for (const Instruction &inst : *bb)
+      if (isQuerySite(inst))
+        region.queries += weight;
+    for (const BasicBlock *succ : successors(bb))
+      blocks.push_back(succ);
+  }
+  return region;
+}
+
+double MergeHandler::getDependentQueries(Region &region, const Value *root) {
+  auto cached = region.dependentQueries.find(root);
+  if (cached != region.dependentQueries.end())
+    return cached->second;
+
+  // values are followed through their uses, and through the memory they
+  // are stored to if that memory belongs to a local or global variable
+  using Node = std::pair<const Value *, bool>;
+  std::set<Node> visited;
+  std::vector<Node> worklist;
+  std::set<const Instruction *> sites;
+  auto visit = [&](const Value *value, bool memory) {
+    if (visited.insert({value, memory}).second)
+      worklist.emplace_back(value, memory);
+  };
+  visit(root, isa<AllocaInst>(root) || isa<GlobalVariable>(root));
+
+  while (!worklist.empty()) {
+    auto [value, memory] = worklist.back();
+    worklist.pop_back();
+    for (const User *user : value->users()) {
+      if (isa<llvm::ConstantExpr>(user)) {
+        visit(user, memory);
+        continue;
+      }
+      auto inst = dyn_cast<Instruction>(user);
+      if (!inst || !region.blocks.count(inst->getParent()))
+        continue;
+
+      if (memory) {
+        if (auto load = dyn_cast<LoadInst>(inst)) {
+          if (load->getPointerOperand() == value)
+            visit(load, false);
+        } else if (isa<GetElementPtrInst>(inst) || isa<CastInst>(inst)) {
+          visit(inst, true);
+        } else if (isa<CallBase>(inst) && isQuerySite(*inst)) {
+          sites.insert(inst);
+        }
+        continue;
+      }
+
+      if (isQuerySite(*inst) && isQueriedBy(*inst, value))
+        sites.insert(inst);
+      if (auto store = dyn_cast<StoreInst>(inst)) {
+        if (store->getValueOperand() != value)
+          continue;
+        const Value *object = getUnderlyingObject(store->getPointerOperand());
+        if (isa<AllocaInst>(object) || isa<GlobalVariable>(object))
+          visit(object, true);
+      } else if (!inst->getType()->isVoidTy()) {
+        visit(inst, false);
+      }
+    }
+  }
+
+  double queries = 0;
+  for (const Instruction *site : sites)
+    queries += region.blocks.at(site->getParent());
+  region.dependentQueries.emplace(root, queries);
+  return queries;
+}
+
+bool MergeHandler::isProfitable(const ExecutionState &a,
+                                const ExecutionState &b) {
+  Region &region = getRegion(a.pc->parent);
+  if (region.queries == 0)
+    return true;
+  double limit = MergeQueryRatio * region.queries;
+  auto isHot = [&](const Value *root) {
+    return getDependentQueries(region, root) > limit;
+  };
+  // a value turns symbolic if it was concrete on one of the paths
+  auto turnsSymbolic = [](const ref<Expr> &valueA, const ref<Expr> &valueB) {
+    return valueA != valueB &&
+           (isa<ConstantExpr>(valueA) || isa<ConstantExpr>(valueB));
+  };
+
+  const StackFrame &frameA = a.stack.valueStack().back();
+  const StackFrame &frameB = b.stack.valueStack().back();
+  KFunction *kf = frameA.kf;
+  for (unsigned reg = 0; reg < frameA.locals->size(); ++reg) {
+    const ref<Expr> &valueA = frameA.locals->at(reg).value;
+    const ref<Expr> &valueB = frameB.locals->at(reg).value;
+    if (!valueA || !valueB || !turnsSymbolic(valueA, valueB))
+      continue;
+    const Value *root =
+        reg < kf->getNumArgs()
+            ? static_cast<const Value *>(kf->function()->getArg(reg))
+            : kf->getInstructionByRegister(reg)->inst();
+    if (isHot(root))
+      return false;
+  }
+
+  for (auto itA = a.addressSpace.objects.begin(),
+            itB = b.addressSpace.objects.begin();
+       itA != a.addressSpace.objects.end(); ++itA, ++itB) {
+    const ObjectState *osA = itA->second.get();
+    const ObjectState *osB = itB->second.get();
+    const MemoryObject *mo = itA->first;
+    if (osA == osB || !mo->allocSite || !mo->allocSite->source)
+      continue;
+    // only variables of this function and globals are tracked through the
+    // region, other memory is reached through pointers
+    const Value *root = mo->allocSite->source->unwrap();
+    auto alloca = dyn_cast<AllocaInst>(root);
+    if (!(alloca && alloca->getFunction() == kf->function()) &&
+        !isa<GlobalVariable>(root))
+      continue;
+    auto size = cast<ConstantExpr>(mo->getSizeExpr())->getZExtValue();
+    for (unsigned offset = 0; offset < size; ++offset) {
+      if (turnsSymbolic(osA->readValue8(offset), osB->readValue8(offset))) {
+        if (isHot(root))
+          return false;
+        break;
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,130 @@
+//===-- MergeHandler.h ------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// States forked at a symbolic branch are merged again where their paths join,
+// at the immediate post-dominator of the branch. A state that reaches such a
+// merge point is held until the other states that may still reach it have
+// arrived, and merged with the first compatible state held there.
+//
+// Merging replaces values that differ by selects, which can make later
+// queries more expensive than the forks they save. Following query count
+// estimation, a merge is only done if none of the values that turn symbolic
+// by it feeds a large share of the queries that may be issued after the merge
+// point.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_MERGEHANDLER_H
+#define KLEE_MERGEHANDLER_H
+
+#include "ObjectManager.h"
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+class BasicBlock;
+class Instruction;
+class Value;
+} // namespace llvm
+
+namespace klee {
+class CodeGraphInfo;
+class ExecutionState;
+struct KBlock;
+struct KInstruction;
+
+class MergeHandler : public Subscriber {
+public:
+  enum class Arrival {
+    /// The state is not at a merge point, or no state will join it there.
+    Continue,
+    /// The state waits at its merge point and is suspended.
+    Held,
+    /// The state was merged into a held state and is no longer needed.
+    Merged
+  };
+
+private:
+  using MergePoint = std::pair<KInstruction *, std::size_t>;
+
+  struct HeldState {
+    ExecutionState *state;
+    /// Instruction count at which the state arrived.
+    std::uint64_t since;
+    /// Whether another state was merged into this one.
+    bool merged = false;
+  };
+
+  /// The code that may run after a merge point, with the query sites in it.
+  struct Region {
+    /// Blocks of the region with the weight of a query site in them.
+    std::unordered_map<const llvm::BasicBlock *, double> blocks;
+    /// Estimated number of queries issued in the region.
+    double queries = 0;
+    /// Estimated number of those queries that depend on a value.
+    std::unordered_map<const llvm::Value *, double> dependentQueries;
+  };
+
+  CodeGraphInfo &codeGraphInfo;
+
+  /// States that run or are about to, and for each merge point how many of
+  /// them may still reach it.
+  std::unordered_set<ExecutionState *> states;
+  std::map<MergePoint, unsigned> expected;
+
+  std::map<MergePoint, std::vector<HeldState>> held;
+  std::size_t heldCount = 0;
+  /// Merge points that no running state will reach any more.
+  std::vector<MergePoint> ready;
+  /// Instruction count at which held states are next checked for expiry.
+  std::uint64_t nextExpiry = 0;
+
+  std::unordered_map<KBlock *, Region> regions;
+
+  void push(ExecutionState &state, const MergePoint &point);
+  void pop(ExecutionState &state);
+  /// A state that may reach point no longer does.
+  void unexpect(const MergePoint &point);
+  void count(const ExecutionState &state, bool added);
+
+  Region &getRegion(KBlock *kb);
+  double getDependentQueries(Region &region, const llvm::Value *root);
+  /// Whether merging b into a is expected to save more than it costs.
+  bool isProfitable(const ExecutionState &a, const ExecutionState &b);
+
+public:
+  explicit MergeHandler(CodeGraphInfo &codeGraphInfo);
+  ~MergeHandler() override = default;
+
+  /// Register the merge point of a symbolic branch at the end of block
+  /// branch, which state a took in one direction and b in the other.
+  void addMergePoint(KBlock *branch, ExecutionState &a, ExecutionState &b);
+
+  /// Forget a state that was branched but is dropped without being added to
+  /// the object manager.
+  void discard(ExecutionState &state);
+
+  /// Called before state executes its next instruction.
+  Arrival arrive(ExecutionState &state);
+
+  bool hasHeldStates() const { return heldCount != 0; }
+  /// Take the held states that no further state will join or that waited
+  /// too long, or all held states.
+  std::vector<ExecutionState *> release(bool all);
+
+  void update(ref<ObjectManager::Event> e) override;
+};
+} // namespace klee
+
+#endif /* KLEE_MERGEHANDLER_H */
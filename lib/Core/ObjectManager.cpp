@@ -38,6 +38,34 @@ ExecutionState *ObjectManager::branchState(ExecutionState *state,
   return newState;
 }
 
+ExecutionState *ObjectManager::branchPendingState(ExecutionState *state) {
+  ExecutionState *newState = state->branch();
+  processForest->attach(state->ptreeNode, newState, state);
+  return newState;
+}
+
+void ObjectManager::resumePendingState(ExecutionState *state,
+                                       BranchType reason) {
+  statesUpdated = true;
+  addedStates.push_back(state);
+  stats::incBranchStat(reason, 1);
+}
+
+void ObjectManager::discardPendingState(ExecutionState *state) {
+  processForest->remove(state->ptreeNode);
+  delete state;
+}
+
+void ObjectManager::suspendState(ExecutionState *state) {
+  removeState(state);
+  suspendedStates.insert(state);
+}
+
+void ObjectManager::resumeState(ExecutionState *state) {
+  statesUpdated = true;
+  addedStates.push_back(state);
+}
+
 void ObjectManager::removeState(ExecutionState *state) {
   assert(std::find(removedStates.begin(), removedStates.end(), state) ==
          removedStates.end());
@@ -61,8 +89,10 @@ void ObjectManager::updateSubscribers() {
     }
 
     for (auto state : removedStates) {
-      processForest->remove(state->ptreeNode);
       states.erase(state);
+      if (suspendedStates.erase(state))
+        continue;
+      processForest->remove(state->ptreeNode);
       delete state;
     }
 
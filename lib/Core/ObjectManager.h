@@ -7,6 +7,7 @@
 #include "klee/Core/BranchTypes.h"
 #include "klee/Module/KModule.h"
 
+#include <unordered_set>
 #include <vector>
 
 namespace klee {
@@ -59,6 +60,18 @@ public:
   ExecutionState *branchState(ExecutionState *state, BranchType reason);
   void removeState(ExecutionState *state);
 
+  /// Branch a state that is kept from the subscribers until it is resumed,
+  /// e.g. because it is not known yet whether its path is feasible.
+  ExecutionState *branchPendingState(ExecutionState *state);
+  void resumePendingState(ExecutionState *state, BranchType reason);
+  /// Drop a pending state as if it had never been branched.
+  void discardPendingState(ExecutionState *state);
+
+  /// Withdraw a state from the subscribers without terminating it, e.g.
+  /// while it waits to be merged, and hand it back to them later.
+  void suspendState(ExecutionState *state);
+  void resumeState(ExecutionState *state);
+
   const states_ty &getStates();
 
   void updateSubscribers();
@@ -79,6 +92,7 @@ public:
   ExecutionState *current = nullptr;
   std::vector<ExecutionState *> addedStates;
   std::vector<ExecutionState *> removedStates;
+  std::unordered_set<ExecutionState *> suspendedStates;
 };
 
 class Subscriber {
@@ -15,7 +15,6 @@
 #include "klee/Expr/ExprPPrinter.h"
 #include "klee/Support/OptionCategories.h"
 
-#include <bitset>
 #include <vector>
 
 using namespace klee;
@@ -33,59 +32,52 @@ cl::opt<bool>
 
 PTree::PTree(ExecutionState *initialState, uint32_t treeID) {
   id = treeID;
-  root = PTreeNodePtr(new PTreeNode(nullptr, initialState, id));
-  initialState->ptreeNode = root.getPointer();
+  root = new PTreeNode(nullptr, initialState, id);
+  initialState->ptreeNode = root;
 }
 
 void PTree::attach(PTreeNode *node, ExecutionState *leftState,
                    ExecutionState *rightState) {
-  assert(node && !node->left.getPointer() && !node->right.getPointer());
+  assert(node && !node->left && !node->right);
   assert(node == rightState->ptreeNode &&
          "Attach assumes the right state is the current state");
   node->state = nullptr;
-  node->left = PTreeNodePtr(new PTreeNode(node, leftState, id));
-  // The current node inherits the tag
-  uint8_t currentNodeTag = root.getInt();
-  if (node->parent)
-    currentNodeTag = node->parent->left.getPointer() == node
-                         ? node->parent->left.getInt()
-                         : node->parent->right.getInt();
-  node->right =
-      PTreeNodePtr(new PTreeNode(node, rightState, id), currentNodeTag);
+  node->left = new PTreeNode(node, leftState, id);
+  node->right = new PTreeNode(node, rightState, id);
 }
 
 void PTree::remove(PTreeNode *n) {
-  assert(!n->left.getPointer() && !n->right.getPointer());
+  assert(!n->left && !n->right);
   do {
     PTreeNode *p = n->parent;
     if (p) {
-      if (n == p->left.getPointer()) {
-        p->left = PTreeNodePtr(nullptr);
+      if (n == p->left) {
+        p->left = nullptr;
       } else {
-        assert(n == p->right.getPointer());
-        p->right = PTreeNodePtr(nullptr);
+        assert(n == p->right);
+        p->right = nullptr;
       }
     }
     delete n;
     n = p;
-  } while (n && !n->left.getPointer() && !n->right.getPointer());
+  } while (n && !n->left && !n->right);
 
   if (n && CompressProcessTree) {
     // We're now at a node that has exactly one child; we've just deleted the
     // other one. Eliminate the node and connect its child to the parent
     // directly (if it's not the root).
-    PTreeNodePtr child = n->left.getPointer() ? n->left : n->right;
+    PTreeNode *child = n->left ? n->left : n->right;
     PTreeNode *parent = n->parent;
 
-    child.getPointer()->parent = parent;
+    child->parent = parent;
     if (!parent) {
       // We're at the root.
       root = child;
     } else {
-      if (n == parent->left.getPointer()) {
+      if (n == parent->left) {
         parent->left = child;
       } else {
-        assert(n == parent->right.getPointer());
+        assert(n == parent->right);
         parent->right = child;
       }
     }
@@ -105,7 +97,7 @@ void PTree::dump(llvm::raw_ostream &os) {
   os << "\tnode [style=\"filled\",width=.1,height=.1,fontname=\"Terminus\"]\n";
   os << "\tedge [arrowsize=.3]\n";
   std::vector<const PTreeNode *> stack;
-  stack.push_back(root.getPointer());
+  stack.push_back(root);
   while (!stack.empty()) {
     const PTreeNode *n = stack.back();
     stack.pop_back();
@@ -113,17 +105,13 @@ void PTree::dump(llvm::raw_ostream &os) {
     if (n->state)
       os << ",fillcolor=green";
     os << "];\n";
-    if (n->left.getPointer()) {
-      os << "\tn" << n << " -> n" << n->left.getPointer();
-      os << " [label=0b"
-         << std::bitset<PtrBitCount>(n->left.getInt()).to_string() << "];\n";
-      stack.push_back(n->left.getPointer());
+    if (n->left) {
+      os << "\tn" << n << " -> n" << n->left << ";\n";
+      stack.push_back(n->left);
     }
-    if (n->right.getPointer()) {
-      os << "\tn" << n << " -> n" << n->right.getPointer();
-      os << " [label=0b"
-         << std::bitset<PtrBitCount>(n->right.getInt()).to_string() << "];\n";
-      stack.push_back(n->right.getPointer());
+    if (n->right) {
+      os << "\tn" << n << " -> n" << n->right << ";\n";
+      stack.push_back(n->right);
     }
   }
   os << "}\n";
@@ -133,6 +121,4 @@ void PTree::dump(llvm::raw_ostream &os) {
 PTreeNode::PTreeNode(PTreeNode *parent, ExecutionState *state, uint32_t id)
     : parent{parent}, state{state}, treeID{id} {
   state->ptreeNode = this;
-  left = PTreeNodePtr(nullptr);
-  right = PTreeNodePtr(nullptr);
 }
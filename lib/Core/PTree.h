@@ -13,25 +13,15 @@
 #include "klee/Core/BranchTypes.h"
 #include "klee/Expr/Expr.h"
 
-#include "llvm/ADT/PointerIntPair.h"
-
 namespace klee {
 class ExecutionState;
-class PTreeNode;
-/* PTreeNodePtr is used by the Random Path Searcher object to efficiently
-record which PTreeNode belongs to it. PTree is a global structure that
-captures all  states, whereas a Random Path Searcher might only care about
-a subset. The integer part of PTreeNodePtr is a bitmask (a "tag") of which
-Random Path Searchers PTreeNode belongs to. */
-constexpr int PtrBitCount = 3;
-using PTreeNodePtr = llvm::PointerIntPair<PTreeNode *, PtrBitCount, uint8_t>;
 
 class PTreeNode {
 public:
   PTreeNode *parent = nullptr;
 
-  PTreeNodePtr left;
-  PTreeNodePtr right;
+  PTreeNode *left = nullptr;
+  PTreeNode *right = nullptr;
   ExecutionState *state = nullptr;
 
   std::uint32_t treeID;
@@ -49,7 +39,7 @@ private:
   uint32_t id;
 
 public:
-  PTreeNodePtr root;
+  PTreeNode *root;
   PTree(ExecutionState *initialState, uint32_t id);
   explicit PTree(ExecutionState *initialState) : PTree(initialState, 0) {}
   ~PTree() = default;
@@ -0,0 +1,275 @@
+//===-- Profiler.cpp ------------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Profiler.h"
+
+#include "CallPathManager.h"
+
+#include "klee/Module/KInstruction.h"
+#include "klee/Module/KModule.h"
+#include "klee/Support/ErrorHandling.h"
+#include "klee/Support/OptionCategories.h"
+
+#include "llvm/IR/Function.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/time.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#endif
+
+using namespace klee;
+using namespace llvm;
+
+namespace {
+cl::opt<bool> Profile(
+    "profile", cl::init(false),
+    cl::desc("Sample where KLEE spends its time and write profile.folded "
+             "(folded stacks for flame graphs) and profile.lines (per source "
+             "line hot spots). Samples are attributed to call stacks unless "
+             "--use-call-paths=false, then to functions only "
+             "(default=false)"),
+    cl::cat(StatsCat));
+
+cl::opt<std::string> ProfileInterval(
+    "profile-interval", cl::init("1ms"),
+    cl::desc("CPU time between two profiler samples (default=1ms)"),
+    cl::cat(StatsCat));
+
+const char *phaseNames[Profiler::NumPhases] = {"interpretation", "solver",
+                                               "resolve", "fork", "external"};
+} // namespace
+
+const KInstruction *volatile Profiler::currentInstruction = nullptr;
+const CallPathNode *volatile Profiler::currentCallPath = nullptr;
+volatile sig_atomic_t Profiler::currentPhase =
+    static_cast<sig_atomic_t>(Profiler::Phase::Interpretation);
+Profiler::Sample Profiler::ring[Profiler::RingSize];
+std::atomic<unsigned> Profiler::ringHead{0};
+std::atomic<unsigned> Profiler::ringTail{0};
+std::atomic<std::uint64_t> Profiler::droppedSamples{0};
+
+bool Profiler::enabled() { return Profile; }
+
+Profiler::Profiler() : interval(ProfileInterval) {
+  if (!interval)
+    klee_error("--profile-interval must be positive");
+}
+
+Profiler::~Profiler() { stop(); }
+
+void Profiler::handleSignal(int) {
+  const KInstruction *ki = currentInstruction;
+  const CallPathNode *cp = currentCallPath;
+  sig_atomic_t phase = currentPhase;
+
+  // The newest entry is never drained while sampling is active, so it can be
+  // extended in place when nothing changed since the previous sample, e.g.
+  // during a long solver query.
+  unsigned head = ringHead.load(std::memory_order_relaxed);
+  unsigned tail = ringTail.load(std::memory_order_acquire);
+  if (head != tail) {
+    Sample &last = ring[(head - 1) % RingSize];
+    if (last.instruction == ki && last.callPath == cp && last.phase == phase) {
+      ++last.count;
+      return;
+    }
+  }
+  if (head - tail == RingSize) {
+    droppedSamples.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  ring[head % RingSize] = {ki, cp, phase, 1};
+  ringHead.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::drain(bool all) {
+  unsigned head = ringHead.load(std::memory_order_acquire);
+  unsigned tail = ringTail.load(std::memory_order_relaxed);
+  if (!all && head != tail)
+    --head;
+
+  for (; tail != head; ++tail) {
+    const Sample &s = ring[tail % RingSize];
+    // without call paths, the function is the only frame we know
+    const llvm::Function *f =
+        !s.callPath && s.instruction
+            ? s.instruction->getKFunction()->function()
+            : nullptr;
+    stackSamples[{s.callPath, f, s.phase}] += s.count;
+    if (s.instruction)
+      instructionSamples[s.instruction][s.phase] += s.count;
+    totalSamples += s.count;
+  }
+  ringTail.store(tail, std::memory_order_release);
+}
+
+void Profiler::start() {
+  if (running)
+    return;
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = handleSignal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, nullptr) != 0) {
+    klee_warning("profiler: cannot install SIGPROF handler: %s",
+                 strerror(errno));
+    return;
+  }
+
+#ifdef __linux__
+  // The timer measures the CPU time of the whole process, so that time spent
+  // in solver threads is sampled as well, but signals only the calling
+  // (interpreter) thread: the handler must not run on a solver thread while
+  // the interpreter updates the state it samples.
+  struct sigevent event;
+  memset(&event, 0, sizeof(event));
+  event.sigev_notify = SIGEV_THREAD_ID;
+  event.sigev_signo = SIGPROF;
+  event.sigev_notify_thread_id = syscall(SYS_gettid);
+  if (timer_create(CLOCK_PROCESS_CPUTIME_ID, &event, &timer) != 0) {
+    klee_warning("profiler: cannot create timer: %s", strerror(errno));
+    return;
+  }
+
+  timeval tv = static_cast<timeval>(interval);
+  struct itimerspec spec;
+  spec.it_interval.tv_sec = tv.tv_sec;
+  spec.it_interval.tv_nsec = tv.tv_usec * 1000;
+  spec.it_value = spec.it_interval;
+  if (timer_settime(timer, 0, &spec, nullptr) != 0) {
+    klee_warning("profiler: cannot start timer: %s", strerror(errno));
+    timer_delete(timer);
+    return;
+  }
+#else
+  struct itimerval timer;
+  timer.it_interval = static_cast<timeval>(interval);
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+    klee_warning("profiler: cannot start timer: %s", strerror(errno));
+    return;
+  }
+#endif
+  running = true;
+}
+
+void Profiler::stop() {
+  if (!running)
+    return;
+
+#ifdef __linux__
+  timer_delete(timer);
+#else
+  struct itimerval timer;
+  memset(&timer, 0, sizeof(timer));
+  setitimer(ITIMER_PROF, &timer, nullptr);
+#endif
+  signal(SIGPROF, SIG_IGN);
+  running = false;
+
+  drain(true);
+}
+
+static std::string getFunctionName(const KInstruction *ki) {
+  return ki ? ki->getKFunction()->function()->getName().str() : "[unknown]";
+}
+
+void Profiler::writeFoldedStacks(llvm::raw_ostream &os) {
+  drain(!running);
+
+  std::vector<std::string> frames;
+  for (const auto &entry : stackSamples) {
+    const CallPathNode *cp = std::get<0>(entry.first);
+    const llvm::Function *f = std::get<1>(entry.first);
+    unsigned phase = std::get<2>(entry.first);
+
+    frames.clear();
+    for (; cp && cp->function; cp = cp->parent)
+      frames.push_back(cp->function->getName().str());
+    if (frames.empty())
+      frames.push_back(f ? f->getName().str() : "[klee]");
+
+    for (auto it = frames.rbegin(), ie = frames.rend(); it != ie; ++it) {
+      if (it != frames.rbegin())
+        os << ';';
+      os << *it;
+    }
+    if (phase != static_cast<unsigned>(Phase::Interpretation))
+      os << ";[" << phaseNames[phase] << ']';
+    os << ' ' << entry.second << '\n';
+  }
+}
+
+void Profiler::writeHotSpots(llvm::raw_ostream &os) {
+  drain(!running);
+
+  struct Line {
+    std::string function;
+    PhaseSamples samples{};
+    std::uint64_t total = 0;
+  };
+  std::map<std::pair<std::string, size_t>, Line> lines;
+  std::uint64_t attributed = 0;
+  for (const auto &entry : instructionSamples) {
+    const KInstruction *ki = entry.first;
+    Line &line = lines[{ki->getSourceFilepath(), ki->getLine()}];
+    if (line.function.empty())
+      line.function = getFunctionName(ki);
+    for (unsigned i = 0; i != NumPhases; ++i) {
+      line.samples[i] += entry.second[i];
+      line.total += entry.second[i];
+    }
+  }
+
+  std::vector<std::pair<const std::pair<std::string, size_t> *, const Line *>>
+      sorted;
+  for (const auto &entry : lines) {
+    sorted.emplace_back(&entry.first, &entry.second);
+    attributed += entry.second.total;
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const auto &a, const auto &b) {
+                     return a.second->total > b.second->total;
+                   });
+
+  os << "# interval: " << interval.toMicroseconds() << "us, samples: "
+     << totalSamples << ", unattributed: " << totalSamples - attributed
+     << ", dropped: " << droppedSamples.load() << '\n';
+  os << "# " << format("%10s", (const char *)"total");
+  for (unsigned i = 0; i != NumPhases; ++i)
+    os << ' ' << format("%14s", phaseNames[i]);
+  os << "  location (function)\n";
+
+  for (const auto &entry : sorted) {
+    const Line &line = *entry.second;
+    os << "  " << format("%10llu", (unsigned long long)line.total);
+    for (unsigned i = 0; i != NumPhases; ++i)
+      os << ' ' << format("%14llu", (unsigned long long)line.samples[i]);
+    os << "  "
+       << (entry.first->first.empty() ? "[unknown]" : entry.first->first)
+       << ':' << entry.first->second << " (" << line.function << ")\n";
+  }
+}
@@ -0,0 +1,130 @@
+//===-- Profiler.h ----------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_PROFILER_H
+#define KLEE_PROFILER_H
+
+#include "klee/System/Time.h"
+
+#include <array>
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace llvm {
+class Function;
+class raw_ostream;
+} // namespace llvm
+
+namespace klee {
+class CallPathNode;
+struct KInstruction;
+
+/// Sampling profiler attributing KLEE's own running time to the
+/// instruction, call path and phase (interpretation, solving, ...) that is
+/// active when a SIGPROF timer fires on the interpreter thread. The signal
+/// handler only appends to a fixed-size ring buffer; samples are aggregated
+/// from the interpreter loop.
+class Profiler {
+public:
+  enum class Phase : unsigned char {
+    Interpretation,
+    Solver,
+    Resolve,
+    Fork,
+    External,
+  };
+  static constexpr unsigned NumPhases = 5;
+
+  /// Marks the lifetime of the guard as spent in a phase. Cheap enough to
+  /// be used unconditionally, it is a no-op unless a profiler is running.
+  class PhaseScope {
+    sig_atomic_t previous;
+
+  public:
+    explicit PhaseScope(Phase phase) : previous(currentPhase) {
+      currentPhase = static_cast<sig_atomic_t>(phase);
+    }
+    ~PhaseScope() { currentPhase = previous; }
+
+    PhaseScope(const PhaseScope &) = delete;
+    PhaseScope &operator=(const PhaseScope &) = delete;
+  };
+
+private:
+  struct Sample {
+    const KInstruction *instruction;
+    const CallPathNode *callPath;
+    sig_atomic_t phase;
+    std::uint32_t count;
+  };
+  static constexpr unsigned RingSize = 1u << 12;
+
+  // state shared with the signal handler
+  static const KInstruction *volatile currentInstruction;
+  static const CallPathNode *volatile currentCallPath;
+  static volatile sig_atomic_t currentPhase;
+  static Sample ring[RingSize];
+  static std::atomic<unsigned> ringHead, ringTail;
+  static std::atomic<std::uint64_t> droppedSamples;
+
+  time::Span interval;
+  bool running = false;
+#ifdef __linux__
+  timer_t timer;
+#endif
+
+  typedef std::array<std::uint64_t, NumPhases> PhaseSamples;
+  std::map<std::tuple<const CallPathNode *, const llvm::Function *, unsigned>,
+           std::uint64_t>
+      stackSamples;
+  std::unordered_map<const KInstruction *, PhaseSamples> instructionSamples;
+  std::uint64_t totalSamples = 0;
+
+  static void handleSignal(int);
+  void drain(bool all);
+
+public:
+  /// Whether --profile was given
+  static bool enabled();
+
+  Profiler();
+  ~Profiler();
+
+  Profiler(const Profiler &) = delete;
+  Profiler &operator=(const Profiler &) = delete;
+
+  void start();
+  void stop();
+
+  /// Record the instruction about to be executed and aggregate pending
+  /// samples. callPath may be null if call paths are not tracked.
+  void stepInstruction(const KInstruction *ki, const CallPathNode *callPath) {
+    currentInstruction = ki;
+    currentCallPath = callPath;
+    if (ringHead.load(std::memory_order_relaxed) -
+            ringTail.load(std::memory_order_relaxed) >
+        1)
+      drain(false);
+  }
+
+  /// Write samples as folded stacks ("frame;frame;... count"), as consumed
+  /// by flame graph tools.
+  void writeFoldedStacks(llvm::raw_ostream &os);
+
+  /// Write samples per source line, hottest lines first.
+  void writeHotSpots(llvm::raw_ostream &os);
+};
+} // namespace klee
+
+#endif /* KLEE_PROFILER_H */
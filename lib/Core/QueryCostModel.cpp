@@ -0,0 +1,170 @@
+//===-- QueryCostModel.cpp ------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "QueryCostModel.h"
+
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/IndependentSet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+using namespace klee;
+
+namespace {
+/// Observations before the model predicts anything.
+constexpr std::uint64_t MinObservations = 16;
+/// Observations of a shape before its mean is trusted over the linear model.
+constexpr std::uint64_t MinShapeObservations = 3;
+/// Constraints whose nonlinear operator counts are remembered.
+constexpr std::size_t NonlinearCacheSize = 1 << 16;
+
+bool isNonlinear(const Expr &e) {
+  switch (e.getKind()) {
+  case Expr::Mul:
+  case Expr::UDiv:
+  case Expr::SDiv:
+  case Expr::URem:
+  case Expr::SRem:
+    return !isa<ConstantExpr>(e.getKid(0)) && !isa<ConstantExpr>(e.getKid(1));
+  default:
+    return false;
+  }
+}
+
+/// The number of bits needed for v, an order of magnitude.
+std::uint32_t magnitude(std::uint32_t v) {
+  std::uint32_t bits = 0;
+  for (; v; v >>= 1)
+    ++bits;
+  return bits;
+}
+} // namespace
+
+std::uint32_t QueryCostModel::countNonlinear(const ref<Expr> &e) {
+  std::uint32_t count = 0;
+  std::unordered_set<const Expr *> visited;
+  std::vector<const Expr *> stack{e.get()};
+  while (!stack.empty()) {
+    const Expr *current = stack.back();
+    stack.pop_back();
+    if (!visited.insert(current).second)
+      continue;
+    if (isNonlinear(*current))
+      ++count;
+    for (unsigned i = 0, n = current->getNumKids(); i != n; ++i)
+      stack.push_back(current->getKid(i).get());
+  }
+  return count;
+}
+
+std::uint32_t QueryCostModel::countNonlinearCached(const ref<Expr> &e) {
+  auto cached = nonlinearCache.find(e);
+  if (cached != nonlinearCache.end())
+    return cached->second;
+  if (nonlinearCache.size() >= NonlinearCacheSize)
+    nonlinearCache.clear();
+  std::uint32_t count = countNonlinear(e);
+  nonlinearCache.emplace(e, count);
+  return count;
+}
+
+QueryFeatures QueryCostModel::extract(const ConstraintSet &constraints,
+                                      ref<Expr> expr,
+                                      QueryFeatures::Kind kind) {
+  QueryFeatures features;
+  features.kind = kind;
+  features.constraints = constraints.cs().size();
+
+  std::vector<ref<const IndependentConstraintSet>> factors;
+  constraints.getAllDependentConstraintsSets(expr, factors);
+  for (const auto &factor : factors) {
+    features.factorConstraints += factor->exprs.size();
+    for (const ref<Expr> &constraint : factor->exprs)
+      features.nonlinear += countNonlinearCached(constraint);
+  }
+  features.nonlinear += countNonlinear(expr);
+
+  std::vector<const Array *> arrays;
+  calculateArraysInFactors(factors, expr, arrays);
+  features.arrays = arrays.size();
+  return features;
+}
+
+QueryFeatures
+QueryCostModel::extract(const ConstraintSet &constraints,
+                        const std::vector<const Array *> &objects) {
+  QueryFeatures features;
+  features.kind = QueryFeatures::InitialValues;
+  features.constraints = constraints.cs().size();
+  features.factorConstraints = features.constraints;
+  features.arrays = objects.size();
+  for (const ref<Expr> &constraint : constraints.cs())
+    features.nonlinear += countNonlinearCached(constraint);
+  return features;
+}
+
+std::array<double, QueryCostModel::NumWeights>
+QueryCostModel::inputs(const QueryFeatures &features) {
+  return {1.,
+          std::log1p(features.constraints),
+          std::log1p(features.factorConstraints),
+          std::log1p(features.arrays),
+          std::log1p(features.nonlinear),
+          features.kind == QueryFeatures::Value ? 1. : 0.,
+          features.kind == QueryFeatures::InitialValues ? 1. : 0.,
+          features.kind == QueryFeatures::Check ? 1. : 0.};
+}
+
+std::uint32_t QueryCostModel::shapeOf(const QueryFeatures &features) {
+  return features.kind | magnitude(features.factorConstraints) << 2 |
+         magnitude(features.arrays) << 8 |
+         std::min<std::uint32_t>(magnitude(features.nonlinear), 7) << 14;
+}
+
+time::Span QueryCostModel::predict(const QueryFeatures &features) const {
+  if (observations < MinObservations)
+    return time::Span();
+
+  double logCost;
+  auto shape = shapes.find(shapeOf(features));
+  if (shape != shapes.end() && shape->second.count >= MinShapeObservations) {
+    logCost = shape->second.mean;
+  } else {
+    auto x = inputs(features);
+    logCost = 0;
+    for (unsigned i = 0; i != NumWeights; ++i)
+      logCost += weights[i] * x[i];
+  }
+  // log costs are of microseconds, at most about a day
+  double us = std::expm1(std::min(std::max(logCost, 0.), 25.));
+  return time::microseconds(static_cast<std::uint64_t>(us));
+}
+
+void QueryCostModel::observe(const QueryFeatures &features, time::Span cost) {
+  double logCost = std::log1p(cost.toMicroseconds());
+  ++observations;
+
+  Shape &shape = shapes[shapeOf(features)];
+  ++shape.count;
+  // a running mean that turns into a moving average for frequent shapes
+  shape.mean += (logCost - shape.mean) * std::max(1. / shape.count, .05);
+
+  auto x = inputs(features);
+  double predicted = 0, norm = 0;
+  for (unsigned i = 0; i != NumWeights; ++i) {
+    predicted += weights[i] * x[i];
+    norm += x[i] * x[i];
+  }
+  double step = .5 * (logCost - predicted) / (1. + norm);
+  for (unsigned i = 0; i != NumWeights; ++i)
+    weights[i] += step * x[i];
+}
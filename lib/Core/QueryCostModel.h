@@ -0,0 +1,74 @@
+//===-- QueryCostModel.h ----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_QUERYCOSTMODEL_H
+#define KLEE_QUERYCOSTMODEL_H
+
+#include "klee/Expr/ExprHashMap.h"
+#include "klee/Solver/SolverUtil.h"
+#include "klee/System/Time.h"
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace klee {
+class Array;
+class ConstraintSet;
+
+/// QueryCostModel - Predicts the time a solver query takes from a few cheap
+/// features of the query, and learns from the times it is told about.
+///
+/// Queries are grouped into shapes by their kind and the orders of magnitude
+/// of their features. Once a shape has been seen a few times, its queries
+/// are predicted by the running mean of its log solve times. Other queries
+/// are predicted by a linear model over the log features, trained online by
+/// normalized least mean squares.
+class QueryCostModel {
+  static constexpr unsigned NumWeights = 8;
+
+  struct Shape {
+    double mean = 0;
+    std::uint64_t count = 0;
+  };
+
+  std::array<double, NumWeights> weights{};
+  std::unordered_map<std::uint32_t, Shape> shapes;
+  std::uint64_t observations = 0;
+
+  /// nonlinear operator counts of constraints, bounded in size
+  ExprHashMap<std::uint32_t> nonlinearCache;
+
+  std::uint32_t countNonlinear(const ref<Expr> &e);
+  std::uint32_t countNonlinearCached(const ref<Expr> &e);
+
+  static std::array<double, NumWeights> inputs(const QueryFeatures &features);
+  static std::uint32_t shapeOf(const QueryFeatures &features);
+
+public:
+  /// Features of a query about expr under constraints.
+  QueryFeatures extract(const ConstraintSet &constraints, ref<Expr> expr,
+                        QueryFeatures::Kind kind);
+  /// Features of a query for a model of objects under constraints.
+  QueryFeatures extract(const ConstraintSet &constraints,
+                        const std::vector<const Array *> &objects);
+
+  /// The predicted solve time, or an empty span while the model has seen
+  /// too few queries to predict anything.
+  time::Span predict(const QueryFeatures &features) const;
+
+  /// Learn that a query with these features took the given time.
+  void observe(const QueryFeatures &features, time::Span cost);
+
+  std::uint64_t getObservations() const { return observations; }
+};
+} // namespace klee
+
+#endif /* KLEE_QUERYCOSTMODEL_H */
@@ -30,6 +30,7 @@
 #include <cassert>
 #include <cmath>
 #include <set>
+#include <unordered_set>
 
 using namespace klee;
 using namespace llvm;
@@ -361,6 +362,7 @@ WeightedRandomSearcher::WeightedRandomSearcher(WeightType type, RNG &rng)
   case InstCount:
   case CPInstCount:
   case QueryCost:
+  case PredictedQueryCost:
   case MinDistToUncovered:
   case CoveringNew:
     updateWeights = true;
@@ -389,7 +391,7 @@ double WeightedRandomSearcher::getWeight(ExecutionState *es) {
   }
   case CPInstCount: {
     const InfoStackFrame &sf = es->stack.infoStack().back();
-    uint64_t count = sf.callPathNode->statistics.getValue(stats::instructions);
+    uint64_t count = sf.callPathNode->getValue(stats::instructions);
     double inv = 1. / std::max((uint64_t)1, count);
     return inv;
   }
@@ -397,6 +399,11 @@ double WeightedRandomSearcher::getWeight(ExecutionState *es) {
     return (es->queryMetaData.queryCost.toSeconds() < .1)
                ? 1.
                : 1. / es->queryMetaData.queryCost.toSeconds();
+  case PredictedQueryCost:
+    // the cost of a state's next query is estimated by that of its last one
+    return (es->queryMetaData.predictedCost.toSeconds() < .01)
+               ? 1.
+               : .01 / es->queryMetaData.predictedCost.toSeconds();
   case CoveringNew:
   case MinDistToUncovered: {
     uint64_t md2u = computeMinDistToUncovered(
@@ -448,6 +455,9 @@ void WeightedRandomSearcher::printName(llvm::raw_ostream &os) {
   case QueryCost:
     os << "QueryCost\n";
     return;
+  case PredictedQueryCost:
+    os << "PredictedQueryCost\n";
+    return;
   case InstCount:
     os << "InstCount\n";
     return;
@@ -468,98 +478,162 @@ void WeightedRandomSearcher::printName(llvm::raw_ostream &os) {
 
 ///
 
-// Check if n is a valid pointer and a node belonging to us
-#define IS_OUR_NODE_VALID(n)                                                   \
-  (((n).getPointer() != nullptr) && (((n).getInt() & idBitMask) != 0))
-
-RandomPathSearcher::RandomPathSearcher(PForest &processForest, RNG &rng)
-    : processForest{processForest}, theRNG{rng},
-      idBitMask{processForest.getNextId()} {};
+RandomPathSearcher::RandomPathSearcher(RNG &rng, bool weighted)
+    : theRNG{rng}, weighted{weighted} {}
 
 ExecutionState &RandomPathSearcher::selectState() {
-  unsigned flips = 0, bits = 0, range = 0;
-  PTreeNodePtr *root = nullptr;
-  while (!root || !IS_OUR_NODE_VALID(*root))
-    root = &processForest.getPTrees()
-                .at(range++ % processForest.getPTrees().size() + 1)
-                ->root;
-  assert(root->getInt() & idBitMask && "Root should belong to the searcher");
-  PTreeNode *n = root->getPointer();
+  assert(!roots.empty() && "No state to select from");
+  unsigned flips = 0, bits = 0;
+  Node *n = roots.begin()->second;
   while (!n->state) {
-    if (!IS_OUR_NODE_VALID(n->left)) {
-      assert(IS_OUR_NODE_VALID(n->right) &&
-             "Both left and right nodes invalid");
-      assert(n != n->right.getPointer());
-      n = n->right.getPointer();
-    } else if (!IS_OUR_NODE_VALID(n->right)) {
-      assert(IS_OUR_NODE_VALID(n->left) && "Both right and left nodes invalid");
-      assert(n != n->left.getPointer());
-      n = n->left.getPointer();
-    } else {
-      if (bits == 0) {
-        flips = theRNG.getInt32();
-        bits = 32;
-      }
-      --bits;
-      n = ((flips & (1U << bits)) ? n->left : n->right).getPointer();
+    if (weighted) {
+      double left = n->children[0]->weight;
+      double total = left + n->children[1]->weight;
+      n = n->children[theRNG.getDoubleL() * total < left ? 0 : 1];
+      continue;
     }
+    if (bits == 0) {
+      flips = theRNG.getInt32();
+      bits = 32;
+    }
+    --bits;
+    n = n->children[(flips & (1U << bits)) ? 0 : 1];
   }
 
   return *n->state;
 }
 
-void RandomPathSearcher::update(
-    ExecutionState *, const std::vector<ExecutionState *> &addedStates,
-    const std::vector<ExecutionState *> &removedStates) {
-  // insert states
-  for (auto &es : addedStates) {
-    PTreeNode *pnode = es->ptreeNode, *parent = pnode->parent;
-    PTreeNodePtr &root = processForest.getPTrees().at(pnode->getTreeID())->root;
-    PTreeNodePtr *childPtr;
-
-    childPtr = parent ? ((parent->left.getPointer() == pnode) ? &parent->left
-                                                              : &parent->right)
-                      : &root;
-    while (pnode && !IS_OUR_NODE_VALID(*childPtr)) {
-      childPtr->setInt(childPtr->getInt() | idBitMask);
-      pnode = parent;
-      if (pnode)
-        parent = pnode->parent;
-
-      childPtr = parent
-                     ? ((parent->left.getPointer() == pnode) ? &parent->left
-                                                             : &parent->right)
-                     : &root;
-    }
+RandomPathSearcher::Node *&RandomPathSearcher::getLink(Node *node) {
+  if (Node *parent = node->parent)
+    return parent->children[parent->children[0] == node ? 0 : 1];
+  PTreeNode *pnode = node->state ? node->state->ptreeNode : node->ptreeNode;
+  return roots.at(pnode->getTreeID());
+}
+
+void RandomPathSearcher::insert(ExecutionState *es) {
+  PTreeNode *pnode = es->ptreeNode, *parent = pnode->parent;
+  auto &leaf = leaves[es];
+  assert(!leaf && "State added twice");
+  leaf = std::make_unique<Node>();
+  Node *node = leaf.get();
+  node->state = es;
+  if (weighted)
+    node->weight = getWeight(es);
+
+  Node *&root = roots[pnode->getTreeID()];
+  if (!root) {
+    root = node;
+    return;
   }
 
-  // remove states
-  for (auto es : removedStates) {
-    PTreeNode *pnode = es->ptreeNode, *parent = pnode->parent;
-    PTreeNodePtr &root = processForest.getPTrees().at(pnode->getTreeID())->root;
-
-    while (pnode && !IS_OUR_NODE_VALID(pnode->left) &&
-           !IS_OUR_NODE_VALID(pnode->right)) {
-      auto childPtr =
-          parent ? ((parent->left.getPointer() == pnode) ? &parent->left
-                                                         : &parent->right)
-                 : &root;
-      assert(IS_OUR_NODE_VALID(*childPtr) && "Removing pTree child not ours");
-      childPtr->setInt(childPtr->getInt() & ~idBitMask);
-      pnode = parent;
-      if (pnode)
-        parent = pnode->parent;
+  // A state usually comes from a fork, where its sibling leads to our states.
+  PTreeNode *branch = parent;
+  Node *sibling = nullptr;
+  int side = 0;
+  if (parent) {
+    side = parent->left == pnode ? 0 : 1;
+    PTreeNode *other = side == 0 ? parent->right : parent->left;
+    if (other && other->state) {
+      auto it = leaves.find(other->state);
+      if (it != leaves.end())
+        sibling = it->second.get();
+    } else if (other) {
+      auto it = branches.find(other);
+      if (it != branches.end())
+        sibling = it->second.get();
     }
   }
+
+  // Otherwise, follow the path to the state down our view for as long as it
+  // goes, and find where it parts from the path down PTree.
+  if (!sibling) {
+    std::unordered_set<PTreeNode *> path;
+    for (PTreeNode *p = pnode; p; p = p->parent)
+      path.insert(p);
+    sibling = root;
+    while (!sibling->state && path.count(sibling->ptreeNode))
+      sibling = sibling->children[path.count(sibling->ptreeNode->left) ? 0 : 1];
+    branch = sibling->state ? sibling->state->ptreeNode : sibling->ptreeNode;
+    while (!path.count(branch))
+      branch = branch->parent;
+    side = path.count(branch->left) ? 0 : 1;
+  }
+
+  auto &split = branches[branch];
+  assert(!split && "Branch already in view");
+  split = std::make_unique<Node>();
+  Node *&link = getLink(sibling);
+  split->parent = sibling->parent;
+  split->ptreeNode = branch;
+  split->children[side] = node;
+  split->children[1 - side] = sibling;
+  node->parent = sibling->parent = split.get();
+  link = split.get();
+  updateWeights(split.get());
+}
+
+void RandomPathSearcher::remove(ExecutionState *es) {
+  auto it = leaves.find(es);
+  assert(it != leaves.end() && "Removing state not in view");
+  Node *node = it->second.get();
+  Node *parent = node->parent;
+  if (!parent) {
+    roots.erase(es->ptreeNode->getTreeID());
+    leaves.erase(it);
+    return;
+  }
+
+  Node *other = parent->children[parent->children[0] == node ? 1 : 0];
+  getLink(parent) = other;
+  other->parent = parent->parent;
+  branches.erase(parent->ptreeNode);
+  leaves.erase(it);
+  if (other->parent)
+    updateWeights(other->parent);
 }
 
-bool RandomPathSearcher::empty() {
-  bool res = true;
-  for (const auto &ntree : processForest.getPTrees())
-    res = res && !IS_OUR_NODE_VALID(ntree.second->root);
-  return res;
+double RandomPathSearcher::getWeight(ExecutionState *es) {
+  uint64_t md2u = computeMinDistToUncovered(
+      es->pc, es->stack.infoStack().back().minDistToUncoveredOnReturn);
+  double invMD2U = 1. / (md2u ? md2u : 10000);
+  return invMD2U * invMD2U;
 }
 
+void RandomPathSearcher::updateWeights(Node *node) {
+  if (!weighted)
+    return;
+  for (; node; node = node->parent) {
+    double weight = (node->children[0]->weight + node->children[1]->weight) / 2;
+    // a change halves at every level up, stop once it no longer shows
+    bool changed = std::abs(weight - node->weight) > node->weight * 1e-6;
+    node->weight = weight;
+    if (!changed)
+      break;
+  }
+}
+
+void RandomPathSearcher::update(
+    ExecutionState *current, const std::vector<ExecutionState *> &addedStates,
+    const std::vector<ExecutionState *> &removedStates) {
+  // update the weight of the current state
+  if (weighted && current) {
+    auto it = leaves.find(current);
+    if (it != leaves.end()) {
+      Node *node = it->second.get();
+      node->weight = getWeight(current);
+      updateWeights(node->parent);
+    }
+  }
+
+  for (auto es : addedStates)
+    insert(es);
+
+  for (auto es : removedStates)
+    remove(es);
+}
+
+bool RandomPathSearcher::empty() { return roots.empty(); }
+
 void RandomPathSearcher::printName(llvm::raw_ostream &os) {
   os << "RandomPathSearcher\n";
 }
@@ -12,7 +12,6 @@
 
 #include "DistanceCalculator.h"
 #include "ExecutionState.h"
-#include "PForest.h"
 #include "PTree.h"
 #include "TargetManager.h"
 
@@ -22,6 +21,8 @@
 
 #include "llvm/Support/raw_ostream.h"
 
+#include <map>
+#include <memory>
 #include <set>
 #include <unordered_map>
 #include <vector>
@@ -78,7 +79,8 @@ public:
     NURS_RP,
     NURS_ICnt,
     NURS_CPICnt,
-    NURS_QC
+    NURS_QC,
+    NURS_PQC
   };
 };
 
@@ -212,6 +214,7 @@ public:
     Depth,
     RP,
     QueryCost,
+    PredictedQueryCost,
     InstCount,
     CPInstCount,
     MinDistToUncovered,
@@ -245,29 +248,47 @@ public:
 /// PTree is a global data structure, however, a searcher can sometimes only
 /// select from a subset of all states (depending on the update calls).
 ///
-/// To support this, RandomPathSearcher has a subgraph view of PTree, in that it
-/// only walks the PTreeNodes that it "owns". Ownership is stored in the
-/// getInt method of the PTreeNodePtr class (which hides it in the pointer
-/// itself).
+/// To support this, RandomPathSearcher keeps its own view of PTree, which
+/// only contains its states and the PTreeNodes at which the paths to them
+/// branch. Chains of PTreeNodes with a single child leading to its states are
+/// left out, so that a walk only flips coins at real branches and takes
+/// O(log n) steps in expectation for n states, however deep PTree gets.
 ///
-/// The current implementation of PTreeNodePtr supports only 3 instances of the
-/// RandomPathSearcher. This is because the current PTreeNodePtr implementation
-/// conforms to C++ and only steals the last 3 alignment bits. This restriction
-/// could be relaxed slightly by an architecture-specific implementation of
-/// PTreeNodePtr that also steals the top bits of the pointer.
-///
-/// The ownership bits are maintained in the update method.
+/// When weighted, the walk takes each side of a branch with a probability
+/// proportional to the weight of the side, the mean of the weights of its two
+/// sides for a branch, where states closer to uncovered code weigh more. With
+/// equal weights this is the unweighted walk.
 class RandomPathSearcher final : public Searcher {
-  PForest &processForest;
+  struct Node {
+    Node *parent = nullptr;
+    /// The left and right side of a branch, null for a state.
+    Node *children[2] = {nullptr, nullptr};
+    /// The PTreeNode of a branch.
+    PTreeNode *ptreeNode = nullptr;
+    ExecutionState *state = nullptr;
+    double weight = 1.;
+  };
+
   RNG &theRNG;
+  bool weighted;
+
+  /// Roots of the views of the trees of PForest, by tree id.
+  std::map<std::uint32_t, Node *> roots;
+  std::unordered_map<ExecutionState *, std::unique_ptr<Node>> leaves;
+  std::unordered_map<PTreeNode *, std::unique_ptr<Node>> branches;
 
-  // Unique bitmask of this searcher
-  const uint8_t idBitMask;
+  /// The pointer to node in its parent, or in roots.
+  Node *&getLink(Node *node);
+  void insert(ExecutionState *es);
+  void remove(ExecutionState *es);
+  double getWeight(ExecutionState *es);
+  /// Recompute the weights from node up, for as long as they change.
+  void updateWeights(Node *node);
 
 public:
-  /// \param processTree The process tree.
   /// \param RNG A random number generator.
-  RandomPathSearcher(PForest &processForest, RNG &rng);
+  /// \param weighted Whether to favour states closer to uncovered code.
+  RandomPathSearcher(RNG &rng, bool weighted = false);
   ~RandomPathSearcher() override = default;
 
   ExecutionState &selectState() override;
@@ -36,6 +36,7 @@
 
 #include <array>
 #include <cerrno>
+#include <limits>
 #include <sstream>
 
 using namespace llvm;
@@ -126,6 +127,10 @@ static constexpr std::array handlerInfo = {
     add("klee_warning", handleWarning, false),
     add("klee_warning_once", handleWarningOnce, false),
     add("klee_dump_constraints", handleDumpConstraints, false),
+    add("klee_memcmp_internal", handleMemcmp, true),
+    add("klee_memcpy_internal", handleMemmove, true),
+    add("klee_memmove_internal", handleMemmove, true),
+    add("klee_memset_internal", handleMemset, true),
     add("malloc", handleMalloc, true),
     add("memalign", handleMemalign, true),
     add("realloc", handleRealloc, true),
@@ -314,6 +319,25 @@ SpecialFunctionHandler::readStringAtAddress(ExecutionState &state,
   return buf.str();
 }
 
+bool SpecialFunctionHandler::resolveMemoryRange(ExecutionState &state,
+                                                ref<Expr> address,
+                                                uint64_t size, ObjectPair &op,
+                                                unsigned &offset) {
+  if (size > std::numeric_limits<unsigned>::max())
+    return false;
+  ref<PointerExpr> pointer =
+      executor.toUnique(state, executor.makePointer(address));
+  if (!isa<ConstantPointerExpr>(pointer) ||
+      !state.addressSpace.resolveOne(cast<ConstantPointerExpr>(pointer), op))
+    return false;
+
+  const MemoryObject *mo = op.first;
+  if (!mo->getBoundsCheckPointer(pointer, size)->isTrue())
+    return false;
+  offset = cast<ConstantExpr>(mo->getOffsetExpr(pointer))->getZExtValue();
+  return true;
+}
+
 /****/
 
 void SpecialFunctionHandler::handleAbort(
@@ -817,6 +841,97 @@ void SpecialFunctionHandler::handleCheckMemoryAccess(
   }
 }
 
+// The memory handlers below return zero for anything they cannot do in one
+// step: symbolic lengths, pointers that do not resolve to a single object
+// and accesses that may be out of bounds or to read-only memory are left to
+// the byte loops of the runtime, which handle and report them like any other
+// memory access.
+
+void SpecialFunctionHandler::handleMemmove(ExecutionState &state,
+                                           KInstruction *target,
+                                           std::vector<ref<Expr>> &arguments) {
+  assert(arguments.size() == 3 &&
+         "invalid number of arguments to klee_memmove_internal");
+
+  ref<Expr> count = executor.toUnique(state, arguments[2]->getValue());
+  bool handled = false;
+  if (ref<ConstantExpr> countConst = dyn_cast<ConstantExpr>(count)) {
+    uint64_t bytes = countConst->getZExtValue();
+    ObjectPair dst, src;
+    unsigned dstOffset, srcOffset;
+    if (bytes == 0) {
+      handled = true;
+    } else if (resolveMemoryRange(state, arguments[0], bytes, dst,
+                                  dstOffset) &&
+               !dst.second->readOnly &&
+               resolveMemoryRange(state, arguments[1], bytes, src,
+                                  srcOffset)) {
+      ObjectState *wos = state.addressSpace.getWriteable(dst.first, dst.second);
+      const ObjectState *ros = src.first == dst.first ? wos : src.second;
+      wos->copy(dstOffset, *ros, srcOffset, bytes);
+      handled = true;
+    }
+  }
+  executor.bindLocal(target, state, ConstantExpr::create(handled, Expr::Int32));
+}
+
+void SpecialFunctionHandler::handleMemset(ExecutionState &state,
+                                          KInstruction *target,
+                                          std::vector<ref<Expr>> &arguments) {
+  assert(arguments.size() == 3 &&
+         "invalid number of arguments to klee_memset_internal");
+
+  ref<Expr> count = executor.toUnique(state, arguments[2]->getValue());
+  bool handled = false;
+  if (ref<ConstantExpr> countConst = dyn_cast<ConstantExpr>(count)) {
+    uint64_t bytes = countConst->getZExtValue();
+    ObjectPair dst;
+    unsigned dstOffset;
+    if (bytes == 0) {
+      handled = true;
+    } else if (resolveMemoryRange(state, arguments[0], bytes, dst,
+                                  dstOffset) &&
+               !dst.second->readOnly) {
+      ObjectState *wos = state.addressSpace.getWriteable(dst.first, dst.second);
+      wos->fill(dstOffset,
+                ExtractExpr::create(arguments[1]->getValue(), 0, Expr::Int8),
+                bytes);
+      handled = true;
+    }
+  }
+  executor.bindLocal(target, state, ConstantExpr::create(handled, Expr::Int32));
+}
+
+void SpecialFunctionHandler::handleMemcmp(ExecutionState &state,
+                                          KInstruction *target,
+                                          std::vector<ref<Expr>> &arguments) {
+  assert(arguments.size() == 4 &&
+         "invalid number of arguments to klee_memcmp_internal");
+
+  ref<Expr> count = executor.toUnique(state, arguments[2]->getValue());
+  bool handled = false;
+  if (ref<ConstantExpr> countConst = dyn_cast<ConstantExpr>(count)) {
+    uint64_t bytes = countConst->getZExtValue();
+    ObjectPair a, b, result;
+    unsigned aOffset = 0, bOffset = 0, resultOffset;
+    if ((bytes == 0 ||
+         (resolveMemoryRange(state, arguments[0], bytes, a, aOffset) &&
+          resolveMemoryRange(state, arguments[1], bytes, b, bOffset))) &&
+        resolveMemoryRange(state, arguments[3], Expr::Int32 / 8, result,
+                           resultOffset) &&
+        !result.second->readOnly) {
+      ref<Expr> difference = ConstantExpr::create(0, Expr::Int32);
+      if (bytes != 0)
+        difference = a.second->compare(aOffset, *b.second, bOffset, bytes);
+      ObjectState *wos =
+          state.addressSpace.getWriteable(result.first, result.second);
+      wos->write(resultOffset, difference);
+      handled = true;
+    }
+  }
+  executor.bindLocal(target, state, ConstantExpr::create(handled, Expr::Int32));
+}
+
 void SpecialFunctionHandler::handleGetValue(ExecutionState &state,
                                             KInstruction *target,
                                             std::vector<ref<Expr>> &arguments) {
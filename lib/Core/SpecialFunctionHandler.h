@@ -12,8 +12,10 @@
 
 #include "klee/Config/config.h"
 
+#include <cstdint>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace llvm {
@@ -25,6 +27,8 @@ class Executor;
 class Expr;
 class PointerExpr;
 class ExecutionState;
+class MemoryObject;
+class ObjectState;
 struct KInstruction;
 template <typename T> class ref;
 
@@ -71,6 +75,14 @@ public:
   std::string readStringAtAddress(ExecutionState &state,
                                   ref<PointerExpr> address);
 
+  /// Resolve the size bytes at address to a single object if the address
+  /// has a unique value and the bytes are in bounds, and set offset to the
+  /// first of them in the object.
+  bool
+  resolveMemoryRange(ExecutionState &state, ref<Expr> address, uint64_t size,
+                     std::pair<const MemoryObject *, const ObjectState *> &op,
+                     unsigned &offset);
+
   /* Handlers */
 
 #define HANDLER(name)                                                          \
@@ -102,6 +114,9 @@ public:
   HANDLER(handleMalloc);
   HANDLER(handleMemalign);
   HANDLER(handleMarkGlobal);
+  HANDLER(handleMemcmp);
+  HANDLER(handleMemmove);
+  HANDLER(handleMemset);
   HANDLER(handleNew);
   HANDLER(handleNewArray);
   HANDLER(handleNewNothrowArray);
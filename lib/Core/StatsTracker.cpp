@@ -16,6 +16,7 @@
 #include "klee/Module/KModule.h"
 #include "klee/Module/LocationInfo.h"
 #include "klee/Solver/SolverStats.h"
+#include "klee/Statistics/LiveMetrics.h"
 #include "klee/Statistics/Statistics.h"
 #include "klee/Support/ErrorHandling.h"
 #include "klee/Support/ModuleUtil.h"
@@ -25,6 +26,7 @@
 #include "CoreStats.h"
 #include "Executor.h"
 #include "MemoryManager.h"
+#include "Profiler.h"
 #include "UserSearcher.h"
 
 #include "llvm/ADT/SmallBitVector.h"
@@ -40,6 +42,8 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
 
+#include <cerrno>
+#include <cstring>
 #include <unistd.h>
 
 using namespace klee;
@@ -139,6 +143,18 @@ cl::opt<std::string> UncoveredUpdateInterval(
     cl::desc("Update interval for uncovered instructions (default=30s)"),
     cl::cat(StatsCat));
 
+cl::opt<bool> LiveMetricsOpt(
+    "live-metrics", cl::init(false),
+    cl::desc("Export statistics and histograms through a shared memory page "
+             "(/dev/shm/klee-live-<pid>) for klee-stats --live "
+             "(default=false)"),
+    cl::cat(StatsCat));
+
+cl::opt<std::string> LiveMetricsInterval(
+    "live-metrics-interval", cl::init("1s"),
+    cl::desc("Time between live metrics updates (default=1s)"),
+    cl::cat(StatsCat));
+
 cl::opt<bool> UseCallPaths("use-call-paths", cl::init(true),
                            cl::desc("Enable calltree tracking for instruction "
                                     "level statistics (default=true)"),
@@ -152,6 +168,8 @@ bool StatsTracker::useStatistics() { return OutputStats || OutputIStats; }
 
 bool StatsTracker::useIStats() { return OutputIStats; }
 
+bool StatsTracker::useLiveMetrics() { return LiveMetricsOpt; }
+
 /// Check for special cases where we statically know an instruction is
 /// uncoverable. Currently the case is an unreachable instruction
 /// following a noreturn call; the instruction is really only there to
@@ -325,6 +343,17 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
         std::make_unique<Timer>(covCheckInterval, [&] { checkCoverage(); }));
   }
 
+  if (LiveMetricsOpt) {
+    if (LiveMetrics::open(executor.interpreterHandler->getOutputFilename(""))) {
+      lastLiveMetricsUpdate = time::getWallTime();
+      executor.timers.add(
+          std::make_unique<Timer>(time::Span{LiveMetricsInterval},
+                                  [&] { updateLiveMetrics(); }));
+    } else {
+      klee_warning("Unable to create live metrics page: %s", strerror(errno));
+    }
+  }
+
   if (OutputIStats) {
     istatsFile = executor.interpreterHandler->openOutputFile("run.istats");
     if (istatsFile) {
@@ -338,6 +367,10 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
 }
 
 StatsTracker::~StatsTracker() {
+  if (LiveMetrics::get()) {
+    updateLiveMetrics();
+    LiveMetrics::close();
+  }
   if (statsFile) {
     auto rc = sqlite3_step(transactionEndStmt);
     if (rc != SQLITE_DONE) {
@@ -363,6 +396,31 @@ void StatsTracker::done() {
   }
 }
 
+void StatsTracker::cover(ExecutionState &es, const KInstruction *ki) {
+  if (theStatisticManager->getIndexedValue(stats::coveredInstructions,
+                                           ki->getGlobalIndex()))
+    return;
+  // Checking for actual stoppoints avoids inconsistencies due
+  // to line number propogation.
+  //
+  // FIXME: This trick no longer works, we should fix this in the line
+  // number propogation.
+  es.coveredLines[ki->getSourceFilepath()].insert(ki->getLine());
+  es.instsSinceCovNew = 1;
+  ++stats::coveredInstructions;
+  stats::uncoveredInstructions += (uint64_t)-1;
+}
+
+void StatsTracker::markCovered(ExecutionState &es, const KInstruction *ki) {
+  if (!OutputIStats || !instructionIsCoverable(ki->inst()))
+    return;
+  // the statistics are counted for the instruction's index
+  unsigned index = theStatisticManager->getIndex();
+  theStatisticManager->setIndex(ki->getGlobalIndex());
+  cover(es, ki);
+  theStatisticManager->setIndex(index);
+}
+
 void StatsTracker::stepInstruction(ExecutionState &es) {
   if (OutputIStats) {
     if (TrackInstructionTime) {
@@ -388,25 +446,13 @@ void StatsTracker::stepInstruction(ExecutionState &es) {
     auto &sf = es.stack.infoStack().back();
     theStatisticManager->setIndex(ki->getGlobalIndex());
     if (UseCallPaths)
-      theStatisticManager->setContext(&sf.callPathNode->statistics);
+      theStatisticManager->setContext(sf.callPathNode->context);
 
     if (es.instsSinceCovNew)
       ++es.instsSinceCovNew;
 
-    if (instructionIsCoverable(inst)) {
-      if (!theStatisticManager->getIndexedValue(stats::coveredInstructions,
-                                                ki->getGlobalIndex())) {
-        // Checking for actual stoppoints avoids inconsistencies due
-        // to line number propogation.
-        //
-        // FIXME: This trick no longer works, we should fix this in the line
-        // number propogation.
-        es.coveredLines[ki->getSourceFilepath()].insert(ki->getLine());
-        es.instsSinceCovNew = 1;
-        ++stats::coveredInstructions;
-        stats::uncoveredInstructions += (uint64_t)-1;
-      }
-    }
+    if (instructionIsCoverable(inst))
+      cover(es, ki);
   }
 
   if (statsFile && StatsWriteAfterInstructions &&
@@ -430,7 +476,8 @@ void StatsTracker::stepInstruction(ExecutionState &es) {
 /* Should be called _after_ the es->pushFrame() */
 void StatsTracker::framePushed(ExecutionState &es,
                                InfoStackFrame *parentFrame) {
-  if (OutputIStats) {
+  // the profiler attributes samples to call paths as well
+  if (OutputIStats || Profiler::enabled()) {
     const CallStackFrame &csf = es.stack.callStack().back();
     InfoStackFrame &isf = es.stack.infoStack().back();
 
@@ -516,8 +563,11 @@ void StatsTracker::writeStatsHeader() {
          << "QueryCexCacheMisses INTEGER,"
          << "QueryCexCacheHits INTEGER,"
          << "InhibitedForks INTEGER,"
+         << "SpeculativeForks INTEGER,"
+         << "ModelQueries INTEGER,"
          << "ExternalCalls INTEGER,"
          << "Allocations INTEGER,"
+         << "ArenaCommittedPages INTEGER,"
          << "States INTEGER," BRANCH_TYPES TERMINATION_CLASSES
          << "ArrayHashTime INTEGER" << ')';
   char *zErrMsg = nullptr;
@@ -565,8 +615,11 @@ void StatsTracker::writeStatsHeader() {
          << "QueryCexCacheMisses,"
          << "QueryCexCacheHits,"
          << "InhibitedForks,"
+         << "SpeculativeForks,"
+         << "ModelQueries,"
          << "ExternalCalls,"
          << "Allocations,"
+         << "ArenaCommittedPages,"
          << "States," BRANCH_TYPES TERMINATION_CLASSES << "ArrayHashTime"
          << ')';
 #undef BTYPE
@@ -599,6 +652,9 @@ void StatsTracker::writeStatsHeader() {
          << "?,"
          << "?,"
          << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
          << "?," BRANCH_TYPES TERMINATION_CLASSES << "? " << ')';
 
   if (sqlite3_prepare_v2(statsFile, insert.str().c_str(), -1, &insertStmt,
@@ -630,7 +686,7 @@ void StatsTracker::writeStatsLine() {
   sqlite3_bind_int64(
       insertStmt, arg++,
       util::GetTotalMallocUsage() +
-          (executor.memory ? executor.memory->getUsedDeterministicSize() : 0));
+          (executor.memory ? executor.memory->getUsedArenaSize() : 0));
   sqlite3_bind_int64(insertStmt, arg++, stats::queries);
   sqlite3_bind_int64(insertStmt, arg++, stats::solverQueries);
   sqlite3_bind_int64(insertStmt, arg++, stats::queryConstructs);
@@ -647,8 +703,11 @@ void StatsTracker::writeStatsLine() {
   sqlite3_bind_int64(insertStmt, arg++, stats::queryCexCacheMisses);
   sqlite3_bind_int64(insertStmt, arg++, stats::queryCexCacheHits);
   sqlite3_bind_int64(insertStmt, arg++, stats::inhibitedForks);
+  sqlite3_bind_int64(insertStmt, arg++, stats::speculativeForks);
+  sqlite3_bind_int64(insertStmt, arg++, stats::modelQueries);
   sqlite3_bind_int64(insertStmt, arg++, stats::externalCalls);
   sqlite3_bind_int64(insertStmt, arg++, stats::allocations);
+  sqlite3_bind_int64(insertStmt, arg++, stats::arenaCommittedPages);
   sqlite3_bind_int64(insertStmt, arg++, ExecutionState::getLastID());
   BRANCH_TYPES
   TERMINATION_CLASSES
@@ -677,6 +736,30 @@ void StatsTracker::writeStatsLine() {
   }
 }
 
+void StatsTracker::updateLiveMetrics() {
+  LiveMetrics *metrics = LiveMetrics::get();
+  if (!metrics)
+    return;
+
+  const auto now = time::getWallTime();
+  const auto seconds = (now - lastLiveMetricsUpdate).toSeconds();
+  const std::uint64_t forks = stats::forks;
+  if (seconds > 0)
+    metrics->record(LiveHistogram::ForkRate,
+                    (forks - lastLiveMetricsForks) / seconds);
+  lastLiveMetricsUpdate = now;
+  lastLiveMetricsForks = forks;
+
+  metrics->record(LiveHistogram::States,
+                  executor.objectManager->getStates().size());
+  metrics->record(
+      LiveHistogram::Memory,
+      (util::GetTotalMallocUsage() +
+       (executor.memory ? executor.memory->getUsedArenaSize() : 0)) >>
+          20);
+  metrics->update();
+}
+
 void StatsTracker::updateStateStatistics(uint64_t addend) {
   for (std::set<ExecutionState *>::iterator
            it = executor.objectManager->getStates().begin(),
@@ -685,8 +768,16 @@ void StatsTracker::updateStateStatistics(uint64_t addend) {
     ExecutionState &state = **it;
     theStatisticManager->incrementIndexedValue(
         stats::states, state.pc->getGlobalIndex(), addend);
+    // Multiplying by (uint64_t)-1 subtracts the footprint again
+    MemoryFootprint footprint = state.getMemoryFootprint();
+    theStatisticManager->incrementIndexedValue(
+        stats::statesMemory, state.pc->getGlobalIndex(),
+        footprint.exclusive * addend);
+    theStatisticManager->incrementIndexedValue(
+        stats::statesSharedMemory, state.pc->getGlobalIndex(),
+        footprint.shared * addend);
     if (UseCallPaths)
-      state.stack.infoStack().back().callPathNode->statistics.incrementValue(
+      state.stack.infoStack().back().callPathNode->incrementValue(
           stats::states, addend);
   }
 }
@@ -722,6 +813,8 @@ void StatsTracker::writeIStats() {
   istatsMask.set(sm.getStatisticID("CoveredInstructions"));
   istatsMask.set(sm.getStatisticID("UncoveredInstructions"));
   istatsMask.set(sm.getStatisticID("States"));
+  istatsMask.set(sm.getStatisticID("StatesMemory"));
+  istatsMask.set(sm.getStatisticID("StatesSharedMemory"));
   istatsMask.set(sm.getStatisticID("MinDistToUncovered"));
 
   of << "positions: instr line\n";
@@ -46,6 +46,9 @@ class StatsTracker {
   std::uint32_t statsWriteCount = 0;
   time::Point startWallTime;
 
+  time::Point lastLiveMetricsUpdate;
+  std::uint64_t lastLiveMetricsForks = 0;
+
   unsigned numBranches;
   unsigned fullBranches, partialBranches, totalBranches;
   unsigned totalInstructions, localInstructionCount;
@@ -59,12 +62,16 @@ class StatsTracker {
 public:
   static bool useStatistics();
   static bool useIStats();
+  static bool useLiveMetrics();
 
 private:
   void updateStateStatistics(uint64_t addend);
   void writeStatsHeader();
   void writeStatsLine();
   void writeIStats();
+  void updateLiveMetrics();
+  // count ki as covered by es if it was not covered before
+  void cover(ExecutionState &es, const KInstruction *ki);
 
 public:
   StatsTracker(Executor &_executor, std::string _objectFilename,
@@ -92,6 +99,10 @@ public:
   // about to be stepped
   void stepInstruction(ExecutionState &es);
 
+  // mark an instruction covered by es without stepping it, e.g. one of a
+  // summarized loop
+  void markCovered(ExecutionState &es, const KInstruction *ki);
+
   /// Return duration since execution start.
   time::Span elapsed();
 
@@ -230,8 +230,10 @@ void TargetManager::update(ExecutionState *current,
 
   states.insert(addedStates.begin(), addedStates.end());
 
-  if (current && (std::find(removedStates.begin(), removedStates.end(),
-                            current) == removedStates.end())) {
+  bool currentRemoved =
+      current && std::find(removedStates.begin(), removedStates.end(),
+                           current) != removedStates.end();
+  if (current && !currentRemoved) {
     localStates.insert(current);
   }
   for (const auto state : addedStates) {
@@ -241,9 +243,15 @@ void TargetManager::update(ExecutionState *current,
     localStates.insert(state);
   }
 
+  // Within a block, the current state neither reaches a target nor gets
+  // closer to one, unless it forked.
+  bool skipCurrent = current && !currentRemoved && addedStates.empty() &&
+                     !isBlockTransition(*current);
   for (auto state : localStates) {
-    updateReached(*state);
-    updateTargets(*state);
+    if (state != current || !skipCurrent) {
+      updateReached(*state);
+      updateTargets(*state);
+    }
     if (state->areTargetsChanged()) {
       changedStates.insert(state);
     }
@@ -263,7 +271,6 @@ void TargetManager::update(ExecutionState *current,
 
   for (const auto state : removedStates) {
     states.erase(state);
-    distances.erase(state);
   }
 
   changedStates.clear();
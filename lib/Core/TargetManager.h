@@ -35,15 +35,12 @@ using TargetHistoryTargetPairToStatesMap =
 class TargetManager : public Subscriber {
 private:
   using StatesSet = states_ty;
-  using StateToDistanceMap =
-      std::unordered_map<const ExecutionState *, TargetHashMap<DistanceResult>>;
 
   Interpreter::GuidanceKind guidance;
   DistanceCalculator &distanceCalculator;
   TargetCalculator &targetCalculator;
   TargetHashSet reachedTargets;
   StatesSet states;
-  StateToDistanceMap distances;
   StatesSet localStates;
   StatesSet changedStates;
   TargetHistoryTargetPairToStatesMap addedTStates;
@@ -71,6 +68,12 @@ private:
 
   void updateTargets(ExecutionState &state);
 
+  /// Whether the last instruction of state left its block, which is the only
+  /// time its targets can be reached or its distances change.
+  static bool isBlockTransition(const ExecutionState &state) {
+    return state.isTransfered() || state.prevPC->inst()->isTerminator();
+  }
+
   void collect(ExecutionState &state);
 
   bool isReachedTarget(const ExecutionState &state, ref<Target> target,
@@ -96,10 +99,6 @@ public:
       return DistanceResult(wresult);
     }
 
-    if (!state.isTransfered() && distances[&state].count(target)) {
-      return distances[&state][target];
-    }
-
     DistanceResult result =
         distanceCalculator.getDistance(state, target->getBlock());
 
@@ -108,8 +107,6 @@ public:
       result.result = Continue;
     }
 
-    distances[&state][target] = result;
-
     return result;
   }
 
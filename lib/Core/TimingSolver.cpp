@@ -10,6 +10,7 @@
 #include "TimingSolver.h"
 
 #include "ExecutionState.h"
+#include "Profiler.h"
 
 #include "klee/Expr/Constraints.h"
 #include "klee/Solver/Solver.h"
@@ -17,14 +18,108 @@
 #include "klee/Solver/SolverUtil.h"
 #include "klee/Statistics/Statistics.h"
 #include "klee/Statistics/TimerStatIncrementer.h"
+#include "klee/Support/OptionCategories.h"
 
 #include "CoreStats.h"
 
+#include "llvm/Support/CommandLine.h"
+
+#include <algorithm>
+
 using namespace klee;
 using namespace llvm;
 
+namespace {
+cl::opt<bool> AdaptiveSolverTimeout(
+    "adaptive-solver-timeout", cl::init(false),
+    cl::desc("Give queries a timeout of a multiple of their predicted cost "
+             "when that is below --max-solver-time. Queries that time out "
+             "under it are run again with --max-solver-time "
+             "(default=false)"),
+    cl::cat(SolvingCat));
+
+cl::opt<unsigned> AdaptiveSolverTimeoutFactor(
+    "adaptive-solver-timeout-factor", cl::init(10),
+    cl::desc("The multiple of its predicted cost a query gets as timeout "
+             "with --adaptive-solver-timeout (default=10)"),
+    cl::cat(SolvingCat));
+
+cl::opt<std::string> MinAdaptiveSolverTimeout(
+    "min-adaptive-solver-timeout", cl::init("1s"),
+    cl::desc("The shortest timeout --adaptive-solver-timeout gives a query "
+             "(default=1s)"),
+    cl::cat(SolvingCat));
+} // namespace
+
 /***/
 
+TimingSolver::TimingSolver(std::unique_ptr<Solver> solver,
+                           ExprOptimizer optimizer, bool _simplifyExprs)
+    : solver(std::move(solver)), optimizer(optimizer),
+      simplifyExprs(_simplifyExprs),
+      minQueryTimeout(MinAdaptiveSolverTimeout) {
+  if (AdaptiveSolverTimeout)
+    costModel = std::make_unique<QueryCostModel>();
+}
+
+void TimingSolver::startQuery(const QueryFeatures &features,
+                              SolverQueryMetaData &metaData) {
+  metaData.lastQuery = features;
+  metaData.predictedCost = costModel->predict(features);
+
+  queryTimeout = timeout;
+  if (AdaptiveSolverTimeout && timeout && metaData.predictedCost) {
+    time::Span adapted = std::max(
+        metaData.predictedCost * AdaptiveSolverTimeoutFactor, minQueryTimeout);
+    if (adapted < timeout) {
+      queryTimeout = adapted;
+      solver->setCoreSolverLimits(adapted, memoryLimit);
+    }
+  }
+}
+
+void TimingSolver::startQuery(const ConstraintSet &constraints,
+                              ref<Expr> expr, QueryFeatures::Kind kind,
+                              SolverQueryMetaData &metaData) {
+  if (costModel)
+    startQuery(costModel->extract(constraints, expr, kind), metaData);
+}
+
+template <typename Run>
+bool TimingSolver::finishQuery(SolverQueryMetaData &metaData, Run run) {
+  if (!costModel)
+    return run();
+
+  std::uint64_t solverQueries = stats::solverQueries;
+  time::Point start = time::getWallTime();
+  bool success = run();
+  if (!success && queryTimeout < timeout) {
+    // the prediction was wrong, so the query gets the budget it would have
+    // had without one
+    ++stats::adaptiveTimeouts;
+    solver->setCoreSolverLimits(timeout, memoryLimit);
+    queryTimeout = timeout;
+    start = time::getWallTime();
+    success = run();
+  }
+  if (!(queryTimeout == timeout)) {
+    solver->setCoreSolverLimits(timeout, memoryLimit);
+    queryTimeout = timeout;
+  }
+
+  // queries answered by the caches say nothing about solving costs
+  if (stats::solverQueries == solverQueries)
+    return success;
+
+  // a query that failed under a timeout would have needed at least the
+  // whole --max-solver-time
+  time::Span cost = time::getWallTime() - start;
+  if (!success && timeout)
+    cost = std::max(cost, timeout);
+  costModel->observe(metaData.lastQuery, cost);
+  return success;
+}
+
 bool TimingSolver::evaluate(const ConstraintSet &constraints, ref<Expr> expr,
                             PartialValidity &result,
                             SolverQueryMetaData &metaData,
@@ -37,6 +132,7 @@ bool TimingSolver::evaluate(const ConstraintSet &constraints, ref<Expr> expr,
   }
 
   TimerStatIncrementer timer(stats::solverTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Solver);
 
   if (simplifyExprs)
     expr = Simplificator::simplifyExpr(constraints, expr).simplified;
@@ -45,9 +141,12 @@ bool TimingSolver::evaluate(const ConstraintSet &constraints, ref<Expr> expr,
   ref<SolverResponse> negatedQueryResult;
   Query query(constraints, expr, metaData.id);
 
-  bool success = produceValidityCore
-                     ? solver->evaluate(query, queryResult, negatedQueryResult)
-                     : solver->evaluate(query, result);
+  startQuery(constraints, expr, QueryFeatures::Validity, metaData);
+  bool success = finishQuery(metaData, [&] {
+    return produceValidityCore
+               ? solver->evaluate(query, queryResult, negatedQueryResult)
+               : solver->evaluate(query, result);
+  });
 
   if (success && produceValidityCore) {
     if (isa<ValidResponse>(queryResult) &&
@@ -89,14 +188,17 @@ bool TimingSolver::tryGetUnique(const ConstraintSet &constraints, ref<Expr> e,
 
     e = optimizer.optimizeExpr(e, true);
     TimerStatIncrementer timer(stats::solverTime);
-
-    if (!solver->getValue(Query(constraints, e, metaData.id), unique)) {
-      return false;
-    }
-
-    ref<Expr> cond = EqExpr::create(e, unique);
-    cond = optimizer.optimizeExpr(cond, false);
-    if (!solver->mustBeTrue(Query(constraints, cond, metaData.id), isTrue)) {
+    Profiler::PhaseScope phase(Profiler::Phase::Solver);
+
+    startQuery(constraints, e, QueryFeatures::Value, metaData);
+    bool success = finishQuery(metaData, [&] {
+      if (!solver->getValue(Query(constraints, e, metaData.id), unique))
+        return false;
+      ref<Expr> cond = EqExpr::create(e, unique);
+      cond = optimizer.optimizeExpr(cond, false);
+      return solver->mustBeTrue(Query(constraints, cond, metaData.id), isTrue);
+    });
+    if (!success) {
       return false;
     }
     if (isTrue) {
@@ -120,6 +222,7 @@ bool TimingSolver::mustBeTrue(const ConstraintSet &constraints, ref<Expr> expr,
   }
 
   TimerStatIncrementer timer(stats::solverTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Solver);
 
   if (simplifyExprs)
     expr = Simplificator::simplifyExpr(constraints, expr).simplified;
@@ -127,9 +230,12 @@ bool TimingSolver::mustBeTrue(const ConstraintSet &constraints, ref<Expr> expr,
   ValidityCore validityCore;
   Query query(constraints, expr, metaData.id);
 
-  bool success = produceValidityCore
-                     ? solver->getValidityCore(query, validityCore, result)
-                     : solver->mustBeTrue(query, result);
+  startQuery(constraints, expr, QueryFeatures::Validity, metaData);
+  bool success = finishQuery(metaData, [&] {
+    return produceValidityCore
+               ? solver->getValidityCore(query, validityCore, result)
+               : solver->mustBeTrue(query, result);
+  });
 
   metaData.queryCost += timer.delta();
 
@@ -173,12 +279,15 @@ bool TimingSolver::getValue(const ConstraintSet &constraints, ref<Expr> expr,
   }
 
   TimerStatIncrementer timer(stats::solverTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Solver);
 
   if (simplifyExprs)
     expr = Simplificator::simplifyExpr(constraints, expr).simplified;
 
-  bool success =
-      solver->getValue(Query(constraints, expr, metaData.id), result);
+  startQuery(constraints, expr, QueryFeatures::Value, metaData);
+  bool success = finishQuery(metaData, [&] {
+    return solver->getValue(Query(constraints, expr, metaData.id), result);
+  });
 
   metaData.queryCost += timer.delta();
 
@@ -222,12 +331,16 @@ bool TimingSolver::getMinimalUnsignedValue(const ConstraintSet &constraints,
   }
 
   TimerStatIncrementer timer(stats::solverTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Solver);
 
   if (simplifyExprs)
     expr = Simplificator::simplifyExpr(constraints, expr).simplified;
 
-  bool success = solver->getMinimalUnsignedValue(
-      Query(constraints, expr, metaData.id), result);
+  startQuery(constraints, expr, QueryFeatures::Value, metaData);
+  bool success = finishQuery(metaData, [&] {
+    return solver->getMinimalUnsignedValue(
+        Query(constraints, expr, metaData.id), result);
+  });
 
   metaData.queryCost += timer.delta();
 
@@ -243,13 +356,18 @@ bool TimingSolver::getInitialValues(
     return true;
 
   TimerStatIncrementer timer(stats::solverTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Solver);
 
   ref<SolverResponse> queryResult;
   Query query(constraints, Expr::createFalse(), metaData.id);
 
-  bool success = produceValidityCore
-                     ? solver->check(query, queryResult)
-                     : solver->getInitialValues(query, objects, result);
+  if (costModel)
+    startQuery(costModel->extract(constraints, objects), metaData);
+  bool success = finishQuery(metaData, [&] {
+    return produceValidityCore
+               ? solver->check(query, queryResult)
+               : solver->getInitialValues(query, objects, result);
+  });
 
   if (success && produceValidityCore && isa<InvalidResponse>(queryResult)) {
     success = queryResult->tryGetInitialValuesFor(objects, result);
@@ -266,6 +384,7 @@ bool TimingSolver::evaluate(const ConstraintSet &constraints, ref<Expr> expr,
                             SolverQueryMetaData &metaData) {
   ++stats::queries;
   TimerStatIncrementer timer(stats::solverTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Solver);
 
   if (simplifyExprs) {
     auto simplification = Simplificator::simplifyExpr(constraints, expr);
@@ -286,8 +405,11 @@ bool TimingSolver::evaluate(const ConstraintSet &constraints, ref<Expr> expr,
     }
   }
 
-  bool success = solver->evaluate(Query(constraints, expr, metaData.id),
-                                  queryResult, negatedQueryResult);
+  startQuery(constraints, expr, QueryFeatures::Validity, metaData);
+  bool success = finishQuery(metaData, [&] {
+    return solver->evaluate(Query(constraints, expr, metaData.id),
+                            queryResult, negatedQueryResult);
+  });
 
   metaData.queryCost += timer.delta();
 
@@ -306,6 +428,7 @@ bool TimingSolver::getValidityCore(const ConstraintSet &constraints,
   }
 
   TimerStatIncrementer timer(stats::solverTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Solver);
 
   if (simplifyExprs) {
     auto simplification = Simplificator::simplifyExpr(constraints, expr);
@@ -321,8 +444,11 @@ bool TimingSolver::getValidityCore(const ConstraintSet &constraints,
     }
   }
 
-  bool success = solver->getValidityCore(Query(constraints, expr, metaData.id),
-                                         validityCore, result);
+  startQuery(constraints, expr, QueryFeatures::Validity, metaData);
+  bool success = finishQuery(metaData, [&] {
+    return solver->getValidityCore(Query(constraints, expr, metaData.id),
+                                   validityCore, result);
+  });
 
   metaData.queryCost += timer.delta();
 
@@ -340,6 +466,7 @@ bool TimingSolver::getResponse(const ConstraintSet &constraints, ref<Expr> expr,
   }
 
   TimerStatIncrementer timer(stats::solverTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Solver);
 
   if (simplifyExprs) {
     auto simplification = Simplificator::simplifyExpr(constraints, expr);
@@ -355,8 +482,10 @@ bool TimingSolver::getResponse(const ConstraintSet &constraints, ref<Expr> expr,
     }
   }
 
-  bool success =
-      solver->check(Query(constraints, expr, metaData.id), queryResult);
+  startQuery(constraints, expr, QueryFeatures::Check, metaData);
+  bool success = finishQuery(metaData, [&] {
+    return solver->check(Query(constraints, expr, metaData.id), queryResult);
+  });
 
   metaData.queryCost += timer.delta();
 
@@ -368,6 +497,7 @@ TimingSolver::getRange(const ConstraintSet &constraints, ref<Expr> expr,
                        SolverQueryMetaData &metaData, time::Span timeout) {
   ++stats::queries;
   TimerStatIncrementer timer(stats::solverTime);
+  Profiler::PhaseScope phase(Profiler::Phase::Solver);
   Query query(constraints, expr, metaData.id);
   auto result = solver->getRange(query, timeout);
   metaData.queryCost += timer.delta();
@@ -10,6 +10,8 @@
 #ifndef KLEE_TIMINGSOLVER_H
 #define KLEE_TIMINGSOLVER_H
 
+#include "QueryCostModel.h"
+
 #include "klee/Expr/ArrayExprOptimizer.h"
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/Expr.h"
@@ -32,6 +34,27 @@ public:
   std::unique_ptr<Solver> solver;
   ExprOptimizer optimizer;
   bool simplifyExprs;
+  /// Predicts query costs if set, see QueryCostModel.
+  std::unique_ptr<QueryCostModel> costModel;
+
+private:
+  /// Limits set by setLimits(), and the timeout of the running query.
+  time::Span timeout;
+  unsigned memoryLimit = 0;
+  time::Span queryTimeout;
+  /// The shortest timeout a query gets because of its predicted cost.
+  time::Span minQueryTimeout;
+
+  /// Record the features and predicted cost of a query in metaData, and
+  /// shorten the solver timeout for it if its cost is predicted.
+  void startQuery(const QueryFeatures &features, SolverQueryMetaData &metaData);
+  void startQuery(const ConstraintSet &, ref<Expr>, QueryFeatures::Kind kind,
+                  SolverQueryMetaData &metaData);
+  /// Run the query started last and restore the timeout. A query that
+  /// fails under a shortened timeout is run once more with the full limits.
+  /// Its cost is reported to the cost model if it reached the core solver.
+  template <typename Run>
+  bool finishQuery(SolverQueryMetaData &metaData, Run run);
 
 public:
   /// TimingSolver - Construct a new timing solver.
@@ -40,11 +63,11 @@ public:
   /// simplified (via the constraint manager interface) prior to
   /// querying.
   TimingSolver(std::unique_ptr<Solver> solver, ExprOptimizer optimizer,
-               bool _simplifyExprs = true)
-      : solver(std::move(solver)), optimizer(optimizer),
-        simplifyExprs(_simplifyExprs) {}
+               bool _simplifyExprs = true);
 
   void setLimits(time::Span t, unsigned m) {
+    timeout = t;
+    memoryLimit = m;
     solver->setCoreSolverLimits(t, m);
   }
 
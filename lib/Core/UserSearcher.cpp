@@ -46,7 +46,9 @@ cl::list<Searcher::CoreSearchType> CoreSearch(
                    "use NURS with Instr-Count"),
         clEnumValN(Searcher::NURS_CPICnt, "nurs:cpicnt",
                    "use NURS with CallPath-Instr-Count"),
-        clEnumValN(Searcher::NURS_QC, "nurs:qc", "use NURS with Query-Cost")),
+        clEnumValN(Searcher::NURS_QC, "nurs:qc", "use NURS with Query-Cost"),
+        clEnumValN(Searcher::NURS_PQC, "nurs:pqc",
+                   "use NURS with Predicted-Query-Cost")),
     cl::cat(SearchCat));
 
 cl::opt<HaltExecution::Reason> UseIterativeDeepeningSearch(
@@ -87,6 +89,12 @@ cl::opt<bool> UseFairSearch(
         "(default=false)"),
     cl::init(false), cl::cat(SearchCat));
 
+cl::opt<bool> RandomPathWeighted(
+    "random-path-weighted",
+    cl::desc("Make random path search favour states closer to uncovered code "
+             "rather than flip a fair coin at each branch (default=false)"),
+    cl::init(false), cl::cat(SearchCat));
+
 } // namespace klee
 
 void klee::initializeSearchOptions() {
@@ -107,11 +115,18 @@ bool klee::userSearcherRequiresMD2U() {
           std::find(CoreSearch.begin(), CoreSearch.end(),
                     Searcher::NURS_CPICnt) != CoreSearch.end() ||
           std::find(CoreSearch.begin(), CoreSearch.end(), Searcher::NURS_QC) !=
-              CoreSearch.end());
+              CoreSearch.end() ||
+          (RandomPathWeighted &&
+           std::find(CoreSearch.begin(), CoreSearch.end(),
+                     Searcher::RandomPath) != CoreSearch.end()));
+}
+
+bool klee::userSearcherRequiresQueryCostModel() {
+  return std::find(CoreSearch.begin(), CoreSearch.end(), Searcher::NURS_PQC) !=
+         CoreSearch.end();
 }
 
-Searcher *getNewSearcher(Searcher::CoreSearchType type, RNG &rng,
-                         PForest &processForest) {
+Searcher *getNewSearcher(Searcher::CoreSearchType type, RNG &rng) {
   Searcher *searcher = nullptr;
   switch (type) {
   case Searcher::DFS:
@@ -124,7 +139,7 @@ Searcher *getNewSearcher(Searcher::CoreSearchType type, RNG &rng,
     searcher = new RandomSearcher(rng);
     break;
   case Searcher::RandomPath:
-    searcher = new RandomPathSearcher(processForest, rng);
+    searcher = new RandomPathSearcher(rng, RandomPathWeighted);
     break;
   case Searcher::NURS_CovNew:
     searcher =
@@ -152,22 +167,24 @@ Searcher *getNewSearcher(Searcher::CoreSearchType type, RNG &rng,
     searcher =
         new WeightedRandomSearcher(WeightedRandomSearcher::QueryCost, rng);
     break;
+  case Searcher::NURS_PQC:
+    searcher = new WeightedRandomSearcher(
+        WeightedRandomSearcher::PredictedQueryCost, rng);
+    break;
   }
 
   return searcher;
 }
 
 Searcher *klee::constructBaseSearcher(Executor &executor) {
-  Searcher *searcher =
-      getNewSearcher(CoreSearch[0], executor.theRNG, *executor.processForest);
+  Searcher *searcher = getNewSearcher(CoreSearch[0], executor.theRNG);
 
   if (CoreSearch.size() > 1) {
     std::vector<Searcher *> s;
     s.push_back(searcher);
 
     for (unsigned i = 1; i < CoreSearch.size(); i++)
-      s.push_back(getNewSearcher(CoreSearch[i], executor.theRNG,
-                                 *executor.processForest));
+      s.push_back(getNewSearcher(CoreSearch[i], executor.theRNG));
 
     searcher = new InterleavedSearcher(s);
   }
@@ -16,40 +16,42 @@
 namespace klee {
 
 const Array *AlphaBuilder::visitArray(const Array *arr) {
-  if (!reverse && alphaArrayMap.find(arr) == alphaArrayMap.end()) {
-    ref<SymbolicSource> source = arr->source;
-    ref<Expr> size = visit(arr->getSize());
-    if (ref<MockDeterministicSource> mockSource =
-            dyn_cast_or_null<MockDeterministicSource>(source)) {
-      std::vector<ref<Expr>> args;
-      for (const auto &it : mockSource->args) {
-        args.push_back(visit(it));
-      }
-      source = SourceBuilder::mockDeterministic(mockSource->km,
-                                                mockSource->function, args);
-      alphaArrayMap[arr] =
-          Array::create(size, source, arr->getDomain(), arr->getRange());
-      reverseAlphaArrayMap[alphaArrayMap[arr]] = arr;
-    } else if (!arr->isConstantArray()) {
-      source = SourceBuilder::alpha(index);
-      index++;
-      alphaArrayMap[arr] =
-          Array::create(size, source, arr->getDomain(), arr->getRange());
-      reverseAlphaArrayMap[alphaArrayMap[arr]] = arr;
-    } else if (size != arr->getSize()) {
-      alphaArrayMap[arr] =
-          Array::create(size, source, arr->getDomain(), arr->getRange());
-      reverseAlphaArrayMap[alphaArrayMap[arr]] = arr;
-    } else {
-      alphaArrayMap[arr] = arr;
-      reverseAlphaArrayMap[arr] = arr;
+  if (reverse) {
+    auto original = reverseAlphaArrayMap->find(arr);
+    return original != reverseAlphaArrayMap->end() ? original->second
+                                                   : nullptr;
+  }
+  auto renamed = alphaArrayMap->find(arr);
+  if (renamed != alphaArrayMap->end())
+    return renamed->second;
+
+  const Array *alpha = arr;
+  ref<SymbolicSource> source = arr->source;
+  ref<Expr> size = visit(arr->getSize());
+  if (ref<MockDeterministicSource> mockSource =
+          dyn_cast_or_null<MockDeterministicSource>(source)) {
+    std::vector<ref<Expr>> args;
+    for (const auto &it : mockSource->args) {
+      args.push_back(visit(it));
     }
+    source = SourceBuilder::mockDeterministic(mockSource->km,
+                                              mockSource->function, args);
+    alpha = Array::create(size, source, arr->getDomain(), arr->getRange());
+  } else if (!arr->isConstantArray()) {
+    source = SourceBuilder::alpha(index);
+    index++;
+    alpha = Array::create(size, source, arr->getDomain(), arr->getRange());
+  } else if (size != arr->getSize()) {
+    alpha = Array::create(size, source, arr->getDomain(), arr->getRange());
   }
-  if (reverse) {
-    return reverseAlphaArrayMap[arr];
-  } else {
-    return alphaArrayMap[arr];
+
+  if (alphaArrayMap.use_count() > 1) {
+    alphaArrayMap = std::make_shared<ArrayMap>(*alphaArrayMap);
+    reverseAlphaArrayMap = std::make_shared<ArrayMap>(*reverseAlphaArrayMap);
   }
+  (*alphaArrayMap)[arr] = alpha;
+  (*reverseAlphaArrayMap)[alpha] = arr;
+  return alpha;
 }
 
 UpdateList AlphaBuilder::visitUpdateList(UpdateList u) {
@@ -65,7 +67,7 @@ UpdateList AlphaBuilder::visitUpdateList(UpdateList u) {
   for (int i = updates.size() - 2; i >= 0; i--) {
     ref<Expr> index = visit(updates[i]->index);
     ref<Expr> value = visit(updates[i]->value);
-    updates[i] = new UpdateNode(updates[i + 1], index, value);
+    updates[i] = UpdateNode::create(updates[i + 1], index, value);
   }
   return UpdateList(root, updates[0]);
 }
@@ -77,25 +79,24 @@ ExprVisitor::Action AlphaBuilder::visitRead(const ReadExpr &re) {
   return Action::changeTo(e);
 }
 
-AlphaBuilder::AlphaBuilder() {}
+AlphaBuilder::AlphaBuilder()
+    : alphaArrayMap(std::make_shared<ArrayMap>()),
+      reverseAlphaArrayMap(std::make_shared<ArrayMap>()) {}
+
+AlphaBuilder::AlphaBuilder(const AlphaBuilder &b)
+    : ExprVisitor(), alphaArrayMap(b.alphaArrayMap),
+      reverseAlphaArrayMap(b.reverseAlphaArrayMap), index(b.index),
+      reverse(b.reverse) {}
 
 constraints_ty AlphaBuilder::visitConstraints(const constraints_ty &cs) {
   constraints_ty result;
   for (const auto &arg : cs) {
-    ref<Expr> v = visit(arg);
-    reverseExprMap[v] = arg;
-    reverseExprMap[Expr::createIsZero(v)] = Expr::createIsZero(arg);
-    result.insert(v);
+    result.insert(visit(arg));
   }
   return result;
 }
 
-ref<Expr> AlphaBuilder::build(ref<Expr> v) {
-  ref<Expr> e = visit(v);
-  reverseExprMap[e] = v;
-  reverseExprMap[Expr::createIsZero(e)] = Expr::createIsZero(v);
-  return e;
-}
+ref<Expr> AlphaBuilder::build(ref<Expr> v) { return visit(v); }
 ref<Expr> AlphaBuilder::reverseBuild(ref<Expr> v) {
   reverse = true;
   ref<Expr> e = visit(v);
@@ -182,7 +182,7 @@ public:
     for (int i = updates.size() - 2; i >= 0; i--) {
       ref<Expr> index = visit(updates[i]->index);
       ref<Expr> value = visit(updates[i]->value);
-      updates[i] = new UpdateNode(updates[i + 1], index, value);
+      updates[i] = UpdateNode::create(updates[i + 1], index, value);
     }
     return UpdateList(root, updates[0]);
   }
@@ -429,6 +429,27 @@ void PathConstraints::rewriteConcretization(const Assignment &a) {
   constraints.rewriteConcretization(a);
 }
 
+std::pair<ref<Expr>, ref<Expr>>
+PathConstraints::merge(const PathConstraints &b) {
+  constraints_ty common;
+  ref<Expr> inA = Expr::createTrue(), inB = Expr::createTrue();
+  for (const auto &constraint : constraints.cs()) {
+    if (b.constraints.cs().count(constraint))
+      common.insert(constraint);
+    else
+      inA = AndExpr::create(inA, constraint);
+  }
+  for (const auto &constraint : b.constraints.cs())
+    if (!common.count(constraint))
+      inB = AndExpr::create(inB, constraint);
+  if (inA->isTrue() || inB->isTrue())
+    return {};
+
+  constraints = ConstraintSet(common);
+  addConstraint(OrExpr::create(inA, inB));
+  return {inA, inB};
+}
+
 Simplificator::ExprResult
 Simplificator::simplifyExpr(const constraints_ty &constraints,
                             const ref<Expr> &expr) {
@@ -611,6 +632,12 @@ void ConstraintSet::getAllDependentConstraintsSets(
   _independentElements->getAllDependentConstraintSets(queryExpr, result);
 }
 
+void ConstraintSet::getAllDependentConstraintsSets(
+    const std::vector<const Array *> &arrays,
+    std::vector<ref<const IndependentConstraintSet>> &result) const {
+  _independentElements->getAllDependentConstraintSets(arrays, result);
+}
+
 std::vector<const Array *> ConstraintSet::gatherArrays() const {
   std::vector<const Array *> arrays;
   findObjects(_constraints.begin(), _constraints.end(), arrays);
@@ -263,14 +263,12 @@ void Expr::printKind(llvm::raw_ostream &os, Kind k) {
 //
 ///////
 
-unsigned Expr::computeHash() {
-  unsigned res = getKind() * Expr::MAGIC_HASH_CONSTANT;
+uint64_t Expr::computeHash() {
+  uint64_t res = hashing::mix(getKind());
 
   int n = getNumKids();
-  for (int i = 0; i < n; i++) {
-    res <<= 1;
-    res ^= getKid(i)->hash() * Expr::MAGIC_HASH_CONSTANT;
-  }
+  for (int i = 0; i < n; i++)
+    res = hashing::combine(res, getKid(i)->hash());
 
   hashValue = res;
   return hashValue;
@@ -288,33 +286,35 @@ unsigned Expr::computeHeight() {
   return heightValue;
 }
 
-unsigned ConstantExpr::computeHash() {
+uint64_t ConstantExpr::computeHash() {
   Expr::Width w = getWidth();
-  if (w <= 64)
-    hashValue = value.getLimitedValue() ^ (w * MAGIC_HASH_CONSTANT);
-  else
-    hashValue = hash_value(value) ^ (w * MAGIC_HASH_CONSTANT);
-
+  uint64_t res = hashing::mix(w);
+  if (w <= 64) {
+    hashValue = hashing::combine(res, value.getLimitedValue());
+  } else {
+    for (unsigned i = 0, e = value.getNumWords(); i != e; ++i)
+      res = hashing::combine(res, value.getRawData()[i]);
+    hashValue = res;
+  }
   return hashValue;
 }
 
-unsigned CastExpr::computeHash() {
-  unsigned res = getWidth() * Expr::MAGIC_HASH_CONSTANT;
-  hashValue = res ^ src->hash() * Expr::MAGIC_HASH_CONSTANT;
+uint64_t CastExpr::computeHash() {
+  uint64_t res = hashing::combine(getKind(), getWidth());
+  hashValue = hashing::combine(res, src->hash());
   return hashValue;
 }
 
-unsigned ExtractExpr::computeHash() {
-  unsigned res = offset * Expr::MAGIC_HASH_CONSTANT;
-  res ^= getWidth() * Expr::MAGIC_HASH_CONSTANT;
-  hashValue = res ^ expr->hash() * Expr::MAGIC_HASH_CONSTANT;
+uint64_t ExtractExpr::computeHash() {
+  uint64_t res = hashing::combine(getKind(), offset);
+  res = hashing::combine(res, getWidth());
+  hashValue = hashing::combine(res, expr->hash());
   return hashValue;
 }
 
-unsigned ReadExpr::computeHash() {
-  unsigned res = index->hash() * Expr::MAGIC_HASH_CONSTANT;
-  res ^= updates.hash();
-  hashValue = res;
+uint64_t ReadExpr::computeHash() {
+  uint64_t res = hashing::combine(getKind(), index->hash());
+  hashValue = hashing::combine(res, updates.hash());
   return hashValue;
 }
 
@@ -323,48 +323,48 @@ unsigned ReadExpr::computeHeight() {
   return heightValue;
 }
 
-unsigned NotExpr::computeHash() {
-  hashValue = expr->hash() * Expr::MAGIC_HASH_CONSTANT * Expr::Not;
+uint64_t NotExpr::computeHash() {
+  hashValue = hashing::combine(Expr::Not, expr->hash());
   return hashValue;
 }
 
-unsigned IsNaNExpr::computeHash() {
-  hashValue = expr->hash() * Expr::MAGIC_HASH_CONSTANT * Expr::IsNaN;
+uint64_t IsNaNExpr::computeHash() {
+  hashValue = hashing::combine(Expr::IsNaN, expr->hash());
   return hashValue;
 }
 
-unsigned IsInfiniteExpr::computeHash() {
-  hashValue = expr->hash() * Expr::MAGIC_HASH_CONSTANT * Expr::IsInfinite;
+uint64_t IsInfiniteExpr::computeHash() {
+  hashValue = hashing::combine(Expr::IsInfinite, expr->hash());
   return hashValue;
 }
 
-unsigned IsNormalExpr::computeHash() {
-  hashValue = expr->hash() * Expr::MAGIC_HASH_CONSTANT * Expr::IsNormal;
+uint64_t IsNormalExpr::computeHash() {
+  hashValue = hashing::combine(Expr::IsNormal, expr->hash());
   return hashValue;
 }
 
-unsigned IsSubnormalExpr::computeHash() {
-  hashValue = expr->hash() * Expr::MAGIC_HASH_CONSTANT * Expr::IsSubnormal;
+uint64_t IsSubnormalExpr::computeHash() {
+  hashValue = hashing::combine(Expr::IsSubnormal, expr->hash());
   return hashValue;
 }
 
-unsigned FSqrtExpr::computeHash() {
-  hashValue = expr->hash() * Expr::MAGIC_HASH_CONSTANT * Expr::FSqrt;
+uint64_t FSqrtExpr::computeHash() {
+  hashValue = hashing::combine(Expr::FSqrt, expr->hash());
   return hashValue;
 }
 
-unsigned FAbsExpr::computeHash() {
-  hashValue = expr->hash() * Expr::MAGIC_HASH_CONSTANT * Expr::FAbs;
+uint64_t FAbsExpr::computeHash() {
+  hashValue = hashing::combine(Expr::FAbs, expr->hash());
   return hashValue;
 }
 
-unsigned FNegExpr::computeHash() {
-  hashValue = expr->hash() * Expr::MAGIC_HASH_CONSTANT * Expr::FNeg;
+uint64_t FNegExpr::computeHash() {
+  hashValue = hashing::combine(Expr::FNeg, expr->hash());
   return hashValue;
 }
 
-unsigned FRintExpr::computeHash() {
-  hashValue = expr->hash() * Expr::MAGIC_HASH_CONSTANT * Expr::FRint;
+uint64_t FRintExpr::computeHash() {
+  hashValue = hashing::combine(Expr::FRint, expr->hash());
   return hashValue;
 }
 
@@ -568,6 +568,7 @@ std::string Expr::toString() const {
 /***/
 
 Expr::ExprCacheSet Expr::cachedExpressions;
+uint64_t Expr::cacheCollisions = 0;
 
 Expr::~Expr() {
   Expr::count--;
@@ -1505,11 +1506,8 @@ const Array *Array::create(ref<Expr> _size, const ref<SymbolicSource> source,
   return cachedArrays.CreateArray(_size, source, _domain, _range);
 }
 
-unsigned Array::computeHash() {
-  unsigned res = 0;
-  res = (res * Expr::MAGIC_HASH_CONSTANT) + size->hash();
-  res = (res * Expr::MAGIC_HASH_CONSTANT) + source->hash();
-  hashValue = res;
+uint64_t Array::computeHash() {
+  hashValue = hashing::combine(size->hash(), source->hash());
   return hashValue;
 }
 /***/
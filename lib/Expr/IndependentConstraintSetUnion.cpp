@@ -127,9 +127,25 @@ void IndependentConstraintSetUnion::getAllIndependentConstraintSets(
 
 void IndependentConstraintSetUnion::getAllDependentConstraintSets(
     ref<Expr> e, std::vector<ref<const IndependentConstraintSet>> &result) {
-  flushConstraints();
   ref<const IndependentConstraintSet> compare =
       new IndependentConstraintSet(new ExprOrSymcrete::left(e));
+  getAllDependentConstraintSets(compare, result);
+}
+
+void IndependentConstraintSetUnion::getAllDependentConstraintSets(
+    const std::vector<const Array *> &arrays,
+    std::vector<ref<const IndependentConstraintSet>> &result) {
+  ref<IndependentConstraintSet> compare = new IndependentConstraintSet();
+  for (const Array *array : arrays)
+    compare->wholeObjects.insert(array);
+  getAllDependentConstraintSets(ref<const IndependentConstraintSet>(compare),
+                                result);
+}
+
+void IndependentConstraintSetUnion::getAllDependentConstraintSets(
+    ref<const IndependentConstraintSet> compare,
+    std::vector<ref<const IndependentConstraintSet>> &result) {
+  flushConstraints();
   for (auto &r : roots) {
     ref<const IndependentConstraintSet> ics = disjointSets.at(r);
     if (IndependentConstraintSet::intersects(ics, compare)) {
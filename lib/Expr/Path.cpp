@@ -4,42 +4,305 @@
 #include "klee/Module/KModule.h"
 
 #include "llvm/ADT/StringExtras.h"
+
+#include <algorithm>
+#include <cassert>
 #include <stack>
 
 using namespace klee;
 using namespace llvm;
 
+namespace {
+/// Longest repeated block sequence folded into a run.
+constexpr std::uint32_t MaxPeriod = 32;
+/// Runs and literal blocks kept before they are frozen into a checkpoint.
+constexpr std::size_t MaxRuns = 32;
+constexpr std::size_t MaxLiteral = 256;
+} // namespace
+
+Path::Path(unsigned firstInstruction, const std::vector<KBlock *> &kblocks,
+           unsigned lastInstruction)
+    : firstInstruction(firstInstruction), lastInstruction(lastInstruction) {
+  for (auto kblock : kblocks) {
+    push(kblock);
+  }
+}
+
 void Path::advance(KInstruction *ki) {
-  if (KBlocks.empty()) {
+  if (size == 0) {
     firstInstruction = ki->getIndex();
     lastInstruction = ki->getIndex();
-    KBlocks.push_back(ki->parent);
+    push(ki->parent);
     return;
   }
-  auto lastBlock = KBlocks.back();
-  if (ki->parent != lastBlock) {
-    KBlocks.push_back(ki->parent);
+  if (ki->parent != back()) {
+    push(ki->parent);
   }
   lastInstruction = ki->getIndex();
 }
 
-unsigned Path::KBlockSize() const { return KBlocks.size(); }
+KBlock *Path::back() const {
+  assert(!runs.empty() && "requires not empty path");
+  const Run &run = runs.back();
+  return matched ? literal[run.start + matched - 1]
+                 : literal[run.start + run.length - 1];
+}
+
+void Path::push(KBlock *kblock) {
+  ++size;
+  if (runs.empty()) {
+    runs.push_back({static_cast<std::uint32_t>(literal.size()), 1, 1});
+    literal.push_back(kblock);
+  } else if (runs.back().repeat == 1) {
+    literal.push_back(kblock);
+    ++runs.back().length;
+  } else {
+    Run run = runs.back();
+    if (literal[run.start + matched] == kblock) {
+      if (++matched == run.length) {
+        ++runs.back().repeat;
+        matched = 0;
+      }
+      return;
+    }
+
+    // The repetition ended, maybe in the middle of an iteration. A short
+    // repetition is likely part of an enclosing one, which can only be found
+    // among literal blocks, so it is turned back into literal blocks.
+    std::uint32_t start = literal.size();
+    std::uint64_t copies = 0;
+    if (run.repeat * run.length <= MaxPeriod) {
+      runs.pop_back();
+      start = run.start;
+      copies = run.repeat - 1;
+    }
+    for (std::uint64_t i = 0; i < copies; ++i) {
+      for (std::uint32_t j = 0; j < run.length; ++j) {
+        KBlock *copy = literal[run.start + j];
+        literal.push_back(copy);
+      }
+    }
+    for (std::uint32_t j = 0; j < matched; ++j) {
+      KBlock *copy = literal[run.start + j];
+      literal.push_back(copy);
+    }
+    matched = 0;
+    literal.push_back(kblock);
+
+    std::uint32_t length = literal.size() - start;
+    if (!runs.empty() && runs.back().repeat == 1 &&
+        runs.back().start + runs.back().length == start) {
+      runs.back().length += length;
+    } else {
+      runs.push_back({start, length, 1});
+    }
+  }
+
+  fold();
+  if (runs.size() >= MaxRuns || literal.size() >= MaxLiteral) {
+    makeCheckpoint();
+  }
+}
+
+void Path::fold() {
+  Run &run = runs.back();
+  if (run.repeat != 1) {
+    return;
+  }
+  std::uint32_t end = run.start + run.length;
+  std::uint32_t maxPeriod = std::min(MaxPeriod, run.length / 2);
+  for (std::uint32_t period = 1; period <= maxPeriod; ++period) {
+    auto second = literal.begin() + (end - period);
+    auto first = second - period;
+    if (*(second - 1) != literal[end - 1] ||
+        !std::equal(first, second, second)) {
+      continue;
+    }
+    literal.resize(end - period);
+    run.length -= 2 * period;
+    Run repeated = {end - 2 * period, period, 2};
+    if (run.length == 0) {
+      run = repeated;
+    } else {
+      runs.push_back(repeated);
+    }
+    return;
+  }
+}
+
+void Path::makeCheckpoint() {
+  // The last run stays open so that it can still grow, with enough literal
+  // blocks to find a repetition at their end.
+  Run last = runs.back();
+  runs.pop_back();
+  if (last.repeat == 1 && last.length > 2 * MaxPeriod) {
+    std::uint32_t split = last.length - 2 * MaxPeriod;
+    runs.push_back({last.start, split, 1});
+    last.start += split;
+    last.length -= split;
+  }
+  if (runs.empty()) {
+    runs.push_back(last);
+    return;
+  }
+
+  auto frozen = std::make_shared<Checkpoint>();
+  frozen->prev = checkpoint;
+  frozen->literal.assign(literal.begin(), literal.begin() + last.start);
+  frozen->runs = runs;
+  frozen->size = size - last.length * last.repeat - matched;
+  checkpoint = frozen;
+
+  literal.erase(literal.begin(), literal.begin() + last.start);
+  last.start = 0;
+  runs.assign(1, last);
+}
+
+void Path::append(llvm::ArrayRef<KBlock *> body, std::uint64_t repeat) {
+  for (std::uint64_t i = 0; i < repeat; ++i) {
+    for (auto kblock : body) {
+      push(kblock);
+    }
+    if (i + 1 == repeat) {
+      break;
+    }
+    // Once the body is folded into the last run, the remaining repetitions
+    // only add to its count.
+    const Run &run = runs.back();
+    if (run.repeat == 1 || matched != 0 || body.size() % run.length != 0) {
+      continue;
+    }
+    bool folded = true;
+    for (std::size_t j = 0; j < body.size() && folded; ++j) {
+      folded = body[j] == literal[run.start + j % run.length];
+    }
+    if (folded) {
+      std::uint64_t remaining = repeat - i - 1;
+      runs.back().repeat += remaining * (body.size() / run.length);
+      size += remaining * body.size();
+      return;
+    }
+  }
+}
+
+void Path::forEachRun(
+    llvm::function_ref<void(llvm::ArrayRef<KBlock *>, std::uint64_t)> f)
+    const {
+  std::vector<const Checkpoint *> checkpoints;
+  for (auto cp = checkpoint.get(); cp; cp = cp->prev.get()) {
+    checkpoints.push_back(cp);
+  }
+  for (auto it = checkpoints.rbegin(); it != checkpoints.rend(); ++it) {
+    for (const Run &run : (*it)->runs) {
+      f(llvm::makeArrayRef((*it)->literal).slice(run.start, run.length),
+        run.repeat);
+    }
+  }
+  for (const Run &run : runs) {
+    f(llvm::makeArrayRef(literal).slice(run.start, run.length), run.repeat);
+  }
+  if (matched) {
+    f(llvm::makeArrayRef(literal).slice(runs.back().start, matched), 1);
+  }
+}
+
+void Path::forEachBlock(llvm::function_ref<void(KBlock *)> f) const {
+  forEachRun([f](llvm::ArrayRef<KBlock *> body, std::uint64_t repeat) {
+    for (std::uint64_t i = 0; i < repeat; ++i) {
+      for (auto kblock : body) {
+        f(kblock);
+      }
+    }
+  });
+}
+
+unsigned Path::KBlockSize() const { return size; }
 
-const Path::path_ty &Path::getBlocks() const { return KBlocks; }
+KBlock *Path::getBlock(unsigned long index) const {
+  assert(index < size && "Out of bound");
+  const std::vector<KBlock *> *blocks = &literal;
+  const std::vector<Run> *blockRuns = &runs;
+  unsigned long offset = checkpoint ? checkpoint->size : 0;
+  for (auto cp = checkpoint.get(); cp && index < offset;
+       cp = cp->prev.get()) {
+    blocks = &cp->literal;
+    blockRuns = &cp->runs;
+    offset = cp->prev ? cp->prev->size : 0;
+  }
+  index -= offset;
+  for (const Run &run : *blockRuns) {
+    unsigned long length = run.length * run.repeat;
+    if (index < length) {
+      return (*blocks)[run.start + index % run.length];
+    }
+    index -= length;
+  }
+  // in the unfinished repetition of the last run
+  return literal[runs.back().start + index];
+}
 
 unsigned Path::getFirstIndex() const { return firstInstruction; }
 
 unsigned Path::getLastIndex() const { return lastInstruction; }
 
 Path::PathIndex Path::getCurrentIndex() const {
-  return {KBlocks.size() - 1, lastInstruction};
+  return {size - 1, lastInstruction};
+}
+
+std::vector<stackframe_ty> Path::getStack(bool reversed) const {
+  std::vector<stackframe_ty> stack;
+  KBlock *prev = nullptr;
+  auto step = [&stack, &prev](KBlock *current) {
+    auto kind = prev ? getTransitionKind(prev, current)
+                     : TransitionKind::StepInto;
+    if (kind == TransitionKind::StepInto) {
+      KInstruction *callsite =
+          prev ? cast<KCallBlock>(prev)->kcallInstruction : nullptr;
+      stack.emplace_back(callsite, current->parent);
+    } else if (kind == TransitionKind::StepOut) {
+      if (!stack.empty()) {
+        stack.pop_back();
+      }
+      if (stack.empty()) {
+        stack.emplace_back(nullptr, current->parent);
+      }
+    }
+    prev = current;
+  };
+  forEachRun([&](llvm::ArrayRef<KBlock *> body, std::uint64_t repeat) {
+    std::vector<stackframe_ty> previous;
+    for (std::uint64_t i = 0; i < repeat; ++i) {
+      for (auto kblock : body) {
+        step(kblock);
+      }
+      // A repetition that leaves the stack as it found it does so every time
+      if (i != 0 && stack == previous) {
+        break;
+      }
+      previous = stack;
+    }
+  });
+  if (reversed) {
+    std::reverse(stack.begin(), stack.end());
+  }
+  return stack;
+}
+
+std::size_t Path::getMemoryUsage() const {
+  std::size_t bytes = sizeof(Path) + literal.capacity() * sizeof(KBlock *) +
+                      runs.capacity() * sizeof(Run);
+  for (auto cp = checkpoint.get(); cp; cp = cp->prev.get()) {
+    bytes += sizeof(Checkpoint) + cp->literal.capacity() * sizeof(KBlock *) +
+             cp->runs.capacity() * sizeof(Run);
+  }
+  return bytes;
 }
 
 Path Path::concat(const Path &l, const Path &r) {
   Path path = l;
-  for (auto block : r.KBlocks) {
-    path.KBlocks.push_back(block);
-  }
+  r.forEachRun([&path](llvm::ArrayRef<KBlock *> body, std::uint64_t repeat) {
+    path.append(body, repeat);
+  });
   path.lastInstruction = r.lastInstruction;
   return path;
 }
@@ -47,17 +310,9 @@ Path Path::concat(const Path &l, const Path &r) {
 std::string Path::toString() const {
   std::string blocks = "";
   unsigned depth = 0;
-  std::vector<KBlock *> KBlocksVector;
-  KBlocksVector.reserve(KBlocks.size());
-  for (auto kblock : KBlocks) {
-    KBlocksVector.push_back(kblock);
-  }
-  for (size_t i = 0; i < KBlocksVector.size(); i++) {
-    auto current = KBlocksVector[i];
-    KBlock *prev = nullptr;
-    if (i != 0) {
-      prev = KBlocksVector[i - 1];
-    }
+  unsigned long i = 0;
+  KBlock *prev = nullptr;
+  forEachBlock([&](KBlock *current) {
     auto kind =
         i == 0 ? TransitionKind::StepInto : getTransitionKind(prev, current);
     if (kind == TransitionKind::StepInto) {
@@ -74,13 +329,15 @@ std::string Path::toString() const {
       }
     }
     blocks += " " + current->getLabel();
-    if (i == KBlocks.size() - 1) {
+    if (i == size - 1) {
       blocks += ")";
       if (depth > 0) {
         depth--;
       }
     }
-  }
+    prev = current;
+    ++i;
+  });
   blocks += std::string(depth, ')');
   return "(path: " + llvm::utostr(firstInstruction) + blocks + " " +
          utostr(lastInstruction) + ")";
@@ -99,7 +356,7 @@ Path Path::parse(const std::string &str, const KModule &km) {
   auto firstInstruction = std::stoul(firstInstructionStr);
 
   std::stack<KFunction *> stack;
-  path_ty KBlocks;
+  std::vector<KBlock *> KBlocks;
   bool firstParsed = false;
   while (!stack.empty() || !firstParsed) {
     while (index < str.size() && str[index] == ' ') {
@@ -135,7 +392,7 @@ Path Path::parse(const std::string &str, const KModule &km) {
   index++;
 
   std::string lastInstructionStr;
-  while (index < str.size() && str[index] != ' ') {
+  while (index < str.size() && str[index] != ')') {
     lastInstructionStr += str[index];
     index++;
   }
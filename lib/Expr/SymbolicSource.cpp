@@ -1,4 +1,5 @@
 #include "klee/Expr/SymbolicSource.h"
+#include "klee/ADT/Hashing.h"
 #include "klee/Expr/Expr.h"
 #include "klee/Expr/ExprPPrinter.h"
 #include "klee/Expr/ExprUtil.h"
@@ -42,26 +43,25 @@ std::set<const Array *> LazyInitializationSource::getRelatedArrays() const {
   return std::set<const Array *>(objects.begin(), objects.end());
 }
 
-unsigned ConstantSource::computeHash() {
+uint64_t ConstantSource::computeHash() {
   auto defaultV = constantValues->defaultV();
   auto ordered = constantValues->calculateOrderedStorage();
 
-  unsigned res = (getKind() * SymbolicSource::MAGIC_HASH_CONSTANT) +
-                 (defaultV ? defaultV->hash() : 0);
+  uint64_t res =
+      hashing::combine(getKind(), defaultV ? defaultV->hash() : 0);
 
   for (auto kv : ordered) {
-    res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) + kv.first;
-    res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) + kv.second->hash();
+    res = hashing::combine(res, kv.first);
+    res = hashing::combine(res, kv.second->hash());
   }
 
   hashValue = res;
   return hashValue;
 }
 
-unsigned UninitializedSource::computeHash() {
-  unsigned res = getKind();
-  res = res * SymbolicSource::MAGIC_HASH_CONSTANT + version;
-  res = res * SymbolicSource::MAGIC_HASH_CONSTANT + allocSite->hash();
+uint64_t UninitializedSource::computeHash() {
+  uint64_t res = hashing::combine(getKind(), version);
+  res = hashing::combine(res, allocSite->hash());
   hashValue = res;
   return hashValue;
 }
@@ -105,27 +105,25 @@ int SymbolicSizeConstantAddressSource::internalCompare(
   return 0;
 }
 
-unsigned SymbolicSizeConstantAddressSource::computeHash() {
-  unsigned res = getKind();
-  res = res * MAGIC_HASH_CONSTANT + version;
-  res = res * MAGIC_HASH_CONSTANT + allocSite->hash();
-  res = res * MAGIC_HASH_CONSTANT + size->hash();
+uint64_t SymbolicSizeConstantAddressSource::computeHash() {
+  uint64_t res = hashing::combine(getKind(), version);
+  res = hashing::combine(res, allocSite->hash());
+  res = hashing::combine(res, size->hash());
   hashValue = res;
   return hashValue;
 }
 
-unsigned MakeSymbolicSource::computeHash() {
-  unsigned res = (getKind() * SymbolicSource::MAGIC_HASH_CONSTANT) + version;
+uint64_t MakeSymbolicSource::computeHash() {
+  uint64_t res = hashing::combine(getKind(), version);
   for (unsigned i = 0, e = name.size(); i != e; ++i) {
-    res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) + name[i];
+    res = hashing::combine(res, name[i]);
   }
   hashValue = res;
   return hashValue;
 }
 
-unsigned LazyInitializationSource::computeHash() {
-  unsigned res =
-      (getKind() * SymbolicSource::MAGIC_HASH_CONSTANT) + pointer->hash();
+uint64_t LazyInitializationSource::computeHash() {
+  uint64_t res = hashing::combine(getKind(), pointer->hash());
   hashValue = res;
   return hashValue;
 }
@@ -174,34 +172,31 @@ int InstructionSource::internalCompare(const SymbolicSource &b) const {
   return 0;
 }
 
-unsigned ArgumentSource::computeHash() {
-  unsigned res = (getKind() * SymbolicSource::MAGIC_HASH_CONSTANT) + index;
+uint64_t ArgumentSource::computeHash() {
+  uint64_t res = hashing::combine(getKind(), index);
   auto parent = allocSite.getParent();
-  res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) + km->getFunctionId(parent);
-  res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) + allocSite.getArgNo();
+  res = hashing::combine(res, km->getFunctionId(parent));
+  res = hashing::combine(res, allocSite.getArgNo());
   hashValue = res;
   return hashValue;
 }
 
-unsigned InstructionSource::computeHash() {
-  unsigned res = (getKind() * SymbolicSource::MAGIC_HASH_CONSTANT) + index;
+uint64_t InstructionSource::computeHash() {
+  uint64_t res = hashing::combine(getKind(), index);
   auto function = allocSite.getParent()->getParent();
   auto kf = km->functionMap.at(function);
   auto block = allocSite.getParent();
-  res =
-      (res * SymbolicSource::MAGIC_HASH_CONSTANT) + km->getFunctionId(function);
-  res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) +
-        kf->blockMap[block]->getId();
-  res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) +
-        kf->instructionMap[&allocSite]->getIndex();
+  res = hashing::combine(res, km->getFunctionId(function));
+  res = hashing::combine(res, kf->blockMap[block]->getId());
+  res = hashing::combine(res, kf->instructionMap[&allocSite]->getIndex());
   hashValue = res;
   return hashValue;
 }
 
-unsigned MockNaiveSource::computeHash() {
-  unsigned res = (getKind() * SymbolicSource::MAGIC_HASH_CONSTANT) + version;
+uint64_t MockNaiveSource::computeHash() {
+  uint64_t res = hashing::combine(getKind(), version);
   unsigned funcID = km->getFunctionId(&function);
-  res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) + funcID;
+  res = hashing::combine(res, funcID);
   hashValue = res;
   return res;
 }
@@ -227,12 +222,10 @@ MockDeterministicSource::MockDeterministicSource(
     const std::vector<ref<Expr>> &_args)
     : MockSource(km, function), args(_args) {}
 
-unsigned MockDeterministicSource::computeHash() {
-  unsigned res = getKind();
-  res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) +
-        km->getFunctionId(&function);
+uint64_t MockDeterministicSource::computeHash() {
+  uint64_t res = hashing::combine(getKind(), km->getFunctionId(&function));
   for (const auto &arg : args) {
-    res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) + arg->hash();
+    res = hashing::combine(res, arg->hash());
   }
   hashValue = res;
   return res;
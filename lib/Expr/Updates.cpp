@@ -29,6 +29,34 @@ UpdateNode::UpdateNode(const ref<UpdateNode> &_next, const ref<Expr> &_index,
   size = next ? next->size + 1 : 1;
 }
 
+UpdateNode::UpdateNodeCacheSet UpdateNode::cachedNodes;
+uint64_t UpdateNode::cacheHits = 0;
+uint64_t UpdateNode::cacheMisses = 0;
+
+UpdateNode::~UpdateNode() {
+  if (isCached) {
+    cachedNodes.cache.erase(this);
+    isCached = false;
+  }
+}
+
+ref<UpdateNode> UpdateNode::create(const ref<UpdateNode> &next,
+                                   const ref<Expr> &index,
+                                   const ref<Expr> &value) {
+  ref<UpdateNode> un(new UpdateNode(next, index, value));
+  std::pair<CacheType::const_iterator, bool> success =
+      cachedNodes.cache.insert(un.get());
+  if (success.second) {
+    // Cache miss
+    ++cacheMisses;
+    un->isCached = true;
+    return un;
+  }
+  // Cache hit
+  ++cacheHits;
+  return *success.first;
+}
+
 extern "C" void vc_DeleteExpr(void *);
 
 int UpdateNode::compare(const UpdateNode &b) const {
@@ -39,10 +67,12 @@ int UpdateNode::compare(const UpdateNode &b) const {
 
 bool UpdateNode::equals(const UpdateNode &b) const { return compare(b) == 0; }
 
-unsigned UpdateNode::computeHash() {
-  hashValue = index->hash() ^ value->hash();
-  if (next)
-    hashValue ^= next->hash();
+uint64_t UpdateNode::computeHash() {
+  // Extend the hash of the rest of the sequence, so that it depends on the
+  // order of the updates.
+  hashValue = next ? next->hash() : 0;
+  hashValue = hashing::combine(hashValue, index->hash());
+  hashValue = hashing::combine(hashValue, value->hash());
   return hashValue;
 }
 
@@ -66,7 +96,7 @@ void UpdateList::extend(const ref<Expr> &index, const ref<Expr> &value) {
     assert(root->getRange() == value->getWidth());
   }
 
-  head = new UpdateNode(head, index, value);
+  head = UpdateNode::create(head, index, value);
 }
 
 int UpdateList::compare(const UpdateList &b) const {
@@ -83,8 +113,14 @@ int UpdateList::compare(const UpdateList &b) const {
   else if (getSize() > b.getSize())
     return 1;
 
-  // XXX build comparison into update, make fast
+  // Update nodes are hash-consed, so sequences are equal exactly when their
+  // heads are. Distinct sequences are ordered by their hashes and only need
+  // to be walked when the hashes collide.
   const auto *an = head.get(), *bn = b.head.get();
+  if (an == bn)
+    return 0;
+  if (int hc = (an->hash() > bn->hash()) - (an->hash() < bn->hash()))
+    return hc;
   for (; an && bn; an = an->next.get(), bn = bn->next.get()) {
     if (an == bn) { // exploit shared list structure
       return 0;
@@ -97,11 +133,10 @@ int UpdateList::compare(const UpdateList &b) const {
   return 0;
 }
 
-unsigned UpdateList::hash() const {
-  unsigned res = 0;
-  res = (res * Expr::MAGIC_HASH_CONSTANT) + root->source->hash();
+uint64_t UpdateList::hash() const {
+  uint64_t res = root->source->hash();
   if (head)
-    res = (res * Expr::MAGIC_HASH_CONSTANT) + head->hash();
+    res = hashing::combine(res, head->hash());
   return res;
 }
 
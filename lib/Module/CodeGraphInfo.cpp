@@ -12,7 +12,10 @@
 
 #include "klee/Module/KModule.h"
 
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/PostDominators.h"
 #include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
 
 #include <deque>
 #include <unordered_map>
@@ -147,6 +150,25 @@ void CodeGraphInfo::calculateFunctionBlocks(KFunction *kf) {
   }
 }
 
+void CodeGraphInfo::calculatePostDominators(KFunction *kf) {
+  auto &ipdoms = functionPostDominators[kf];
+  llvm::PostDominatorTree pdt(*kf->function());
+  for (auto &kb : kf->blocks) {
+    auto node = pdt.getNode(kb->basicBlock());
+    if (!node || !node->getIDom() || !node->getIDom()->getBlock())
+      continue;
+    ipdoms.emplace(kb.get(), kf->blockMap.at(node->getIDom()->getBlock()));
+  }
+}
+
+void CodeGraphInfo::calculateLoopDepths(KFunction *kf) {
+  auto &depths = functionLoopDepths[kf];
+  llvm::DominatorTree dt(*kf->function());
+  llvm::LoopInfo li(dt);
+  for (auto &kb : kf->blocks)
+    depths.emplace(kb.get(), li.getLoopDepth(kb->basicBlock()));
+}
+
 const BlockDistanceMap &CodeGraphInfo::getDistance(KBlock *b) {
   if (blockDistance.count(b) == 0)
     calculateDistance(b);
@@ -223,3 +245,17 @@ CodeGraphInfo::getFunctionBlocks(KFunction *kf) {
     calculateFunctionBlocks(kf);
   return functionBlocks.at(kf);
 }
+
+KBlock *CodeGraphInfo::getImmediatePostDominator(KBlock *kb) {
+  if (functionPostDominators.count(kb->parent) == 0)
+    calculatePostDominators(kb->parent);
+  auto &ipdoms = functionPostDominators.at(kb->parent);
+  auto it = ipdoms.find(kb);
+  return it == ipdoms.end() ? nullptr : it->second;
+}
+
+unsigned CodeGraphInfo::getLoopDepth(KBlock *kb) {
+  if (functionLoopDepths.count(kb->parent) == 0)
+    calculateLoopDepths(kb->parent);
+  return functionLoopDepths.at(kb->parent).at(kb);
+}
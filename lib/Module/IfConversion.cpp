@@ -0,0 +1,261 @@
+//===-- IfConversion.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Passes.h"
+
+#include "klee/Support/CompilerWarning.h"
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_DEPRECATED_DECLARATIONS
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+DISABLE_WARNING_POP
+
+#include <algorithm>
+
+using namespace llvm;
+
+namespace klee {
+
+char IfConversionPass::ID;
+
+namespace {
+/// The block on one side of a branch, if the side has one.
+struct Arm {
+  BasicBlock *block = nullptr;
+  StoreInst *store = nullptr;
+  /// Number of instructions that are executed speculatively.
+  unsigned size = 0;
+};
+
+bool onLine(const DebugLoc &line, const DebugLoc &loc) {
+  if (!loc) {
+    return true;
+  }
+  return line && line.getLine() == loc.getLine() &&
+         line->getFilename() == loc->getFilename();
+}
+
+/// Whether block is the only block between head and join on a side of a
+/// branch, and can be executed speculatively. Fills arm if it is.
+bool analyzeArm(BasicBlock *block, BasicBlock *head, BasicBlock *join,
+                const DebugLoc &line, bool keepDebugLocations, Arm &arm) {
+  if (block == head || block == join ||
+      block->getSinglePredecessor() != head || block->hasAddressTaken()) {
+    return false;
+  }
+  auto br = dyn_cast<BranchInst>(block->getTerminator());
+  if (!br || br->isConditional() || br->getSuccessor(0) != join) {
+    return false;
+  }
+
+  Arm result;
+  result.block = block;
+  for (auto &inst : *block) {
+    if (isa<DbgInfoIntrinsic>(inst)) {
+      continue;
+    }
+    if (keepDebugLocations && !onLine(line, inst.getDebugLoc())) {
+      return false;
+    }
+    if (&inst == br) {
+      break;
+    }
+    // the store has to be the last instruction of the arm
+    if (result.store || isa<PHINode>(inst)) {
+      return false;
+    }
+    if (auto store = dyn_cast<StoreInst>(&inst)) {
+      auto pointer = dyn_cast<Instruction>(store->getPointerOperand());
+      if (!store->isSimple() || (pointer && pointer->getParent() == block)) {
+        return false;
+      }
+      result.store = store;
+      continue;
+    }
+    if (!isSafeToSpeculativelyExecute(&inst)) {
+      return false;
+    }
+    ++result.size;
+  }
+  arm = result;
+  return true;
+}
+
+/// The value stored by the head of br to the address of store, if that store
+/// comes shortly before br with nothing else written in between. Like
+/// LLVM's isSafeToSpeculateStore, a store of one arm is only made
+/// unconditional then: the address is known to be writable, and the other
+/// path writes this value back.
+Value *getPriorStoredValue(StoreInst *store, BranchInst *br) {
+  unsigned budget = 9;
+  BasicBlock *head = br->getParent();
+  for (auto it = ++br->getReverseIterator(); it != head->rend() && budget;
+       ++it) {
+    if (isa<DbgInfoIntrinsic>(*it)) {
+      continue;
+    }
+    --budget;
+    if (auto prior = dyn_cast<StoreInst>(&*it)) {
+      if (prior->isSimple() &&
+          prior->getPointerOperand() == store->getPointerOperand() &&
+          prior->getValueOperand()->getType() ==
+              store->getValueOperand()->getType()) {
+        return prior->getValueOperand();
+      }
+      return nullptr;
+    }
+    if (it->mayWriteToMemory()) {
+      return nullptr;
+    }
+  }
+  return nullptr;
+}
+
+/// Move the instructions of the arm except for its store before br.
+void hoist(const Arm &arm, BranchInst *br) {
+  if (!arm.block) {
+    return;
+  }
+  for (auto it = arm.block->begin(); &*it != arm.block->getTerminator();) {
+    Instruction &inst = *it++;
+    if (&inst != arm.store) {
+      inst.moveBefore(br);
+    }
+  }
+}
+} // namespace
+
+bool IfConversionPass::convert(BasicBlock &head) {
+  auto br = dyn_cast<BranchInst>(head.getTerminator());
+  if (!br || br->isUnconditional() || isa<Constant>(br->getCondition())) {
+    return false;
+  }
+  BasicBlock *trueBlock = br->getSuccessor(0);
+  BasicBlock *falseBlock = br->getSuccessor(1);
+  if (trueBlock == falseBlock) {
+    return false;
+  }
+
+  DebugLoc line = br->getDebugLoc();
+  Arm trueArm, falseArm;
+  BasicBlock *join = nullptr;
+  if (analyzeArm(trueBlock, &head, falseBlock, line, keepDebugLocations,
+                 trueArm)) {
+    join = falseBlock;
+  } else if (analyzeArm(falseBlock, &head, trueBlock, line,
+                        keepDebugLocations, falseArm)) {
+    join = trueBlock;
+  } else {
+    join = trueBlock->getSingleSuccessor();
+    if (!join || join == &head || falseBlock->getSingleSuccessor() != join ||
+        !analyzeArm(trueBlock, &head, join, line, keepDebugLocations,
+                    trueArm) ||
+        !analyzeArm(falseBlock, &head, join, line, keepDebugLocations,
+                    falseArm)) {
+      return false;
+    }
+  }
+  if (trueArm.size + falseArm.size > threshold) {
+    return false;
+  }
+
+  // Stores in both arms have to be to the same address, and a store in one
+  // arm only needs the value stored before the branch on the other path.
+  StoreInst *store = trueArm.store ? trueArm.store : falseArm.store;
+  Value *pointer = store ? store->getPointerOperand() : nullptr;
+  Type *storedType = store ? store->getValueOperand()->getType() : nullptr;
+  if (trueArm.store && falseArm.store &&
+      (falseArm.store->getPointerOperand() != pointer ||
+       falseArm.store->getValueOperand()->getType() != storedType)) {
+    return false;
+  }
+  Align alignment = store ? store->getAlign() : Align();
+  if (trueArm.store && falseArm.store) {
+    alignment = std::min(alignment, falseArm.store->getAlign());
+  }
+  Value *oldValue = nullptr;
+  if (store && (!trueArm.store || !falseArm.store)) {
+    oldValue = getPriorStoredValue(store, br);
+    if (!oldValue) {
+      return false;
+    }
+  }
+
+  hoist(trueArm, br);
+  hoist(falseArm, br);
+
+  Value *condition = br->getCondition();
+  BasicBlock *truePred = trueArm.block ? trueArm.block : &head;
+  BasicBlock *falsePred = falseArm.block ? falseArm.block : &head;
+  for (PHINode &phi : join->phis()) {
+    Value *trueValue = phi.getIncomingValueForBlock(truePred);
+    Value *falseValue = phi.getIncomingValueForBlock(falsePred);
+    Value *value = trueValue;
+    if (trueValue != falseValue) {
+      auto select = SelectInst::Create(condition, trueValue, falseValue,
+                                       phi.getName(), br);
+      select->setDebugLoc(line);
+      value = select;
+    }
+    // the incoming values of the arms go with their blocks
+    if (trueArm.block && falseArm.block) {
+      phi.addIncoming(value, &head);
+    } else {
+      phi.setIncomingValueForBlock(&head, value);
+    }
+  }
+
+  if (store) {
+    Value *trueValue =
+        trueArm.store ? trueArm.store->getValueOperand() : oldValue;
+    Value *falseValue =
+        falseArm.store ? falseArm.store->getValueOperand() : oldValue;
+    auto select =
+        SelectInst::Create(condition, trueValue, falseValue, "", br);
+    select->setDebugLoc(line);
+    auto merged = new StoreInst(select, pointer, false, alignment, br);
+    merged->setDebugLoc(store->getDebugLoc());
+  }
+
+  auto jump = BranchInst::Create(join, br);
+  jump->setDebugLoc(line);
+  br->eraseFromParent();
+  for (BasicBlock *arm : {trueArm.block, falseArm.block}) {
+    if (arm) {
+      DeleteDeadBlock(arm);
+    }
+  }
+  MergeBlockIntoPredecessor(join);
+
+  ++convertedBranches;
+  speculatedInstructions += trueArm.size + falseArm.size;
+  return true;
+}
+
+bool IfConversionPass::runOnFunction(Function &f) {
+  bool changed = false;
+  // Converting an inner branch can make its enclosing branch convertible.
+  bool converted;
+  do {
+    converted = false;
+    for (auto &head : f) {
+      while (convert(head)) {
+        converted = true;
+      }
+    }
+    changed |= converted;
+  } while (converted);
+  return changed;
+}
+} // namespace klee
@@ -40,6 +40,9 @@ extern cl::opt<bool> StripUnwantedCalls;
 extern cl::opt<bool> SplitCalls;
 extern cl::opt<bool> SplitReturns;
 extern cl::opt<SwitchImplType> SwitchType;
+extern cl::opt<bool> IfConversion;
+extern cl::opt<unsigned> IfConversionThreshold;
+extern cl::opt<bool> IfConversionKeepDebugLocations;
 } // namespace klee
 
 void klee::instrument(bool CheckDivZero, bool CheckOvershift,
@@ -145,6 +148,12 @@ void klee::optimiseAndPrepare(bool OptimiseKLEECall, bool Optimize,
   llvm::DataLayout targetData(module);
   pm3.add(new IntrinsicCleanerPass(targetData, WithFPRuntime));
   pm3.add(createScalarizerPass());
+  IfConversionPass *ifConversion = nullptr;
+  if (IfConversion) {
+    ifConversion = new IfConversionPass(IfConversionThreshold,
+                                        IfConversionKeepDebugLocations);
+    pm3.add(ifConversion);
+  }
   pm3.add(new PhiCleanerPass());
   pm3.add(new FunctionAliasPass());
   if (StripUnwantedCalls)
@@ -158,4 +167,11 @@ void klee::optimiseAndPrepare(bool OptimiseKLEECall, bool Optimize,
 
   pm3.add(new FreezeLower());
   pm3.run(*module);
+
+  if (ifConversion && ifConversion->getConvertedBranches()) {
+    klee_message("If-conversion turned %u branches into selects, executing "
+                 "%u instructions speculatively",
+                 ifConversion->getConvertedBranches(),
+                 ifConversion->getSpeculatedInstructions());
+  }
 }
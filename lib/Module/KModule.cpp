@@ -109,6 +109,25 @@ cl::opt<SwitchImplType> SwitchType(
                clEnumValN(SwitchImplType::eSwitchTypeInternal, "internal",
                           "execute switch internally")),
     cl::init(SwitchImplType::eSwitchTypeInternal), cl::cat(ModuleCat));
+
+cl::opt<bool> IfConversion(
+    "if-conversion",
+    cl::desc("Turn branches over small side-effect free blocks into selects, "
+             "which avoids forking on them (default=false)"),
+    cl::init(false), cl::cat(ModuleCat));
+
+cl::opt<unsigned> IfConversionThreshold(
+    "if-conversion-threshold",
+    cl::desc("Maximum number of instructions executed speculatively by a "
+             "converted branch (default=8)"),
+    cl::init(8), cl::cat(ModuleCat));
+
+cl::opt<bool> IfConversionKeepDebugLocations(
+    "if-conversion-keep-debug-locations",
+    cl::desc("Do not convert branches over instructions on other source "
+             "lines than the branch, which keeps line coverage exact "
+             "(default=true)"),
+    cl::init(true), cl::cat(ModuleCat));
 } // namespace klee
 
 /***/
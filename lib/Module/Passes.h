@@ -90,6 +90,39 @@ public:
   bool runOnFunction(llvm::Function &f) override;
 };
 
+/// IfConversionPass - Turn branches over small side-effect free diamonds and
+/// triangles into selects. A branch on a symbolic condition forks the state
+/// and costs a query, while a select only builds an expression, and a select
+/// on a concrete condition costs no more than the branch it replaces.
+///
+/// The arms of a converted branch may only contain instructions that can be
+/// executed speculatively, at most threshold of them, followed by a single
+/// store. Stores to the same address in both arms become one store of a
+/// select. A store in one arm only is converted if the head block stored to
+/// the same address shortly before, and the other path stores that prior
+/// value again. With keepDebugLocations, arms with instructions on other
+/// source lines than the branch are not converted, so that line coverage does
+/// not change.
+class IfConversionPass : public llvm::FunctionPass {
+  static char ID;
+  unsigned threshold;
+  bool keepDebugLocations;
+  unsigned convertedBranches = 0;
+  unsigned speculatedInstructions = 0;
+
+  bool convert(llvm::BasicBlock &head);
+
+public:
+  IfConversionPass(unsigned threshold, bool keepDebugLocations)
+      : llvm::FunctionPass(ID), threshold(threshold),
+        keepDebugLocations(keepDebugLocations) {}
+
+  bool runOnFunction(llvm::Function &f) override;
+
+  unsigned getConvertedBranches() const { return convertedBranches; }
+  unsigned getSpeculatedInstructions() const { return speculatedInstructions; }
+};
+
 class DivCheckPass : public llvm::ModulePass {
   static char ID;
 
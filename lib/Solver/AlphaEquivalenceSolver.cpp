@@ -18,13 +18,102 @@
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/ExprHashMap.h"
 #include "klee/Solver/SolverImpl.h"
+#include "klee/Solver/SolverStats.h"
+#include "klee/Support/OptionCategories.h"
+#include "klee/Support/Timer.h"
+
+#include "llvm/Support/CommandLine.h"
+
+#include <iterator>
+#include <list>
+#include <memory>
+#include <unordered_map>
 
 using namespace klee;
 using namespace llvm;
 
+namespace {
+cl::opt<unsigned> AlphaEquivalenceCacheSize(
+    "alpha-equivalence-cache-size",
+    cl::desc("Number of alpha-renamed constraints kept across queries. "
+             "Constraint sets that start with the same constraints share "
+             "their renaming. 0 renames all constraints of every query "
+             "(default=4096)"),
+    cl::init(4096), cl::cat(SolvingCat));
+
+/// The alpha-renamed form of a constraint, renamed after the constraints on
+/// the path to it. The renaming of a constraint set is the path of its
+/// constraints in the order of constraints_ty.
+struct RenamedConstraint {
+  std::shared_ptr<const RenamedConstraint> parent;
+  ref<Expr> constraint;
+  ref<Expr> alphaConstraint;
+  /// The renaming after this constraint
+  AlphaBuilder builder;
+  time::Span buildTime;
+};
+
+/// CanonicalCache - LRU cache of renamed constraints, keyed by the
+/// constraint and the renamed constraint before it. Queries of a state
+/// mostly share their constraints, so a query only renames the constraints
+/// after the longest prefix that an earlier query renamed.
+class CanonicalCache {
+  typedef std::shared_ptr<const RenamedConstraint> Node;
+  typedef std::pair<const RenamedConstraint *, ref<Expr>> Key;
+
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const {
+      return klee::hashing::combine(reinterpret_cast<uintptr_t>(key.first),
+                                    key.second->hash());
+    }
+  };
+
+  /// most recently used first
+  std::list<Node> entries;
+  std::unordered_map<Key, std::list<Node>::iterator, KeyHash> index;
+
+public:
+  Node lookup(const RenamedConstraint *parent, const ref<Expr> &constraint) {
+    auto it = index.find({parent, constraint});
+    return it != index.end() ? *it->second : nullptr;
+  }
+
+  void insert(const Node &node) {
+    if (AlphaEquivalenceCacheSize == 0)
+      return;
+    entries.push_front(node);
+    index.emplace(Key(node->parent.get(), node->constraint), entries.begin());
+
+    while (entries.size() > AlphaEquivalenceCacheSize) {
+      const Node &last = entries.back();
+      auto it = index.find({last->parent.get(), last->constraint});
+      if (it != index.end() && it->second == std::prev(entries.end()))
+        index.erase(it);
+      entries.pop_back();
+    }
+  }
+
+  /// Mark the nodes of a path as used, the first ones most recently so that
+  /// prefixes outlive their extensions.
+  void touch(const std::vector<Node> &path) {
+    for (auto node = path.rbegin(); node != path.rend(); ++node) {
+      auto it = index.find({(*node)->parent.get(), (*node)->constraint});
+      if (it != index.end())
+        entries.splice(entries.begin(), entries, it->second);
+    }
+  }
+};
+} // namespace
+
 class AlphaEquivalenceSolver : public SolverImpl {
 private:
   std::unique_ptr<Solver> solver;
+  CanonicalCache canonicalCache;
+
+  /// Return a builder that has renamed the constraints, and their renamed
+  /// form in alphaConstraints.
+  AlphaBuilder canonicalize(const constraints_ty &constraints,
+                            constraints_ty &alphaConstraints);
 
 public:
   AlphaEquivalenceSolver(std::unique_ptr<Solver> solver)
@@ -117,7 +206,7 @@ AlphaEquivalenceSolver::changeVersion(ref<SolverResponse> res,
 
   if (isa<InvalidResponse>(res)) {
     Assignment a = cast<InvalidResponse>(res)->initialValues();
-    a = changeVersion(a, builder.reverseAlphaArrayMap);
+    a = changeVersion(a, builder.getReverseAlphaArrayMap());
     reverseRes = new InvalidResponse(a.bindings);
   } else {
     ValidityCore validityCore;
@@ -128,10 +217,43 @@ AlphaEquivalenceSolver::changeVersion(ref<SolverResponse> res,
   return reverseRes;
 }
 
+AlphaBuilder
+AlphaEquivalenceSolver::canonicalize(const constraints_ty &constraints,
+                                     constraints_ty &alphaConstraints) {
+  std::vector<std::shared_ptr<const RenamedConstraint>> path;
+  path.reserve(constraints.size());
+  auto it = constraints.begin();
+  for (; it != constraints.end(); ++it) {
+    auto node =
+        canonicalCache.lookup(path.empty() ? nullptr : path.back().get(), *it);
+    if (!node)
+      break;
+    ++stats::alphaCacheHits;
+    stats::alphaCacheTimeSaved += node->buildTime.toMicroseconds();
+    path.push_back(std::move(node));
+  }
+
+  AlphaBuilder builder =
+      path.empty() ? AlphaBuilder() : AlphaBuilder(path.back()->builder);
+  for (; it != constraints.end(); ++it) {
+    WallTimer timer;
+    ref<Expr> alphaConstraint = builder.build(*it);
+    path.push_back(std::make_shared<RenamedConstraint>(RenamedConstraint{
+        path.empty() ? nullptr : path.back(), *it, alphaConstraint,
+        AlphaBuilder(builder), timer.delta()}));
+    canonicalCache.insert(path.back());
+  }
+  canonicalCache.touch(path);
+
+  for (const auto &node : path)
+    alphaConstraints.insert(node->alphaConstraint);
+  return builder;
+}
+
 bool AlphaEquivalenceSolver::computeValidity(const Query &query,
                                              PartialValidity &result) {
-  AlphaBuilder builder;
-  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  constraints_ty alphaQuery;
+  AlphaBuilder builder = canonicalize(query.constraints.cs(), alphaQuery);
   ref<Expr> alphaQueryExpr = builder.build(query.expr);
   return solver->impl->computeValidity(
       Query(ConstraintSet(alphaQuery, {}, {}), alphaQueryExpr, query.id),
@@ -139,8 +261,8 @@ bool AlphaEquivalenceSolver::computeValidity(const Query &query,
 }
 
 bool AlphaEquivalenceSolver::computeTruth(const Query &query, bool &isValid) {
-  AlphaBuilder builder;
-  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  constraints_ty alphaQuery;
+  AlphaBuilder builder = canonicalize(query.constraints.cs(), alphaQuery);
   ref<Expr> alphaQueryExpr = builder.build(query.expr);
   return solver->impl->computeTruth(
       Query(ConstraintSet(alphaQuery, {}, {}), alphaQueryExpr, query.id),
@@ -149,8 +271,8 @@ bool AlphaEquivalenceSolver::computeTruth(const Query &query, bool &isValid) {
 
 bool AlphaEquivalenceSolver::computeValue(const Query &query,
                                           ref<Expr> &result) {
-  AlphaBuilder builder;
-  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  constraints_ty alphaQuery;
+  AlphaBuilder builder = canonicalize(query.constraints.cs(), alphaQuery);
   ref<Expr> alphaQueryExpr = builder.build(query.expr);
   return solver->impl->computeValue(
       Query(ConstraintSet(alphaQuery, {}, {}), alphaQueryExpr, query.id),
@@ -160,8 +282,8 @@ bool AlphaEquivalenceSolver::computeValue(const Query &query,
 bool AlphaEquivalenceSolver::computeInitialValues(
     const Query &query, const std::vector<const Array *> &objects,
     std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution) {
-  AlphaBuilder builder;
-  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  constraints_ty alphaQuery;
+  AlphaBuilder builder = canonicalize(query.constraints.cs(), alphaQuery);
   ref<Expr> alphaQueryExpr = builder.build(query.expr);
   const std::vector<const Array *> newObjects = changeVersion(objects, builder);
 
@@ -175,9 +297,8 @@ bool AlphaEquivalenceSolver::computeInitialValues(
 
 bool AlphaEquivalenceSolver::check(const Query &query,
                                    ref<SolverResponse> &result) {
-  AlphaBuilder builder;
-
-  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  constraints_ty alphaQuery;
+  AlphaBuilder builder = canonicalize(query.constraints.cs(), alphaQuery);
   ref<Expr> alphaQueryExpr = builder.build(query.expr);
   if (!solver->impl->check(
           Query(ConstraintSet(alphaQuery, {}, {}), alphaQueryExpr, query.id),
@@ -192,9 +313,8 @@ bool AlphaEquivalenceSolver::check(const Query &query,
 bool AlphaEquivalenceSolver::computeValidityCore(const Query &query,
                                                  ValidityCore &validityCore,
                                                  bool &isValid) {
-  AlphaBuilder builder;
-
-  constraints_ty alphaQuery = builder.visitConstraints(query.constraints.cs());
+  constraints_ty alphaQuery;
+  AlphaBuilder builder = canonicalize(query.constraints.cs(), alphaQuery);
   ref<Expr> alphaQueryExpr = builder.build(query.expr);
   if (!solver->impl->computeValidityCore(
           Query(ConstraintSet(alphaQuery, {}, {}), alphaQueryExpr, query.id),
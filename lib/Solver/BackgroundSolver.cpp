@@ -0,0 +1,103 @@
+//===-- BackgroundSolver.cpp ----------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Solver/BackgroundSolver.h"
+
+#include "SolverWorkerPool.h"
+
+#include "klee/Solver/Solver.h"
+#include "klee/Statistics/Statistics.h"
+#include "klee/Support/Timer.h"
+
+#include <utility>
+
+using namespace klee;
+
+BackgroundSolver::BackgroundSolver(std::unique_ptr<Solver> solver)
+    : solver(std::move(solver)),
+      expressionLock(std::make_unique<ExpressionLock>()),
+      thread(&BackgroundSolver::work, this) {}
+
+BackgroundSolver::~BackgroundSolver() {
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    stopping = true;
+  }
+  wakeup.notify_all();
+  // the query in flight needs the expression lock to finish
+  expressionLock.reset();
+  thread.join();
+  tasks.clear();
+  results.clear();
+}
+
+void BackgroundSolver::work() {
+  // the current statistics index is the interpreter's instruction
+  StatisticManager::setThreadIndexed(false);
+
+  std::unique_lock<std::mutex> guard(mutex);
+  while (true) {
+    wakeup.wait(guard, [this] { return stopping || !tasks.empty(); });
+    if (stopping)
+      return;
+
+    std::unique_ptr<Task> task = std::move(tasks.front());
+    tasks.pop_front();
+    ++running;
+    guard.unlock();
+
+    auto result = std::make_unique<Result>();
+    {
+      ExpressionLock lock;
+      WallTimer timer;
+      result->id = task->id;
+      result->success = solver->check(task->query, result->response);
+      result->solveTime = timer.delta();
+      // the query holds expressions, so it has to go while the lock is held
+      task.reset();
+    }
+
+    guard.lock();
+    --running;
+    results.push_back(std::move(result));
+    answered.notify_all();
+  }
+}
+
+std::uint64_t BackgroundSolver::submit(const Query &query) {
+  std::uint64_t id;
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    id = nextId++;
+    tasks.push_back(std::make_unique<Task>(Task{id, query}));
+  }
+  wakeup.notify_one();
+  return id;
+}
+
+std::size_t BackgroundSolver::pending() {
+  std::lock_guard<std::mutex> guard(mutex);
+  return tasks.size() + running + results.size();
+}
+
+void BackgroundSolver::collect(std::vector<Result> &out, bool wait) {
+  std::unique_lock<std::mutex> guard(mutex);
+  if (wait && results.empty() && (!tasks.empty() || running)) {
+    guard.unlock();
+    // the background thread needs the expression lock to answer
+    UnlockedNativeCall unlocked;
+    guard.lock();
+    answered.wait(guard, [this] { return !results.empty(); });
+  }
+  for (auto &result : results)
+    out.push_back(std::move(*result));
+  results.clear();
+}
+
+void BackgroundSolver::yield() { expressionLock->yield(); }
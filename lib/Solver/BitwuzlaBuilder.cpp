@@ -17,6 +17,7 @@
 
 #include "klee/Expr/Expr.h"
 #include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverCmdLine.h"
 #include "klee/Solver/SolverStats.h"
 #include "klee/Support/ErrorHandling.h"
 
@@ -35,7 +36,8 @@ void BitwuzlaArrayExprHash::clear() {
 void BitwuzlaArrayExprHash::clearUpdates() { _update_node_hash.clear(); }
 
 BitwuzlaBuilder::BitwuzlaBuilder(bool autoClearConstructCache)
-    : autoClearConstructCache(autoClearConstructCache), ctx(new TermManager()) {
+    : constructed(SolverTranslationCacheSize),
+      autoClearConstructCache(autoClearConstructCache), ctx(new TermManager()) {
 }
 
 BitwuzlaBuilder::~BitwuzlaBuilder() {
@@ -448,17 +450,23 @@ Term BitwuzlaBuilder::construct(ref<Expr> e, int *width_out) {
   if (!BitwuzlaHashConfig::UseConstructHashBitwuzla || isa<ConstantExpr>(e)) {
     return constructActual(e, width_out);
   } else {
-    ExprHashMap<std::pair<Term, unsigned>>::iterator it = constructed.find(e);
-    if (it != constructed.end()) {
+    if (auto entry = constructed.find(e)) {
       if (width_out)
-        *width_out = it->second.second;
-      return it->second.first;
+        *width_out = entry->width;
+      sideConstraints.insert(sideConstraints.end(),
+                             entry->sideConstraints.begin(),
+                             entry->sideConstraints.end());
+      return entry->term;
     } else {
       int width;
       if (!width_out)
         width_out = &width;
+      std::size_t firstSideConstraint = sideConstraints.size();
       Term res = constructActual(e, width_out);
-      constructed.insert(std::make_pair(e, std::make_pair(res, *width_out)));
+      constructed.insert(
+          e, {res, static_cast<unsigned>(*width_out),
+              std::vector<Term>(sideConstraints.begin() + firstSideConstraint,
+                                sideConstraints.end())});
       return res;
     }
   }
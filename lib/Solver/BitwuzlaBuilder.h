@@ -10,6 +10,8 @@
 #ifndef BITWUZLABUILDER_H_
 #define BITWUZLABUILDER_H_
 
+#include "TranslationCache.h"
+
 #include "klee/Expr/ArrayExprHash.h"
 #include "klee/Expr/ExprHashMap.h"
 
@@ -108,7 +110,7 @@ protected:
   Term getRoundingModeSort(llvm::APFloat::roundingMode rm);
   Term getx87FP80ExplicitSignificandIntegerBit(const Term &e);
 
-  ExprHashMap<std::pair<Term, unsigned>> constructed;
+  TranslationCache<Term> constructed;
   BitwuzlaArrayExprHash _arr_hash;
   bool autoClearConstructCache;
 
@@ -137,6 +139,13 @@ public:
   }
   void clearConstructCache() { constructed.clear(); }
   void clearSideConstraints() { sideConstraints.clear(); }
+
+  /// Drop the side constraints of the finished query and the translations
+  /// that do not fit into the translation cache.
+  void finishQuery() {
+    constructed.finishQuery();
+    clearSideConstraints();
+  }
 };
 } // namespace klee
 
@@ -11,6 +11,7 @@
 
 #include "klee/Config/config.h"
 #include "klee/Solver/SolverStats.h"
+#include "klee/Statistics/LiveMetrics.h"
 #include "klee/Statistics/TimerStatIncrementer.h"
 
 #ifdef ENABLE_BITWUZLA
@@ -160,7 +161,7 @@ enum class ObjectAssignment {
 
 struct BitwuzlaSolverEnv {
   using arr_vec = std::vector<const Array *>;
-  std::unique_ptr<BitwuzlaBuilder> builder;
+  std::shared_ptr<BitwuzlaBuilder> builder;
   inc_vector<const Array *> objects;
   arr_vec objectsForGetModel;
   ExprIncMap bitwuzla_ast_expr_to_klee_expr;
@@ -170,6 +171,9 @@ struct BitwuzlaSolverEnv {
 
   explicit BitwuzlaSolverEnv();
   explicit BitwuzlaSolverEnv(const arr_vec &objects);
+  /// Use an existing builder, whose translations outlive this environment.
+  BitwuzlaSolverEnv(std::shared_ptr<BitwuzlaBuilder> builder,
+                    const arr_vec &objects = arr_vec());
 
   void pop(size_t popSize);
   void push();
@@ -179,11 +183,14 @@ struct BitwuzlaSolverEnv {
 };
 
 BitwuzlaSolverEnv::BitwuzlaSolverEnv(const arr_vec &objects)
-    : objectsForGetModel(objects) {
+    : BitwuzlaSolverEnv(std::make_shared<BitwuzlaBuilder>(
+                            /*autoClearConstructCache=*/false),
+                        objects) {}
 
-  builder = std::unique_ptr<BitwuzlaBuilder>(new BitwuzlaBuilder(
-      /*autoClearConstructCache=*/false));
-  assert(builder && "unable to create BitwuzlaBuilder");
+BitwuzlaSolverEnv::BitwuzlaSolverEnv(std::shared_ptr<BitwuzlaBuilder> builder,
+                                     const arr_vec &objects)
+    : builder(std::move(builder)), objectsForGetModel(objects) {
+  assert(this->builder && "unable to create BitwuzlaBuilder");
 }
 
 BitwuzlaSolverEnv::BitwuzlaSolverEnv() : BitwuzlaSolverEnv(arr_vec()) {}
@@ -214,7 +221,7 @@ void BitwuzlaSolverEnv::clear() {
   expr_to_track.clear();
   usedArrayBytes.clear();
   symbolicObjects.clear();
-  builder.reset(new BitwuzlaBuilder(false));
+  builder = std::make_shared<BitwuzlaBuilder>(false);
 }
 
 const BitwuzlaSolverEnv::arr_vec *
@@ -472,11 +479,14 @@ bool BitwuzlaSolverImpl::internalRunSolver(
     std::vector<SparseStorageImpl<unsigned char>> *values,
     ValidityCore *validityCore, bool &hasSolution) {
   TimerStatIncrementer t(stats::queryTime);
+  LiveHistogramTimer latency(LiveHistogram::QueryTime);
   runStatusCode = SolverImpl::SOLVER_RUN_STATUS_FAILURE;
 
   std::unordered_set<const Array *> all_constant_arrays_in_query;
   BitwuzlaASTIncSet exprs;
 
+  std::optional<TimerStatIncrementer> translationTimer;
+  translationTimer.emplace(stats::queryTranslationTime);
   for (size_t i = 0; i < query.constraints.framesSize();
        i++, env.push(), exprs.push()) {
     ConstantArrayFinder constant_arrays_in_query;
@@ -527,6 +537,7 @@ bool BitwuzlaSolverImpl::internalRunSolver(
                  env.builder->sideConstraints.end());
   }
   exprs.pop(1); // drop last empty frame
+  translationTimer.reset();
 
   ++stats::solverQueries;
   if (!env.objects.v.empty())
@@ -554,7 +565,11 @@ bool BitwuzlaSolverImpl::internalRunSolver(
     }
   }
 
-  Result satisfiable = theSolver.check_sat();
+  Result satisfiable = Result::UNKNOWN;
+  {
+    TimerStatIncrementer checkTimer(stats::queryCheckTime);
+    satisfiable = theSolver.check_sat();
+  }
   theSolver.configure_terminator(nullptr);
   runStatusCode = handleSolverResponse(theSolver, satisfiable, env, needObjects,
                                        values, hasSolution);
@@ -594,13 +609,13 @@ bool BitwuzlaSolverImpl::internalRunSolver(
 
   deinitNativeBitwuzla(theSolver);
 
-  // Clear the builder's cache to prevent memory usage exploding.
-  // By using ``autoClearConstructCache=false`` and clearning now
+  // Bound the builder's cache to prevent memory usage exploding.
+  // By using ``autoClearConstructCache=false`` and only trimming now
   // we allow Term expressions to be shared from an entire
-  // ``Query`` rather than only sharing within a single call to
+  // ``Query``, and across queries as far as the translation cache
+  // allows, rather than only sharing within a single call to
   // ``builder->construct()``.
-  env.builder->clearConstructCache();
-  env.builder->clearSideConstraints();
+  env.builder->finishQuery();
   if (runStatusCode == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_SOLVABLE ||
       runStatusCode == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE) {
     if (hasSolution) {
@@ -682,6 +697,10 @@ SolverImpl::SolverRunStatus BitwuzlaSolverImpl::getOperationStatusCode() {
 class BitwuzlaNonIncSolverImpl final : public BitwuzlaSolverImpl {
 private:
   std::optional<Bitwuzla> theSolver;
+  /// Shared by all queries so that the term manager and the translations of
+  /// recurring expressions survive from one query to the next.
+  std::shared_ptr<BitwuzlaBuilder> builder =
+      std::make_shared<BitwuzlaBuilder>(/*autoClearConstructCache=*/false);
 
 public:
   BitwuzlaNonIncSolverImpl() = default;
@@ -700,12 +719,12 @@ public:
 
   /// implementation of the SolverImpl interface
   bool computeTruth(const Query &query, bool &isValid) override {
-    BitwuzlaSolverEnv env;
+    BitwuzlaSolverEnv env(builder);
     return BitwuzlaSolverImpl::computeTruth(ConstraintQuery(query, false), env,
                                             isValid);
   }
   bool computeValue(const Query &query, ref<Expr> &result) override {
-    BitwuzlaSolverEnv env;
+    BitwuzlaSolverEnv env(builder);
     return BitwuzlaSolverImpl::computeValue(ConstraintQuery(query, false), env,
                                             result);
   }
@@ -714,18 +733,18 @@ public:
                        const std::vector<const Array *> &objects,
                        std::vector<SparseStorageImpl<unsigned char>> &values,
                        bool &hasSolution) override {
-    BitwuzlaSolverEnv env(objects);
+    BitwuzlaSolverEnv env(builder, objects);
     return BitwuzlaSolverImpl::computeInitialValues(
         ConstraintQuery(query, false), env, values, hasSolution);
   }
   bool check(const Query &query, ref<SolverResponse> &result) override {
-    BitwuzlaSolverEnv env;
+    BitwuzlaSolverEnv env(builder);
     return BitwuzlaSolverImpl::check(ConstraintQuery(query, false), env,
                                      result);
   }
   bool computeValidityCore(const Query &query, ValidityCore &validityCore,
                            bool &isValid) override {
-    BitwuzlaSolverEnv env;
+    BitwuzlaSolverEnv env(builder);
     return BitwuzlaSolverImpl::computeValidityCore(
         ConstraintQuery(query, false), env, validityCore, isValid);
   }
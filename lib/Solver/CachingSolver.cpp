@@ -36,29 +36,34 @@ private:
 
   struct CacheEntry {
     CacheEntry(const ConstraintSet &c, ref<Expr> q)
-        : constraints(c.cs()), query(q) {}
+        : constraints(c.cs()), query(q) {
+      // the sum keeps the hash independent of the order of the constraints
+      uint64_t sum = 0;
+      for (auto const &constraint : constraints)
+        sum += hashing::mix(constraint->hash());
+      hashValue = hashing::combine(query->hash(), sum);
+    }
 
     CacheEntry(const CacheEntry &ce)
-        : constraints(ce.constraints), query(ce.query) {}
+        : constraints(ce.constraints), query(ce.query),
+          hashValue(ce.hashValue) {}
 
     constraints_ty constraints;
     ref<Expr> query;
+    uint64_t hashValue;
 
     bool operator==(const CacheEntry &b) const {
-      return constraints == b.constraints && *query.get() == *b.query.get();
+      if (hashValue != b.hashValue)
+        return false;
+      if (constraints == b.constraints && *query.get() == *b.query.get())
+        return true;
+      ++stats::solverCacheCollisions;
+      return false;
     }
   };
 
   struct CacheEntryHash {
-    unsigned operator()(const CacheEntry &ce) const {
-      unsigned result = ce.query->hash();
-
-      for (auto const &constraint : ce.constraints) {
-        result ^= constraint->hash();
-      }
-
-      return result;
-    }
+    std::size_t operator()(const CacheEntry &ce) const { return ce.hashValue; }
   };
 
   typedef std::unordered_map<CacheEntry, PartialValidity, CacheEntryHash>
@@ -9,20 +9,25 @@
 
 #include "klee/Solver/Solver.h"
 
-#include "klee/ADT/MapOfSets.h"
+#include "klee/ADT/SetIndex.h"
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
 #include "klee/Expr/ExprUtil.h"
 #include "klee/Solver/SolverImpl.h"
 #include "klee/Solver/SolverStats.h"
+#include "klee/Statistics/LiveMetrics.h"
 #include "klee/Statistics/TimerStatIncrementer.h"
 #include "klee/Support/ErrorHandling.h"
 #include "klee/Support/OptionCategories.h"
 
 #include "llvm/Support/CommandLine.h"
 
+#include <chrono>
+#include <map>
 #include <memory>
 #include <utility>
+#include <vector>
 
 using namespace klee;
 using namespace llvm;
@@ -50,6 +55,13 @@ cl::opt<bool> CexCacheValidityCores(
     "cex-cache-validity-cores", cl::init(false),
     cl::desc("Cache assignment and it's validity cores (default=false)"),
     cl::cat(SolvingCat));
+
+cl::opt<unsigned> CexCacheSize(
+    "cex-cache-size",
+    cl::desc("Memory budget of the counterexample cache in MiB. The least "
+             "frequently hit entries are evicted once it is exceeded. 0 "
+             "means no budget (default=1024)"),
+    cl::init(1024), cl::cat(SolvingCat));
 } // namespace
 
 ///
@@ -64,15 +76,19 @@ struct ResponseComparator {
 };
 
 class CexCachingSolver : public SolverImpl {
-  typedef std::set<ref<SolverResponse>, ResponseComparator> responseTable_ty;
+  /// Distinct counterexamples, with the number of cache entries that hold
+  /// each of them
+  typedef std::map<ref<SolverResponse>, unsigned, ResponseComparator>
+      responseTable_ty;
 
   std::unique_ptr<Solver> solver;
 
-  MapOfSets<ref<Expr>, ref<SolverResponse>> cache;
+  SetIndex<ref<Expr>, ref<SolverResponse>, util::ExprHash> cache;
   // memo table
   responseTable_ty responseTable;
 
   bool searchForResponse(KeyType &key, ref<SolverResponse> &result);
+  void cacheResponse(const KeyType &key, ref<SolverResponse> result);
 
   bool lookupResponse(const Query &query, KeyType &key,
                       ref<SolverResponse> &result);
@@ -87,7 +103,8 @@ class CexCachingSolver : public SolverImpl {
 
 public:
   CexCachingSolver(std::unique_ptr<Solver> solver)
-      : solver(std::move(solver)) {}
+      : solver(std::move(solver)),
+        cache(static_cast<std::size_t>(CexCacheSize) << 20) {}
   ~CexCachingSolver();
 
   bool computeTruth(const Query &, bool &isValid);
@@ -166,7 +183,7 @@ bool CexCachingSolver::searchForResponse(KeyType &key,
     for (responseTable_ty::iterator it = responseTable.begin(),
                                     ie = responseTable.end();
          it != ie; ++it) {
-      ref<SolverResponse> a = *it;
+      ref<SolverResponse> a = it->first;
       if (isa<InvalidResponse>(a) &&
           cast<InvalidResponse>(a)->satisfiesOrConstant(key)) {
         result = a;
@@ -230,7 +247,17 @@ bool CexCachingSolver::lookupResponse(const Query &query, KeyType &key,
     }
   }
 
-  bool found = searchForResponse(key, result);
+  bool found;
+  if (LiveMetrics *metrics = LiveMetrics::get()) {
+    auto start = std::chrono::steady_clock::now();
+    found = searchForResponse(key, result);
+    metrics->record(LiveHistogram::CexCacheLookup,
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count());
+  } else {
+    found = searchForResponse(key, result);
+  }
   if (found)
     ++stats::queryCexCacheHits;
   else
@@ -258,11 +285,10 @@ void CexCachingSolver::setResponse(const Query &query,
   KeyType key = makeKey(query);
 
   if (isa<InvalidResponse>(result)) {
-    // Memorize the result.
-    std::pair<responseTable_ty::iterator, bool> res =
-        responseTable.insert(result);
-    if (!res.second) {
-      result = *res.first;
+    // Share the response with the cache entries of an equal one.
+    responseTable_ty::iterator res = responseTable.find(result);
+    if (res != responseTable.end()) {
+      result = res->first;
     }
 
     if (DebugCexCacheCheckBinding) {
@@ -281,10 +307,37 @@ void CexCachingSolver::setResponse(const Query &query,
                                   resultCore.constraints.end());
     ref<Expr> neg = Expr::createIsZero(resultCore.expr);
     resultCoreConstarints.insert(neg);
-    cache.insert(resultCoreConstarints, result);
+    cacheResponse(resultCoreConstarints, result);
   }
   if (isa<ValidResponse>(result) || isa<InvalidResponse>(result)) {
-    cache.insert(key, result);
+    cacheResponse(key, result);
+  }
+}
+
+void CexCachingSolver::cacheResponse(const KeyType &key,
+                                     ref<SolverResponse> result) {
+  // count the bindings that the cache keeps alive
+  std::size_t responseSize = 0;
+  Assignment::bindings_ty bindings;
+  if (result->tryGetInitialValues(bindings))
+    for (auto const &binding : bindings)
+      responseSize += sizeof(binding) + binding.second.sizeOfSetRange();
+
+  std::uint64_t evictions = cache.getEvictions();
+  std::vector<ref<SolverResponse>> removed;
+  cache.insert(key, result, responseSize, &removed);
+  stats::cexCacheEvictions += cache.getEvictions() - evictions;
+
+  // Forget the counterexamples that no entry holds any more, so that the
+  // budget also bounds the table
+  if (isa<InvalidResponse>(result))
+    ++responseTable[result];
+  for (const ref<SolverResponse> &response : removed) {
+    if (!isa<InvalidResponse>(response))
+      continue;
+    responseTable_ty::iterator it = responseTable.find(response);
+    if (it != responseTable.end() && --it->second == 0)
+      responseTable.erase(it);
   }
 }
 
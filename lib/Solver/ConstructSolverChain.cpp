@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace klee {
 
@@ -31,6 +32,22 @@ void constructCachingSolver(std::unique_ptr<Solver> &solver) {
     solver = createCachingSolver(std::move(solver));
 }
 
+static std::unique_ptr<Solver>
+constructParallelIndependentSolver(std::unique_ptr<Solver> solver) {
+  std::vector<std::unique_ptr<Solver>> workers;
+  for (unsigned i = 0; i < IndependentSolverThreads; ++i) {
+    std::unique_ptr<Solver> worker = createCoreSolver(CoreSolverToUse);
+    if (!worker)
+      klee_error("Failed to create core solver for independent solver worker");
+    constructCachingSolver(worker);
+    workers.push_back(std::move(worker));
+  }
+  if (!workers.empty())
+    klee_message("Solving independent factors on %u threads\n",
+                 IndependentSolverThreads.getValue());
+  return createIndependentSolver(std::move(solver), std::move(workers));
+}
+
 std::unique_ptr<Solver> constructSolverChain(
     std::unique_ptr<Solver> coreSolver, std::string querySMT2LogPath,
     std::string baseSolverQuerySMT2LogPath, std::string queryKQueryLogPath,
@@ -70,7 +87,7 @@ std::unique_ptr<Solver> constructSolverChain(
   }
 
   if (UseIndependentSolver)
-    solver = createIndependentSolver(std::move(solver));
+    solver = constructParallelIndependentSolver(std::move(solver));
 
   if (UseConcretizingSolver) {
     solver = createConcretizingSolver(std::move(solver));
@@ -107,4 +124,25 @@ std::unique_ptr<Solver> constructSolverChain(
 
   return solver;
 }
+
+std::unique_ptr<Solver>
+constructBackgroundSolverChain(std::unique_ptr<Solver> coreSolver) {
+  std::unique_ptr<Solver> solver = std::move(coreSolver);
+
+  if (UseFastCexSolver)
+    solver = createFastCexSolver(std::move(solver));
+
+  constructCachingSolver(solver);
+
+  if (UseAlphaEquivalence) {
+    solver = createAlphaEquivalenceSolver(std::move(solver));
+
+    constructCachingSolver(solver);
+  }
+
+  if (UseIndependentSolver)
+    solver = createIndependentSolver(std::move(solver));
+
+  return solver;
+}
 } // namespace klee
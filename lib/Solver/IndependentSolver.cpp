@@ -7,6 +7,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "SolverWorkerPool.h"
+
 #include "klee/Expr/SymbolicSource.h"
 #include "klee/Solver/SolverUtil.h"
 
@@ -20,21 +22,184 @@
 #include "klee/Expr/IndependentConstraintSetUnion.h"
 #include "klee/Expr/IndependentSet.h"
 #include "klee/Solver/SolverImpl.h"
+#include "klee/Solver/SolverStats.h"
+#include "klee/Support/OptionCategories.h"
+#include "klee/System/Time.h"
+
+#include "llvm/Support/CommandLine.h"
 
+#include <algorithm>
+#include <atomic>
+#include <list>
 #include <memory>
+#include <optional>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 using namespace klee;
 using namespace llvm;
 
+namespace {
+cl::opt<bool> UseFactorCache(
+    "use-factor-cache", cl::init(false),
+    cl::desc("Cache the solution or unsatisfiability of each independent "
+             "factor and reuse it for queries sharing the factor "
+             "(default=false)"),
+    cl::cat(SolvingCat));
+
+cl::opt<unsigned> FactorCacheSize(
+    "factor-cache-size", cl::init(64),
+    cl::desc("Maximum size of the factor cache in MiB (default=64)"),
+    cl::cat(SolvingCat));
+
+/// FactorCache - Solver responses for independent constraint sets, shared by
+/// all queries, i.e. by all states. An entry is either a satisfying
+/// assignment for the arrays of the factor, or a ValidResponse if the factor
+/// has no solution. The least recently used entries are evicted once the
+/// estimated memory usage exceeds the capacity.
+class FactorCache {
+  typedef std::vector<ref<Expr>> Key;
+
+  struct Entry {
+    Key key;
+    uint64_t hash;
+    ref<SolverResponse> response;
+    std::size_t size;
+  };
+
+  /// most recently used first
+  std::list<Entry> entries;
+  std::unordered_multimap<uint64_t, std::list<Entry>::iterator> index;
+  std::size_t size = 0;
+  const std::size_t capacity;
+
+  static bool makeKey(const IndependentConstraintSet &factor, Key &key,
+                      uint64_t &hash);
+
+public:
+  explicit FactorCache(std::size_t capacity) : capacity(capacity) {}
+
+  /// Find the response for a factor whose arrays are `arrays`. A cached
+  /// assignment that does not bind all of them is not used.
+  bool lookup(const IndependentConstraintSet &factor,
+              const std::vector<const Array *> &arrays,
+              ref<SolverResponse> &response);
+  void insert(const IndependentConstraintSet &factor,
+              ref<SolverResponse> response);
+};
+} // namespace
+
+bool FactorCache::makeKey(const IndependentConstraintSet &factor, Key &key,
+                          uint64_t &hash) {
+  // symcretes are concretized above the independent solver, so the same
+  // constraints may stand for different queries
+  if (!factor.symcretes.empty() || factor.exprs.empty())
+    return false;
+
+  key.reserve(factor.exprs.size());
+  hash = factor.exprs.size();
+  for (ref<Expr> e : factor.exprs) {
+    key.push_back(e);
+    hash = klee::hashing::combine(hash, e->hash());
+  }
+  return true;
+}
+
+bool FactorCache::lookup(const IndependentConstraintSet &factor,
+                         const std::vector<const Array *> &arrays,
+                         ref<SolverResponse> &response) {
+  Key key;
+  uint64_t hash;
+  if (!makeKey(factor, key, hash))
+    return false;
+
+  auto range = index.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->key == key) {
+      auto invalid = dyn_cast<InvalidResponse>(it->second->response);
+      if (invalid && !invalid->bindsAll(arrays))
+        break;
+      entries.splice(entries.begin(), entries, it->second);
+      response = it->second->response;
+      ++stats::factorCacheHits;
+      return true;
+    }
+    ++stats::solverCacheCollisions;
+  }
+  ++stats::factorCacheMisses;
+  return false;
+}
+
+void FactorCache::insert(const IndependentConstraintSet &factor,
+                         ref<SolverResponse> response) {
+  Key key;
+  uint64_t hash;
+  if (!makeKey(factor, key, hash))
+    return;
+
+  // replace an entry that lookup() could not use
+  auto range = index.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->key == key) {
+      size -= it->second->size;
+      entries.erase(it->second);
+      index.erase(it);
+      break;
+    }
+  }
+
+  std::size_t entrySize = sizeof(Entry) + key.size() * sizeof(ref<Expr>);
+  Assignment::bindings_ty bindings;
+  if (response->tryGetInitialValues(bindings))
+    for (auto const &binding : bindings)
+      entrySize += sizeof(binding) + binding.second.sizeOfSetRange();
+  if (entrySize > capacity)
+    return;
+
+  entries.push_front({std::move(key), hash, response, entrySize});
+  index.emplace(hash, entries.begin());
+  size += entrySize;
+
+  while (size > capacity) {
+    Entry &victim = entries.back();
+    auto victims = index.equal_range(victim.hash);
+    for (auto it = victims.first; it != victims.second; ++it) {
+      if (it->second == std::prev(entries.end())) {
+        index.erase(it);
+        break;
+      }
+    }
+    size -= victim.size;
+    entries.pop_back();
+  }
+}
+
 class IndependentSolver : public SolverImpl {
 private:
   std::unique_ptr<Solver> solver;
+  std::unique_ptr<SolverWorkerPool> workers;
+  std::unique_ptr<FactorCache> factorCache;
+  /// Status of the worker that made the last parallel query fail
+  std::optional<SolverRunStatus> workerStatus;
+
+  bool shouldSolveInParallel(
+      const std::vector<ref<const IndependentConstraintSet>> &factors) const;
+  bool solveInParallel(
+      const Query &query,
+      const std::vector<ref<const IndependentConstraintSet>> &factors,
+      Assignment &retMap, ref<SolverResponse> &validResponse);
 
 public:
-  IndependentSolver(std::unique_ptr<Solver> solver)
-      : solver(std::move(solver)) {}
+  IndependentSolver(std::unique_ptr<Solver> solver,
+                    std::vector<std::unique_ptr<Solver>> workerSolvers)
+      : solver(std::move(solver)) {
+    if (UseFactorCache)
+      factorCache = std::make_unique<FactorCache>(
+          static_cast<std::size_t>(FactorCacheSize) << 20);
+    if (!workerSolvers.empty())
+      workers = std::make_unique<SolverWorkerPool>(std::move(workerSolvers));
+  }
 
   bool computeTruth(const Query &, bool &isValid);
   bool computeValidity(const Query &, PartialValidity &result);
@@ -53,6 +218,7 @@ public:
 
 bool IndependentSolver::computeValidity(const Query &query,
                                         PartialValidity &result) {
+  workerStatus.reset();
   std::vector<ref<const IndependentConstraintSet>> factors;
   query.getAllDependentConstraintsSets(factors);
   ConstraintSet tmp(factors,
@@ -61,6 +227,7 @@ bool IndependentSolver::computeValidity(const Query &query,
 }
 
 bool IndependentSolver::computeTruth(const Query &query, bool &isValid) {
+  workerStatus.reset();
   std::vector<ref<const IndependentConstraintSet>> factors;
   query.getAllDependentConstraintsSets(factors);
   ConstraintSet tmp(factors,
@@ -69,6 +236,7 @@ bool IndependentSolver::computeTruth(const Query &query, bool &isValid) {
 }
 
 bool IndependentSolver::computeValue(const Query &query, ref<Expr> &result) {
+  workerStatus.reset();
   std::vector<ref<const IndependentConstraintSet>> factors;
   query.getAllDependentConstraintsSets(factors);
   ConstraintSet tmp(factors,
@@ -133,9 +301,119 @@ bool assertCreatedPointEvaluatesToTrue(const Query &query,
   return assertCreatedPointEvaluatesToTrue(query, objects, values, retMap);
 }
 
+bool IndependentSolver::shouldSolveInParallel(
+    const std::vector<ref<const IndependentConstraintSet>> &factors) const {
+  if (!workers)
+    return false;
+  unsigned solvable = 0;
+  for (auto const &factor : factors)
+    if (factor->exprs.size() != 0 && ++solvable > 1)
+      return true;
+  return false;
+}
+
+// Solve the given independent factors on the worker pool and add their
+// models to ``retMap``. If a factor has no solution, ``validResponse`` is
+// set to its response. Returns false if a worker solver failed.
+bool IndependentSolver::solveInParallel(
+    const Query &query,
+    const std::vector<ref<const IndependentConstraintSet>> &factors,
+    Assignment &retMap, ref<SolverResponse> &validResponse) {
+  struct Factor {
+    ref<const IndependentConstraintSet> set;
+    std::vector<const Array *> arrays;
+    ref<SolverResponse> response;
+    std::optional<SolverRunStatus> failure;
+    bool solved = false;
+    time::Span time;
+  };
+
+  std::vector<Factor> solvable;
+  for (ref<const IndependentConstraintSet> it : factors) {
+    Factor factor;
+    factor.set = it;
+    it->calculateArrayReferences(factor.arrays);
+    if (factor.arrays.size() == 0)
+      continue;
+    if (it->exprs.size() == 0)
+      factor.response = new InvalidResponse();
+    else if (factorCache)
+      factorCache->lookup(*it, factor.arrays, factor.response);
+    solvable.push_back(std::move(factor));
+  }
+
+  // Once a factor is known to be unsatisfiable, the remaining ones are not
+  // needed anymore.
+  std::atomic<bool> foundValid{false};
+  std::vector<SolverWorkerPool::Task> tasks;
+  for (Factor &factor : solvable) {
+    if (factor.response)
+      continue;
+    tasks.push_back([&factor, &foundValid, id = query.id](Solver &worker) {
+      if (foundValid.load(std::memory_order_relaxed))
+        return;
+      time::Point start = time::getWallTime();
+      Query factorQuery(ConstraintSet(factor.set), Expr::createFalse(), id);
+      if (!worker.impl->check(factorQuery, factor.response)) {
+        factor.response = ref<SolverResponse>();
+        factor.failure = worker.impl->getOperationStatusCode();
+      } else {
+        factor.solved = true;
+        if (isa<ValidResponse>(factor.response))
+          foundValid.store(true, std::memory_order_relaxed);
+      }
+      factor.time = time::getWallTime() - start;
+    });
+  }
+
+  time::Point start = time::getWallTime();
+  workers->run(tasks);
+  time::Span elapsed = time::getWallTime() - start;
+
+  time::Span total, criticalPath;
+  for (const Factor &factor : solvable) {
+    total += factor.time;
+    criticalPath = std::max(criticalPath, factor.time);
+  }
+  stats::independentFactors += tasks.size();
+  stats::independentFactorTime += total.toMicroseconds();
+  stats::independentParallelTime += elapsed.toMicroseconds();
+  stats::independentCriticalPathTime += criticalPath.toMicroseconds();
+
+  if (factorCache)
+    for (const Factor &factor : solvable)
+      if (factor.solved)
+        factorCache->insert(*factor.set, factor.response);
+
+  for (const Factor &factor : solvable) {
+    if (factor.response && isa<ValidResponse>(factor.response)) {
+      validResponse = factor.response;
+      return true;
+    }
+  }
+  for (const Factor &factor : solvable) {
+    if (factor.failure) {
+      workerStatus = factor.failure;
+      return false;
+    }
+  }
+
+  for (const Factor &factor : solvable) {
+    std::vector<SparseStorageImpl<unsigned char>> tempValues;
+    [[maybe_unused]] bool success =
+        factor.response->tryGetInitialValuesFor(factor.arrays, tempValues);
+    assert(success && "Can not get initial values (Independent solver)!");
+    assert(tempValues.size() == factor.arrays.size() &&
+           "Should be equal number arrays and answers");
+    factor.set->addValuesToAssignment(factor.arrays, tempValues, retMap);
+  }
+  return true;
+}
+
 bool IndependentSolver::computeInitialValues(
     const Query &query, const std::vector<const Array *> &objects,
     std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution) {
+  workerStatus.reset();
   // We assume the query has a solution except proven differently
   // This is important in case we don't have any constraints but
   // we need initial values for requested array objects.
@@ -175,6 +453,20 @@ bool IndependentSolver::computeInitialValues(
     }
   }
 
+  if (shouldSolveInParallel(independentFactors)) {
+    ref<SolverResponse> validResponse;
+    if (!solveInParallel(query, independentFactors, retMap, validResponse)) {
+      values.clear();
+      return false;
+    } else if (validResponse) {
+      hasSolution = false;
+      values.clear();
+      return true;
+    }
+    // all factors are part of retMap already
+    independentFactors.clear();
+  }
+
   // Used to rearrange all of the answers into the correct order
   for (ref<const IndependentConstraintSet> it : independentFactors) {
     std::vector<const Array *> arraysInFactor;
@@ -183,6 +475,7 @@ bool IndependentSolver::computeInitialValues(
     // below
     ConstraintSet tmp(it);
     std::vector<SparseStorageImpl<unsigned char>> tempValues;
+    ref<SolverResponse> cachedResult;
     if (arraysInFactor.size() == 0) {
       continue;
     } else if (it->exprs.size() == 0) {
@@ -190,13 +483,28 @@ bool IndependentSolver::computeInitialValues(
       [[maybe_unused]] bool success =
           tempResult->tryGetInitialValuesFor(arraysInFactor, tempValues);
       assert(success && "Can not get initial values (Independent solver)!");
+    } else if (factorCache &&
+               factorCache->lookup(*it, arraysInFactor, cachedResult) &&
+               (!isa<InvalidResponse>(cachedResult) ||
+                cachedResult->tryGetInitialValuesFor(arraysInFactor,
+                                                     tempValues))) {
+      hasSolution = isa<InvalidResponse>(cachedResult);
     } else {
+      tempValues.clear();
       if (!solver->impl->computeInitialValues(
               Query(tmp, Expr::createFalse(), query.id), arraysInFactor,
               tempValues, hasSolution)) {
         values.clear();
         return false;
       }
+      if (factorCache) {
+        if (hasSolution)
+          cachedResult = new InvalidResponse(arraysInFactor, tempValues);
+        else
+          cachedResult = new ValidResponse(
+              ValidityCore(it->getConstraints(), Expr::createFalse()));
+        factorCache->insert(*it, cachedResult);
+      }
     }
 
     if (!hasSolution) {
@@ -239,6 +547,7 @@ bool IndependentSolver::computeInitialValues(
 }
 
 bool IndependentSolver::check(const Query &query, ref<SolverResponse> &result) {
+  workerStatus.reset();
   // We assume the query has a solution except proven differently
   // This is important in case we don't have any constraints but
   // we need initial values for requested array objects.
@@ -280,6 +589,18 @@ bool IndependentSolver::check(const Query &query, ref<SolverResponse> &result) {
     }
   }
 
+  if (shouldSolveInParallel(independentFactors)) {
+    ref<SolverResponse> validResponse;
+    if (!solveInParallel(query, independentFactors, retMap, validResponse)) {
+      return false;
+    } else if (validResponse) {
+      result = validResponse;
+      return true;
+    }
+    // all factors are part of retMap already
+    independentFactors.clear();
+  }
+
   // Used to rearrange all of the answers into the correct order
   for (ref<const IndependentConstraintSet> it : independentFactors) {
     std::vector<const Array *> arraysInFactor;
@@ -292,12 +613,15 @@ bool IndependentSolver::check(const Query &query, ref<SolverResponse> &result) {
       continue;
     } else if (it->exprs.size() == 0) {
       tempResult = new InvalidResponse();
-    } else {
+    } else if (!factorCache ||
+               !factorCache->lookup(*it, arraysInFactor, tempResult)) {
       if (!solver->impl->check(
               Query(ConstraintSet(it), Expr::createFalse(), query.id),
               tempResult)) {
         return false;
       }
+      if (factorCache)
+        factorCache->insert(*it, tempResult);
     }
 
     if (isa<ValidResponse>(tempResult)) {
@@ -328,6 +652,7 @@ bool IndependentSolver::check(const Query &query, ref<SolverResponse> &result) {
 bool IndependentSolver::computeValidityCore(const Query &query,
                                             ValidityCore &validityCore,
                                             bool &isValid) {
+  workerStatus.reset();
   std::vector<ref<const IndependentConstraintSet>> factors;
   query.getAllDependentConstraintsSets(factors);
   ConstraintSet tmp(factors,
@@ -337,6 +662,8 @@ bool IndependentSolver::computeValidityCore(const Query &query,
 }
 
 SolverImpl::SolverRunStatus IndependentSolver::getOperationStatusCode() {
+  if (workerStatus)
+    return *workerStatus;
   return solver->impl->getOperationStatusCode();
 }
 
@@ -347,14 +674,21 @@ std::string IndependentSolver::getConstraintLog(const Query &query) {
 void IndependentSolver::setCoreSolverLimits(time::Span timeout,
                                             unsigned memoryLimit) {
   solver->impl->setCoreSolverLimits(timeout, memoryLimit);
+  if (workers)
+    for (auto &worker : workers->getSolvers())
+      worker->impl->setCoreSolverLimits(timeout, memoryLimit);
 }
 
 void IndependentSolver::notifyStateTermination(std::uint32_t id) {
   solver->impl->notifyStateTermination(id);
+  if (workers)
+    for (auto &worker : workers->getSolvers())
+      worker->impl->notifyStateTermination(id);
 }
 
 std::unique_ptr<Solver>
-klee::createIndependentSolver(std::unique_ptr<Solver> s) {
+klee::createIndependentSolver(std::unique_ptr<Solver> s,
+                              std::vector<std::unique_ptr<Solver>> workers) {
   return std::make_unique<Solver>(
-      std::make_unique<IndependentSolver>(std::move(s)));
+      std::make_unique<IndependentSolver>(std::move(s), std::move(workers)));
 }
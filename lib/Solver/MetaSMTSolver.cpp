@@ -18,6 +18,7 @@
 #include "klee/Solver/Solver.h"
 #include "klee/Solver/SolverImpl.h"
 #include "klee/Solver/SolverStats.h"
+#include "klee/Statistics/LiveMetrics.h"
 #include "klee/Statistics/TimerStatIncrementer.h"
 #include "klee/Support/ErrorHandling.h"
 
@@ -193,6 +194,7 @@ bool MetaSMTSolverImpl<SolverContext>::computeInitialValues(
   _runStatusCode = SOLVER_RUN_STATUS_FAILURE;
 
   TimerStatIncrementer t(stats::queryTime);
+  LiveHistogramTimer latency(LiveHistogram::QueryTime);
   assert(_builder);
 
   ++stats::solverQueries;
@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 #include "klee/Config/config.h"
 #include "klee/Solver/SolverStats.h"
+#include "klee/Statistics/LiveMetrics.h"
 #include "klee/Statistics/TimerStatIncrementer.h"
 
 #ifdef ENABLE_STP
@@ -430,6 +431,7 @@ bool STPSolverImpl::computeInitialValues(
     std::vector<SparseStorageImpl<unsigned char>> &values, bool &hasSolution) {
   runStatusCode = SOLVER_RUN_STATUS_FAILURE;
   TimerStatIncrementer t(stats::queryTime);
+  LiveHistogramTimer latency(LiveHistogram::QueryTime);
 
   vc_push(vc);
 
@@ -67,6 +67,13 @@ cl::opt<bool>
                          cl::desc("Use constraint independence (default=true)"),
                          cl::cat(SolvingCat));
 
+cl::opt<unsigned> IndependentSolverThreads(
+    "independent-solver-threads", cl::init(0),
+    cl::desc("Solve the independent factors of a query on this many worker "
+             "threads, each with its own core solver. 0 solves them one after "
+             "another (default=0)"),
+    cl::cat(SolvingCat));
+
 cl::opt<bool> DebugValidateSolver(
     "debug-validate-solver", cl::init(false),
     cl::desc("Crosscheck the results of the solver chain above the core solver "
@@ -107,6 +114,13 @@ cl::opt<bool> CoreSolverOptimizeDivides(
              "passing them to the core SMT solver (default=false)"),
     cl::init(false), cl::cat(SolvingCat));
 
+cl::opt<unsigned> SolverTranslationCacheSize(
+    "solver-translation-cache-size",
+    cl::desc("Number of expression translations the Z3 and Bitwuzla "
+             "backends keep across queries. 0 translates every query from "
+             "scratch (default=65536)"),
+    cl::init(65536), cl::cat(SolvingCat));
+
 cl::bits<QueryLoggingSolverType> QueryLoggingOptions(
     "use-query-log",
     cl::desc("Log queries to a file. Multiple options can be specified "
@@ -18,14 +18,31 @@ Statistic stats::queriesInvalid("QueriesInvalid", "Qiv");
 Statistic stats::queriesValid("QueriesValid", "Qv");
 Statistic stats::queryCacheHits("QueryCacheHits", "QChits");
 Statistic stats::queryCacheMisses("QueryCacheMisses", "QCmisses");
+Statistic stats::solverCacheCollisions("SolverCacheCollisions", "SCcoll");
 Statistic stats::queryCexCacheHits("QueryCexCacheHits", "QCexHits");
 Statistic stats::queryCexCacheMisses("QueryCexCacheMisses", "QCexMisses");
+Statistic stats::cexCacheEvictions("CexCacheEvictions", "QCexEvict");
 Statistic stats::queryConstructs("QueryConstructs", "QB");
 Statistic stats::queryCounterexamples("QueriesCEX", "Qcex");
 Statistic stats::validQueriesSize("ValidQueriesSize", "VQsize");
 Statistic stats::validityCoresSize("ValidityCoresSize", "VCsize");
 Statistic stats::queryValidityCores("QueryValidityCores", "QVcores");
 Statistic stats::queryTime("QueryTime", "Qtime");
+Statistic stats::queryTranslationTime("QueryTranslationTime", "QTtime");
+Statistic stats::queryCheckTime("QueryCheckTime", "QCtime");
+Statistic stats::translationCacheHits("TranslationCacheHits", "TChits");
+Statistic stats::translationCacheEvictions("TranslationCacheEvictions",
+                                           "TCevict");
+Statistic stats::independentFactors("IndependentFactors", "IFactors");
+Statistic stats::independentFactorTime("IndependentFactorTime", "IFtime");
+Statistic stats::independentParallelTime("IndependentParallelTime",
+                                         "IPtime");
+Statistic stats::independentCriticalPathTime("IndependentCriticalPathTime",
+                                             "ICPtime");
+Statistic stats::factorCacheHits("FactorCacheHits", "FChits");
+Statistic stats::factorCacheMisses("FactorCacheMisses", "FCmisses");
+Statistic stats::alphaCacheHits("AlphaCacheHits", "AChits");
+Statistic stats::alphaCacheTimeSaved("AlphaCacheTimeSaved", "ACsaved");
 
 #ifdef KLEE_ARRAY_DEBUG
 Statistic stats::arrayHashTime("ArrayHashTime", "AHtime");
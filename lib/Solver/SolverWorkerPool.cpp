@@ -0,0 +1,131 @@
+//===-- SolverWorkerPool.cpp ----------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SolverWorkerPool.h"
+
+#include "klee/Solver/Solver.h"
+
+#include <atomic>
+#include <cassert>
+#include <utility>
+
+using namespace klee;
+
+namespace {
+/// Serialises all tasks' accesses to expressions.
+std::mutex expressionMutex;
+
+/// The expression lock held by the current thread, if any.
+thread_local std::unique_lock<std::mutex> *heldExpressionLock = nullptr;
+
+/// The number of threads blocked on the expression lock, and the number of
+/// times the lock was taken, for ExpressionLock::yield().
+std::atomic<unsigned> expressionWaiters{0};
+std::atomic<unsigned> expressionAcquisitions{0};
+
+void lockExpressions(std::unique_lock<std::mutex> &lock) {
+  ++expressionWaiters;
+  lock.lock();
+  --expressionWaiters;
+  ++expressionAcquisitions;
+}
+} // namespace
+
+SolverWorkerPool::SolverWorkerPool(
+    std::vector<std::unique_ptr<Solver>> solvers)
+    : solvers(std::move(solvers)) {
+  threads.reserve(this->solvers.size());
+  for (auto &solver : this->solvers)
+    threads.emplace_back(&SolverWorkerPool::work, this, std::ref(*solver));
+}
+
+SolverWorkerPool::~SolverWorkerPool() {
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    stopping = true;
+  }
+  wakeup.notify_all();
+  for (auto &thread : threads)
+    thread.join();
+}
+
+void SolverWorkerPool::work(Solver &solver) {
+  unsigned seenGeneration = 0;
+  std::unique_lock<std::mutex> guard(mutex);
+  while (true) {
+    wakeup.wait(guard,
+                [&] { return stopping || generation != seenGeneration; });
+    if (stopping)
+      return;
+    seenGeneration = generation;
+
+    while (batch && nextTask < batch->size()) {
+      Task &task = (*batch)[nextTask++];
+      ++runningTasks;
+      guard.unlock();
+      {
+        ExpressionLock expressionLock;
+        task(solver);
+      }
+      guard.lock();
+      --runningTasks;
+    }
+    if (runningTasks == 0)
+      finished.notify_all();
+  }
+}
+
+void SolverWorkerPool::run(std::vector<Task> &tasks) {
+  if (tasks.empty())
+    return;
+
+  // the workers need the expression lock if this thread holds it
+  UnlockedNativeCall unlocked;
+  std::unique_lock<std::mutex> guard(mutex);
+  batch = &tasks;
+  nextTask = 0;
+  ++generation;
+  wakeup.notify_all();
+  finished.wait(guard, [&] {
+    return nextTask == batch->size() && runningTasks == 0;
+  });
+  batch = nullptr;
+}
+
+ExpressionLock::ExpressionLock() : lock(expressionMutex, std::defer_lock) {
+  assert(!heldExpressionLock && "expression lock is not recursive");
+  lockExpressions(lock);
+  heldExpressionLock = &lock;
+}
+
+ExpressionLock::~ExpressionLock() { heldExpressionLock = nullptr; }
+
+void ExpressionLock::yield() {
+  if (expressionWaiters.load(std::memory_order_relaxed) == 0)
+    return;
+
+  // std::mutex is not fair, so wait until the lock changed hands before
+  // asking for it again
+  unsigned acquisitions = expressionAcquisitions.load();
+  lock.unlock();
+  while (expressionWaiters.load() != 0 &&
+         expressionAcquisitions.load() == acquisitions)
+    std::this_thread::yield();
+  lockExpressions(lock);
+}
+
+UnlockedNativeCall::UnlockedNativeCall() : lock(heldExpressionLock) {
+  if (lock)
+    lock->unlock();
+}
+
+UnlockedNativeCall::~UnlockedNativeCall() {
+  if (lock)
+    lockExpressions(*lock);
+}
@@ -0,0 +1,106 @@
+//===-- SolverWorkerPool.h --------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SOLVERWORKERPOOL_H
+#define KLEE_SOLVERWORKERPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace klee {
+class Solver;
+
+/// SolverWorkerPool - A fixed set of threads, each owning its own solver
+/// chain, that run batches of solver tasks concurrently.
+///
+/// Expressions are reference counted and hash-consed without any
+/// synchronisation, so tasks run under a single expression lock. The lock is
+/// only given up by UnlockedNativeCall while a core solver is inside the
+/// native solver library, which is where the time goes for hard queries.
+/// The thread calling run() gives up the expression lock while it waits if
+/// it holds one (see ExpressionLock).
+class SolverWorkerPool {
+public:
+  typedef std::function<void(Solver &)> Task;
+
+private:
+  std::vector<std::unique_ptr<Solver>> solvers;
+  std::vector<std::thread> threads;
+
+  std::mutex mutex;
+  std::condition_variable wakeup, finished;
+  std::vector<Task> *batch = nullptr;
+  std::size_t nextTask = 0;
+  std::size_t runningTasks = 0;
+  unsigned generation = 0;
+  bool stopping = false;
+
+  void work(Solver &solver);
+
+public:
+  explicit SolverWorkerPool(std::vector<std::unique_ptr<Solver>> solvers);
+  ~SolverWorkerPool();
+
+  SolverWorkerPool(const SolverWorkerPool &) = delete;
+  SolverWorkerPool &operator=(const SolverWorkerPool &) = delete;
+
+  std::size_t size() const { return solvers.size(); }
+
+  /// The worker solvers. Only to be used while no batch is running.
+  const std::vector<std::unique_ptr<Solver>> &getSolvers() const {
+    return solvers;
+  }
+
+  /// Run all tasks of the batch and wait for them to finish. Each task runs
+  /// on one worker and is passed that worker's solver. The calling thread
+  /// must not hold any expression references that the tasks modify.
+  void run(std::vector<Task> &tasks);
+};
+
+/// ExpressionLock - Holds the expression lock for the lifetime of the guard.
+/// Worker threads take it for every task. A thread that works on
+/// expressions alongside workers takes it for as long as the workers exist.
+class ExpressionLock {
+  std::unique_lock<std::mutex> lock;
+
+public:
+  ExpressionLock();
+  ~ExpressionLock();
+
+  ExpressionLock(const ExpressionLock &) = delete;
+  ExpressionLock &operator=(const ExpressionLock &) = delete;
+
+  /// Hand the lock to a thread that is waiting for it, if there is one, and
+  /// take it back afterwards. Threads that hold the lock for long stretches
+  /// have to call this regularly.
+  void yield();
+};
+
+/// UnlockedNativeCall - Releases the expression lock of the current thread
+/// for the lifetime of the guard. Everything done in its scope must be
+/// independent of klee expressions. A no-op on threads that do not hold an
+/// ExpressionLock.
+class UnlockedNativeCall {
+  std::unique_lock<std::mutex> *lock;
+
+public:
+  UnlockedNativeCall();
+  ~UnlockedNativeCall();
+
+  UnlockedNativeCall(const UnlockedNativeCall &) = delete;
+  UnlockedNativeCall &operator=(const UnlockedNativeCall &) = delete;
+};
+} // namespace klee
+
+#endif /* KLEE_SOLVERWORKERPOOL_H */
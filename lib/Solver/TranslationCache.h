@@ -0,0 +1,90 @@
+//===-- TranslationCache.h --------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_TRANSLATIONCACHE_H
+#define KLEE_TRANSLATIONCACHE_H
+
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
+#include "klee/Solver/SolverStats.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace klee {
+
+/// TranslationCache - Translations of expressions into the term language of
+/// a solver, kept across queries.
+///
+/// Entries live in two generations. Lookups move entries of the old
+/// generation into the current one, and at the end of a query the current
+/// generation becomes the old one once it holds half of the capacity, which
+/// drops everything that was not used since the previous rotation. A
+/// capacity of zero forgets all translations after every query.
+template <typename Term> class TranslationCache {
+public:
+  struct Entry {
+    Term term;
+    unsigned width;
+    /// Side constraints emitted while translating the expression. They have
+    /// to be asserted again by every query that reuses the translation.
+    std::vector<Term> sideConstraints;
+  };
+
+private:
+  ExprHashMap<Entry> current, previous;
+  std::size_t capacity;
+
+public:
+  explicit TranslationCache(std::size_t capacity = 0) : capacity(capacity) {}
+
+  /// Return the translation of e, or null if it is not cached. The pointer is
+  /// valid until the next call to insert(), finishQuery() or clear().
+  const Entry *find(const ref<Expr> &e) {
+    auto it = current.find(e);
+    if (it != current.end()) {
+      ++stats::translationCacheHits;
+      return &it->second;
+    }
+    auto old = previous.find(e);
+    if (old == previous.end())
+      return nullptr;
+    ++stats::translationCacheHits;
+    auto promoted = current.emplace(e, std::move(old->second)).first;
+    previous.erase(old);
+    return &promoted->second;
+  }
+
+  void insert(const ref<Expr> &e, Entry entry) {
+    current.emplace(e, std::move(entry));
+  }
+
+  /// Called after each query to bound the size of the cache.
+  void finishQuery() {
+    if (capacity == 0) {
+      stats::translationCacheEvictions += size();
+      clear();
+    } else if (current.size() >= capacity / 2) {
+      stats::translationCacheEvictions += previous.size();
+      previous = std::move(current);
+      current.clear();
+    }
+  }
+
+  void clear() {
+    current.clear();
+    previous.clear();
+  }
+
+  std::size_t size() const { return current.size() + previous.size(); }
+};
+} // namespace klee
+
+#endif /* KLEE_TRANSLATIONCACHE_H */
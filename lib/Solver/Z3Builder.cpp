@@ -15,6 +15,7 @@
 #include "klee/Expr/SymbolicSource.h"
 #include "klee/Module/KModule.h"
 #include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverCmdLine.h"
 #include "klee/Solver/SolverStats.h"
 #include "klee/Support/ErrorHandling.h"
 
@@ -75,7 +76,8 @@ void Z3ArrayExprHash::clearUpdates() { _update_node_hash.clear(); }
 
 Z3Builder::Z3Builder(bool autoClearConstructCache,
                      const char *z3LogInteractionFileArg)
-    : autoClearConstructCache(autoClearConstructCache),
+    : constructed(SolverTranslationCacheSize),
+      autoClearConstructCache(autoClearConstructCache),
       z3LogInteractionFile("") {
   if (z3LogInteractionFileArg)
     this->z3LogInteractionFile = std::string(z3LogInteractionFileArg);
@@ -366,18 +368,24 @@ Z3ASTHandle Z3Builder::construct(ref<Expr> e, int *width_out) {
   if (!Z3HashConfig::UseConstructHashZ3 || isa<ConstantExpr>(e)) {
     return constructActual(e, width_out);
   } else {
-    ExprHashMap<std::pair<Z3ASTHandle, unsigned>>::iterator it =
-        constructed.find(e);
-    if (it != constructed.end()) {
+    if (auto entry = constructed.find(e)) {
       if (width_out)
-        *width_out = it->second.second;
-      return it->second.first;
+        *width_out = entry->width;
+      sideConstraints.insert(sideConstraints.end(),
+                             entry->sideConstraints.begin(),
+                             entry->sideConstraints.end());
+      return entry->term;
     } else {
       int width;
       if (!width_out)
         width_out = &width;
+      std::size_t firstSideConstraint = sideConstraints.size();
       Z3ASTHandle res = constructActual(e, width_out);
-      constructed.insert(std::make_pair(e, std::make_pair(res, *width_out)));
+      constructed.insert(
+          e, {res, static_cast<unsigned>(*width_out),
+              std::vector<Z3ASTHandle>(sideConstraints.begin() +
+                                           firstSideConstraint,
+                                       sideConstraints.end())});
       return res;
     }
   }
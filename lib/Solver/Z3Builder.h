@@ -10,6 +10,7 @@
 #ifndef KLEE_Z3BUILDER_H
 #define KLEE_Z3BUILDER_H
 
+#include "TranslationCache.h"
 #include "Z3HashConfig.h"
 #include "klee/Config/config.h"
 #include "klee/Expr/ArrayExprHash.h"
@@ -197,7 +198,7 @@ protected:
   Z3SortHandle getBvSort(unsigned width);
   Z3SortHandle getArraySort(Z3SortHandle domainSort, Z3SortHandle rangeSort);
 
-  ExprHashMap<std::pair<Z3ASTHandle, unsigned>> constructed;
+  TranslationCache<Z3ASTHandle> constructed;
   Z3ArrayExprHash _arr_hash;
   bool autoClearConstructCache;
   std::string z3LogInteractionFile;
@@ -227,6 +228,13 @@ public:
   }
   void clearConstructCache() { constructed.clear(); }
   void clearSideConstraints() { sideConstraints.clear(); }
+
+  /// Drop the side constraints of the finished query and the translations
+  /// that do not fit into the translation cache.
+  void finishQuery() {
+    constructed.finishQuery();
+    clearSideConstraints();
+  }
 };
 } // namespace klee
 
@@ -9,10 +9,12 @@
 
 #include "klee/Config/config.h"
 #include "klee/Solver/SolverStats.h"
+#include "klee/Statistics/LiveMetrics.h"
 #include "klee/Statistics/TimerStatIncrementer.h"
 
 #ifdef ENABLE_Z3
 
+#include "SolverWorkerPool.h"
 #include "Z3BitvectorBuilder.h"
 #include "Z3Builder.h"
 #include "Z3CoreBuilder.h"
@@ -32,6 +34,7 @@
 #include "llvm/Support/raw_ostream.h"
 
 #include <csignal>
+#include <optional>
 
 namespace {
 // NOTE: Very useful for debugging Z3 behaviour. These files can be given to
@@ -507,6 +510,7 @@ bool Z3SolverImpl::internalRunSolver(
   }
 
   TimerStatIncrementer t(stats::queryTime);
+  LiveHistogramTimer latency(LiveHistogram::QueryTime);
   // NOTE: Z3 will switch to using a slower solver internally if push/pop are
   // used so for now it is likely that creating a new solver each time is the
   // right way to go until Z3 changes its behaviour.
@@ -519,6 +523,8 @@ bool Z3SolverImpl::internalRunSolver(
   std::unordered_set<const Array *> all_constant_arrays_in_query;
   Z3ASTIncSet exprs;
 
+  std::optional<TimerStatIncrementer> translationTimer;
+  translationTimer.emplace(stats::queryTranslationTime);
   for (size_t i = 0; i < query.constraints.framesSize();
        i++, env.push(), exprs.push()) {
     ConstantArrayFinder constant_arrays_in_query;
@@ -572,6 +578,7 @@ bool Z3SolverImpl::internalRunSolver(
                  builder->sideConstraints.end());
   }
   exprs.pop(1); // drop last empty frame
+  translationTimer.reset();
 
   ++stats::solverQueries;
   if (!env.objects.v.empty())
@@ -606,7 +613,13 @@ bool Z3SolverImpl::internalRunSolver(
     dumpedQueriesFile->flush();
   }
 
-  ::Z3_lbool satisfiable = Z3_solver_check(builder->ctx, theSolver);
+  ::Z3_lbool satisfiable;
+  {
+    // no klee expressions are used while Z3 is checking
+    TimerStatIncrementer checkTimer(stats::queryCheckTime);
+    UnlockedNativeCall unlocked;
+    satisfiable = Z3_solver_check(builder->ctx, theSolver);
+  }
   runStatusCode = handleSolverResponse(theSolver, satisfiable, env, needObjects,
                                        values, hasSolution);
   if (ProduceUnsatCore && validityCore && satisfiable == Z3_L_FALSE) {
@@ -652,13 +665,13 @@ bool Z3SolverImpl::internalRunSolver(
 
   deinitNativeZ3(theSolver);
 
-  // Clear the builder's cache to prevent memory usage exploding.
-  // By using ``autoClearConstructCache=false`` and clearning now
+  // Bound the builder's cache to prevent memory usage exploding.
+  // By using ``autoClearConstructCache=false`` and only trimming now
   // we allow Z3_ast expressions to be shared from an entire
-  // ``Query`` rather than only sharing within a single call to
+  // ``Query``, and across queries as far as the translation cache
+  // allows, rather than only sharing within a single call to
   // ``builder->construct()``.
-  builder->clearConstructCache();
-  builder->clearSideConstraints();
+  builder->finishQuery();
   if (runStatusCode == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_SOLVABLE ||
       runStatusCode == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE) {
     if (hasSolution) {
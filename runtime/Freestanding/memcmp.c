@@ -36,10 +36,18 @@
 
 #include <string.h>
 
+int klee_memcmp_internal(const void *s1, const void *s2, size_t n,
+                         int *result);
+
 /*
  * Compare memory regions.
  */
 int memcmp(const void *s1, const void *s2, size_t n) {
+  int result;
+  /* Compare the whole regions at once when KLEE can. */
+  if (klee_memcmp_internal(s1, s2, n, &result))
+    return result;
+
   if (n != 0) {
     const unsigned char *p1 = s1, *p2 = s2;
 
@@ -9,7 +9,13 @@
 
 #include <stdlib.h>
 
+int klee_memcpy_internal(void *destaddr, void const *srcaddr, size_t len);
+
 void *memcpy(void *destaddr, void const *srcaddr, size_t len) {
+  // Copy the whole range at once when KLEE can, and byte by byte otherwise.
+  if (klee_memcpy_internal(destaddr, srcaddr, len))
+    return destaddr;
+
   char *dest = destaddr;
   char const *src = srcaddr;
 
@@ -9,7 +9,13 @@
 
 #include <stdlib.h>
 
+int klee_memmove_internal(void *dst, const void *src, size_t count);
+
 void *memmove(void *dst, const void *src, size_t count) {
+  // Move the whole range at once when KLEE can, and byte by byte otherwise.
+  if (klee_memmove_internal(dst, src, count))
+    return dst;
+
   char *a = dst;
   const char *b = src;
 
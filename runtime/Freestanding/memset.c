@@ -9,7 +9,13 @@
 
 #include <stdlib.h>
 
+int klee_memset_internal(void *dst, int s, size_t count);
+
 void *memset(void *dst, int s, size_t count) {
+  // Fill the whole range at once when KLEE can, and byte by byte otherwise.
+  if (klee_memset_internal(dst, s, count))
+    return dst;
+
   char *a = dst;
   while (count-- > 0)
     *a++ = s;
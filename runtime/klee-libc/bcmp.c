@@ -9,7 +9,16 @@
 
 #include <strings.h>
 
+int klee_memcmp_internal(const void *s1, const void *s2, size_t n,
+                         int *result);
+
 int bcmp(const void *s1, const void *s2, size_t n) {
+  int result;
+  // Compare the whole regions at once when KLEE can, and byte by byte
+  // otherwise.
+  if (klee_memcmp_internal(s1, s2, n, &result))
+    return result != 0;
+
   const unsigned char *p1 = s1, *p2 = s2;
   while (n-- != 0) {
     if (*p1++ != *p2++)
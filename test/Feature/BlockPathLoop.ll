@@ -0,0 +1,38 @@
+; RUN: %llvmas %s -o %t1.bc
+; RUN: rm -rf %t.klee-out
+; RUN: %klee --output-dir=%t.klee-out --optimize=false --write-kpaths %t1.bc
+; RUN: grep -o "(inc:" %t.klee-out/test000001.kpath | wc -l | FileCheck --check-prefix=CALLS %s
+; RUN: FileCheck --input-file=%t.klee-out/test000001.kpath %s
+
+; Loop iterations are stored once with a repetition count, but are still
+; written out one by one.
+
+; CALLS: 100
+; CHECK: (path: 0 (main: %entry %header %call (inc: %body %0) %call %header %call (inc: %body %0) %call
+; CHECK-SAME: %header %call (inc: %body %0) %call %header %exit) 0)
+
+define i32 @inc(i32 %x) {
+body:
+  %y = add i32 %x, 1
+  ret i32 %y
+}
+
+define i32 @main() {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %n, %latch ]
+  %c = icmp slt i32 %i, 100
+  br i1 %c, label %call, label %exit
+
+call:
+  %n = call i32 @inc(i32 %i)
+  br label %latch
+
+latch:
+  br label %header
+
+exit:
+  ret i32 0
+}
@@ -0,0 +1,60 @@
+// RUN: %clang %s -emit-llvm %O0opt -g -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out %t.bc > %t.log 2>&1
+// RUN: FileCheck %s -input-file=%t.log
+// RUN: not grep -q "ASSERTION FAIL" %t.log
+// RUN: %klee-stats --print-columns 'Instrs' --table-format=csv %t.klee-out > %t.stats
+// RUN: FileCheck -check-prefix=STATS -input-file=%t.stats %s
+#include "klee/klee.h"
+
+#include <assert.h>
+#include <string.h>
+
+// the byte loops would execute several instructions per byte of these
+static char large[8192], copy[8192];
+
+int main(void) {
+  char concrete[8] = "abcdefg";
+  char buf[16];
+
+  memset(large, 'z', sizeof(large));
+  memcpy(copy, large, sizeof(large));
+  assert(copy[0] == 'z' && copy[sizeof(copy) - 1] == 'z');
+
+  memset(buf, 'x', sizeof(buf));
+  memcpy(buf, concrete, sizeof(concrete));
+  assert(buf[3] == 'd' && buf[8] == 'x' && buf[15] == 'x');
+
+  // overlapping moves in both directions
+  memmove(buf + 2, buf, 6);
+  assert(memcmp(buf, "ababcdef", 8) == 0);
+  memmove(buf, buf + 2, 6);
+  assert(memcmp(buf, "abcdefef", 8) == 0);
+
+  char input[4];
+  klee_make_symbolic(input, sizeof(input), "input");
+  memcpy(buf + 4, input, sizeof(input));
+  memset(buf, input[0], 2);
+  assert(buf[1] == input[0] && buf[7] == input[3]);
+
+  int cmp = memcmp(buf + 4, "ok", 2);
+  if (cmp == 0)
+    assert(input[0] == 'o' && input[1] == 'k');
+  else if (input[0] != 'o')
+    assert(cmp == (unsigned char)input[0] - 'o');
+  else
+    assert(cmp == (unsigned char)input[1] - 'k');
+
+  // out of bounds ranges are still reported
+  if (input[2] == '!') {
+    // CHECK: memory error: out of bound pointer
+    memcpy(buf + 12, concrete, sizeof(concrete));
+  }
+  return 0;
+}
+
+// CHECK: KLEE: done
+
+// all paths together execute far fewer instructions than there are bytes
+// STATS: Instrs
+// STATS-NEXT: {{^[0-9]{1,4}$}}
@@ -0,0 +1,29 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --allocate-determ --allocate-determ-size=1 --allocate-determ-start-address=0x0 %t1.bc 2>&1 | FileCheck %s
+// RUN: test -f %t.klee-out/test000001.ptr.err
+
+#include <stdlib.h>
+
+int main() {
+  // Each 1KiB object takes a 2KiB slot with its redzone. 4096 of them only
+  // fit into the 1MiB of deterministic space if the slots of freed objects
+  // are reused once they leave the quarantine, which may take a tenth of the
+  // space by default
+  // CHECK-NOT: Not enough deterministic space left
+  for (int i = 0; i < 4096; ++i) {
+    char *buf = malloc(1024);
+    buf[0] = i;
+    free(buf);
+  }
+
+  // The freed object is still in quarantine, so the new one gets another
+  // address and the dangling access is detected
+  char *p = malloc(16);
+  free(p);
+  char *q = malloc(16);
+  q[0] = 0;
+  // CHECK: memory error: out of bound pointer
+  p[0] = 1;
+  return 0;
+}
@@ -2,6 +2,7 @@
 // RUN: rm -rf %t.klee-out
 // RUN: %klee --output-dir=%t.klee-out --max-instructions=1 --dump-states-on-halt=all %t1.bc 2>&1 | FileCheck %s
 // RUN: test -f %t.klee-out/test000001.ktest
+// RUN: FileCheck -check-prefix=CHECK-MEM -input-file=%t.klee-out/test000001.early %s
 
 int main(int argc, char **argv) {
   int x = 1;
@@ -10,3 +11,4 @@ int main(int argc, char **argv) {
   return x;
 }
 // CHECK: halting execution, dumping remaining states
+// CHECK-MEM: Memory: {{[0-9]+}} bytes exclusive, {{[0-9]+}} bytes shared
@@ -0,0 +1,90 @@
+; RUN: %llvmas %s -o %t1.bc
+; RUN: rm -rf %t.klee-out
+; RUN: %klee --output-dir=%t.klee-out --optimize=false --simplify=false --if-conversion %t1.bc 2>&1 | FileCheck --check-prefix=CHECK-IFC %s
+; RUN: ls %t.klee-out/ | grep -c abort.err | FileCheck --check-prefix=ERR %s
+; RUN: rm -rf %t.klee-out-fork
+; RUN: %klee --output-dir=%t.klee-out-fork --optimize=false --simplify=false %t1.bc 2>&1 | FileCheck --check-prefix=CHECK-FORK %s
+; RUN: ls %t.klee-out-fork/ | grep -c abort.err | FileCheck --check-prefix=ERR %s
+
+; The conditional expression, the absolute value and the clamp are turned
+; into selects. The store to f stays conditional, as nothing is stored to f
+; right before it. So the only forks left are on it and on the call to abort,
+; which is reached with x == 10 either way.
+
+; CHECK-IFC: KLEE: If-conversion turned 3 branches into selects
+; CHECK-IFC: KLEE: done: completed paths = 2
+; CHECK-FORK: KLEE: done: completed paths = 6
+; ERR: 1
+
+@.str = private unnamed_addr constant [2 x i8] c"x\00", align 1
+
+define i32 @main() {
+entry:
+  %x.addr = alloca i32, align 4
+  %m = alloca i32, align 4
+  %f = alloca i32, align 4
+  %p = bitcast i32* %x.addr to i8*
+  call void @klee_make_symbolic(i8* %p, i64 4, i8* getelementptr inbounds ([2 x i8], [2 x i8]* @.str, i64 0, i64 0))
+  %x = load i32, i32* %x.addr, align 4
+  %cmp = icmp sgt i32 %x, 10
+  br i1 %cmp, label %cond.true, label %cond.false
+
+; y = x > 10 ? 10 : x
+cond.true:
+  br label %cond.end
+
+cond.false:
+  %x1 = load i32, i32* %x.addr, align 4
+  br label %cond.end
+
+cond.end:
+  %y = phi i32 [ 10, %cond.true ], [ %x1, %cond.false ]
+  %cmp1 = icmp slt i32 %x, 0
+  br i1 %cmp1, label %if.then, label %if.else
+
+; if (x < 0) m = -x; else m = x;
+if.then:
+  %neg = sub nsw i32 0, %x
+  store i32 %neg, i32* %m, align 4
+  br label %if.end
+
+if.else:
+  store i32 %x, i32* %m, align 4
+  br label %if.end
+
+; if (m > 100) m = 100;
+if.end:
+  %m1 = load i32, i32* %m, align 4
+  %cmp2 = icmp sgt i32 %m1, 100
+  br i1 %cmp2, label %if.then2, label %if.end2
+
+if.then2:
+  store i32 100, i32* %m, align 4
+  br label %if.end2
+
+if.end2:
+  %r = load i32, i32* %m, align 4
+  %s = add i32 %y, %r
+  %cmp4 = icmp eq i32 %x, 5
+  br i1 %cmp4, label %if.then4, label %if.end4
+
+; if (x == 5) f = 1;
+if.then4:
+  store i32 1, i32* %f, align 4
+  br label %if.end4
+
+if.end4:
+  %cmp3 = icmp eq i32 %s, 20
+  br i1 %cmp3, label %error, label %exit
+
+error:
+  call void @abort()
+  unreachable
+
+exit:
+  ret i32 0
+}
+
+declare void @klee_make_symbolic(i8*, i64, i8*)
+
+declare void @abort()
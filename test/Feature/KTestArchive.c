@@ -0,0 +1,46 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --write-ktest-archive --write-kqueries --write-paths %t.bc
+// RUN: not test -f %t.klee-out/test000001.ktest
+// RUN: not test -f %t.klee-out/test000001.kquery
+// RUN: not test -f %t.klee-out/test000001.path
+// RUN: test -f %t.klee-out/tests.ktar.idx
+// RUN: %ktest-tool %t.klee-out/tests.ktar | FileCheck --check-prefix=CHECK-TOOL %s
+// RUN: %ktest-tool --cat-file test000001.kquery %t.klee-out/tests.ktar | FileCheck --check-prefix=CHECK-FILE %s
+
+// RUN: rm -rf %t.klee-out-2
+// RUN: %klee --output-dir=%t.klee-out-2 --replay-ktest-file=%t.klee-out/tests.ktar %t.bc 2>&1 | FileCheck --check-prefix=CHECK-REPLAY %s
+
+// RUN: rm -f %t.ktar %t.ktar.idx
+// RUN: %ktest-gen --archive %t.ktar --archive-dedup first
+// RUN: %ktest-gen --archive %t.ktar --archive-dedup second
+// RUN: %ktest-tool %t.ktar | FileCheck --check-prefix=CHECK-GEN %s
+#include "klee/klee.h"
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof x, "x");
+
+  if (x > 10)
+    return 1;
+  if (x < -10)
+    return 2;
+  return 0;
+}
+
+// CHECK-TOOL: ktest file : '{{.*}}tests.ktar#0'
+// CHECK-TOOL: object 0: name: 'x'
+// CHECK-TOOL: ktest file : '{{.*}}tests.ktar#1'
+// CHECK-TOOL: ktest file : '{{.*}}tests.ktar#2'
+// CHECK-TOOL-NOT: ktest file
+
+// CHECK-FILE: (query [
+
+// CHECK-REPLAY: KLEE: replaying: {{.*}} (1/3)
+// CHECK-REPLAY: KLEE: replaying: {{.*}} (2/3)
+// CHECK-REPLAY: KLEE: replaying: {{.*}} (3/3)
+
+// CHECK-GEN: ktest file : '{{.*}}.ktar#0'
+// CHECK-GEN: object 0: text: first.
+// CHECK-GEN: ktest file : '{{.*}}.ktar#1'
+// CHECK-GEN: object 0: text: second.
@@ -0,0 +1,19 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --live-metrics --live-metrics-interval=10ms %t.bc 2>&1 | FileCheck %s
+// RUN: %klee-stats --live --live-iterations=1 %t.klee-out | FileCheck --check-prefix=CHECK-STATS %s
+#include "klee/klee.h"
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof x, "x");
+  if (x > 0)
+    return 1;
+  return 0;
+}
+
+// CHECK-NOT: Unable to create live metrics page
+// CHECK: KLEE: done: completed paths = 2
+
+// The page is removed when KLEE exits.
+// CHECK-STATS: No running KLEE process with --live-metrics found
@@ -0,0 +1,29 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-guided-search=none --merge-states %t.bc 2>&1 | FileCheck --check-prefixes=CHECK,CHECK-MERGE %s
+// RUN: rm -rf %t.klee-out-fork
+// RUN: %klee --output-dir=%t.klee-out-fork --use-guided-search=none %t.bc 2>&1 | FileCheck --check-prefixes=CHECK,CHECK-FORK %s
+
+#include "klee/klee.h"
+
+#include <stdio.h>
+
+int main(void) {
+  char buf[6];
+  klee_make_symbolic(buf, sizeof(buf), "buf");
+
+  // the states forked in an iteration are merged at its end, with count
+  // turning symbolic
+  int count = 0;
+  for (int i = 0; i < 6; ++i)
+    if (buf[i] == 'a')
+      ++count;
+
+  // CHECK: all
+  if (count == 6)
+    printf("all\n");
+  return 0;
+}
+
+// CHECK-MERGE: KLEE: done: completed paths = 1
+// CHECK-FORK: KLEE: done: completed paths = 64
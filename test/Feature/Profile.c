@@ -0,0 +1,22 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --profile --profile-interval=100us %t.bc
+// RUN: test -f %t.klee-out/profile.folded
+// RUN: FileCheck --input-file=%t.klee-out/profile.lines %s
+#include "klee/klee.h"
+
+int main() {
+  unsigned x;
+  klee_make_symbolic(&x, sizeof x, "x");
+
+  unsigned n = 0;
+  for (unsigned i = 0; i < 1000; ++i)
+    n += x * i;
+
+  if (n % 7 == 3)
+    return 1;
+  return 0;
+}
+
+// CHECK: # interval: 100us, samples: {{[0-9]+}}, unattributed: {{[0-9]+}}, dropped: 0
+// CHECK-NEXT: # total interpretation solver resolve fork external location (function)
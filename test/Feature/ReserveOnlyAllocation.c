@@ -0,0 +1,29 @@
+// RUN: %clang %s -emit-llvm %O0opt -g -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --external-calls=all --exit-on-error --allocate-reserve-only %t.bc 2>&1 | FileCheck %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --external-calls=all --exit-on-error --allocate-reserve-only=false %t.bc 2>&1 | FileCheck %s
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main() {
+  // Only backed by host memory once it is passed to an external call
+  char *buf = malloc(1 << 20);
+  buf[0] = 'k';
+  buf[1] = 'l';
+  buf[2] = 'e';
+  buf[3] = 'e';
+  buf[4] = '\0';
+
+  // Written by the external call and copied back into the state
+  char *copy = malloc(16);
+  strcpy(copy, buf);
+  free(buf);
+
+  // CHECK: copy = klee
+  printf("copy = %s\n", copy);
+  free(copy);
+  return 0;
+}
@@ -0,0 +1,27 @@
+// REQUIRES: 32bit-support
+// REQUIRES: not-darwin
+// RUN: %clang %s -m32 -emit-llvm %O0opt -g -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --external-calls=all --exit-on-error --allocate-reserve-only %t.bc 2>&1 | FileCheck %s
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+int main() {
+  // 32-bit programs get the ctype tables and errno as objects of the
+  // allocation arena, which external calls read without copying them out
+  const unsigned short *table = *__ctype_b_loc();
+  unsigned short upper = table['A'];
+  // CHECK: table = 0
+  printf("table = %d\n", strncmp((const char *)&table['A'],
+                                 (const char *)&upper, sizeof(upper)));
+
+  errno = 0;
+  int zero = 0;
+  // CHECK: errno = 0
+  printf("errno = %d\n",
+         strncmp((const char *)&errno, (const char *)&zero, sizeof(zero)));
+  return 0;
+}
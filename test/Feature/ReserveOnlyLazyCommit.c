@@ -0,0 +1,31 @@
+// RUN: %clang %s -emit-llvm %O0opt -g -c -o %t.bc
+// RUN: %clang %s -DEXTERNAL -emit-llvm %O0opt -g -c -o %t.external.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --external-calls=all --allocate-reserve-only %t.bc
+// RUN: %klee-stats --print-columns 'ArenaPages' --table-format=csv %t.klee-out > %t.stats
+// RUN: FileCheck -check-prefix=LAZY -input-file=%t.stats %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --external-calls=all --allocate-reserve-only %t.external.bc
+// RUN: %klee-stats --print-columns 'ArenaPages' --table-format=csv %t.klee-out > %t.stats
+// RUN: FileCheck -check-prefix=EXTERNAL -input-file=%t.stats %s
+
+#include <stdlib.h>
+#include <string.h>
+
+int main() {
+  // 8MiB that only get host pages once an external call may access them
+  char *buf = malloc(8 << 20);
+  for (int i = 0; i < (8 << 20); i += 4096)
+    buf[i] = 'a';
+  buf[(8 << 20) - 1] = '\0';
+#ifdef EXTERNAL
+  if (strlen(buf) == 0)
+    return 1;
+#endif
+  return 0;
+}
+
+// LAZY: ArenaPages
+// LAZY-NEXT: {{^[0-9]{1,2}$}}
+// EXTERNAL: ArenaPages
+// EXTERNAL-NEXT: {{^[0-9]{3,}$}}
@@ -0,0 +1,38 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --speculative-fork %t.bc 2>&1 | FileCheck %s
+// RUN: %klee-stats --print-columns 'SpecForks' --table-format=csv %t.klee-out > %t.stats
+// RUN: FileCheck -check-prefix=STATS -input-file=%t.stats %s
+// RUN: rm -rf %t.klee-out-sync
+// RUN: %klee --output-dir=%t.klee-out-sync %t.bc 2>&1 | FileCheck %s
+
+#include "klee/klee.h"
+
+#include <stdio.h>
+
+int main(void) {
+  int x, y;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  klee_make_symbolic(&y, sizeof(y), "y");
+
+  int paths = 0;
+  if (x > 10) {
+    ++paths;
+    // the branched state of this infeasible direction is discarded
+    // CHECK-NOT: unreachable
+    if (x < 5)
+      printf("unreachable\n");
+  }
+  if (y == 42)
+    ++paths;
+  if ((x ^ y) & 1)
+    ++paths;
+
+  return paths;
+}
+
+// CHECK: KLEE: done: completed paths = 8
+// CHECK: KLEE: done: generated tests = 8
+
+// STATS: SpecForks
+// STATS-NEXT: {{^[1-9][0-9]*$}}
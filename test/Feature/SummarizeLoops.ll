@@ -0,0 +1,99 @@
+; RUN: %llvmas %s -o %t1.bc
+; RUN: rm -rf %t.klee-out
+; RUN: %klee --output-dir=%t.klee-out --optimize=false --use-guided-search=none --summarize-loops %t1.bc 2>&1 | FileCheck --check-prefix=CHECK-SUMMARY %s
+; RUN: rm -rf %t.klee-out-fork
+; RUN: %klee --output-dir=%t.klee-out-fork --optimize=false --use-guided-search=none %t1.bc 2>&1 | FileCheck --check-prefix=CHECK-FORK %s
+; RUN: %klee-stats --print-columns 'ICovered' --table-format=csv %t.klee-out > %t.stats
+; RUN: %klee-stats --print-columns 'ICovered' --table-format=csv %t.klee-out-fork >> %t.stats
+; RUN: FileCheck --check-prefix=COV --input-file=%t.stats %s
+
+; The length of the string and the position of the first 'a' in it are found
+; without forking on every byte. The state leaving strlen is branched once
+; more on the length being 5, and the one leaving memchr once for each exit.
+; Both runs check that the pointer returned by memchr points to an 'a'.
+
+; CHECK-SUMMARY-NOT: KLEE: ERROR
+; CHECK-SUMMARY: KLEE: done: completed paths = 3
+; CHECK-FORK-NOT: KLEE: ERROR
+; CHECK-FORK: KLEE: done: completed paths = 14
+
+; The instructions of summarized loops count as covered.
+; COV: ICovered
+; COV-NEXT: {{^}}[[COVERED:[0-9]+]]{{$}}
+; COV-NEXT: ICovered
+; COV-NEXT: {{^}}[[COVERED]]{{$}}
+
+@.str = private unnamed_addr constant [4 x i8] c"buf\00", align 1
+
+define i64 @my_strlen(i8* %s) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %next, %loop ]
+  %p = getelementptr inbounds i8, i8* %s, i64 %i
+  %c = load i8, i8* %p, align 1
+  %end = icmp eq i8 %c, 0
+  %next = add i64 %i, 1
+  br i1 %end, label %exit, label %loop
+
+exit:
+  ret i64 %i
+}
+
+define i8* @my_memchr(i8* %s, i8 %c, i64 %n) {
+entry:
+  %empty = icmp eq i64 %n, 0
+  br i1 %empty, label %notfound, label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %inc, %latch ]
+  %p = getelementptr inbounds i8, i8* %s, i64 %i
+  %v = load i8, i8* %p, align 1
+  %match = icmp eq i8 %v, %c
+  br i1 %match, label %found, label %latch
+
+latch:
+  %inc = add i64 %i, 1
+  %more = icmp ult i64 %inc, %n
+  br i1 %more, label %loop, label %notfound
+
+found:
+  ret i8* %p
+
+notfound:
+  ret i8* null
+}
+
+define i32 @main() {
+entry:
+  %buf = alloca [8 x i8], align 1
+  %s = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 0
+  call void @klee_make_symbolic(i8* %s, i64 8, i8* getelementptr inbounds ([4 x i8], [4 x i8]* @.str, i64 0, i64 0))
+  %last = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 7
+  store i8 0, i8* %last, align 1
+  %len = call i64 @my_strlen(i8* %s)
+  %five = icmp eq i64 %len, 5
+  br i1 %five, label %search, label %done
+
+search:
+  %r = call i8* @my_memchr(i8* %s, i8 97, i64 8)
+  %null = icmp eq i8* %r, null
+  br i1 %null, label %done, label %check
+
+check:
+  %a = load i8, i8* %r, align 1
+  %isa = icmp eq i8 %a, 97
+  br i1 %isa, label %done, label %fail
+
+fail:
+  call void @abort()
+  unreachable
+
+done:
+  ret i32 0
+}
+
+declare void @klee_make_symbolic(i8*, i64, i8*)
+
+declare void @abort()
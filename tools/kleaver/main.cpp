@@ -87,6 +87,12 @@ llvm::cl::opt<bool> ClearArrayAfterQuery(
     llvm::cl::desc("Discard the previous array declarations after a query "
                    "is performed (default=false)"),
     llvm::cl::init(false), llvm::cl::cat(klee::ExprCat));
+
+llvm::cl::opt<bool> PrintStatistics(
+    "print-stats",
+    llvm::cl::desc("Print all non-zero statistics after the queries "
+                   "(default=false)"),
+    llvm::cl::init(false), llvm::cl::cat(klee::SolvingCat));
 } // namespace
 
 static std::string getQueryLogPath(const char filename[]) {
@@ -316,6 +322,15 @@ static bool EvaluateInputAST(const char *Filename, const llvm::MemoryBuffer *MB,
                  << '\n';
   }
 
+  if (PrintStatistics) {
+    for (unsigned i = 0, e = theStatisticManager->getNumStatistics(); i != e;
+         ++i) {
+      Statistic &statistic = theStatisticManager->getStatistic(i);
+      if (uint64_t value = statistic.getValue())
+        llvm::outs() << statistic.getName() << " = " << value << '\n';
+    }
+  }
+
   return success;
 }
 
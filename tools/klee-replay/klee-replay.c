@@ -274,7 +274,7 @@ void ensure_capsyschroot(const char *executable) {
 
 static void usage(void) {
   fprintf(stderr,
-          "Usage: %s [option]... <executable> <ktest-file>...\n"
+          "Usage: %s [option]... <executable> <ktest-file|ktar-file>...\n"
           "   or: %s --create-files-only <ktest-file>\n"
           "\n"
           "-r, --chroot-to-dir=DIR  use chroot jail, requires CAP_SYS_CHROOT\n"
@@ -366,71 +366,93 @@ int main(int argc, char **argv) {
   int idx = 0;
   for (idx = optind + 1; idx != argc; ++idx) {
     char *input_fname = argv[idx];
-    unsigned i;
+    KTestArchive *archive = NULL;
+    unsigned test, num_tests = 1;
 
-    input = kTest_fromFile(input_fname);
-    if (!input) {
-      fprintf(stderr, "KLEE-REPLAY: ERROR: input file %s not valid.\n",
-              input_fname);
-      exit(1);
+    /* An archive replays each of the tests it contains */
+    if (kTestArchive_isArchiveFile(input_fname)) {
+      archive = kTestArchive_open(input_fname);
+      if (!archive) {
+        fprintf(stderr, "KLEE-REPLAY: ERROR: input file %s not valid.\n",
+                input_fname);
+        exit(1);
+      }
+      num_tests = kTestArchive_numTests(archive);
     }
 
-    obj_index = 0;
-    prg_argc = input->numArgs;
-    prg_argv = input->args;
-    free(prg_argv[0]);
-    prg_argv[0] = strdup(argv[optind]);
-
-    klee_init_env(&prg_argc, &prg_argv);
+    for (test = 0; test != num_tests; ++test) {
+      unsigned i;
 
-    if (idx > 2)
-      fputc('\n', stderr);
-    fprintf(stderr,
-            "KLEE-REPLAY: NOTE: Test file: %s\n"
-            "KLEE-REPLAY: NOTE: Arguments: ",
-            input_fname);
-    for (i = 0; i != (unsigned)prg_argc; ++i) {
-      char *s = prg_argv[i];
-      if (s[0] == 'A' && s[1] && !s[2])
-        s[1] = '\0';
-      fprintf(stderr, "\"%s\" ", prg_argv[i]);
-    }
-    fputc('\n', stderr);
+      input = archive ? kTestArchive_getTest(archive, test)
+                      : kTest_fromFile(input_fname);
+      if (!input) {
+        fprintf(stderr, "KLEE-REPLAY: ERROR: input file %s not valid.\n",
+                input_fname);
+        exit(1);
+      }
 
-    /* Create the input files, pipes, etc. */
-    replay_create_files(&__exe_fs);
+      obj_index = 0;
+      prg_argc = input->numArgs;
+      prg_argv = input->args;
+      free(prg_argv[0]);
+      prg_argv[0] = strdup(argv[optind]);
 
-    /* Run the test case machinery in a subprocess, eventually this parent
-       process should be a script or something which shells out to the actual
-       execution tool. */
+      klee_init_env(&prg_argc, &prg_argv);
 
-    int pid = fork();
-    if (pid < 0) {
-      perror("fork");
-      _exit(66);
-    } else if (pid == 0) {
-      /* Run the executable */
-      run_monitored(executable, prg_argc, prg_argv);
-      _exit(0);
-    } else {
-      /* Wait for the executable to finish. */
-      int res, status;
+      if (idx > 2 || test)
+        fputc('\n', stderr);
+      if (archive)
+        fprintf(stderr, "KLEE-REPLAY: NOTE: Test file: %s#%u\n", input_fname,
+                test);
+      else
+        fprintf(stderr, "KLEE-REPLAY: NOTE: Test file: %s\n", input_fname);
+      fputs("KLEE-REPLAY: NOTE: Arguments: ", stderr);
+      for (i = 0; i != (unsigned)prg_argc; ++i) {
+        char *s = prg_argv[i];
+        if (s[0] == 'A' && s[1] && !s[2])
+          s[1] = '\0';
+        fprintf(stderr, "\"%s\" ", prg_argv[i]);
+      }
+      fputc('\n', stderr);
 
-      do {
-        res = waitpid(pid, &status, 0);
-      } while (res < 0 && errno == EINTR);
+      /* Create the input files, pipes, etc. */
+      replay_create_files(&__exe_fs);
 
-      // Delete all files in the replay directory
-      replay_delete_files();
+      /* Run the test case machinery in a subprocess, eventually this parent
+         process should be a script or something which shells out to the actual
+         execution tool. */
 
-      if (res < 0) {
-        perror("waitpid");
+      int pid = fork();
+      if (pid < 0) {
+        perror("fork");
         _exit(66);
+      } else if (pid == 0) {
+        /* Run the executable */
+        run_monitored(executable, prg_argc, prg_argv);
+        _exit(0);
+      } else {
+        /* Wait for the executable to finish. */
+        int res, status;
+
+        do {
+          res = waitpid(pid, &status, 0);
+        } while (res < 0 && errno == EINTR);
+
+        // Delete all files in the replay directory
+        replay_delete_files();
+
+        if (res < 0) {
+          perror("waitpid");
+          _exit(66);
+        }
+
+        free(prg_argv);
+        kTest_free(input);
       }
-
-      free(prg_argv);
-      kTest_free(input);
     }
+
+    if (archive)
+      kTestArchive_close(archive);
   }
 
   return 0;
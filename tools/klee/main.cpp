@@ -15,6 +15,7 @@
 #include "klee/Core/Context.h"
 #include "klee/Core/Interpreter.h"
 #include "klee/Core/TargetedExecutionReporter.h"
+#include "klee/Expr/Expr.h"
 #include "klee/Module/LocationInfo.h"
 #include "klee/Module/SarifReport.h"
 #include "klee/Solver/SolverCmdLine.h"
@@ -95,6 +96,20 @@ cl::opt<bool> WriteKTests(
     cl::desc("Write .ktest files for each test case (default=true)"),
     cl::cat(TestCaseCat));
 
+cl::opt<bool> WriteKTestArchive(
+    "write-ktest-archive", cl::init(false),
+    cl::desc("Append test cases, and the other files written for each test "
+             "case (.kquery, .path, .cov, ...), to a single tests.ktar "
+             "archive in the output directory instead of writing separate "
+             "files (default=false)"),
+    cl::cat(TestCaseCat));
+
+cl::opt<bool> KTestArchiveDedup(
+    "ktest-archive-dedup", cl::init(true),
+    cl::desc("Store identical object contents only once in the test case "
+             "archive (default=true)"),
+    cl::cat(TestCaseCat));
+
 cl::opt<bool>
     WriteCVCs("write-cvcs",
               cl::desc("Write .cvc files for each test case (default=false)"),
@@ -283,12 +298,14 @@ cl::OptionCategory ReplayCat("Replaying options",
 
 cl::list<std::string>
     ReplayKTestFile("replay-ktest-file",
-                    cl::desc("Specify a .ktest file to use for replay"),
+                    cl::desc("Specify a .ktest file or .ktar archive to use "
+                             "for replay"),
                     cl::value_desc(".ktest file"), cl::cat(ReplayCat));
 
 cl::list<std::string>
     ReplayKTestDir("replay-ktest-dir",
-                   cl::desc("Specify a directory to replay .ktest files from"),
+                   cl::desc("Specify a directory to replay .ktest files and "
+                            ".ktar archives from"),
                    cl::value_desc("output directory"), cl::cat(ReplayCat));
 
 cl::opt<std::string> ReplayPathFile("replay-path",
@@ -296,13 +313,15 @@ cl::opt<std::string> ReplayPathFile("replay-path",
                                     cl::value_desc("path file"),
                                     cl::cat(ReplayCat));
 
-cl::list<std::string> SeedOutFile("seed-file",
-                                  cl::desc(".ktest file to be used as seed"),
-                                  cl::cat(SeedingCat));
+cl::list<std::string>
+    SeedOutFile("seed-file",
+                cl::desc(".ktest file or .ktar archive to be used as seed"),
+                cl::cat(SeedingCat));
 
 cl::list<std::string>
     SeedOutDir("seed-dir",
-               cl::desc("Directory with .ktest files to be used as seeds"),
+               cl::desc("Directory with .ktest files and .ktar archives to be "
+                        "used as seeds"),
                cl::cat(SeedingCat));
 
 cl::opt<unsigned> MakeConcreteSymbolic(
@@ -430,6 +449,34 @@ class ExecutionState;
 
 /***/
 
+/// Collects the contents of a test case file and appends them to the test
+/// case archive when the stream is destroyed.
+class ArchivedFileStream : public llvm::raw_ostream {
+  KTestArchiveWriter *archive;
+  std::string name;
+  std::string contents;
+
+  void write_impl(const char *ptr, size_t size) override {
+    contents.append(ptr, size);
+  }
+  uint64_t current_pos() const override { return contents.size(); }
+
+public:
+  ArchivedFileStream(KTestArchiveWriter *archive, std::string name)
+      : archive(archive), name(std::move(name)) {
+    SetUnbuffered();
+  }
+
+  ~ArchivedFileStream() override {
+    flush();
+    if (!kTestArchiveWriter_appendFile(
+            archive, name.c_str(), (const unsigned char *)contents.data(),
+            contents.size()))
+      klee_warning("unable to write \"%s\" to the test case archive",
+                   name.c_str());
+  }
+};
+
 class KleeHandler : public InterpreterHandler {
 private:
   Interpreter *m_interpreter;
@@ -447,6 +494,9 @@ private:
   int m_argc;
   char **m_argv;
 
+  // opened on the first test case with --write-ktest-archive
+  KTestArchiveWriter *m_ktestArchive;
+
 public:
   KleeHandler(int argc, char **argv);
   ~KleeHandler();
@@ -474,8 +524,9 @@ public:
   openOutputFile(const std::string &filename) override;
   std::string getTestFilename(const std::string &suffix, unsigned id,
                               unsigned version = 0);
-  std::unique_ptr<llvm::raw_fd_ostream>
+  std::unique_ptr<llvm::raw_ostream>
   openTestFile(const std::string &suffix, unsigned id, unsigned version = 0);
+  KTestArchiveWriter *getKTestArchive();
 
   // load a .path file
   static void loadPathFile(std::string name, std::vector<bool> &buffer);
@@ -483,6 +534,10 @@ public:
   static void getKTestFilesInDir(std::string directoryPath,
                                  std::vector<std::string> &results);
 
+  // load the test of a .ktest file or all tests of a .ktar archive
+  static bool loadKTests(const std::string &path,
+                         std::vector<KTest *> &results);
+
   static std::string getRunTimeLibraryPath(const char *argv0);
 
   void setOutputDirectory(const std::string &directory);
@@ -495,7 +550,8 @@ public:
 KleeHandler::KleeHandler(int argc, char **argv)
     : m_interpreter(0), m_pathWriter(0), m_symPathWriter(0),
       m_outputDirectory(), m_numTotalTests(0), m_numGeneratedTests(0),
-      m_pathsCompleted(0), m_pathsExplored(0), m_argc(argc), m_argv(argv) {
+      m_pathsCompleted(0), m_pathsExplored(0), m_argc(argc), m_argv(argv),
+      m_ktestArchive(0) {
 
   // create output directory (OutputDir or "klee-out-<i>")
   bool dir_given = OutputDir != "";
@@ -577,6 +633,8 @@ KleeHandler::KleeHandler(int argc, char **argv)
 KleeHandler::~KleeHandler() {
   delete m_pathWriter;
   delete m_symPathWriter;
+  if (m_ktestArchive)
+    kTestArchiveWriter_close(m_ktestArchive);
   fclose(klee_warning_file);
   fclose(klee_message_file);
 }
@@ -663,9 +721,25 @@ ToolJson KleeHandler::info() const {
   return tool;
 }
 
-std::unique_ptr<llvm::raw_fd_ostream>
+KTestArchiveWriter *KleeHandler::getKTestArchive() {
+  if (!WriteKTestArchive)
+    return nullptr;
+  if (!m_ktestArchive) {
+    m_ktestArchive = kTestArchiveWriter_open(
+        getOutputFilename("tests.ktar").c_str(), KTestArchiveDedup);
+    if (!m_ktestArchive)
+      klee_error("cannot open test case archive \"%s\"",
+                 getOutputFilename("tests.ktar").c_str());
+  }
+  return m_ktestArchive;
+}
+
+std::unique_ptr<llvm::raw_ostream>
 KleeHandler::openTestFile(const std::string &suffix, unsigned id,
                           unsigned version) {
+  if (KTestArchiveWriter *archive = getKTestArchive())
+    return std::make_unique<ArchivedFileStream>(
+        archive, getTestFilename(suffix, id, version));
   return openOutputFile(getTestFilename(suffix, id, version));
 }
 
@@ -693,10 +767,18 @@ void KleeHandler::processTestCase(const ExecutionState &state,
 
     if (success) {
       if (WriteKTests) {
-        for (unsigned i = 0; i < ktest.uninitCoeff + 1; ++i) {
-          if (!kTest_toFile(
-                  &ktest,
-                  getOutputFilename(getTestFilename("ktest", id, i)).c_str())) {
+        // the versions of a test case only differ in their file names, so
+        // the archive keeps a single copy
+        KTestArchiveWriter *archive = getKTestArchive();
+        unsigned versions = archive ? 1 : ktest.uninitCoeff + 1;
+        for (unsigned i = 0; i < versions; ++i) {
+          bool written =
+              archive ? kTestArchiveWriter_append(archive, &ktest)
+                      : kTest_toFile(&ktest,
+                                     getOutputFilename(
+                                         getTestFilename("ktest", id, i))
+                                         .c_str());
+          if (!written) {
             klee_warning("unable to write output test case, losing it");
           } else {
             atLeastOneGenerated = true;
@@ -914,7 +996,8 @@ void KleeHandler::getKTestFilesInDir(std::string directoryPath,
   llvm::sys::fs::directory_iterator i(directoryPath, ec), e;
   for (; i != e && !ec; i.increment(ec)) {
     auto f = i->path();
-    if (f.size() >= 6 && f.substr(f.size() - 6, f.size()) == ".ktest") {
+    if ((f.size() >= 6 && f.substr(f.size() - 6, f.size()) == ".ktest") ||
+        (f.size() >= 5 && f.substr(f.size() - 5, f.size()) == ".ktar")) {
       results.push_back(f);
     }
   }
@@ -926,6 +1009,32 @@ void KleeHandler::getKTestFilesInDir(std::string directoryPath,
   }
 }
 
+bool KleeHandler::loadKTests(const std::string &path,
+                             std::vector<KTest *> &results) {
+  if (!kTestArchive_isArchiveFile(path.c_str())) {
+    KTest *out = kTest_fromFile(path.c_str());
+    if (!out)
+      return false;
+    results.push_back(out);
+    return true;
+  }
+
+  KTestArchive *archive = kTestArchive_open(path.c_str());
+  if (!archive)
+    return false;
+  bool success = true;
+  for (unsigned i = 0, e = kTestArchive_numTests(archive); i != e; ++i) {
+    KTest *out = kTestArchive_getTest(archive, i);
+    if (!out) {
+      success = false;
+      break;
+    }
+    results.push_back(out);
+  }
+  kTestArchive_close(archive);
+  return success;
+}
+
 std::string KleeHandler::getRunTimeLibraryPath(const char *argv0) {
   // allow specifying the path to the runtime library
   const char *env = getenv("KLEE_RUNTIME_LIBRARY_PATH");
@@ -1077,6 +1186,8 @@ static const char *modelledExternals[] = {
     "klee_prefer_cex", "klee_posix_prefer_cex", "klee_print_expr",
     "klee_print_range", "klee_report_error", "klee_set_forking",
     "klee_silent_exit", "klee_warning", "klee_warning_once", "klee_stack_trace",
+    "klee_memcmp_internal", "klee_memcpy_internal", "klee_memmove_internal",
+    "klee_memset_internal",
 #ifdef SUPPORT_KLEE_EH_CXX
     "_klee_eh_Unwind_RaiseException_impl", "klee_eh_typeid_for",
 #endif
@@ -1535,10 +1646,7 @@ static int run_klee_on_function(int pArgc, char **pArgv, char **pEnvp,
     for (std::vector<std::string>::iterator it = kTestFiles.begin(),
                                             ie = kTestFiles.end();
          it != ie; ++it) {
-      KTest *out = kTest_fromFile(it->c_str());
-      if (out) {
-        kTests.push_back(out);
-      } else {
+      if (!KleeHandler::loadKTests(*it, kTests)) {
         klee_warning("unable to open: %s\n", (*it).c_str());
       }
     }
@@ -1558,7 +1666,7 @@ static int run_klee_on_function(int pArgc, char **pArgv, char **pEnvp,
       interpreter->setReplayKTest(out);
       llvm::errs() << "KLEE: replaying: " << *it << " (" << kTest_numBytes(out)
                    << " bytes)"
-                   << " (" << ++i << "/" << kTestFiles.size() << ")\n";
+                   << " (" << ++i << "/" << kTests.size() << ")\n";
       // XXX should put envp in .ktest ?
       interpreter->runFunctionAsMain(mainFn, out->numArgs, out->args, pEnvp);
       if (interrupted)
@@ -1574,11 +1682,9 @@ static int run_klee_on_function(int pArgc, char **pArgv, char **pEnvp,
     for (std::vector<std::string>::iterator it = SeedOutFile.begin(),
                                             ie = SeedOutFile.end();
          it != ie; ++it) {
-      KTest *out = kTest_fromFile(it->c_str());
-      if (!out) {
+      if (!KleeHandler::loadKTests(*it, seeds)) {
         klee_error("unable to open: %s\n", (*it).c_str());
       }
-      seeds.push_back(out);
     }
     for (std::vector<std::string>::iterator it = SeedOutDir.begin(),
                                             ie = SeedOutDir.end();
@@ -1588,11 +1694,9 @@ static int run_klee_on_function(int pArgc, char **pArgv, char **pEnvp,
       for (std::vector<std::string>::iterator it2 = kTestFiles.begin(),
                                               ie = kTestFiles.end();
            it2 != ie; ++it2) {
-        KTest *out = kTest_fromFile(it2->c_str());
-        if (!out) {
+        if (!KleeHandler::loadKTests(*it2, seeds)) {
           klee_error("unable to open: %s\n", (*it2).c_str());
         }
-        seeds.push_back(out);
       }
       if (kTestFiles.empty()) {
         klee_error("seeds directory is empty: %s\n", (*it).c_str());
@@ -2442,6 +2546,8 @@ int main(int argc, char **argv, char **envp) {
       *theStatisticManager->getStatisticByName("QueriesCEX");
   uint64_t queryConstructs =
       *theStatisticManager->getStatisticByName("QueryConstructs");
+  uint64_t solverCacheCollisions =
+      *theStatisticManager->getStatisticByName("SolverCacheCollisions");
   uint64_t instructions =
       *theStatisticManager->getStatisticByName("Instructions");
   uint64_t forks = *theStatisticManager->getStatisticByName("Forks");
@@ -2461,6 +2567,17 @@ int main(int argc, char **argv, char **envp) {
                            << "\n"
                            << "KLEE: done: query cex = " << queryCounterexamples
                            << "\n";
+  handler->getInfoStream()
+      << "KLEE: done: update node cache hits = " << UpdateNode::cacheHits
+      << "\n"
+      << "KLEE: done: update node cache misses = " << UpdateNode::cacheMisses
+      << "\n"
+      << "KLEE: done: update node cache size = " << UpdateNode::getCacheSize()
+      << " (" << UpdateNode::getCacheSize() * sizeof(UpdateNode) << " bytes)\n"
+      << "KLEE: done: expression cache collisions = " << Expr::cacheCollisions
+      << "\n"
+      << "KLEE: done: solver cache collisions = " << solverCacheCollisions
+      << "\n";
 
   std::stringstream stats;
   stats << '\n'
@@ -48,6 +48,10 @@ void print_usage_and_exit(char *program_name) {
           "with the following treated as special:\n"
           "       --bout-file <filename>      - Specifying the output file "
           "name for the ktest file (default: file.bout).\n"
+          "       --archive <filename>        - Append the test to a ktest "
+          "archive instead of writing a ktest file.\n"
+          "       --archive-dedup             - Share object contents with "
+          "tests already in the archive.\n"
           "       --sym-stdin <filename>      - Specifying a file that is the "
           "content of stdin (only once).\n"
           "       --sym-stdout <filename>     - Specifying a file that is the "
@@ -68,6 +72,8 @@ int main(int argc, char *argv[]) {
   char *content_filenames_list[1024];
   char **argv_copy;
   char *bout_file = NULL;
+  char *archive_file = NULL;
+  int archive_dedup = 0;
 
   if (argc < 2)
     print_usage_and_exit(argv[0]);
@@ -120,6 +126,15 @@ int main(int argc, char *argv[]) {
         print_usage_and_exit(argv[0]);
 
       bout_file = argv[i];
+    } else if (strcmp(argv[i], "--archive") == 0 ||
+               strcmp(argv[i], "-archive") == 0) {
+      if (++i == (unsigned)argc)
+        print_usage_and_exit(argv[0]);
+
+      archive_file = argv[i];
+    } else if (strcmp(argv[i], "--archive-dedup") == 0 ||
+               strcmp(argv[i], "-archive-dedup") == 0) {
+      archive_dedup = 1;
     } else {
       long nbytes = strlen(argv[i]) + 1;
       static int total_args = 0;
@@ -313,7 +328,15 @@ int main(int argc, char *argv[]) {
   b.numArgs = argv_copy_idx;
   b.args = argv_copy;
 
-  if (!kTest_toFile(&b, bout_file ? bout_file : "file.bout"))
+  if (archive_file) {
+    KTestArchiveWriter *archive =
+        kTestArchiveWriter_open(archive_file, archive_dedup);
+    if (!archive || !kTestArchiveWriter_append(archive, &b)) {
+      fprintf(stderr, "Failure appending to archive %s\n", archive_file);
+      return 1;
+    }
+    kTestArchiveWriter_close(archive);
+  } else if (!kTest_toFile(&b, bout_file ? bout_file : "file.bout"))
     assert(0);
 
   for (int i = 0; i < (int)b.numObjects; ++i) {
@@ -0,0 +1,115 @@
+//===-- ExecutionStateTest.cpp --------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#define KLEE_UNITTEST
+
+#include "gtest/gtest.h"
+
+#include "Core/ExecutionState.h"
+#include "Core/Memory.h"
+#include "klee/Core/Context.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/SourceBuilder.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+ref<PointerExpr> symbolicPointer(const std::string &name) {
+  const Array *array = Array::create(ConstantExpr::create(8, Expr::Int64),
+                                     SourceBuilder::makeSymbolic(name, 0));
+  ref<Expr> base = Expr::createTempRead(array, Expr::Int64);
+  return cast<PointerExpr>(PointerExpr::create(base, base));
+}
+
+ref<MemoryObject> memoryObject(IDType id) {
+  ref<MemoryObject> mo = new MemoryObject(0x1000 * id);
+  mo->id = id;
+  return mo;
+}
+
+class ExecutionStateTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    // memory objects create their addresses as pointer expressions
+    if (!ContextInitialized)
+      Context::initialize(true, Expr::Int64);
+  }
+};
+
+TEST_F(ExecutionStateTest, BranchSharesPointerResolutions) {
+  ExecutionState state;
+  ref<PointerExpr> p = symbolicPointer("p"), q = symbolicPointer("q");
+  ref<MemoryObject> a = memoryObject(1), b = memoryObject(2);
+
+  state.addPointerResolution(p, a.get(), 4);
+  state.addPointerResolution(p, b.get(), 4);
+  state.addPointerResolution(p, a.get(), 4);
+  ASSERT_EQ(state.resolvedPointers.at(p->getBase()).size(), 2u);
+  ASSERT_EQ(state.resolvedSubobjects.at(MemorySubobject(p, 4)).size(), 2u);
+
+  std::unique_ptr<ExecutionState> branched(state.branch());
+  EXPECT_EQ(branched->resolvedPointers.at(p->getBase()).size(), 2u);
+
+  // changes of either state do not show in the other one
+  branched->addUniquePointerResolution(p, b.get(), 4);
+  branched->addPointerResolution(q, a.get(), 4);
+  EXPECT_EQ(branched->resolvedPointers.at(p->getBase()).size(), 1u);
+  EXPECT_EQ(state.resolvedPointers.at(p->getBase()).size(), 2u);
+  EXPECT_FALSE(state.resolvedPointers.count(q->getBase()));
+
+  state.removePointerResolutions(a.get());
+  EXPECT_EQ(state.resolvedPointers.at(p->getBase()).size(), 1u);
+  EXPECT_EQ(state.resolvedPointers.at(p->getBase()).begin()->get(), b.get());
+  EXPECT_TRUE(branched->resolvedPointers.at(q->getBase()).count(a));
+
+  state.removePointerResolutions(b.get());
+  EXPECT_FALSE(state.resolvedPointers.count(p->getBase()));
+  EXPECT_FALSE(state.resolvedSubobjects.count(MemorySubobject(p, 4)));
+  EXPECT_EQ(branched->resolvedPointers.size(), 2u);
+}
+
+// Time to branch a state against the number of pointers it has resolved. Run
+// with --gtest_also_run_disabled_tests.
+TEST_F(ExecutionStateTest, DISABLED_BranchLatency) {
+  const unsigned branches = 1000;
+  std::vector<ref<MemoryObject>> objects;
+  for (IDType id = 1; id <= 4; ++id)
+    objects.push_back(memoryObject(id));
+
+  for (unsigned pointers = 1; pointers <= 100000; pointers *= 10) {
+    ExecutionState state;
+    for (unsigned i = 0; i < pointers; ++i) {
+      ref<PointerExpr> p = symbolicPointer("p" + std::to_string(i));
+      state.addPointerResolution(p, objects[i % objects.size()].get(), 4);
+    }
+
+    std::vector<std::unique_ptr<ExecutionState>> branched;
+    branched.reserve(branches);
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < branches; ++i)
+      branched.emplace_back(state.branch());
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    llvm::outs() << pointers << " resolved pointers: "
+                 << std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        elapsed)
+                            .count() /
+                        branches
+                 << " ns per branch\n";
+  }
+}
+} // namespace
@@ -31,7 +31,7 @@ ref<Expr> getConstant(int value, Expr::Width width) {
   return ConstantExpr::create(trunc, width);
 }
 
-TEST(ArrayExprTest, HashCollisions) {
+TEST(ArrayExprTest, ReadsOfExtendedUpdateList) {
   klee::OptimizeArray = ALL;
   SparseStorageImpl<ref<ConstantExpr>> constVals(
       ConstantExpr::create(5, Expr::Int8));
@@ -49,10 +49,7 @@ TEST(ArrayExprTest, HashCollisions) {
   ul.extend(getConstant(6, Expr::Int32), getConstant(42, Expr::Int8));
   ref<Expr> updatedRead = ReadExpr::create(ul, symIdx);
 
-  // This test requires hash collision and should be updated if the hash
-  // function changes
   ASSERT_NE(updatedRead, firstRead);
-  ASSERT_EQ(updatedRead->hash(), firstRead->hash());
 
   SparseStorageImpl<unsigned char> value({6, 0, 0, 0});
   std::vector<SparseStorageImpl<unsigned char>> values = {value};
@@ -13,6 +13,12 @@
 #include "klee/Expr/Expr.h"
 #include "klee/Expr/SourceBuilder.h"
 
+#include "llvm/Support/raw_ostream.h"
+
+#include <chrono>
+#include <unordered_set>
+#include <vector>
+
 using namespace klee;
 
 namespace {
@@ -287,4 +293,86 @@ TEST(ExprTest, ReadExprFoldingSymbolicIndexUpdate) {
     EXPECT_EQ(Expr::Read, read.get()->getKind());
   }
 }
+
+TEST(ExprTest, UpdateNodesAreHashConsed) {
+  const Array *array =
+      Array::create(ConstantExpr::create(256, sizeof(uint64_t) * CHAR_BIT),
+                    SourceBuilder::makeSymbolic("arr", 3));
+  ref<Expr> index = ReadExpr::createTempRead(array, Expr::Int32);
+
+  // Equal sequences built independently share their nodes
+  UpdateList a(array, nullptr), b(array, nullptr), c(array, nullptr);
+  for (unsigned i = 0; i < 1000; ++i) {
+    ref<Expr> offset = AddExpr::create(index, getConstant(i, Expr::Int32));
+    a.extend(offset, getConstant(i, Expr::Int8));
+    b.extend(offset, getConstant(i, Expr::Int8));
+    c.extend(offset, getConstant(i == 0, Expr::Int8));
+  }
+  EXPECT_EQ(a.head.get(), b.head.get());
+  EXPECT_EQ(0, a.compare(b));
+  EXPECT_EQ(a.hash(), b.hash());
+
+  // Sequences that differ in their first update share no nodes
+  EXPECT_NE(a.head.get(), c.head.get());
+  EXPECT_NE(0, a.compare(c));
+  EXPECT_EQ(-a.compare(c), c.compare(a));
+
+  // Reads of them are the same expression
+  ref<Expr> readA = ReadExpr::create(a, index);
+  ref<Expr> readB = ReadExpr::create(b, index);
+  EXPECT_EQ(readA.get(), readB.get());
+
+  // The order of updates matters
+  UpdateList d(array, nullptr), e(array, nullptr);
+  d.extend(getConstant(0, Expr::Int32), getConstant(1, Expr::Int8));
+  d.extend(getConstant(1, Expr::Int32), getConstant(2, Expr::Int8));
+  e.extend(getConstant(1, Expr::Int32), getConstant(2, Expr::Int8));
+  e.extend(getConstant(0, Expr::Int32), getConstant(1, Expr::Int8));
+  EXPECT_NE(0, d.compare(e));
+}
+
+TEST(ExprTest, HashesOfSimilarExpressionsDiffer) {
+  const Array *array =
+      Array::create(ConstantExpr::create(256, sizeof(uint64_t) * CHAR_BIT),
+                    SourceBuilder::makeSymbolic("arr", 4));
+  ref<Expr> index = ReadExpr::createTempRead(array, Expr::Int32);
+
+  uint64_t collisions = Expr::cacheCollisions;
+  std::unordered_set<uint64_t> hashes;
+  for (unsigned i = 2; i < 100002; ++i) {
+    hashes.insert(AddExpr::create(index, getConstant(i, Expr::Int32))->hash());
+    hashes.insert(MulExpr::create(index, getConstant(i, Expr::Int32))->hash());
+  }
+  EXPECT_EQ(200000u, hashes.size());
+  EXPECT_EQ(collisions, Expr::cacheCollisions);
+}
+
+// Time to look up expressions in the expression cache against the number of
+// cached expressions. Run with --gtest_also_run_disabled_tests.
+TEST(ExprTest, DISABLED_CacheLookupLatency) {
+  const Array *array =
+      Array::create(ConstantExpr::create(256, sizeof(uint64_t) * CHAR_BIT),
+                    SourceBuilder::makeSymbolic("arr", 5));
+  ref<Expr> index = ReadExpr::createTempRead(array, Expr::Int32);
+
+  std::vector<ref<Expr>> exprs;
+  for (unsigned size = 1000; size <= 1000000; size *= 10) {
+    for (unsigned i = exprs.size(); i < size; ++i)
+      exprs.push_back(AddExpr::create(index, getConstant(i, Expr::Int32)));
+
+    uint64_t collisions = Expr::cacheCollisions;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < size; ++i)
+      AddExpr::create(index, getConstant(i, Expr::Int32));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    llvm::outs() << size << " cached expressions: "
+                 << std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        elapsed)
+                            .count() /
+                        size
+                 << " ns per lookup, "
+                 << Expr::cacheCollisions - collisions << " collisions\n";
+  }
+}
 } // namespace
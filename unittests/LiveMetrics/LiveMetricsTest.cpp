@@ -0,0 +1,149 @@
+//===-- LiveMetricsTest.cpp -----------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Statistics/LiveMetrics.h"
+#include "klee/Statistics/Statistics.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace klee;
+
+namespace {
+
+Statistic liveStatistic("LiveMetricsTestStatistic", "LMTs");
+
+// The page layout as decoded by klee-stats --live.
+constexpr unsigned NameSize = 48;
+constexpr unsigned PathSize = 4096;
+
+struct PageHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t pid;
+  std::uint32_t numStatistics;
+  std::uint32_t numHistograms;
+  std::uint32_t numBuckets;
+  std::uint32_t nameSize;
+  std::uint64_t sequence;
+  std::uint64_t updateTime;
+  char outputDirectory[PathSize];
+};
+
+struct HistogramSlot {
+  char name[NameSize];
+  std::uint64_t count, sum, last, max;
+  std::uint64_t buckets[LiveMetrics::NumBuckets];
+};
+
+struct StatisticSlot {
+  char name[NameSize];
+  std::uint64_t value;
+};
+
+/// Maps the shared page read-only, as another process would.
+class PageReader {
+  void *mem = MAP_FAILED;
+  std::size_t size = 0;
+
+public:
+  explicit PageReader(const std::string &name) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0) {
+      size = st.st_size;
+      mem = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    if (fd >= 0)
+      close(fd);
+  }
+  ~PageReader() {
+    if (mem != MAP_FAILED)
+      munmap(mem, size);
+  }
+
+  bool good() const { return mem != MAP_FAILED; }
+  const PageHeader &header() const {
+    return *static_cast<const PageHeader *>(mem);
+  }
+  const HistogramSlot &histogram(LiveHistogram h) const {
+    auto slots = reinterpret_cast<const HistogramSlot *>(&header() + 1);
+    return slots[static_cast<unsigned>(h)];
+  }
+  const StatisticSlot *statistic(const std::string &name) const {
+    auto slots = reinterpret_cast<const StatisticSlot *>(
+        &histogram(LiveHistogram::QueryTime) + header().numHistograms);
+    for (unsigned i = 0; i != header().numStatistics; ++i)
+      if (name == slots[i].name)
+        return &slots[i];
+    return nullptr;
+  }
+};
+
+TEST(LiveMetricsTest, PageMirrorsStatisticsAndHistograms) {
+  LiveMetrics *metrics = LiveMetrics::open("/tmp/live-metrics-test");
+  ASSERT_NE(metrics, nullptr);
+  EXPECT_EQ(metrics, LiveMetrics::get());
+  std::string name = metrics->getName();
+
+  {
+    PageReader reader(name);
+    ASSERT_TRUE(reader.good());
+    const PageHeader &header = reader.header();
+    EXPECT_EQ(0, memcmp(header.magic, "KLEELIVE", 8));
+    EXPECT_EQ(static_cast<std::uint32_t>(getpid()), header.pid);
+    EXPECT_EQ(theStatisticManager->getNumStatistics(), header.numStatistics);
+    EXPECT_EQ(LiveMetrics::NumHistograms, header.numHistograms);
+    EXPECT_EQ(LiveMetrics::NumBuckets, header.numBuckets);
+    EXPECT_STREQ("/tmp/live-metrics-test", header.outputDirectory);
+    EXPECT_EQ(0u, header.sequence % 2);
+
+    // statistics are only copied by update()
+    const StatisticSlot *slot = reader.statistic("LiveMetricsTestStatistic");
+    ASSERT_NE(slot, nullptr);
+    std::uint64_t before = slot->value;
+    liveStatistic += 5;
+    EXPECT_EQ(before, slot->value);
+    std::uint64_t sequence = header.sequence;
+    metrics->update();
+    EXPECT_EQ(before + 5, slot->value);
+    EXPECT_EQ(sequence + 2, header.sequence);
+
+    // histograms are written through immediately
+    metrics->record(LiveHistogram::QueryTime, 0);
+    metrics->record(LiveHistogram::QueryTime, 1);
+    metrics->record(LiveHistogram::QueryTime, 5);
+    metrics->record(LiveHistogram::QueryTime, 7);
+    metrics->record(LiveHistogram::QueryTime, 1000);
+    const HistogramSlot &h = reader.histogram(LiveHistogram::QueryTime);
+    EXPECT_STREQ("QueryTime", h.name);
+    EXPECT_EQ(5u, h.count);
+    EXPECT_EQ(1013u, h.sum);
+    EXPECT_EQ(1000u, h.last);
+    EXPECT_EQ(1000u, h.max);
+    EXPECT_EQ(1u, h.buckets[0]);  // 0
+    EXPECT_EQ(1u, h.buckets[1]);  // [1, 2)
+    EXPECT_EQ(2u, h.buckets[3]);  // [4, 8)
+    EXPECT_EQ(1u, h.buckets[10]); // [512, 1024)
+    EXPECT_EQ(0u, reader.histogram(LiveHistogram::States).count);
+  }
+
+  LiveMetrics::close();
+  EXPECT_EQ(nullptr, LiveMetrics::get());
+  EXPECT_FALSE(PageReader(name).good());
+}
+} // namespace
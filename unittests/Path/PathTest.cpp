@@ -0,0 +1,232 @@
+//===-- PathTest.cpp ------------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Expr/Path.h"
+#include "klee/Module/Cell.h"
+#include "klee/Module/KInstruction.h"
+#include "klee/Module/KModule.h"
+
+#include "gtest/gtest.h"
+
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/SourceMgr.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+// Calls start their own blocks, as after --split-calls.
+const char *program = R"(
+define void @f() {
+entry:
+  br label %loop
+loop:
+  br label %body
+body:
+  br i1 undef, label %loop, label %exit
+exit:
+  ret void
+}
+
+define i32 @main() {
+entry:
+  br label %call
+call:
+  call void @f()
+  br label %after
+after:
+  br i1 undef, label %call, label %return
+return:
+  ret i32 0
+}
+)";
+
+class PathTest : public ::testing::Test {
+protected:
+  llvm::LLVMContext context;
+  KModule kmodule;
+  KFunction *f, *main;
+
+  void SetUp() override {
+    llvm::SMDiagnostic error;
+    kmodule.module = llvm::parseAssemblyString(program, error, context);
+    ASSERT_TRUE(kmodule.module);
+    kmodule.targetData =
+        std::make_unique<llvm::DataLayout>(kmodule.module.get());
+    // there is no output directory to write assembly.ll to
+    auto outputSource = static_cast<llvm::cl::opt<bool> *>(
+        llvm::cl::getRegisteredOptions().lookup("output-source"));
+    outputSource->setValue(false);
+    kmodule.manifest(nullptr, false);
+    f = kmodule.functionNameMap.at("f");
+    main = kmodule.functionNameMap.at("main");
+  }
+
+  KBlock *block(KFunction *kf, const std::string &label) {
+    return kf->getLabelMap().at("%" + label);
+  }
+
+  /// Blocks of n calls of f from the loop of main, in which f loops
+  /// iterations[i] times in call i, starting in the entry block of main.
+  std::vector<KBlock *> calls(const std::vector<unsigned> &iterations) {
+    std::vector<KBlock *> blocks = {block(main, "entry")};
+    for (unsigned n : iterations) {
+      blocks.push_back(block(main, "call"));
+      blocks.push_back(block(f, "entry"));
+      for (unsigned i = 0; i < n; ++i) {
+        blocks.push_back(block(f, "loop"));
+        blocks.push_back(block(f, "body"));
+      }
+      blocks.push_back(block(f, "exit"));
+      blocks.push_back(block(main, "after"));
+    }
+    return blocks;
+  }
+
+  static void expectBlocks(const Path &path,
+                           const std::vector<KBlock *> &expected) {
+    ASSERT_EQ(path.KBlockSize(), expected.size());
+    for (unsigned long i = 0; i < expected.size(); ++i)
+      ASSERT_EQ(path.getBlock(i), expected[i]) << "at block " << i;
+    std::vector<KBlock *> visited;
+    path.forEachBlock([&visited](KBlock *kb) { visited.push_back(kb); });
+    EXPECT_EQ(visited, expected);
+  }
+};
+} // namespace
+
+TEST_F(PathTest, GetBlockAcrossFoldsAndCheckpoints) {
+  // Loops of all lengths, up to more than fit into the literal blocks of a
+  // checkpoint, mixed with irregular stretches that end repetitions in the
+  // middle of an iteration.
+  std::mt19937 rng(0);
+  std::vector<KBlock *> pool = {block(f, "entry"), block(f, "loop"),
+                                block(f, "body"), block(f, "exit")};
+  std::vector<KBlock *> expected;
+  for (unsigned i = 0; i < 200; ++i) {
+    unsigned period = 1 + rng() % 5;
+    unsigned repeat = rng() % 4 == 0 ? 300 : rng() % 8;
+    std::vector<KBlock *> body;
+    for (unsigned j = 0; j < period; ++j)
+      body.push_back(pool[rng() % pool.size()]);
+    for (unsigned j = 0; j < repeat; ++j)
+      expected.insert(expected.end(), body.begin(), body.end());
+    unsigned partial = rng() % period;
+    expected.insert(expected.end(), body.begin(), body.begin() + partial);
+  }
+
+  Path path(0, expected, 0);
+  expectBlocks(path, expected);
+  EXPECT_EQ(path.getBlock(Path::PathIndex{expected.size() - 1, 0}),
+            expected.back());
+
+  // a copy shares the checkpoints, but grows on its own
+  Path copy = path;
+  std::vector<KBlock *> copied = expected;
+  KBlock *exit = block(f, "exit");
+  for (unsigned i = 0; i < 1000; ++i) {
+    copy.advance(exit->getFirstInstruction());
+    copy.advance(block(f, "loop")->getFirstInstruction());
+    copied.push_back(exit);
+    copied.push_back(block(f, "loop"));
+  }
+  expectBlocks(copy, copied);
+  expectBlocks(path, expected);
+  EXPECT_LT(path.getMemoryUsage(), expected.size() * sizeof(KBlock *));
+}
+
+TEST_F(PathTest, PathIndex) {
+  Path path;
+  KBlock *entry = block(f, "entry"), *loop = block(f, "loop"),
+         *body = block(f, "body");
+  path.advance(entry->getFirstInstruction());
+  path.advance(entry->getLastInstruction());
+  EXPECT_EQ(path.getCurrentIndex(),
+            (Path::PathIndex{0, entry->getLastInstruction()->getIndex()}));
+
+  // instructions of one block do not add blocks, also inside a loop
+  for (unsigned i = 0; i < 500; ++i) {
+    for (KBlock *kb : {loop, body}) {
+      for (unsigned j = 0; j < kb->getNumInstructions(); ++j)
+        path.advance(kb->instructions[j]);
+    }
+    Path::PathIndex index = path.getCurrentIndex();
+    ASSERT_EQ(index.block, 2 * i + 2);
+    ASSERT_EQ(index.instruction, body->getLastInstruction()->getIndex());
+    ASSERT_EQ(path.getBlock(index), body);
+    ASSERT_EQ(path.getBlock(Path::PathIndex{index.block - 1, 0}), loop);
+  }
+  EXPECT_EQ(path.getFirstIndex(), entry->getFirstInstruction()->getIndex());
+
+  Path::PathIndexCompare less;
+  EXPECT_TRUE(less({1, 5}, {2, 0}));
+  EXPECT_TRUE(less({2, 0}, {2, 1}));
+  EXPECT_FALSE(less({2, 1}, {2, 1}));
+}
+
+TEST_F(PathTest, GetStack) {
+  KInstruction *callsite =
+      llvm::cast<KCallBlock>(block(main, "call"))->kcallInstruction;
+  std::vector<stackframe_ty> inMain = {{nullptr, main}};
+  std::vector<stackframe_ty> inF = {{nullptr, main}, {callsite, f}};
+
+  // returns from f repeat, so their runs are folded
+  std::vector<KBlock *> blocks = calls(std::vector<unsigned>(100, 3));
+  EXPECT_EQ(Path(0, blocks, 0).getStack(false), inMain);
+
+  // ends in the middle of a call that is part of a repetition
+  blocks = calls(std::vector<unsigned>(100, 3));
+  blocks.resize(blocks.size() - 4);
+  EXPECT_EQ(Path(0, blocks, 0).getStack(false), inF);
+  std::vector<stackframe_ty> reversed(inF.rbegin(), inF.rend());
+  EXPECT_EQ(Path(0, blocks, 0).getStack(true), reversed);
+
+  // and in a loop of f long enough to be checkpointed
+  blocks = calls({1000});
+  blocks.resize(blocks.size() - 2);
+  EXPECT_EQ(Path(0, blocks, 0).getStack(false), inF);
+
+  // a path that starts inside a function has no callsite for it
+  blocks = {block(f, "loop"), block(f, "body"), block(f, "exit"),
+            block(main, "after")};
+  EXPECT_EQ(Path(0, blocks, 0).getStack(false), inMain);
+  blocks.resize(2);
+  EXPECT_EQ(Path(0, blocks, 0).getStack(false),
+            (std::vector<stackframe_ty>{{nullptr, f}}));
+}
+
+TEST_F(PathTest, ParseAndConcat) {
+  std::vector<unsigned> iterations;
+  for (unsigned i = 0; i < 50; ++i)
+    iterations.push_back(i % 7 == 0 ? 400 : i % 3);
+  std::vector<KBlock *> blocks = calls(iterations);
+  blocks.push_back(block(main, "return"));
+
+  Path path(2, blocks, 1);
+  Path parsed = Path::parse(path.toString(), kmodule);
+  expectBlocks(parsed, blocks);
+  EXPECT_EQ(parsed.getFirstIndex(), 2u);
+  EXPECT_EQ(parsed.getLastIndex(), 1u);
+  EXPECT_EQ(parsed.toString(), path.toString());
+
+  for (std::size_t split : {std::size_t(1), std::size_t(5), blocks.size() / 2,
+                            blocks.size() - 1}) {
+    std::vector<KBlock *> front(blocks.begin(), blocks.begin() + split);
+    std::vector<KBlock *> back(blocks.begin() + split, blocks.end());
+    Path concatenated = Path::concat(Path(2, front, 0), Path(0, back, 1));
+    expectBlocks(concatenated, blocks);
+    EXPECT_EQ(concatenated.toString(), path.toString());
+  }
+}
@@ -0,0 +1,80 @@
+//===-- QueryCostModelTest.cpp --------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Core/QueryCostModel.h"
+
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/SourceBuilder.h"
+#include "gtest/gtest.h"
+
+using namespace klee;
+
+namespace {
+ref<Expr> read(const char *name) {
+  const Array *array = Array::create(ConstantExpr::create(4, Expr::Int64),
+                                     SourceBuilder::makeSymbolic(name, 0));
+  return Expr::createTempRead(array, Expr::Int32);
+}
+
+QueryFeatures features(std::uint32_t factorConstraints,
+                       std::uint32_t nonlinear) {
+  QueryFeatures f;
+  f.constraints = factorConstraints;
+  f.factorConstraints = factorConstraints;
+  f.arrays = 1;
+  f.nonlinear = nonlinear;
+  return f;
+}
+} // namespace
+
+TEST(QueryCostModelTest, Extract) {
+  ref<Expr> x = read("x"), y = read("y"), z = read("z");
+  constraints_ty cs;
+  cs.insert(
+      UltExpr::create(MulExpr::create(x, y), ConstantExpr::create(7, 32)));
+  cs.insert(UltExpr::create(MulExpr::create(x, ConstantExpr::create(3, 32)),
+                            ConstantExpr::create(9, 32)));
+  cs.insert(UltExpr::create(z, ConstantExpr::create(5, 32)));
+  ConstraintSet constraints(cs);
+
+  QueryCostModel model;
+  QueryFeatures f =
+      model.extract(constraints, EqExpr::create(UDivExpr::create(x, y), y),
+                    QueryFeatures::Value);
+  ASSERT_EQ(QueryFeatures::Value, f.kind);
+  ASSERT_EQ(3u, f.constraints);
+  // the constraint on z is independent of the query
+  ASSERT_EQ(2u, f.factorConstraints);
+  ASSERT_EQ(2u, f.arrays);
+  // x * 3 is linear
+  ASSERT_EQ(2u, f.nonlinear);
+}
+
+TEST(QueryCostModelTest, LearnsShapes) {
+  QueryCostModel model;
+  ASSERT_FALSE(model.predict(features(10, 0)));
+
+  for (unsigned i = 0; i < 50; ++i) {
+    model.observe(features(10, 0), time::microseconds(100));
+    model.observe(features(1000, 20), time::seconds(2));
+  }
+
+  time::Span cheap = model.predict(features(10, 0));
+  time::Span expensive = model.predict(features(1000, 20));
+  ASSERT_GT(cheap, time::microseconds(50));
+  ASSERT_LT(cheap, time::microseconds(200));
+  ASSERT_GT(expensive, time::seconds(1));
+  ASSERT_LT(expensive, time::seconds(4));
+
+  // an unseen shape in between is predicted by the linear model
+  time::Span unseen = model.predict(features(100, 4));
+  ASSERT_GT(unseen, cheap);
+  ASSERT_LT(unseen, expensive);
+}
@@ -28,12 +28,11 @@ TEST(SearcherTest, RandomPath) {
   ExecutionState es;
   PForest processForest = PForest();
   processForest.addRoot(&es);
-  es.ptreeNode = processForest.getPTrees()
-                     .at(es.ptreeNode->getTreeID())
-                     ->root.getPointer();
+  es.ptreeNode =
+      processForest.getPTrees().at(es.ptreeNode->getTreeID())->root;
 
   RNG rng;
-  RandomPathSearcher rp(processForest, rng);
+  RandomPathSearcher rp(rng);
   EXPECT_TRUE(rp.empty());
 
   rp.update(nullptr, {&es}, {});
@@ -73,14 +72,14 @@ TEST(SearcherTest, TwoRandomPath) {
   processForest.addRoot(&root);
   root.ptreeNode = processForest.getPTrees()
                        .at(root.ptreeNode->getTreeID())
-                       ->root.getPointer();
+                       ->root;
 
   ExecutionState es(root);
   processForest.attach(root.ptreeNode, &es, &root);
 
   RNG rng, rng1;
-  RandomPathSearcher rp(processForest, rng);
-  RandomPathSearcher rp1(processForest, rng1);
+  RandomPathSearcher rp(rng);
+  RandomPathSearcher rp1(rng1);
   EXPECT_TRUE(rp.empty());
   EXPECT_TRUE(rp1.empty());
 
@@ -134,7 +133,7 @@ TEST(SearcherTest, TwoRandomPathDot) {
   processForest.addRoot(&root);
   root.ptreeNode = processForest.getPTrees()
                        .at(root.ptreeNode->getTreeID())
-                       ->root.getPointer();
+                       ->root;
   rootPNode = root.ptreeNode;
 
   ExecutionState es(root);
@@ -143,8 +142,8 @@ TEST(SearcherTest, TwoRandomPathDot) {
   esParentPNode = es.ptreeNode;
 
   RNG rng;
-  RandomPathSearcher rp(processForest, rng);
-  RandomPathSearcher rp1(processForest, rng);
+  RandomPathSearcher rp(rng);
+  RandomPathSearcher rp1(rng);
 
   rp.update(nullptr, {&es}, {});
 
@@ -166,13 +165,12 @@ TEST(SearcherTest, TwoRandomPathDot) {
       << "\tnode [style=\"filled\",width=.1,height=.1,fontname=\"Terminus\"]\n"
       << "\tedge [arrowsize=.3]\n"
       << "\tn" << rootPNode << " [shape=diamond];\n"
-      << "\tn" << rootPNode << " -> n" << esParentPNode << " [label=0b011];\n"
-      << "\tn" << rootPNode << " -> n" << rightLeafPNode << " [label=0b000];\n"
+      << "\tn" << rootPNode << " -> n" << esParentPNode << ";\n"
+      << "\tn" << rootPNode << " -> n" << rightLeafPNode << ";\n"
       << "\tn" << rightLeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "\tn" << esParentPNode << " [shape=diamond];\n"
-      << "\tn" << esParentPNode << " -> n" << es1LeafPNode
-      << " [label=0b010];\n"
-      << "\tn" << esParentPNode << " -> n" << esLeafPNode << " [label=0b001];\n"
+      << "\tn" << esParentPNode << " -> n" << es1LeafPNode << ";\n"
+      << "\tn" << esParentPNode << " -> n" << esLeafPNode << ";\n"
       << "\tn" << esLeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "\tn" << es1LeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "}\n";
@@ -197,12 +195,11 @@ TEST(SearcherTest, TwoRandomPathDot) {
       << "\tnode [style=\"filled\",width=.1,height=.1,fontname=\"Terminus\"]\n"
       << "\tedge [arrowsize=.3]\n"
       << "\tn" << rootPNode << " [shape=diamond];\n"
-      << "\tn" << rootPNode << " -> n" << esParentPNode << " [label=0b001];\n"
-      << "\tn" << rootPNode << " -> n" << rightLeafPNode << " [label=0b000];\n"
+      << "\tn" << rootPNode << " -> n" << esParentPNode << ";\n"
+      << "\tn" << rootPNode << " -> n" << rightLeafPNode << ";\n"
       << "\tn" << rightLeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "\tn" << esParentPNode << " [shape=diamond];\n"
-      << "\tn" << esParentPNode << " -> n" << es1LeafPNode
-      << " [label=0b001];\n"
+      << "\tn" << esParentPNode << " -> n" << es1LeafPNode << ";\n"
       << "\tn" << es1LeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "}\n";
 
@@ -212,20 +209,54 @@ TEST(SearcherTest, TwoRandomPathDot) {
   processForest.remove(es1.ptreeNode);
   processForest.remove(root.ptreeNode);
 }
-TEST(SearcherDeathTest, TooManyRandomPaths) {
-  // First state
-  ExecutionState es;
+
+TEST(SearcherTest, ManyRandomPaths) {
+  // Root state
+  ExecutionState root;
   PForest processForest = PForest();
-  processForest.addRoot(&es);
-  es.ptreeNode = processForest.getPTrees()
-                     .at(es.ptreeNode->getTreeID())
-                     ->root.getPointer();
-  processForest.remove(es.ptreeNode); // Need to remove to avoid leaks
+  processForest.addRoot(&root);
+  root.ptreeNode = processForest.getPTrees()
+                       .at(root.ptreeNode->getTreeID())
+                       ->root;
+
+  // Four leaves, each searcher owning a different pair of them
+  ExecutionState es(root);
+  processForest.attach(root.ptreeNode, &es, &root);
+  ExecutionState es1(es);
+  processForest.attach(es.ptreeNode, &es1, &es);
+  ExecutionState es2(root);
+  processForest.attach(root.ptreeNode, &es2, &root);
+  std::vector<ExecutionState *> states = {&root, &es, &es1, &es2};
 
   RNG rng;
-  RandomPathSearcher rp(processForest, rng);
-  RandomPathSearcher rp1(processForest, rng);
-  RandomPathSearcher rp2(processForest, rng);
-  ASSERT_DEATH({ RandomPathSearcher rp3(processForest, rng); }, "");
+  std::vector<std::unique_ptr<RandomPathSearcher>> searchers;
+  std::vector<std::pair<ExecutionState *, ExecutionState *>> owned;
+  for (unsigned i = 0; i < 8; i++) {
+    owned.emplace_back(states[i % 4], states[(i + 1 + i / 4) % 4]);
+    searchers.emplace_back(new RandomPathSearcher(rng));
+    searchers[i]->update(nullptr, {owned[i].first, owned[i].second}, {});
+  }
+
+  for (unsigned i = 0; i < 8; i++) {
+    bool selectedFirst = false, selectedSecond = false;
+    for (int j = 0; j < 100; j++) {
+      ExecutionState *selected = &searchers[i]->selectState();
+      EXPECT_TRUE(selected == owned[i].first || selected == owned[i].second);
+      selectedFirst |= selected == owned[i].first;
+      selectedSecond |= selected == owned[i].second;
+    }
+    EXPECT_TRUE(selectedFirst && selectedSecond);
+
+    searchers[i]->update(nullptr, {}, {owned[i].first});
+    for (int j = 0; j < 100; j++) {
+      EXPECT_EQ(&searchers[i]->selectState(), owned[i].second);
+    }
+    searchers[i]->update(nullptr, {}, {owned[i].second});
+    EXPECT_TRUE(searchers[i]->empty());
+  }
+
+  for (auto state : states) {
+    processForest.remove(state->ptreeNode);
+  }
 }
 } // namespace
@@ -0,0 +1,130 @@
+//===-- SetIndexTest.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/ADT/MapOfSets.h"
+#include "klee/ADT/SetIndex.h"
+#include "gtest/gtest.h"
+
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+std::set<int> randomSet(std::mt19937 &rng, unsigned maxSize) {
+  std::set<int> set;
+  unsigned size = rng() % (maxSize + 1);
+  for (unsigned i = 0; i < size; ++i)
+    set.insert(rng() % 16);
+  return set;
+}
+
+struct IsEven {
+  bool operator()(int v) const { return v % 2 == 0; }
+};
+} // namespace
+
+TEST(SetIndexTest, Lookup) {
+  SetIndex<int, int> index;
+  index.insert({1, 2, 3}, 1);
+  index.insert({}, 2);
+  index.insert({1, 2, 3}, 3);
+
+  ASSERT_EQ(2u, index.getSize());
+  ASSERT_EQ(3, *index.lookup({1, 2, 3}));
+  ASSERT_EQ(2, *index.lookup({}));
+  ASSERT_EQ(nullptr, index.lookup({1, 2}));
+}
+
+TEST(SetIndexTest, MatchesMapOfSets) {
+  std::mt19937 rng(42);
+  MapOfSets<int, int> trie;
+  SetIndex<int, int> index;
+
+  for (int i = 0; i < 2000; ++i) {
+    std::set<int> set = randomSet(rng, 6);
+    trie.insert(set, i);
+    index.insert(set, i);
+  }
+
+  for (int i = 0; i < 2000; ++i) {
+    std::set<int> set = randomSet(rng, 10);
+
+    int *expected = trie.lookup(set);
+    int *actual = index.lookup(set);
+    ASSERT_EQ(expected == nullptr, actual == nullptr);
+    if (expected) {
+      ASSERT_EQ(*expected, *actual);
+    }
+
+    expected = trie.findSubset(set, IsEven());
+    actual = index.findSubset(set, IsEven());
+    ASSERT_EQ(expected == nullptr, actual == nullptr);
+    if (actual) {
+      ASSERT_TRUE(*actual % 2 == 0);
+    }
+
+    std::set<int> small = randomSet(rng, 2);
+    expected = trie.findSuperset(small, IsEven());
+    actual = index.findSuperset(small, IsEven());
+    ASSERT_EQ(expected == nullptr, actual == nullptr);
+    if (actual) {
+      ASSERT_TRUE(*actual % 2 == 0);
+    }
+  }
+}
+
+TEST(SetIndexTest, InsertionOrder) {
+  SetIndex<int, int> index;
+  index.insert({2, 3}, 1);
+  index.insert({1}, 2);
+  index.insert({1, 2}, 3);
+
+  ASSERT_EQ(1, *index.findSubset({1, 2, 3}, [](int) { return true; }));
+  ASSERT_EQ(2, *index.findSuperset({1}, [](int) { return true; }));
+  ASSERT_EQ(3, *index.findSubset({1, 2, 3}, [](int v) { return v > 2; }));
+}
+
+TEST(SetIndexTest, Eviction) {
+  SetIndex<int, int> index(64 * 1024);
+  std::set<int> hot = {100, 101};
+  index.insert(hot, -1);
+
+  for (int i = 0; i < 10000; ++i) {
+    index.insert({i, i + 1, i + 2}, i);
+    ASSERT_NE(nullptr, index.lookup(hot));
+  }
+
+  ASSERT_LE(index.getMemoryUsage(), 64u * 1024);
+  ASSERT_GT(index.getEvictions(), 0u);
+  ASSERT_EQ(-1, *index.lookup(hot));
+  ASSERT_EQ(nullptr, index.findSubset({0, 1, 2}, [](int) { return true; }));
+  ASSERT_NE(nullptr, index.findSubset({9997, 9998, 9999, 10000},
+                                      [](int) { return true; }));
+}
+
+TEST(SetIndexTest, BudgetBoundsEntries) {
+  SetIndex<int, int> index(16 * 1024);
+  std::vector<int> removed;
+
+  for (int i = 0; i < 10000; ++i) {
+    index.insert({i, i + 1, i + 2}, i, 0, &removed);
+    ASSERT_LE(index.getMemoryUsage(), 16u * 1024);
+  }
+
+  // entries hold at least their key, so the budget bounds their number
+  ASSERT_LE(index.getSize() * 3 * sizeof(int), 16u * 1024);
+  ASSERT_EQ(10000u, index.getSize() + removed.size());
+  ASSERT_EQ(index.getEvictions(), removed.size());
+
+  index.insert({0, 1, 2}, -1, 0, &removed);
+  index.insert({0, 1, 2}, -2, 0, &removed);
+  ASSERT_EQ(-1, removed.back());
+}